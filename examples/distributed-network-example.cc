@@ -0,0 +1,296 @@
+/*
+ * This script simulates a network of gateways, each serving a cluster of end
+ * devices, that can be distributed over several MPI processes. Run it with
+ *
+ *   ./ns3 run distributed-network-example
+ *
+ * for a sequential simulation, or with
+ *
+ *   ./ns3 run distributed-network-example --command-template="mpiexec -n 2 %s --distributed"
+ *
+ * for a distributed one. The two print the same packet counts: each process
+ * simulates the clusters of its own gateways, and the packet trackers of
+ * all processes are merged before printing. With --test, the counts are
+ * printed on lines starting with TEST, which the lorawan-distributed-example
+ * test suites compare to a reference output.
+ *
+ * Transmissions reach the PHYs of other processes through a message that is
+ * delivered after the lookahead, which therefore can't exceed the shortest
+ * propagation delay between PHYs of different processes. Clusters are kept
+ * apart so that this is a few microseconds. Such a lookahead is practical
+ * because the granted time window simulator does not synchronize processes
+ * once per lookahead: each synchronization lets all processes run until the
+ * earliest pending event of any process plus the lookahead, so the idle time
+ * between transmissions, which take milliseconds to seconds and are minutes
+ * apart, is skipped in a single round. Since a process learns about the
+ * transmissions of other processes after its own ones, signals that reach a
+ * PHY at the same time are sorted by sender before they are delivered.
+ *
+ * Random variables are drawn the same way by all processes, which create
+ * every node and only install applications on their own ones. The correlated
+ * shadowing uses its counter-based mode, which computes each value from the
+ * position instead of drawing values in the order they are first needed: the
+ * order differs among processes, and so would the shadowing.
+ */
+
+#include "ns3/boolean.h"
+#include "ns3/command-line.h"
+#include "ns3/constant-position-mobility-model.h"
+#include "ns3/correlated-shadowing-propagation-loss-model.h"
+#include "ns3/global-value.h"
+#include "ns3/log.h"
+#include "ns3/lora-channel.h"
+#include "ns3/lora-helper.h"
+#include "ns3/lora-packet-tracker.h"
+#include "ns3/lorawan-mac-helper.h"
+#include "ns3/mobility-helper.h"
+#include "ns3/mpi-interface.h"
+#include "ns3/node-container.h"
+#include "ns3/periodic-sender.h"
+#include "ns3/position-allocator.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/simulator.h"
+#include "ns3/string.h"
+
+#include <iostream>
+
+using namespace ns3;
+using namespace lorawan;
+
+NS_LOG_COMPONENT_DEFINE("DistributedNetworkExample");
+
+int
+main(int argc, char* argv[])
+{
+    int nDevices = 400;
+    int nGateways = 4;
+    double gatewayDistance = 8000;
+    double clusterRadius = 2000;
+    double simulationTime = 3600;
+    int appPeriodSeconds = 600;
+    bool distributed = false;
+    bool verbose = false;
+    bool test = false;
+
+    CommandLine cmd(__FILE__);
+    cmd.AddValue("nDevices", "Number of end devices to include in the simulation", nDevices);
+    cmd.AddValue("nGateways", "Number of gateways to include in the simulation", nGateways);
+    cmd.AddValue("gatewayDistance", "The distance between neighboring gateways", gatewayDistance);
+    cmd.AddValue("clusterRadius",
+                 "The radius of the area where the end devices of a gateway are placed",
+                 clusterRadius);
+    cmd.AddValue("simulationTime", "The time for which to simulate", simulationTime);
+    cmd.AddValue("appPeriod",
+                 "The period in seconds to be used by periodically transmitting applications",
+                 appPeriodSeconds);
+    cmd.AddValue("distributed", "Whether to distribute the simulation with MPI", distributed);
+    cmd.AddValue("verbose", "Whether to log the progress of the simulation", verbose);
+    cmd.AddValue("test", "Whether to mark the packet counts as test output", test);
+    cmd.Parse(argc, argv);
+
+    NS_ABORT_MSG_IF(nGateways < 1, "At least one gateway is needed");
+
+    if (verbose)
+    {
+        LogComponentEnable("DistributedNetworkExample", LOG_LEVEL_ALL);
+        LogComponentEnable("LoraChannel", LOG_LEVEL_INFO);
+    }
+
+    // Each process simulates the clusters of an equal share of the gateways
+    uint32_t systemId = 0;
+    uint32_t systemCount = 1;
+    if (distributed)
+    {
+        GlobalValue::Bind("SimulatorImplementationType",
+                          StringValue("ns3::DistributedSimulatorImpl"));
+        MpiInterface::Enable(&argc, &argv);
+        systemId = MpiInterface::GetSystemId();
+        systemCount = MpiInterface::GetSize();
+    }
+    NS_ABORT_MSG_IF(systemCount > uint32_t(nGateways),
+                    "Each process needs at least one gateway");
+    auto getClusterSystemId = [systemCount, nGateways](int cluster) {
+        return uint32_t(cluster * systemCount / nGateways);
+    };
+
+    /************************
+     *  Create the channel  *
+     ************************/
+
+    // Create the lora channel object
+    Ptr<LogDistancePropagationLossModel> loss = CreateObject<LogDistancePropagationLossModel>();
+    loss->SetPathLossExponent(3.76);
+    loss->SetReference(1, 7.7);
+
+    // Create the correlated shadowing component, with values that don't
+    // depend on the order they are needed in
+    Ptr<CorrelatedShadowingPropagationLossModel> shadowing =
+        CreateObject<CorrelatedShadowingPropagationLossModel>();
+    shadowing->SetAttribute("CounterBased", BooleanValue(true));
+    int64_t stream = shadowing->AssignStreams(0);
+
+    // Aggregate shadowing to the logdistance loss
+    loss->SetNext(shadowing);
+
+    Ptr<PropagationDelayModel> delay = CreateObject<ConstantSpeedPropagationDelayModel>();
+
+    Ptr<LoraChannel> channel = CreateObject<LoraChannel>(loss, delay);
+
+    // Deliver signals that reach a PHY at the same time in the same order,
+    // whether the simulation is distributed or not
+    channel->SetAttribute("SortSimultaneousArrivals", BooleanValue(true));
+
+    /************************
+     *  Create the helpers  *
+     ************************/
+
+    // Create the LoraPhyHelper
+    LoraPhyHelper phyHelper = LoraPhyHelper();
+    phyHelper.SetChannel(channel);
+
+    // Create the LorawanMacHelper
+    LorawanMacHelper macHelper = LorawanMacHelper();
+
+    // Create the LoraHelper
+    LoraHelper helper = LoraHelper();
+    helper.EnablePacketTracking();
+
+    /*********************
+     *  Create Gateways  *
+     *********************/
+
+    // Gateways are placed on a line, and nodes belong to the process of
+    // the cluster they are in
+    NodeContainer gateways;
+    Ptr<ListPositionAllocator> gatewayAllocator = CreateObject<ListPositionAllocator>();
+    for (int cluster = 0; cluster < nGateways; cluster++)
+    {
+        gateways.Add(CreateObject<Node>(getClusterSystemId(cluster)));
+        gatewayAllocator->Add(Vector(cluster * gatewayDistance, 0, 15));
+    }
+
+    MobilityHelper mobility;
+    mobility.SetMobilityModel("ns3::ConstantPositionMobilityModel");
+    mobility.SetPositionAllocator(gatewayAllocator);
+    mobility.Install(gateways);
+
+    // Create a netdevice for each gateway
+    phyHelper.SetDeviceType(LoraPhyHelper::GW);
+    macHelper.SetDeviceType(LorawanMacHelper::GW);
+    helper.Install(phyHelper, macHelper, gateways);
+
+    /************************
+     *  Create End Devices  *
+     ************************/
+
+    NodeContainer endDevices;
+    Ptr<UniformDiscPositionAllocator> disc = CreateObject<UniformDiscPositionAllocator>();
+    disc->SetRho(clusterRadius);
+    stream += disc->AssignStreams(stream);
+    Ptr<ListPositionAllocator> endDeviceAllocator = CreateObject<ListPositionAllocator>();
+    for (int i = 0; i < nDevices; i++)
+    {
+        int cluster = i % nGateways;
+        endDevices.Add(CreateObject<Node>(getClusterSystemId(cluster)));
+        Vector position = disc->GetNext();
+        position.x += cluster * gatewayDistance;
+        endDeviceAllocator->Add(position);
+    }
+
+    mobility.SetPositionAllocator(endDeviceAllocator);
+    mobility.Install(endDevices);
+
+    // Create the LoraNetDevices of the end devices
+    phyHelper.SetDeviceType(LoraPhyHelper::ED);
+    macHelper.SetDeviceType(LorawanMacHelper::ED_A);
+    helper.Install(phyHelper, macHelper, endDevices);
+
+    /**********************************************
+     *  Set up the end device's spreading factor  *
+     **********************************************/
+
+    LorawanMacHelper::SetSpreadingFactorsUp(endDevices, gateways, channel);
+
+    /*********************************************
+     *  Install applications on the end devices  *
+     *********************************************/
+
+    // All processes draw the initial delays of all devices, so that each
+    // device gets the same one as in a sequential simulation
+    Ptr<UniformRandomVariable> initialDelay = CreateObject<UniformRandomVariable>();
+    initialDelay->SetStream(stream);
+    for (uint32_t i = 0; i < endDevices.GetN(); i++)
+    {
+        Time appInitialDelay = Seconds(initialDelay->GetValue(0, appPeriodSeconds));
+
+        Ptr<Node> node = endDevices.Get(i);
+        if (node->GetSystemId() != systemId)
+        {
+            continue;
+        }
+
+        Ptr<PeriodicSender> app = CreateObject<PeriodicSender>();
+        app->SetInterval(Seconds(appPeriodSeconds));
+        app->SetInitialDelay(appInitialDelay);
+        app->SetPacketSize(23);
+        app->SetStartTime(Seconds(0));
+        app->SetStopTime(Seconds(simulationTime));
+        node->AddApplication(app);
+    }
+
+    /*****************************
+     *  Set up the distribution  *
+     *****************************/
+
+    if (systemCount > 1)
+    {
+        Time lookahead = channel->ComputeLookahead();
+        NS_LOG_INFO("System " << systemId << " uses a lookahead of " << lookahead);
+        channel->SetLookahead(lookahead);
+    }
+
+    ////////////////
+    // Simulation //
+    ////////////////
+
+    Time appStopTime = Seconds(simulationTime);
+    Simulator::Stop(appStopTime + Hours(1));
+
+    NS_LOG_INFO("Running simulation...");
+    Simulator::Run();
+
+    ///////////////////
+    // Print results //
+    ///////////////////
+
+    // All processes take part in the merge, then only the first one has
+    // the counts of the whole network
+    LoraPacketTracker& tracker = helper.GetPacketTracker();
+    tracker.MergeDistributedResults();
+
+    if (systemId == 0)
+    {
+        std::string prefix = test ? "TEST " : "";
+        std::cout << prefix << "Global MAC performance: "
+                  << tracker.CountMacPacketsGlobally(Seconds(0), appStopTime + Hours(1))
+                  << std::endl;
+        for (uint32_t i = 0; i < gateways.GetN(); i++)
+        {
+            int gatewayId = gateways.Get(i)->GetId();
+            std::cout << prefix << "Gateway " << gatewayId << " PHY performance: "
+                      << tracker.PrintPhyPacketsPerGw(Seconds(0),
+                                                      appStopTime + Hours(1),
+                                                      gatewayId)
+                      << std::endl;
+        }
+    }
+
+    Simulator::Destroy();
+
+    if (distributed)
+    {
+        MpiInterface::Disable();
+    }
+
+    return 0;
+}
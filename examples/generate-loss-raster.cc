@@ -0,0 +1,118 @@
+/*
+ * This program precomputes the loss between a gateway and each point of a
+ * region, and saves it to a raster file that can be used by a
+ * RasterPropagationLossModel in later simulations. The loss is given by the
+ * same log distance and correlated shadowing models used by the other
+ * examples, and shadowing values are drawn with the counter-based generator,
+ * so that the raster only depends on the seed, run number and stream.
+ */
+
+#include "ns3/boolean.h"
+#include "ns3/command-line.h"
+#include "ns3/constant-position-mobility-model.h"
+#include "ns3/correlated-shadowing-propagation-loss-model.h"
+#include "ns3/log.h"
+#include "ns3/propagation-loss-model.h"
+#include "ns3/raster-propagation-loss-model.h"
+
+#include <cmath>
+
+using namespace ns3;
+using namespace lorawan;
+
+NS_LOG_COMPONENT_DEFINE("GenerateLossRaster");
+
+int
+main(int argc, char* argv[])
+{
+    std::string filename = "loss.raster";
+    double gatewayX = 0;
+    double gatewayY = 0;
+    double gatewayZ = 15;
+    double deviceZ = 1.2;
+    double radius = 6000;
+    double resolution = 10;
+    uint32_t tileSize = 256;
+    bool pathLoss = true;
+    bool shadowing = true;
+    int64_t stream = 0;
+
+    CommandLine cmd(__FILE__);
+    cmd.AddValue("filename", "The raster file to write", filename);
+    cmd.AddValue("gatewayX", "The x coordinate of the gateway", gatewayX);
+    cmd.AddValue("gatewayY", "The y coordinate of the gateway", gatewayY);
+    cmd.AddValue("gatewayZ", "The height of the gateway", gatewayZ);
+    cmd.AddValue("deviceZ", "The height of the end devices", deviceZ);
+    cmd.AddValue("radius", "The half side of the square region around the gateway", radius);
+    cmd.AddValue("resolution", "The distance between samples, in meters", resolution);
+    cmd.AddValue("tileSize", "The number of samples on the side of a tile", tileSize);
+    cmd.AddValue("pathLoss", "Whether to include the log distance loss", pathLoss);
+    cmd.AddValue("shadowing", "Whether to include the correlated shadowing", shadowing);
+    cmd.AddValue("stream", "The stream of the shadowing model", stream);
+    cmd.Parse(argc, argv);
+
+    // Set up logging
+    LogComponentEnable("GenerateLossRaster", LOG_LEVEL_ALL);
+    LogComponentEnable("RasterPropagationLossModel", LOG_LEVEL_DEBUG);
+
+    /**********************
+     *  Create the model  *
+     **********************/
+
+    // The loss model chain, as in the other examples
+    Ptr<PropagationLossModel> loss;
+    if (pathLoss)
+    {
+        Ptr<LogDistancePropagationLossModel> logDistance =
+            CreateObject<LogDistancePropagationLossModel>();
+        logDistance->SetPathLossExponent(3.76);
+        logDistance->SetReference(1, 7.7);
+        loss = logDistance;
+    }
+    if (shadowing)
+    {
+        Ptr<CorrelatedShadowingPropagationLossModel> correlatedShadowing =
+            CreateObject<CorrelatedShadowingPropagationLossModel>();
+        correlatedShadowing->SetAttribute("CounterBased", BooleanValue(true));
+        correlatedShadowing->AssignStreams(stream);
+        if (loss)
+        {
+            loss->SetNext(correlatedShadowing);
+        }
+        else
+        {
+            loss = correlatedShadowing;
+        }
+    }
+    NS_ABORT_MSG_UNLESS(loss, "The raster needs at least a loss component");
+
+    /***********************
+     *  Write the raster  *
+     ***********************/
+
+    RasterPropagationLossModel::RasterInfo info;
+    info.originX = gatewayX - radius;
+    info.originY = gatewayY - radius;
+    info.resolution = resolution;
+    info.width = std::floor(2 * radius / resolution) + 1;
+    info.height = info.width;
+    info.tileSize = tileSize;
+    info.hasAnchor = true;
+    info.anchor = Vector(gatewayX, gatewayY, gatewayZ);
+
+    Ptr<ConstantPositionMobilityModel> gateway = CreateObject<ConstantPositionMobilityModel>();
+    gateway->SetPosition(info.anchor);
+    Ptr<ConstantPositionMobilityModel> device = CreateObject<ConstantPositionMobilityModel>();
+
+    NS_LOG_INFO("Writing a " << info.width << "x" << info.height << " raster to " << filename);
+
+    // Compute the loss of uplink transmissions, from each point to the gateway
+    RasterPropagationLossModel::WriteRaster(filename, info, [&](double x, double y) {
+        device->SetPosition(Vector(x, y, deviceZ));
+        return -loss->CalcRxPower(0, device, gateway);
+    });
+
+    NS_LOG_INFO("Done");
+
+    return 0;
+}
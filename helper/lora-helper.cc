@@ -63,33 +63,49 @@ LoraHelper::Install(const LoraPhyHelper& phyHelper,
         device->SetPhy(phy);
         NS_LOG_DEBUG("Done creating the PHY");
 
+        // Give gateways one PHY per sector
+        if (phyHelper.GetDeviceType().IsChildOf(GatewayLoraPhy::GetTypeId()))
+        {
+            for (std::size_t k = 0; k < m_gatewayAntennas.size(); k++)
+            {
+                Ptr<LoraPhy> sectorPhy = phy;
+                if (k > 0)
+                {
+                    sectorPhy = phyHelper.Create(node, device);
+                    device->AddPhy(sectorPhy);
+                }
+                sectorPhy->SetAntenna(m_gatewayAntennas[k]);
+            }
+        }
+
         // Connect Trace Sources if necessary
-        if (m_packetTracker)
+        for (uint32_t k = 0; m_packetTracker && k < device->GetNPhys(); k++)
         {
+            Ptr<LoraPhy> devicePhy = device->GetPhy(k);
             if (phyHelper.GetDeviceType() == TypeId::LookupByName("ns3::SimpleEndDeviceLoraPhy"))
             {
-                phy->TraceConnectWithoutContext(
+                devicePhy->TraceConnectWithoutContext(
                     "StartSending",
                     MakeCallback(&LoraPacketTracker::TransmissionCallback, m_packetTracker));
             }
-            else if (phyHelper.GetDeviceType() == TypeId::LookupByName("ns3::SimpleGatewayLoraPhy"))
+            else if (phyHelper.GetDeviceType().IsChildOf(GatewayLoraPhy::GetTypeId()))
             {
-                phy->TraceConnectWithoutContext(
+                devicePhy->TraceConnectWithoutContext(
                     "StartSending",
                     MakeCallback(&LoraPacketTracker::TransmissionCallback, m_packetTracker));
-                phy->TraceConnectWithoutContext(
+                devicePhy->TraceConnectWithoutContext(
                     "ReceivedPacket",
                     MakeCallback(&LoraPacketTracker::PacketReceptionCallback, m_packetTracker));
-                phy->TraceConnectWithoutContext(
+                devicePhy->TraceConnectWithoutContext(
                     "LostPacketBecauseInterference",
                     MakeCallback(&LoraPacketTracker::InterferenceCallback, m_packetTracker));
-                phy->TraceConnectWithoutContext(
+                devicePhy->TraceConnectWithoutContext(
                     "LostPacketBecauseNoMoreReceivers",
                     MakeCallback(&LoraPacketTracker::NoMoreReceiversCallback, m_packetTracker));
-                phy->TraceConnectWithoutContext(
+                devicePhy->TraceConnectWithoutContext(
                     "LostPacketBecauseUnderSensitivity",
                     MakeCallback(&LoraPacketTracker::UnderSensitivityCallback, m_packetTracker));
-                phy->TraceConnectWithoutContext(
+                devicePhy->TraceConnectWithoutContext(
                     "NoReceptionBecauseTransmitting",
                     MakeCallback(&LoraPacketTracker::LostBecauseTxCallback, m_packetTracker));
             }
@@ -115,7 +131,7 @@ LoraHelper::Install(const LoraPhyHelper& phyHelper,
                     MakeCallback(&LoraPacketTracker::RequiredTransmissionsCallback,
                                  m_packetTracker));
             }
-            else if (phyHelper.GetDeviceType() == TypeId::LookupByName("ns3::SimpleGatewayLoraPhy"))
+            else if (phyHelper.GetDeviceType().IsChildOf(GatewayLoraPhy::GetTypeId()))
             {
                 mac->TraceConnectWithoutContext(
                     "SentNewPacket",
@@ -141,6 +157,14 @@ LoraHelper::Install(const LoraPhyHelper& phy, const LorawanMacHelper& mac, Ptr<N
     return Install(phy, mac, NodeContainer(node));
 }
 
+void
+LoraHelper::AddGatewayAntenna(Ptr<AntennaModel> antenna)
+{
+    NS_LOG_FUNCTION(this << antenna);
+
+    m_gatewayAntennas.push_back(antenna);
+}
+
 void
 LoraHelper::EnablePacketTracking()
 {
@@ -30,6 +30,7 @@
 #include "ns3/node-container.h"
 
 #include <ctime>
+#include <vector>
 
 namespace ns3
 {
@@ -75,6 +76,20 @@ class LoraHelper
                                        const LorawanMacHelper& macHelper,
                                        Ptr<Node> node) const;
 
+    /**
+     * Add an antenna to the gateways installed afterwards.
+     *
+     * Each gateway gets a PHY for each antenna added with this method, so
+     * that, for instance, three ParabolicAntennaModel instances with a beam
+     * width of 120 degrees and different orientations make gateways with three
+     * independent sectors. The first PHY is the one used for transmission.
+     * Antenna models are shared among the gateways. If no antenna is added,
+     * gateways get a single PHY with no antenna model.
+     *
+     * \param antenna The antenna model of a sector.
+     */
+    void AddGatewayAntenna(Ptr<AntennaModel> antenna);
+
     /**
      * Enable tracking of packets via trace sources.
      *
@@ -134,6 +149,8 @@ class LoraHelper
 
     Time m_lastPhyPerformanceUpdate;
     Time m_lastGlobalPerformanceUpdate;
+
+    std::vector<Ptr<AntennaModel>> m_gatewayAntennas; //!< The antennas of the gateway sectors
 };
 
 } // namespace lorawan
@@ -20,11 +20,19 @@
 #include "lora-packet-tracker.h"
 
 #include "ns3/log.h"
+#include "ns3/lora-origin-tag.h"
 #include "ns3/lorawan-mac-header.h"
 #include "ns3/simulator.h"
 
+#ifdef NS3_MPI
+#include "ns3/mpi-interface.h"
+
+#include <mpi.h>
+#endif
+
 #include <fstream>
 #include <iostream>
+#include <tuple>
 
 namespace ns3
 {
@@ -91,16 +99,8 @@ LoraPacketTracker::MacGwReceptionCallback(Ptr<const Packet> packet)
                     << " at the MAC layer of gateway " << Simulator::GetContext());
 
         // Find the received packet in the m_macPacketTracker
-        auto it = m_macPacketTracker.find(packet);
-        if (it != m_macPacketTracker.end())
-        {
-            (*it).second.receptionTimes.insert(
-                std::pair<int, Time>(Simulator::GetContext(), Simulator::Now()));
-        }
-        else
-        {
-            NS_ABORT_MSG("Packet not found in tracker");
-        }
+        GetMacPacketStatus(packet).receptionTimes.insert(
+            std::pair<int, Time>(Simulator::GetContext(), Simulator::Now()));
     }
 }
 
@@ -132,8 +132,9 @@ LoraPacketTracker::PacketReceptionCallback(Ptr<const Packet> packet, uint32_t gw
         // Remove the successfully received packet from the list of sent ones
         NS_LOG_INFO("PHY packet " << packet << " was successfully received at gateway " << gwId);
 
-        auto it = m_packetTracker.find(packet);
-        (*it).second.outcomes.insert(std::pair<int, enum PhyPacketOutcome>(gwId, RECEIVED));
+        // A gateway with several sectors received the packet if any of them
+        // did, even if another one reported a failure first
+        GetPacketStatus(packet).outcomes[gwId] = RECEIVED;
     }
 }
 
@@ -144,8 +145,8 @@ LoraPacketTracker::InterferenceCallback(Ptr<const Packet> packet, uint32_t gwId)
     {
         NS_LOG_INFO("PHY packet " << packet << " was interfered at gateway " << gwId);
 
-        auto it = m_packetTracker.find(packet);
-        (*it).second.outcomes.insert(std::pair<int, enum PhyPacketOutcome>(gwId, INTERFERED));
+        GetPacketStatus(packet).outcomes.insert(
+            std::pair<int, enum PhyPacketOutcome>(gwId, INTERFERED));
     }
 }
 
@@ -156,8 +157,7 @@ LoraPacketTracker::NoMoreReceiversCallback(Ptr<const Packet> packet, uint32_t gw
     {
         NS_LOG_INFO("PHY packet " << packet << " was lost because no more receivers at gateway "
                                   << gwId);
-        auto it = m_packetTracker.find(packet);
-        (*it).second.outcomes.insert(
+        GetPacketStatus(packet).outcomes.insert(
             std::pair<int, enum PhyPacketOutcome>(gwId, NO_MORE_RECEIVERS));
     }
 }
@@ -170,8 +170,7 @@ LoraPacketTracker::UnderSensitivityCallback(Ptr<const Packet> packet, uint32_t g
         NS_LOG_INFO("PHY packet " << packet << " was lost because under sensitivity at gateway "
                                   << gwId);
 
-        auto it = m_packetTracker.find(packet);
-        (*it).second.outcomes.insert(
+        GetPacketStatus(packet).outcomes.insert(
             std::pair<int, enum PhyPacketOutcome>(gwId, UNDER_SENSITIVITY));
     }
 }
@@ -184,9 +183,49 @@ LoraPacketTracker::LostBecauseTxCallback(Ptr<const Packet> packet, uint32_t gwId
         NS_LOG_INFO("PHY packet " << packet << " was lost because of GW transmission at gateway "
                                   << gwId);
 
-        auto it = m_packetTracker.find(packet);
-        (*it).second.outcomes.insert(std::pair<int, enum PhyPacketOutcome>(gwId, LOST_BECAUSE_TX));
+        GetPacketStatus(packet).outcomes.insert(
+            std::pair<int, enum PhyPacketOutcome>(gwId, LOST_BECAUSE_TX));
+    }
+}
+
+PacketStatus&
+LoraPacketTracker::GetPacketStatus(Ptr<const Packet> packet)
+{
+    auto it = m_packetTracker.find(packet);
+    if (it == m_packetTracker.end())
+    {
+        NS_LOG_DEBUG("PHY packet " << packet << " was sent by another system");
+
+        PacketStatus status;
+        status.packet = packet;
+        status.senderId = 0;
+        status.sendTime = Time::Max();
+
+        it = m_packetTracker.insert(std::pair<Ptr<const Packet>, PacketStatus>(packet, status))
+                 .first;
+    }
+    return it->second;
+}
+
+MacPacketStatus&
+LoraPacketTracker::GetMacPacketStatus(Ptr<const Packet> packet)
+{
+    auto it = m_macPacketTracker.find(packet);
+    if (it == m_macPacketTracker.end())
+    {
+        NS_LOG_DEBUG("MAC packet " << packet << " was sent by another system");
+
+        MacPacketStatus status;
+        status.packet = packet;
+        status.senderId = 0;
+        status.sendTime = Time::Max();
+        status.receivedTime = Time::Max();
+
+        it = m_macPacketTracker
+                 .insert(std::pair<Ptr<const Packet>, MacPacketStatus>(packet, status))
+                 .first;
     }
+    return it->second;
 }
 
 bool
@@ -365,5 +404,176 @@ LoraPacketTracker::CountMacPacketsGloballyCpsr(Time startTime, Time stopTime)
     return std::to_string(sent) + " " + std::to_string(received);
 }
 
+void
+LoraPacketTracker::MergeDistributedResults()
+{
+    NS_LOG_FUNCTION(this);
+
+#ifdef NS3_MPI
+    if (!MpiInterface::IsEnabled() || MpiInterface::GetSize() < 2)
+    {
+        return;
+    }
+
+    // Each entry is serialized as a kind (0 for PHY, 1 for MAC and 2 for
+    // retransmission entries), the system the packet was sent from, its uid
+    // there and the fields of the entry. Uids are only unique within a
+    // system, so packets received from another one carry a LoraOriginTag.
+    enum EntryKind
+    {
+        PHY_ENTRY = 0,
+        MAC_ENTRY = 1,
+        RETRANSMISSION_ENTRY = 2
+    };
+
+    std::vector<uint64_t> local;
+    uint32_t systemId = MpiInterface::GetSystemId();
+    auto addKey = [&local, systemId](EntryKind kind, Ptr<const Packet> packet) {
+        LoraOriginTag tag(systemId, packet->GetUid());
+        packet->PeekPacketTag(tag);
+        local.insert(local.end(), {uint64_t(kind), tag.GetSystemId(), tag.GetPacketUid()});
+    };
+
+    for (const auto& [packet, status] : m_packetTracker)
+    {
+        addKey(PHY_ENTRY, packet);
+        local.insert(local.end(),
+                     {status.senderId,
+                      uint64_t(status.sendTime.GetTimeStep()),
+                      status.outcomes.size()});
+        for (const auto& [gwId, outcome] : status.outcomes)
+        {
+            local.insert(local.end(), {uint64_t(gwId), uint64_t(outcome)});
+        }
+    }
+    for (const auto& [packet, status] : m_macPacketTracker)
+    {
+        addKey(MAC_ENTRY, packet);
+        local.insert(local.end(),
+                     {status.senderId,
+                      uint64_t(status.sendTime.GetTimeStep()),
+                      uint64_t(status.receivedTime.GetTimeStep()),
+                      status.receptionTimes.size()});
+        for (const auto& [gwId, time] : status.receptionTimes)
+        {
+            local.insert(local.end(), {uint64_t(gwId), uint64_t(time.GetTimeStep())});
+        }
+    }
+    for (const auto& [packet, status] : m_reTransmissionTracker)
+    {
+        addKey(RETRANSMISSION_ENTRY, packet);
+        local.insert(local.end(),
+                     {uint64_t(status.firstAttempt.GetTimeStep()),
+                      uint64_t(status.finishTime.GetTimeStep()),
+                      status.reTxAttempts,
+                      status.successful});
+    }
+
+    // Gather all entries on system 0
+    MPI_Comm communicator = MpiInterface::GetCommunicator();
+    uint32_t size = MpiInterface::GetSize();
+    int localSize = local.size();
+    std::vector<int> sizes(size);
+    MPI_Gather(&localSize, 1, MPI_INT, sizes.data(), 1, MPI_INT, 0, communicator);
+
+    std::vector<int> offsets(size, 0);
+    for (uint32_t i = 1; i < size; i++)
+    {
+        offsets[i] = offsets[i - 1] + sizes[i - 1];
+    }
+    std::vector<uint64_t> all(systemId == 0 ? offsets.back() + sizes.back() : 0);
+    MPI_Gatherv(local.data(),
+                localSize,
+                MPI_UINT64_T,
+                all.data(),
+                sizes.data(),
+                offsets.data(),
+                MPI_UINT64_T,
+                0,
+                communicator);
+
+    if (systemId != 0)
+    {
+        return;
+    }
+
+    // Rebuild the trackers of system 0, merging the entries of the same
+    // packet: the sender's system knows when the packet was sent, while the
+    // receivers' systems know its outcomes
+    m_packetTracker.clear();
+    m_macPacketTracker.clear();
+    m_reTransmissionTracker.clear();
+    std::map<std::tuple<uint64_t, uint64_t, uint64_t>, Ptr<const Packet>> packets;
+    auto getPacket = [&packets](uint64_t kind, uint64_t origin, uint64_t uid) {
+        Ptr<const Packet>& packet = packets[{kind, origin, uid}];
+        if (!packet)
+        {
+            packet = Create<Packet>();
+        }
+        return packet;
+    };
+
+    std::size_t k = 0;
+    while (k < all.size())
+    {
+        uint64_t kind = all[k++];
+        Ptr<const Packet> packet = getPacket(kind, all[k], all[k + 1]);
+        k += 2;
+        switch (kind)
+        {
+        case PHY_ENTRY: {
+            PacketStatus& status = GetPacketStatus(packet);
+            uint32_t senderId = all[k++];
+            Time sendTime = TimeStep(all[k++]);
+            if (sendTime < status.sendTime)
+            {
+                status.senderId = senderId;
+                status.sendTime = sendTime;
+            }
+            uint64_t n = all[k++];
+            for (uint64_t o = 0; o < n; o++, k += 2)
+            {
+                status.outcomes.insert(
+                    std::pair<int, enum PhyPacketOutcome>(all[k], PhyPacketOutcome(all[k + 1])));
+            }
+            break;
+        }
+        case MAC_ENTRY: {
+            MacPacketStatus& status = GetMacPacketStatus(packet);
+            uint32_t senderId = all[k++];
+            Time sendTime = TimeStep(all[k++]);
+            if (sendTime < status.sendTime)
+            {
+                status.senderId = senderId;
+                status.sendTime = sendTime;
+            }
+            status.receivedTime = std::min(status.receivedTime, Time(TimeStep(all[k++])));
+            uint64_t n = all[k++];
+            for (uint64_t o = 0; o < n; o++, k += 2)
+            {
+                status.receptionTimes.insert(std::pair<int, Time>(all[k], TimeStep(all[k + 1])));
+            }
+            break;
+        }
+        case RETRANSMISSION_ENTRY: {
+            RetransmissionStatus status;
+            status.firstAttempt = TimeStep(all[k++]);
+            status.finishTime = TimeStep(all[k++]);
+            status.reTxAttempts = all[k++];
+            status.successful = all[k++];
+            m_reTransmissionTracker.insert(
+                std::pair<Ptr<const Packet>, RetransmissionStatus>(packet, status));
+            break;
+        }
+        default:
+            NS_FATAL_ERROR("Invalid tracker entry kind " << kind);
+        }
+    }
+
+    NS_LOG_INFO("Merged " << m_packetTracker.size() << " PHY and " << m_macPacketTracker.size()
+                          << " MAC packets from " << size << " systems");
+#endif
+}
+
 } // namespace lorawan
 } // namespace ns3
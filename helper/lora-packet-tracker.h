@@ -158,7 +158,40 @@ class LoraPacketTracker
      */
     std::string CountMacPacketsGloballyCpsr(Time startTime, Time stopTime);
 
+    /**
+     * Merge the packets tracked by all the systems of a distributed
+     * simulation into the tracker of system 0.
+     *
+     * In a distributed simulation, each system only sees the packets sent and
+     * received by its own nodes, and a packet received from another system
+     * has an unknown send time (Time::Max()) until it is merged with the
+     * entry of its sender. Entries are matched by the system the packet was
+     * sent from and its uid there (see LoraOriginTag), since uids are only
+     * unique within a system. This must be called by all systems after the
+     * simulation ends, and the counting functions are then only meaningful
+     * on system 0. It does nothing if the simulation is not distributed.
+     */
+    void MergeDistributedResults();
+
   private:
+    /**
+     * Find the PHY entry of a packet, creating one with an unknown sender and
+     * send time if the packet was sent by another system.
+     *
+     * \param packet The packet.
+     * \return The entry.
+     */
+    PacketStatus& GetPacketStatus(Ptr<const Packet> packet);
+
+    /**
+     * Find the MAC entry of a packet, creating one with an unknown sender and
+     * send time if the packet was sent by another system.
+     *
+     * \param packet The packet.
+     * \return The entry.
+     */
+    MacPacketStatus& GetMacPacketStatus(Ptr<const Packet> packet);
+
     PhyPacketData m_packetTracker;
     MacPacketData m_macPacketTracker;
     RetransmissionData m_reTransmissionTracker;
@@ -70,6 +70,16 @@ LoraPhyHelper::Set(std::string name, const AttributeValue& v)
     m_phy.Set(name, v);
 }
 
+void
+LoraPhyHelper::SetGatewayType(std::string type)
+{
+    NS_LOG_FUNCTION(this << type);
+
+    NS_ASSERT_MSG(TypeId::LookupByName(type).IsChildOf(GatewayLoraPhy::GetTypeId()),
+                  type << " is not a GatewayLoraPhy");
+    m_phy.SetTypeId(type);
+}
+
 Ptr<LoraPhy>
 LoraPhyHelper::Create(Ptr<Node> node, Ptr<NetDevice> device) const
 {
@@ -81,7 +91,7 @@ LoraPhyHelper::Create(Ptr<Node> node, Ptr<NetDevice> device) const
 
     // Configuration is different based on the kind of device we have to create
     std::string typeId = m_phy.GetTypeId().GetName();
-    if (typeId == "ns3::SimpleGatewayLoraPhy")
+    if (m_phy.GetTypeId().IsChildOf(GatewayLoraPhy::GetTypeId()))
     {
         // Inform the channel of the presence of this PHY
         m_channel->Add(phy);
@@ -101,7 +111,7 @@ LoraPhyHelper::Create(Ptr<Node> node, Ptr<NetDevice> device) const
 
         for (auto& f : frequencies)
         {
-            phy->GetObject<SimpleGatewayLoraPhy>()->AddFrequency(f);
+            phy->GetObject<GatewayLoraPhy>()->AddFrequency(f);
         }
 
         int receptionPaths = 0;
@@ -109,7 +119,7 @@ LoraPhyHelper::Create(Ptr<Node> node, Ptr<NetDevice> device) const
         // int maxReceptionPaths = 8;
         while (receptionPaths < m_maxReceptionPaths)
         {
-            phy->GetObject<SimpleGatewayLoraPhy>()->AddReceptionPath();
+            phy->GetObject<GatewayLoraPhy>()->AddReceptionPath();
             receptionPaths++;
         }
     }
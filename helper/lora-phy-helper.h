@@ -72,6 +72,17 @@ class LoraPhyHelper
 
     TypeId GetDeviceType() const;
 
+    /**
+     * Set the type of the PHY layer of gateways.
+     *
+     * This must be called after SetDeviceType, and replaces the
+     * SimpleGatewayLoraPhy it selects for gateways.
+     *
+     * \param type The name of a subclass of GatewayLoraPhy, e.g.,
+     * ns3::Sx1302GatewayLoraPhy.
+     */
+    void SetGatewayType(std::string type);
+
     /**
      * Set an attribute of the underlying PHY object.
      *
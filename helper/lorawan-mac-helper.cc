@@ -181,24 +181,28 @@ LorawanMacHelper::ConfigureForAlohaRegion(Ptr<GatewayLorawanMac> gwMac) const
     ///////////////////////////////
     // ReceivePath configuration //
     ///////////////////////////////
-    Ptr<GatewayLoraPhy> gwPhy =
-        gwMac->GetDevice()->GetObject<LoraNetDevice>()->GetPhy()->GetObject<GatewayLoraPhy>();
+    Ptr<LoraNetDevice> device = gwMac->GetDevice()->GetObject<LoraNetDevice>();
 
     ApplyCommonAlohaConfigurations(gwMac);
 
-    if (gwPhy) // If cast is successful, there's a GatewayLoraPhy
+    // All the sectors of the gateway get the same configuration
+    for (uint32_t i = 0; i < device->GetNPhys(); i++)
     {
-        NS_LOG_DEBUG("Resetting reception paths");
-        gwPhy->ResetReceptionPaths();
-
-        int receptionPaths = 0;
-        int maxReceptionPaths = 1;
-        while (receptionPaths < maxReceptionPaths)
+        Ptr<GatewayLoraPhy> gwPhy = device->GetPhy(i)->GetObject<GatewayLoraPhy>();
+        if (gwPhy) // If cast is successful, there's a GatewayLoraPhy
         {
-            gwPhy->GetObject<GatewayLoraPhy>()->AddReceptionPath();
-            receptionPaths++;
+            NS_LOG_DEBUG("Resetting reception paths");
+            gwPhy->ResetReceptionPaths();
+
+            int receptionPaths = 0;
+            int maxReceptionPaths = 1;
+            while (receptionPaths < maxReceptionPaths)
+            {
+                gwPhy->GetObject<GatewayLoraPhy>()->AddReceptionPath();
+                receptionPaths++;
+            }
+            gwPhy->AddFrequency(868.1);
         }
-        gwPhy->AddFrequency(868.1);
     }
 }
 
@@ -278,32 +282,36 @@ LorawanMacHelper::ConfigureForEuRegion(Ptr<GatewayLorawanMac> gwMac) const
     ///////////////////////////////
     // ReceivePath configuration //
     ///////////////////////////////
-    Ptr<GatewayLoraPhy> gwPhy =
-        gwMac->GetDevice()->GetObject<LoraNetDevice>()->GetPhy()->GetObject<GatewayLoraPhy>();
+    Ptr<LoraNetDevice> device = gwMac->GetDevice()->GetObject<LoraNetDevice>();
 
     ApplyCommonEuConfigurations(gwMac);
 
-    if (gwPhy) // If cast is successful, there's a GatewayLoraPhy
+    // All the sectors of the gateway get the same configuration
+    for (uint32_t i = 0; i < device->GetNPhys(); i++)
     {
-        NS_LOG_DEBUG("Resetting reception paths");
-        gwPhy->ResetReceptionPaths();
+        Ptr<GatewayLoraPhy> gwPhy = device->GetPhy(i)->GetObject<GatewayLoraPhy>();
+        if (gwPhy) // If cast is successful, there's a GatewayLoraPhy
+        {
+            NS_LOG_DEBUG("Resetting reception paths");
+            gwPhy->ResetReceptionPaths();
 
-        std::vector<double> frequencies;
-        frequencies.push_back(868.1);
-        frequencies.push_back(868.3);
-        frequencies.push_back(868.5);
+            std::vector<double> frequencies;
+            frequencies.push_back(868.1);
+            frequencies.push_back(868.3);
+            frequencies.push_back(868.5);
 
-        for (auto& f : frequencies)
-        {
-            gwPhy->AddFrequency(f);
-        }
+            for (auto& f : frequencies)
+            {
+                gwPhy->AddFrequency(f);
+            }
 
-        int receptionPaths = 0;
-        int maxReceptionPaths = 8;
-        while (receptionPaths < maxReceptionPaths)
-        {
-            gwPhy->GetObject<GatewayLoraPhy>()->AddReceptionPath();
-            receptionPaths++;
+            int receptionPaths = 0;
+            int maxReceptionPaths = 8;
+            while (receptionPaths < maxReceptionPaths)
+            {
+                gwPhy->GetObject<GatewayLoraPhy>()->AddReceptionPath();
+                receptionPaths++;
+            }
         }
     }
 }
@@ -392,30 +400,34 @@ LorawanMacHelper::ConfigureForSingleChannelRegion(Ptr<GatewayLorawanMac> gwMac)
     ///////////////////////////////
     // ReceivePath configuration //
     ///////////////////////////////
-    Ptr<GatewayLoraPhy> gwPhy =
-        gwMac->GetDevice()->GetObject<LoraNetDevice>()->GetPhy()->GetObject<GatewayLoraPhy>();
+    Ptr<LoraNetDevice> device = gwMac->GetDevice()->GetObject<LoraNetDevice>();
 
     ApplyCommonEuConfigurations(gwMac);
 
-    if (gwPhy) // If cast is successful, there's a GatewayLoraPhy
+    // All the sectors of the gateway get the same configuration
+    for (uint32_t i = 0; i < device->GetNPhys(); i++)
     {
-        NS_LOG_DEBUG("Resetting reception paths");
-        gwPhy->ResetReceptionPaths();
+        Ptr<GatewayLoraPhy> gwPhy = device->GetPhy(i)->GetObject<GatewayLoraPhy>();
+        if (gwPhy) // If cast is successful, there's a GatewayLoraPhy
+        {
+            NS_LOG_DEBUG("Resetting reception paths");
+            gwPhy->ResetReceptionPaths();
 
-        std::vector<double> frequencies;
-        frequencies.push_back(868.1);
+            std::vector<double> frequencies;
+            frequencies.push_back(868.1);
 
-        for (auto& f : frequencies)
-        {
-            gwPhy->AddFrequency(f);
-        }
+            for (auto& f : frequencies)
+            {
+                gwPhy->AddFrequency(f);
+            }
 
-        int receptionPaths = 0;
-        int maxReceptionPaths = 8;
-        while (receptionPaths < maxReceptionPaths)
-        {
-            gwPhy->GetObject<GatewayLoraPhy>()->AddReceptionPath();
-            receptionPaths++;
+            int receptionPaths = 0;
+            int maxReceptionPaths = 8;
+            while (receptionPaths < maxReceptionPaths)
+            {
+                gwPhy->GetObject<GatewayLoraPhy>()->AddReceptionPath();
+                receptionPaths++;
+            }
         }
     }
 }
@@ -461,6 +473,14 @@ LorawanMacHelper::SetSpreadingFactorsUp(NodeContainer endDevices,
     NS_LOG_FUNCTION_NOARGS();
 
     std::vector<int> sfQuantity(7, 0);
+
+    std::vector<Ptr<MobilityModel>> gatewayPositions;
+    for (auto currentGw = gateways.Begin(); currentGw != gateways.End(); ++currentGw)
+    {
+        gatewayPositions.push_back((*currentGw)->GetObject<MobilityModel>());
+    }
+    std::vector<double> rxPowers;
+
     for (auto j = endDevices.Begin(); j != endDevices.End(); ++j)
     {
         Ptr<Node> object = *j;
@@ -473,25 +493,16 @@ LorawanMacHelper::SetSpreadingFactorsUp(NodeContainer endDevices,
             loraNetDevice->GetMac()->GetObject<ClassAEndDeviceLorawanMac>();
         NS_ASSERT(mac);
 
-        // Try computing the distance from each gateway and find the best one
-        Ptr<Node> bestGateway = gateways.Get(0);
-        Ptr<MobilityModel> bestGatewayPosition = bestGateway->GetObject<MobilityModel>();
-
-        // Assume devices transmit at 14 dBm
-        double highestRxPower = channel->GetRxPower(14, position, bestGatewayPosition);
+        // Compute the power received by each gateway and find the best one,
+        // assuming devices transmit at 14 dBm
+        channel->GetRxPower(14, position, gatewayPositions, rxPowers);
 
-        for (auto currentGw = gateways.Begin() + 1; currentGw != gateways.End(); ++currentGw)
+        double highestRxPower = rxPowers[0];
+        for (std::size_t currentGw = 1; currentGw < rxPowers.size(); ++currentGw)
         {
-            // Compute the power received from the current gateway
-            Ptr<Node> curr = *currentGw;
-            Ptr<MobilityModel> currPosition = curr->GetObject<MobilityModel>();
-            double currentRxPower = channel->GetRxPower(14, position, currPosition); // dBm
-
-            if (currentRxPower > highestRxPower)
+            if (rxPowers[currentGw] > highestRxPower)
             {
-                bestGateway = curr;
-                bestGatewayPosition = curr->GetObject<MobilityModel>();
-                highestRxPower = currentRxPower;
+                highestRxPower = rxPowers[currentGw];
             }
         }
 
@@ -17,9 +17,11 @@
 
 #include "building-penetration-loss.h"
 
+#include "ns3/boolean.h"
 #include "ns3/double.h"
 #include "ns3/log.h"
 #include "ns3/mobility-building-info.h"
+#include "ns3/node.h"
 
 #include <cmath>
 
@@ -38,11 +40,20 @@ BuildingPenetrationLoss::GetTypeId()
     static TypeId tid = TypeId("ns3::BuildingPenetrationLoss")
                             .SetParent<PropagationLossModel>()
                             .SetGroupName("Lora")
-                            .AddConstructor<BuildingPenetrationLoss>();
+                            .AddConstructor<BuildingPenetrationLoss>()
+                            .AddAttribute("FreezeLinkLoss",
+                                          "Whether the penetration loss of each link is drawn "
+                                          "once and then reused. Only suitable for static nodes.",
+                                          BooleanValue(false),
+                                          MakeBooleanAccessor(
+                                              &BuildingPenetrationLoss::SetFreezeLinkLoss,
+                                              &BuildingPenetrationLoss::GetFreezeLinkLoss),
+                                          MakeBooleanChecker());
     return tid;
 }
 
 BuildingPenetrationLoss::BuildingPenetrationLoss()
+    : m_freezeLinkLoss(false)
 {
     NS_LOG_FUNCTION_NOARGS();
 
@@ -55,6 +66,71 @@ BuildingPenetrationLoss::~BuildingPenetrationLoss()
     NS_LOG_FUNCTION_NOARGS();
 }
 
+void
+BuildingPenetrationLoss::SetFreezeLinkLoss(bool freeze)
+{
+    NS_LOG_FUNCTION(this << freeze);
+
+    m_freezeLinkLoss = freeze;
+    m_linkLoss.clear();
+}
+
+bool
+BuildingPenetrationLoss::GetFreezeLinkLoss() const
+{
+    return m_freezeLinkLoss;
+}
+
+uint32_t
+BuildingPenetrationLoss::GetNodeIndex(Ptr<MobilityModel> mobility) const
+{
+    Ptr<Node> node = mobility->GetObject<Node>();
+    if (node)
+    {
+        // Make room for the node here, so that the references returned by
+        // GetNodeInfo are not invalidated by a later call
+        uint32_t id = node->GetId();
+        if (id >= m_nodeInfo.size())
+        {
+            m_nodeInfo.resize(id + 1);
+        }
+        return id;
+    }
+
+    // Mobility models that are not aggregated to a node (e.g., in tests) are
+    // kept in a separate index space
+    auto it = m_detachedIndex.find(mobility);
+    if (it == m_detachedIndex.end())
+    {
+        it = m_detachedIndex.emplace(mobility, m_detachedInfo.size()).first;
+        m_detachedInfo.emplace_back();
+    }
+    return it->second | 0x80000000;
+}
+
+BuildingPenetrationLoss::NodeInfo&
+BuildingPenetrationLoss::GetNodeInfo(uint32_t index, Ptr<MobilityModel> mobility) const
+{
+    NodeInfo* info =
+        (index & 0x80000000) ? &m_detachedInfo[index & 0x7fffffff] : &m_nodeInfo[index];
+
+    // Only go through the MobilityBuildingInfo when the node moved, since
+    // finding out whether it is indoor requires a search of the buildings
+    Vector position = mobility->GetPosition();
+    if (!info->valid || position != info->position)
+    {
+        Ptr<MobilityBuildingInfo> buildingInfo = mobility->GetObject<MobilityBuildingInfo>();
+        NS_ASSERT_MSG(buildingInfo, "Mobility model has no MobilityBuildingInfo aggregated");
+
+        info->valid = true;
+        info->position = position;
+        info->indoor = buildingInfo->IsIndoor();
+        info->building = info->indoor ? buildingInfo->GetBuilding() : nullptr;
+    }
+
+    return *info;
+}
+
 double
 BuildingPenetrationLoss::DoCalcRxPower(double txPowerDbm,
                                        Ptr<MobilityModel> a,
@@ -62,9 +138,59 @@ BuildingPenetrationLoss::DoCalcRxPower(double txPowerDbm,
 {
     NS_LOG_FUNCTION(this << txPowerDbm << a << b);
 
-    Ptr<MobilityBuildingInfo> a1 = a->GetObject<MobilityBuildingInfo>();
-    Ptr<MobilityBuildingInfo> b1 = b->GetObject<MobilityBuildingInfo>();
+    uint32_t aIndex = GetNodeIndex(a);
+    uint32_t bIndex = GetNodeIndex(b);
 
+    return txPowerDbm - GetLinkLoss(aIndex, a, bIndex, b);
+}
+
+void
+BuildingPenetrationLoss::ApplyLoss(Ptr<MobilityModel> a,
+                                   const std::vector<Ptr<MobilityModel>>& receivers,
+                                   double* rxPowersDbm) const
+{
+    NS_LOG_FUNCTION(this << a << receivers.size());
+
+    if (receivers.empty())
+    {
+        return;
+    }
+
+    uint32_t aIndex = GetNodeIndex(a);
+    for (std::size_t k = 0; k < receivers.size(); k++)
+    {
+        uint32_t bIndex = GetNodeIndex(receivers[k]);
+        rxPowersDbm[k] -= GetLinkLoss(aIndex, a, bIndex, receivers[k]);
+    }
+}
+
+double
+BuildingPenetrationLoss::GetLinkLoss(uint32_t aIndex,
+                                     Ptr<MobilityModel> a,
+                                     uint32_t bIndex,
+                                     Ptr<MobilityModel> b) const
+{
+    if (!m_freezeLinkLoss)
+    {
+        return ComputeLoss(GetNodeInfo(aIndex, a), GetNodeInfo(bIndex, b));
+    }
+
+    // The loss is assumed to be reciprocal, so both directions share a value
+    uint64_t key = (static_cast<uint64_t>(std::min(aIndex, bIndex)) << 32) |
+                   std::max(aIndex, bIndex);
+    auto it = m_linkLoss.find(key);
+    if (it == m_linkLoss.end())
+    {
+        double loss = ComputeLoss(GetNodeInfo(aIndex, a), GetNodeInfo(bIndex, b));
+        it = m_linkLoss.emplace(key, loss).first;
+    }
+
+    return it->second;
+}
+
+double
+BuildingPenetrationLoss::ComputeLoss(NodeInfo& a, NodeInfo& b) const
+{
     // These are the components of the loss due to building penetration
     double externalWallLoss = 0;
     double tor1 = 0;
@@ -72,7 +198,7 @@ BuildingPenetrationLoss::DoCalcRxPower(double txPowerDbm,
     double gfh = 0;
 
     // Go through various cases in which a and b are indoors or outdoors
-    if ((b1->IsIndoor() && !a1->IsIndoor()))
+    if ((b.indoor && !a.indoor))
     {
         NS_LOG_INFO("Tx is outdoors and Rx is indoors");
 
@@ -81,7 +207,7 @@ BuildingPenetrationLoss::DoCalcRxPower(double txPowerDbm,
         tor3 = 0.6 * m_uniformRV->GetValue(0, 15);
         gfh = 0;
     }
-    else if ((!b1->IsIndoor() && a1->IsIndoor()))
+    else if ((!b.indoor && a.indoor))
     {
         NS_LOG_INFO("Rx is outdoors and Tx is indoors");
 
@@ -91,14 +217,14 @@ BuildingPenetrationLoss::DoCalcRxPower(double txPowerDbm,
         tor3 = 0.6 * m_uniformRV->GetValue(0, 15);
         gfh = 0;
     }
-    else if (!a1->IsIndoor() && !b1->IsIndoor())
+    else if (!a.indoor && !b.indoor)
     {
         NS_LOG_DEBUG("No penetration loss since both devices are outside");
     }
-    else if (a1->IsIndoor() && b1->IsIndoor())
+    else if (a.indoor && b.indoor)
     {
         // They are in the same building
-        if (a1->GetBuilding() == b1->GetBuilding())
+        if (a.building == b.building)
         {
             NS_LOG_INFO("Devices are in the same building");
             // Only internal wall loss
@@ -125,7 +251,7 @@ BuildingPenetrationLoss::DoCalcRxPower(double txPowerDbm,
 
     NS_LOG_DEBUG("Total loss due to building penetration: " << loss);
 
-    return txPowerDbm - loss;
+    return loss;
 }
 
 int64_t
@@ -186,22 +312,19 @@ BuildingPenetrationLoss::GetWallLossValue() const
 }
 
 double
-BuildingPenetrationLoss::GetWallLoss(Ptr<MobilityModel> b) const
+BuildingPenetrationLoss::GetWallLoss(NodeInfo& b) const
 {
-    NS_LOG_FUNCTION(this << b);
-
-    std::map<Ptr<MobilityModel>, int>::const_iterator it;
+    NS_LOG_FUNCTION(this);
 
     // Check whether the b device already has a wall loss value
-    it = m_wallLossMap.find(b);
-    if (it == m_wallLossMap.end())
+    if (b.wallLossValue < 0)
     {
-        // Create a random value and insert it on the map
-        m_wallLossMap[b] = GetWallLossValue();
-        NS_LOG_DEBUG("Inserted a new wall loss value: " << m_wallLossMap.find(b)->second);
+        // Create a random value and store it in the cache
+        b.wallLossValue = GetWallLossValue();
+        NS_LOG_DEBUG("Inserted a new wall loss value: " << b.wallLossValue);
     }
 
-    switch (m_wallLossMap.find(b)->second)
+    switch (b.wallLossValue)
     {
     case 0:
         return m_uniformRV->GetValue(4, 11);
@@ -216,21 +339,18 @@ BuildingPenetrationLoss::GetWallLoss(Ptr<MobilityModel> b) const
 }
 
 double
-BuildingPenetrationLoss::GetTor1(Ptr<MobilityModel> b) const
+BuildingPenetrationLoss::GetTor1(NodeInfo& b) const
 {
-    NS_LOG_FUNCTION(this << b);
-
-    std::map<Ptr<MobilityModel>, int>::const_iterator it;
+    NS_LOG_FUNCTION(this);
 
     // Check whether the b device already has a p value
-    it = m_pMap.find(b);
-    if (it == m_pMap.end())
+    if (b.pValue < 0)
     {
-        // Create a random p value and insert it on the map
-        m_pMap[b] = GetPValue();
-        NS_LOG_DEBUG("Inserted a new p value: " << m_pMap.find(b)->second);
+        // Create a random p value and store it in the cache
+        b.pValue = GetPValue();
+        NS_LOG_DEBUG("Inserted a new p value: " << b.pValue);
     }
-    return m_uniformRV->GetValue(4, 10) * m_pMap.find(b)->second;
+    return m_uniformRV->GetValue(4, 10) * b.pValue;
 }
 } // namespace lorawan
 } // namespace ns3
@@ -18,11 +18,16 @@
 #ifndef BUILDING_PENETRATION_LOSS_H
 #define BUILDING_PENETRATION_LOSS_H
 
+#include "ns3/building.h"
 #include "ns3/mobility-model.h"
 #include "ns3/propagation-loss-model.h"
 #include "ns3/random-variable-stream.h"
 #include "ns3/vector.h"
 
+#include <map>
+#include <unordered_map>
+#include <vector>
+
 namespace ns3
 {
 class MobilityModel;
@@ -32,6 +37,12 @@ namespace lorawan
 
 /**
  * A class implementing the TR 45.820 model for building losses
+ *
+ * The building class, indoor flag and building of each node are cached in a
+ * vector indexed by node ID, and only updated when the node moves. With the
+ * FreezeLinkLoss attribute set, the penetration loss of each link is drawn
+ * once and then reused, so that the model reduces to a table lookup: this is
+ * only meaningful when nodes do not move between buildings.
  */
 class BuildingPenetrationLoss : public PropagationLossModel
 {
@@ -42,7 +53,99 @@ class BuildingPenetrationLoss : public PropagationLossModel
 
     ~BuildingPenetrationLoss() override;
 
+    /**
+     * Set whether the penetration loss of each link is frozen after it is
+     * first computed.
+     *
+     * \param freeze Whether to freeze the loss of each link.
+     */
+    void SetFreezeLinkLoss(bool freeze);
+
+    /**
+     * Get whether the penetration loss of each link is frozen after it is
+     * first computed.
+     *
+     * \return Whether the loss of each link is frozen.
+     */
+    bool GetFreezeLinkLoss() const;
+
+    /**
+     * Apply the penetration loss of this model, without the models chained
+     * after it, to the links from a transmitter to several receivers.
+     *
+     * The result, including the sequence of random draws, is the same as
+     * calling CalcRxPower on a model without a next model for each receiver
+     * in order, but the cache entry of the transmitter is only looked up
+     * once.
+     *
+     * \param a The mobility model of the transmitter.
+     * \param receivers The mobility models of the receivers.
+     * \param [in,out] rxPowersDbm The received power at each receiver, in dBm.
+     */
+    void ApplyLoss(Ptr<MobilityModel> a,
+                   const std::vector<Ptr<MobilityModel>>& receivers,
+                   double* rxPowersDbm) const;
+
   private:
+    /**
+     * The cached building information of a node.
+     */
+    struct NodeInfo
+    {
+        bool valid = false;          //!< Whether the entry has been initialized
+        Vector position;             //!< The position the entry refers to
+        bool indoor = false;         //!< Whether the node is indoor
+        Ptr<Building> building;      //!< The building of the node, if indoor
+        int pValue = -1;             //!< The p value, or -1 if not drawn yet
+        int wallLossValue = -1;      //!< The wall loss class, or -1 if not drawn yet
+    };
+
+    /**
+     * Get the index of the cache entry of the node a mobility model belongs to.
+     *
+     * Mobility models aggregated to a node use the node ID, while the others
+     * are given an index with the most significant bit set.
+     *
+     * \param mobility The mobility model.
+     * \return The index of the cache entry.
+     */
+    uint32_t GetNodeIndex(Ptr<MobilityModel> mobility) const;
+
+    /**
+     * Get the cache entry of a node, updating its building information if the
+     * node moved since the last call.
+     *
+     * The returned reference stays valid until the next call to GetNodeIndex.
+     *
+     * \param index The index of the entry, as returned by GetNodeIndex.
+     * \param mobility The mobility model of the node.
+     * \return The up to date cache entry.
+     */
+    NodeInfo& GetNodeInfo(uint32_t index, Ptr<MobilityModel> mobility) const;
+
+    /**
+     * Compute the penetration loss between two nodes.
+     *
+     * \param a The cache entry of the first node.
+     * \param b The cache entry of the second node.
+     * \return The loss, in dB.
+     */
+    double ComputeLoss(NodeInfo& a, NodeInfo& b) const;
+
+    /**
+     * Get the penetration loss of a link, frozen or not.
+     *
+     * \param aIndex The index of the cache entry of the transmitter.
+     * \param a The mobility model of the transmitter.
+     * \param bIndex The index of the cache entry of the receiver.
+     * \param b The mobility model of the receiver.
+     * \return The loss, in dB.
+     */
+    double GetLinkLoss(uint32_t aIndex,
+                       Ptr<MobilityModel> a,
+                       uint32_t bIndex,
+                       Ptr<MobilityModel> b) const;
+
     /**
      * Perform the computation of the received power according to the current
      * model.
@@ -68,33 +171,44 @@ class BuildingPenetrationLoss : public PropagationLossModel
     int GetWallLossValue() const;
 
     /**
-     * Compute the wall loss associated to this mobility model
-     * \param b The mobility model associated to the node whose wall loss we need
-     * to compute.
+     * Compute the wall loss associated to this node
+     * \param b The cache entry of the node whose wall loss we need to compute.
      * \returns The power loss due to external walls.
      */
-    double GetWallLoss(Ptr<MobilityModel> b) const;
+    double GetWallLoss(NodeInfo& b) const;
 
     /**
      * Get the Tor1 value used in the TR 45.820 standard to account for internal
      * wall loss.
-     * \param b The mobility model of the node we want to compute the value for.
+     * \param b The cache entry of the node we want to compute the value for.
      * \returns The tor1 value.
      */
-    double GetTor1(Ptr<MobilityModel> b) const;
+    double GetTor1(NodeInfo& b) const;
 
     Ptr<UniformRandomVariable> m_uniformRV; //!< An uniform RV
 
     /**
-     * A map linking each mobility model to a p value
+     * The cached information of the nodes, indexed by node ID
+     */
+    mutable std::vector<NodeInfo> m_nodeInfo;
+
+    /**
+     * The cached information of mobility models not aggregated to a node
      */
-    mutable std::map<Ptr<MobilityModel>, int> m_pMap;
+    mutable std::vector<NodeInfo> m_detachedInfo;
+
+    /**
+     * The index in m_detachedInfo of each mobility model not aggregated to a
+     * node
+     */
+    mutable std::map<Ptr<MobilityModel>, uint32_t> m_detachedIndex;
+
+    bool m_freezeLinkLoss; //!< Whether the loss of each link is frozen
 
     /**
-     * A map linking each mobility model to a value deciding its external wall
-     * loss.
+     * The frozen loss of each link, indexed by the pair of node indices
      */
-    mutable std::map<Ptr<MobilityModel>, int> m_wallLossMap;
+    mutable std::unordered_map<uint64_t, double> m_linkLoss;
 };
 } // namespace lorawan
 } // namespace ns3
@@ -292,6 +292,9 @@ ClassAEndDeviceLorawanMac::TxFinished(Ptr<const Packet> packet)
     //                                              &ClassAEndDeviceLorawanMac::OpenSecondReceiveWindow,
     //                                              this);
 
+    // Let the PHY know when it will need to listen again
+    m_phy->GetObject<EndDeviceLoraPhy>()->ArmReceiveWindow(Simulator::Now() + m_receiveDelay1);
+
     // Switch the PHY to sleep
     m_phy->GetObject<EndDeviceLoraPhy>()->SwitchToSleep();
 }
@@ -304,6 +307,13 @@ ClassAEndDeviceLorawanMac::OpenFirstReceiveWindow()
     // Set Phy in Standby mode
     m_phy->GetObject<EndDeviceLoraPhy>()->SwitchToStandby();
 
+    // The PHY may sleep between the two windows
+    if (!m_secondReceiveWindow.IsExpired())
+    {
+        m_phy->GetObject<EndDeviceLoraPhy>()->ArmReceiveWindow(
+            Simulator::Now() + Simulator::GetDelayLeft(m_secondReceiveWindow));
+    }
+
     // Calculate the duration of a single symbol for the first receive window DR
     double tSym = pow(2, GetSfFromDataRate(GetFirstReceiveWindowDataRate())) /
                   GetBandwidthFromDataRate(GetFirstReceiveWindowDataRate());
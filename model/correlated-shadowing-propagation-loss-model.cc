@@ -17,9 +17,12 @@
 
 #include "correlated-shadowing-propagation-loss-model.h"
 
+#include "ns3/boolean.h"
 #include "ns3/double.h"
 #include "ns3/log.h"
+#include "ns3/rng-seed-manager.h"
 
+#include <array>
 #include <cmath>
 
 namespace ns3
@@ -31,6 +34,42 @@ NS_LOG_COMPONENT_DEFINE("CorrelatedShadowingPropagationLossModel");
 
 NS_OBJECT_ENSURE_REGISTERED(CorrelatedShadowingPropagationLossModel);
 
+namespace
+{
+
+/**
+ * The Philox4x32-10 counter-based random number generator.
+ *
+ * Reference: J. K. Salmon et al., "Parallel Random Numbers: As Easy as 1, 2,
+ * 3", Proceedings of the International Conference for High Performance
+ * Computing, Networking, Storage and Analysis (SC11), 2011.
+ *
+ * \param counter The counter.
+ * \param key The key.
+ * \return 128 random bits, as 4 words.
+ */
+std::array<uint32_t, 4>
+Philox4x32(std::array<uint32_t, 4> counter, std::array<uint32_t, 2> key)
+{
+    for (int round = 0; round < 10; round++)
+    {
+        if (round > 0)
+        {
+            key[0] += 0x9E3779B9;
+            key[1] += 0xBB67AE85;
+        }
+        uint64_t product0 = uint64_t(0xD2511F53) * counter[0];
+        uint64_t product1 = uint64_t(0xCD9E8D57) * counter[2];
+        counter = {uint32_t(product1 >> 32) ^ counter[1] ^ key[0],
+                   uint32_t(product1),
+                   uint32_t(product0 >> 32) ^ counter[3] ^ key[1],
+                   uint32_t(product0)};
+    }
+    return counter;
+}
+
+} // namespace
+
 TypeId
 CorrelatedShadowingPropagationLossModel::GetTypeId()
 {
@@ -45,11 +84,24 @@ CorrelatedShadowingPropagationLossModel::GetTypeId()
                 "uncorrelated",
                 DoubleValue(110.0),
                 MakeDoubleAccessor(&CorrelatedShadowingPropagationLossModel::m_correlationDistance),
-                MakeDoubleChecker<double>());
+                MakeDoubleChecker<double>())
+            .AddAttribute(
+                "CounterBased",
+                "Whether to compute shadowing values on demand with a counter-based "
+                "random number generator, instead of storing them for each square. "
+                "Values then only depend on the seed, run number and stream, and "
+                "not on the order of the queries. Set it before calling AssignStreams, "
+                "which only assigns a stream in this mode",
+                BooleanValue(false),
+                MakeBooleanAccessor(&CorrelatedShadowingPropagationLossModel::m_counterBased),
+                MakeBooleanChecker());
     return tid;
 }
 
 CorrelatedShadowingPropagationLossModel::CorrelatedShadowingPropagationLossModel()
+    : m_counterBased(false),
+      m_stream(0),
+      m_hasStream(false)
 {
 }
 
@@ -65,64 +117,202 @@ CorrelatedShadowingPropagationLossModel::DoCalcRxPower(double txPowerDbm,
      * its shadowing map.
      */
     Vector position = a->GetPosition();
+    std::pair<int, int> coordinates = GetSquare(position);
+    int xcoord = coordinates.first;
+    int ycoord = coordinates.second;
 
-    double x = position.x;
-    double y = position.y;
+    NS_LOG_DEBUG("x " << position.x << ", y " << position.y);
+    NS_LOG_DEBUG("xcoord " << xcoord << ", ycoord " << ycoord);
 
-    // Compute the coordinates of the grid square (i.e., round the raw position)
-    // (x > 0) - (x < 0) is the sign function
-    int xcoord =
-        ((x > 0) - (x < 0)) * ((std::fabs(x) + m_correlationDistance / 2) / m_correlationDistance);
-    int ycoord =
-        ((y > 0) - (y < 0)) * ((std::fabs(y) + m_correlationDistance / 2) / m_correlationDistance);
+    if (m_counterBased)
+    {
+        double loss = GetCounterBasedLoss(coordinates, b->GetPosition());
 
-    // Wrap coordinates up in a pair
-    std::pair<int, int> coordinates(xcoord, ycoord);
+        NS_LOG_INFO("Shadowing loss: " << loss);
 
-    NS_LOG_DEBUG("x " << x << ", y " << y);
-    NS_LOG_DEBUG("xcoord " << xcoord << ", ycoord " << ycoord);
+        return txPowerDbm - loss;
+    }
 
     // Look for the computed coordinates in the shadowingGrid
-    std::map<std::pair<int, int>, Ptr<ShadowingMap>>::const_iterator it;
-
-    it = m_shadowingGrid.find(coordinates);
+    Ptr<ShadowingMap>& shadowingMap = m_shadowingGrid[GetKey(xcoord, ycoord)];
 
-    if (it == m_shadowingGrid.end()) // Did not find the coordinates
+    if (!shadowingMap) // Did not find the coordinates
     {
         // If this shadowing grid was not found, create it
         NS_LOG_DEBUG("Creating a new shadowing map to be used at coordinates "
                      << coordinates.first << " " << coordinates.second);
 
-        Ptr<ShadowingMap> shadowingMap =
-            Create<CorrelatedShadowingPropagationLossModel::ShadowingMap>();
-
-        m_shadowingGrid[coordinates] = shadowingMap;
+        shadowingMap = Create<CorrelatedShadowingPropagationLossModel::ShadowingMap>();
     }
     else
     {
         NS_LOG_DEBUG("This square already has its shadowingMap!");
     }
 
-    // Place the iterator on the coordinates
-    it = m_shadowingGrid.find(coordinates);
-
     // Get b's position in a's ShadowingMap
     CorrelatedShadowingPropagationLossModel::Position bPosition(b->GetPosition().x,
                                                                 b->GetPosition().y);
 
     // Use the map of the a MobilityModel to determine the value of shadowing
     // that corresponds to the position of the MobilityModel b.
-    double loss = it->second->GetLoss(bPosition);
+    double loss = shadowingMap->GetLoss(bPosition);
 
     NS_LOG_INFO("Shadowing loss: " << loss);
 
     return txPowerDbm - loss;
 }
 
+void
+CorrelatedShadowingPropagationLossModel::ApplyLoss(Ptr<MobilityModel> a,
+                                                   const std::vector<Ptr<MobilityModel>>& receivers,
+                                                   double* rxPowersDbm) const
+{
+    NS_LOG_FUNCTION(this << a << receivers.size());
+
+    // Without receivers, CalcRxPower would not have created a ShadowingMap
+    if (receivers.empty())
+    {
+        return;
+    }
+
+    std::pair<int, int> coordinates = GetSquare(a->GetPosition());
+
+    if (m_counterBased)
+    {
+        for (std::size_t k = 0; k < receivers.size(); k++)
+        {
+            rxPowersDbm[k] -= GetCounterBasedLoss(coordinates, receivers[k]->GetPosition());
+        }
+        return;
+    }
+
+    uint64_t key = GetKey(coordinates.first, coordinates.second);
+    Ptr<ShadowingMap>& shadowingMap = m_shadowingGrid[key];
+    if (!shadowingMap)
+    {
+        NS_LOG_DEBUG("Creating a new shadowing map to be used at coordinates "
+                     << coordinates.first << " " << coordinates.second);
+
+        shadowingMap = Create<CorrelatedShadowingPropagationLossModel::ShadowingMap>();
+    }
+
+    for (std::size_t k = 0; k < receivers.size(); k++)
+    {
+        Vector position = receivers[k]->GetPosition();
+        rxPowersDbm[k] -= shadowingMap->GetLoss(
+            CorrelatedShadowingPropagationLossModel::Position(position.x, position.y));
+    }
+}
+
+std::pair<int, int>
+CorrelatedShadowingPropagationLossModel::GetSquare(const Vector& position) const
+{
+    double x = position.x;
+    double y = position.y;
+
+    // Compute the coordinates of the grid square (i.e., round the raw position)
+    // (x > 0) - (x < 0) is the sign function
+    int xcoord =
+        ((x > 0) - (x < 0)) * ((std::fabs(x) + m_correlationDistance / 2) / m_correlationDistance);
+    int ycoord =
+        ((y > 0) - (y < 0)) * ((std::fabs(y) + m_correlationDistance / 2) / m_correlationDistance);
+
+    return std::make_pair(xcoord, ycoord);
+}
+
+uint64_t
+CorrelatedShadowingPropagationLossModel::GetKey(int32_t x, int32_t y)
+{
+    return (uint64_t(uint32_t(x)) << 32) | uint32_t(y);
+}
+
+double
+CorrelatedShadowingPropagationLossModel::GetCounterBasedLoss(std::pair<int, int> square,
+                                                             const Vector& position) const
+{
+    NS_LOG_FUNCTION(this << square.first << square.second << position);
+
+    // Get the square of the receiver, as ShadowingMap::GetLoss does
+    double x = position.x;
+    double y = position.y;
+    std::pair<int, int> receiverSquare = GetSquare(position);
+    int xcoord = receiverSquare.first;
+    int ycoord = receiverSquare.second;
+
+    double xmin = xcoord * m_correlationDistance - m_correlationDistance / 2;
+    double xmax = xcoord * m_correlationDistance + m_correlationDistance / 2;
+    double ymin = ycoord * m_correlationDistance - m_correlationDistance / 2;
+    double ymax = ycoord * m_correlationDistance + m_correlationDistance / 2;
+
+    // Vertex (i, j) is the lower left corner of square (i, j)
+    double q11 = GetVertexValue(square, xcoord, ycoord);
+    double q12 = GetVertexValue(square, xcoord, ycoord + 1);
+    double q21 = GetVertexValue(square, xcoord + 1, ycoord);
+    double q22 = GetVertexValue(square, xcoord + 1, ycoord + 1);
+
+    NS_LOG_DEBUG(q11 << " " << q12 << " " << q21 << " " << q22 << " ");
+
+    return ShadowingMap::Interpolate(x,
+                                     y,
+                                     xmin,
+                                     xmax,
+                                     ymin,
+                                     ymax,
+                                     q11,
+                                     q12,
+                                     q21,
+                                     q22,
+                                     m_correlationDistance);
+}
+
+double
+CorrelatedShadowingPropagationLossModel::GetVertexValue(std::pair<int, int> square,
+                                                        int xcoord,
+                                                        int ycoord) const
+{
+    // Take an automatic stream on first use, like a random variable would,
+    // so that models in the default stored mode do not consume one
+    if (!m_hasStream)
+    {
+        m_stream = RngSeedManager::GetNextStreamIndex();
+        m_hasStream = true;
+    }
+
+    // The counter identifies the value, while the key identifies the sequence
+    std::array<uint32_t, 4> counter = {uint32_t(square.first),
+                                       uint32_t(square.second),
+                                       uint32_t(xcoord),
+                                       uint32_t(ycoord)};
+    uint64_t seed = (uint64_t(RngSeedManager::GetSeed()) << 32) ^ RngSeedManager::GetRun();
+    uint64_t stream = m_stream ^ (seed * 0x9E3779B97F4A7C15);
+    std::array<uint32_t, 2> key = {uint32_t(stream), uint32_t(stream >> 32)};
+
+    std::array<uint32_t, 4> bits = Philox4x32(counter, key);
+
+    // Turn the bits into two uniform values in (0, 1] and [0, 1), with 53
+    // bits each, and then into a normal value with the Box-Muller transform
+    double u1 = ((((uint64_t(bits[0]) << 32) | bits[1]) >> 11) + 1) * 0x1.0p-53;
+    double u2 = (((uint64_t(bits[2]) << 32) | bits[3]) >> 11) * 0x1.0p-53;
+    double normal = std::sqrt(-2 * std::log(u1)) * std::cos(2 * M_PI * u2);
+
+    // Same distribution as the values drawn by ShadowingMap (variance 16)
+    return 4 * normal;
+}
+
 int64_t
 CorrelatedShadowingPropagationLossModel::DoAssignStreams(int64_t stream)
 {
-    return 0;
+    NS_LOG_FUNCTION(this << stream);
+
+    // Shadowing maps draw from their own random variables, so a stream is
+    // only used in counter-based mode
+    if (!m_counterBased)
+    {
+        return 0;
+    }
+    m_stream = (1ULL << 63) + stream;
+    m_hasStream = true;
+    return 1;
 }
 
 /*********************************
@@ -136,6 +326,9 @@ const double CorrelatedShadowingPropagationLossModel::ShadowingMap::m_kInv[4][4]
     {-0.0415206295795327, -0.366414485833771, 1.27968707244633, -0.366414485833771},
     {-0.366414485833771, -0.0415206295795327, -0.366414485833771, 1.27968707244633}};
 
+// Positions closer than 10 cm share the same shadowing value
+const double CorrelatedShadowingPropagationLossModel::ShadowingMap::m_resolution = 0.1;
+
 CorrelatedShadowingPropagationLossModel::ShadowingMap::ShadowingMap()
     : m_correlationDistance(110)
 {
@@ -159,11 +352,12 @@ CorrelatedShadowingPropagationLossModel::ShadowingMap::GetLoss(
 {
     NS_LOG_FUNCTION(this << position.x << position.y);
 
-    // Verify whether this position is already in the shadowingMap. Since the
-    // Position implementation overloads the == operator, this comparison
-    // between doubles is ok and we can use std::map's find function.
-    std::map<CorrelatedShadowingPropagationLossModel::Position, double>::const_iterator it;
-    it = m_shadowingMap.find(position);
+    // Verify whether this position is already in the shadowingMap. Positions
+    // are rounded to the map's resolution, so that the same value is returned
+    // for positions that only differ because of floating point errors.
+    uint64_t key = GetKey(std::lround(position.x / m_resolution),
+                          std::lround(position.y / m_resolution));
+    auto it = m_shadowingMap.find(key);
 
     // If it's not found (i.e, if find returns the end of the map), we need to
     // generate the value at the specified position.
@@ -177,84 +371,107 @@ CorrelatedShadowingPropagationLossModel::ShadowingMap::GetLoss(
         int ycoord = ((y > 0) - (y < 0)) *
                      ((std::fabs(y) + m_correlationDistance / 2) / m_correlationDistance);
 
-        // Verify whether there already are the 4 surrounding positions in the
-        // map
         double xmin = xcoord * m_correlationDistance - m_correlationDistance / 2;
         double xmax = xcoord * m_correlationDistance + m_correlationDistance / 2;
         double ymin = ycoord * m_correlationDistance - m_correlationDistance / 2;
         double ymax = ycoord * m_correlationDistance + m_correlationDistance / 2;
 
-        CorrelatedShadowingPropagationLossModel::Position lowerLeft(xmin, ymin);
-        CorrelatedShadowingPropagationLossModel::Position upperLeft(xmin, ymax);
-        CorrelatedShadowingPropagationLossModel::Position lowerRight(xmax, ymin);
-        CorrelatedShadowingPropagationLossModel::Position upperRight(xmax, ymax);
-
         NS_LOG_DEBUG("Generating a new shadowing value in the following quadrant:");
         NS_LOG_DEBUG("xmin " << xmin << ", xmax " << xmax << ", ymin " << ymin << ", ymax "
                              << ymax);
 
-        // Use the map's insert method to insert the coordinates of the 4
-        // surrounding positions (if they are already there, they won't be
-        // substituted thanks to the map's implementation).
-        // TODO: Avoid useless generation of ShadowingMap values. This can be
-        // done by performing some checks (and not leveraging the map
-        // implementation)
-        double q11 = m_shadowingValue->GetValue();
+        // Get the values at the 4 surrounding vertices, which may have been
+        // generated for a neighbouring square. Vertex (i, j) is the lower left
+        // corner of square (i, j).
+        double q11 = GetVertexValue(xcoord, ycoord);
         NS_LOG_DEBUG("Lower left corner: " << q11);
-        m_shadowingMap[lowerLeft] = q11;
-        double q12 = m_shadowingValue->GetValue();
+        double q12 = GetVertexValue(xcoord, ycoord + 1);
         NS_LOG_DEBUG("Upper left corner: " << q12);
-        m_shadowingMap[upperLeft] = q12;
-        double q21 = m_shadowingValue->GetValue();
+        double q21 = GetVertexValue(xcoord + 1, ycoord);
         NS_LOG_DEBUG("Lower right corner: " << q21);
-        m_shadowingMap[lowerRight] = q21;
-        double q22 = m_shadowingValue->GetValue();
+        double q22 = GetVertexValue(xcoord + 1, ycoord + 1);
         NS_LOG_DEBUG("Upper right corner: " << q22);
-        m_shadowingMap[upperRight] = q22;
 
         NS_LOG_DEBUG(q11 << " " << q12 << " " << q21 << " " << q22 << " ");
 
-        // The c matrix contains the positions of the 4 vertices
-        double c[2][4] = {{xmin, xmax, xmax, xmin}, {ymin, ymin, ymax, ymax}};
-
-        // For the following procedure, reference:
-        // S. Schlegel et al., "On the Interpolation of Data with Normally
-        // Distributed Uncertainty for Visualization", IEEE Transactions on
-        // Visualization and Computer Graphics, vol. 18, no. 12, Dec. 2012.
+        double shadowing = Interpolate(x,
+                                       y,
+                                       xmin,
+                                       xmax,
+                                       ymin,
+                                       ymax,
+                                       q11,
+                                       q12,
+                                       q21,
+                                       q22,
+                                       m_correlationDistance);
 
-        // Compute the phi coefficients
-        double phi1 = 0;
-        double phi2 = 0;
-        double phi3 = 0;
-        double phi4 = 0;
+        // Add the newly computed shadowing value to the shadowing map
+        it = m_shadowingMap.emplace(key, shadowing).first;
+        NS_LOG_DEBUG("Created new shadowing map: " << shadowing);
+    }
+    else
+    {
+        NS_LOG_DEBUG("Shadowing map for this location already exists");
+    }
 
-        for (int j = 0; j < 4; j++)
-        {
-            double distance = sqrt((c[0][j] - x) * (c[0][j] - x) + (c[1][j] - y) * (c[1][j] - y));
+    return it->second;
+}
 
-            NS_LOG_DEBUG("Distance: " << distance);
+double
+CorrelatedShadowingPropagationLossModel::ShadowingMap::GetVertexValue(int xcoord, int ycoord)
+{
+    auto [it, inserted] = m_vertices.emplace(GetKey(xcoord, ycoord), 0);
+    if (inserted)
+    {
+        it->second = m_shadowingValue->GetValue();
+    }
+    return it->second;
+}
 
-            double k = std::exp(-distance / m_correlationDistance);
-            phi1 = phi1 + m_kInv[0][j] * k;
-            phi2 = phi2 + m_kInv[1][j] * k;
-            phi3 = phi3 + m_kInv[2][j] * k;
-            phi4 = phi4 + m_kInv[3][j] * k;
-        }
+double
+CorrelatedShadowingPropagationLossModel::ShadowingMap::Interpolate(double x,
+                                                                  double y,
+                                                                  double xmin,
+                                                                  double xmax,
+                                                                  double ymin,
+                                                                  double ymax,
+                                                                  double q11,
+                                                                  double q12,
+                                                                  double q21,
+                                                                  double q22,
+                                                                  double correlationDistance)
+{
+    // The c matrix contains the positions of the 4 vertices
+    double c[2][4] = {{xmin, xmax, xmax, xmin}, {ymin, ymin, ymax, ymax}};
 
-        NS_LOG_DEBUG("Phi: " << phi1 << " " << phi2 << " " << phi3 << " " << phi4 << " ");
+    // For the following procedure, reference:
+    // S. Schlegel et al., "On the Interpolation of Data with Normally
+    // Distributed Uncertainty for Visualization", IEEE Transactions on
+    // Visualization and Computer Graphics, vol. 18, no. 12, Dec. 2012.
 
-        double shadowing = q11 * phi1 + q21 * phi2 + q22 * phi3 + q12 * phi4;
+    // Compute the phi coefficients
+    double phi1 = 0;
+    double phi2 = 0;
+    double phi3 = 0;
+    double phi4 = 0;
 
-        // Add the newly computed shadowing value to the shadowing map
-        m_shadowingMap[position] = shadowing;
-        NS_LOG_DEBUG("Created new shadowing map: " << shadowing);
-    }
-    else
+    for (int j = 0; j < 4; j++)
     {
-        NS_LOG_DEBUG("Shadowing map for this location already exists");
+        double distance = sqrt((c[0][j] - x) * (c[0][j] - x) + (c[1][j] - y) * (c[1][j] - y));
+
+        NS_LOG_DEBUG("Distance: " << distance);
+
+        double k = std::exp(-distance / correlationDistance);
+        phi1 = phi1 + m_kInv[0][j] * k;
+        phi2 = phi2 + m_kInv[1][j] * k;
+        phi3 = phi3 + m_kInv[2][j] * k;
+        phi4 = phi4 + m_kInv[3][j] * k;
     }
 
-    return m_shadowingMap[position];
+    NS_LOG_DEBUG("Phi: " << phi1 << " " << phi2 << " " << phi3 << " " << phi4 << " ");
+
+    return q11 * phi1 + q21 * phi2 + q22 * phi3 + q12 * phi4;
 }
 
 /*****************************
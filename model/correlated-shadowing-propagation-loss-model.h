@@ -23,6 +23,10 @@
 #include "ns3/random-variable-stream.h"
 #include "ns3/vector.h"
 
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
 namespace ns3
 {
 class MobilityModel;
@@ -65,9 +69,10 @@ class CorrelatedShadowingPropagationLossModel : public PropagationLossModel
          *  We can then interpolate the 4 values surrounding any point in space
          *  in order to get a correlated shadowing value. After generating this
          *  value, we will add it to the map so that we don't have to compute it
-         *  twice. Also, since interpolation is a deterministic operation, we are
-         *  guaranteed that, as long as the grid doesn't change, also two values
-         *  generated in the same square will be correlated.
+         *  twice. Each vertex is generated the first time one of the squares
+         *  around it is used, and is then shared by all of them, so that the
+         *  grid never changes and two values generated in neighbouring squares
+         *  are also correlated.
          */
         ShadowingMap();
 
@@ -80,13 +85,62 @@ class CorrelatedShadowingPropagationLossModel : public PropagationLossModel
          */
         double GetLoss(CorrelatedShadowingPropagationLossModel::Position position);
 
+        /**
+         * Interpolate the shadowing values at the 4 vertices of a grid square
+         * to get the shadowing at a point inside it.
+         *
+         * \param x The x coordinate of the point.
+         * \param y The y coordinate of the point.
+         * \param xmin The x coordinate of the left side of the square.
+         * \param xmax The x coordinate of the right side of the square.
+         * \param ymin The y coordinate of the lower side of the square.
+         * \param ymax The y coordinate of the upper side of the square.
+         * \param q11 The value at the lower left vertex.
+         * \param q12 The value at the upper left vertex.
+         * \param q21 The value at the lower right vertex.
+         * \param q22 The value at the upper right vertex.
+         * \param correlationDistance The correlation distance.
+         * \return The shadowing value at the point.
+         */
+        static double Interpolate(double x,
+                                  double y,
+                                  double xmin,
+                                  double xmax,
+                                  double ymin,
+                                  double ymax,
+                                  double q11,
+                                  double q12,
+                                  double q21,
+                                  double q22,
+                                  double correlationDistance);
+
       private:
         /**
-         * For each Position, this map gives a corresponding loss.
-         * The map contains a basic grid that is initialized at construction
-         * time, and then newly computed values are added as they are created.
+         * Get the shadowing value at a vertex of the grid, generating it if
+         * this is the first time it's used.
+         *
+         * \param xcoord The x index of the vertex.
+         * \param ycoord The y index of the vertex.
+         * \return The shadowing value.
+         */
+        double GetVertexValue(int xcoord, int ycoord);
+
+        /**
+         * The shadowing value at each vertex of the grid, keyed by the indices
+         * of the vertex (see GetKey).
+         */
+        std::unordered_map<uint64_t, double> m_vertices;
+
+        /**
+         * The loss at each position, keyed by the position rounded to a
+         * multiple of m_resolution (see GetKey).
+         */
+        std::unordered_map<uint64_t, double> m_shadowingMap;
+
+        /**
+         * The resolution of the positions in m_shadowingMap, in meters.
          */
-        std::map<CorrelatedShadowingPropagationLossModel::Position, double> m_shadowingMap;
+        static const double m_resolution;
 
         /**
          * The distance after which two samples are to be considered almost
@@ -114,6 +168,15 @@ class CorrelatedShadowingPropagationLossModel : public PropagationLossModel
      */
     CorrelatedShadowingPropagationLossModel();
 
+    /**
+     * Pack a pair of integer coordinates in a key for a hash map.
+     *
+     * \param x The first coordinate.
+     * \param y The second coordinate.
+     * \return The key.
+     */
+    static uint64_t GetKey(int32_t x, int32_t y);
+
     /**
      * Set the correlation distance for newly created ShadowingMap instances
      */
@@ -124,15 +187,84 @@ class CorrelatedShadowingPropagationLossModel : public PropagationLossModel
      */
     double GetCorrelationDistance();
 
+    /**
+     * Apply the shadowing of this model, without the models chained after
+     * it, to the links from a transmitter to several receivers.
+     *
+     * The result is the same as calling CalcRxPower on a model without a next
+     * model for each receiver in order, but the square of the transmitter and
+     * its ShadowingMap are only looked up once.
+     *
+     * \param a The mobility model of the transmitter.
+     * \param receivers The mobility models of the receivers.
+     * \param [in,out] rxPowersDbm The received power at each receiver, in dBm.
+     */
+    void ApplyLoss(Ptr<MobilityModel> a,
+                   const std::vector<Ptr<MobilityModel>>& receivers,
+                   double* rxPowersDbm) const;
+
   private:
     double DoCalcRxPower(double txPowerDbm,
                          Ptr<MobilityModel> a,
                          Ptr<MobilityModel> b) const override;
 
+    /**
+     * Get the coordinates of the square of the grid a position falls in.
+     *
+     * \param position The position.
+     * \return The coordinates of the square.
+     */
+    std::pair<int, int> GetSquare(const Vector& position) const;
+
     int64_t DoAssignStreams(int64_t stream) override;
 
+    /**
+     * Get the shadowing seen at a position from a square of the grid, without
+     * storing anything.
+     *
+     * \param square The coordinates of the square of the transmitter.
+     * \param position The position of the receiver.
+     * \return The shadowing value.
+     */
+    double GetCounterBasedLoss(std::pair<int, int> square, const Vector& position) const;
+
+    /**
+     * Get the shadowing value at a vertex of the grid, as seen from a square
+     * of the grid.
+     *
+     * The value is a function of the seed, run number and stream of the
+     * model, and of the coordinates of the square and vertex, obtained with a
+     * counter-based random number generator, so that it does not need to be
+     * stored to be consistent across calls.
+     *
+     * \param square The coordinates of the square of the transmitter.
+     * \param xcoord The x index of the vertex.
+     * \param ycoord The y index of the vertex.
+     * \return The shadowing value.
+     */
+    double GetVertexValue(std::pair<int, int> square, int xcoord, int ycoord) const;
+
     double m_correlationDistance; //!< The correlation distance for the ShadowingMap
 
+    /**
+     * Whether shadowing values are computed on demand with a counter-based
+     * random number generator, instead of being drawn and stored by a
+     * ShadowingMap for each square.
+     */
+    bool m_counterBased;
+
+    /**
+     * The stream of the counter-based random number generator. As with
+     * RandomVariableStream, automatic streams are the first 2^63 and
+     * assigned streams the last 2^63, so that they never share a key.
+     */
+    mutable uint64_t m_stream;
+
+    /**
+     * Whether m_stream was assigned or automatically taken on first use.
+     */
+    mutable bool m_hasStream;
+
     /**
      * Map linking a square to a ShadowingMap.
      * Each square of the shadowing grid has a corresponding ShadowingMap, and a
@@ -161,16 +293,17 @@ class CorrelatedShadowingPropagationLossModel : public PropagationLossModel
      *  |         |         |    '    |         |         |
      *  o---------o---------o---------o---------o---------o
      *
-     *  For each one of these coordinates, a ShadowingMap is computed. That is,
-     *  each one of the points belonging to the same square sees the same
-     *  shadowing for the points around it. This is one level of correlation for
-     *  the shadowing, i.e. close nodes transmitting to the same point will see
-     *  the same shadowing since they are using the same shadowing map.
-     *  Further, the ShadowingMap will be "smooth": when transmitting from point
-     *  a to points b and c, the shadowing experienced by b and c will be similar
-     *  if they are close (ideally, within a correlation distance).
+     *  For each one of these coordinates (packed with GetKey), a ShadowingMap
+     *  is computed. That is, each one of the points belonging to the same
+     *  square sees the same shadowing for the points around it. This is one
+     *  level of correlation for the shadowing, i.e. close nodes transmitting to
+     *  the same point will see the same shadowing since they are using the same
+     *  shadowing map. Further, the ShadowingMap will be "smooth": when
+     *  transmitting from point a to points b and c, the shadowing experienced
+     *  by b and c will be similar if they are close (ideally, within a
+     *  correlation distance).
      */
-    mutable std::map<std::pair<int, int>, Ptr<ShadowingMap>> m_shadowingGrid;
+    mutable std::unordered_map<uint64_t, Ptr<ShadowingMap>> m_shadowingGrid;
 };
 
 } // namespace lorawan
@@ -21,6 +21,7 @@
 
 #include "lora-tag.h"
 
+#include "ns3/enum.h"
 #include "ns3/log.h"
 #include "ns3/simulator.h"
 
@@ -50,6 +51,24 @@ EndDeviceLoraPhy::GetTypeId()
         TypeId("ns3::EndDeviceLoraPhy")
             .SetParent<LoraPhy>()
             .SetGroupName("lorawan")
+            .AddAttribute("InterferenceBookkeeping",
+                          "Which signals are recorded as interferers: all of them, or, "
+                          "while the device is in SLEEP or TX, only those that may "
+                          "overlap a reception in the next receive window",
+                          EnumValue(EndDeviceLoraPhy::ALL_SIGNALS),
+                          MakeEnumAccessor(&EndDeviceLoraPhy::m_bookkeeping),
+                          MakeEnumChecker(EndDeviceLoraPhy::ALL_SIGNALS,
+                                          "AllSignals",
+                                          EndDeviceLoraPhy::RECEIVE_WINDOWS,
+                                          "ReceiveWindows"))
+            .AddAttribute("MinReceiveDelay",
+                          "The minimum time between the end of a transmission and the "
+                          "opening of a receive window, used by the ReceiveWindows "
+                          "bookkeeping when no window is armed. This must not exceed "
+                          "the receive delays used by the MAC layer",
+                          TimeValue(Seconds(1)),
+                          MakeTimeAccessor(&EndDeviceLoraPhy::m_minReceiveDelay),
+                          MakeTimeChecker(Seconds(0)))
             .AddTraceSource("LostPacketBecauseWrongFrequency",
                             "Trace source indicating a packet "
                             "could not be correctly decoded because"
@@ -74,7 +93,10 @@ EndDeviceLoraPhy::GetTypeId()
 EndDeviceLoraPhy::EndDeviceLoraPhy()
     : m_state(SLEEP),
       m_frequency(868.1),
-      m_sf(7)
+      m_sf(7),
+      m_bookkeeping(ALL_SIGNALS),
+      m_minReceiveDelay(Seconds(1)),
+      m_receiveWindowStart(Seconds(0))
 {
 }
 
@@ -115,6 +137,14 @@ void
 EndDeviceLoraPhy::SetFrequency(double frequencyMHz)
 {
     m_frequency = frequencyMHz;
+
+    UpdateSubscription();
+}
+
+double
+EndDeviceLoraPhy::GetFrequency() const
+{
+    return m_frequency;
 }
 
 void
@@ -124,6 +154,8 @@ EndDeviceLoraPhy::SwitchToStandby()
 
     m_state = STANDBY;
 
+    UpdateSubscription();
+
     // Notify listeners of the state change
     for (auto i = m_listeners.begin(); i != m_listeners.end(); i++)
     {
@@ -140,6 +172,8 @@ EndDeviceLoraPhy::SwitchToRx()
 
     m_state = RX;
 
+    UpdateSubscription();
+
     // Notify listeners of the state change
     for (auto i = m_listeners.begin(); i != m_listeners.end(); i++)
     {
@@ -156,6 +190,8 @@ EndDeviceLoraPhy::SwitchToTx(double txPowerDbm)
 
     m_state = TX;
 
+    UpdateSubscription();
+
     // Notify listeners of the state change
     for (auto i = m_listeners.begin(); i != m_listeners.end(); i++)
     {
@@ -172,6 +208,8 @@ EndDeviceLoraPhy::SwitchToSleep()
 
     m_state = SLEEP;
 
+    UpdateSubscription();
+
     // Notify listeners of the state change
     for (auto i = m_listeners.begin(); i != m_listeners.end(); i++)
     {
@@ -179,6 +217,63 @@ EndDeviceLoraPhy::SwitchToSleep()
     }
 }
 
+void
+EndDeviceLoraPhy::UpdateSubscription()
+{
+    if (!m_channel)
+    {
+        return;
+    }
+
+    // We can only lock on packets in STANDBY, but packets arriving in RX can
+    // still interfere with the one we are receiving
+    if (m_state == STANDBY || m_state == RX)
+    {
+        m_channel->Subscribe(this, m_frequency);
+    }
+    else if (m_receiveWindowStart > Simulator::Now())
+    {
+        // Signals that start before the armed window opens may still be in
+        // the air when it does, on the frequency the window will use
+        m_channel->SubscribeToAllFrequencies(this);
+    }
+    else
+    {
+        m_channel->Unsubscribe(this);
+    }
+}
+
+void
+EndDeviceLoraPhy::ArmReceiveWindow(Time start)
+{
+    NS_LOG_FUNCTION(this << start);
+
+    m_receiveWindowStart = start;
+
+    UpdateSubscription();
+}
+
+bool
+EndDeviceLoraPhy::IsInterferenceRelevant(Time duration) const
+{
+    // While listening, any signal may interfere with a reception
+    if (m_bookkeeping == ALL_SIGNALS || m_state == STANDBY || m_state == RX)
+    {
+        return true;
+    }
+
+    // Otherwise, a reception can't start before the next receive window
+    // opens, so only signals still in the air at that time matter
+    Time now = Simulator::Now();
+    Time windowStart = now + m_minReceiveDelay;
+    if (m_receiveWindowStart >= now)
+    {
+        windowStart = std::min(windowStart, m_receiveWindowStart);
+    }
+
+    return now + duration > windowStart;
+}
+
 EndDeviceLoraPhy::State
 EndDeviceLoraPhy::GetState()
 {
@@ -142,6 +142,25 @@ class EndDeviceLoraPhy : public LoraPhy
         RX
     };
 
+    /**
+     * The signals an EndDeviceLoraPhy keeps track of as interferers.
+     */
+    enum InterferenceBookkeeping
+    {
+        /**
+         * All signals are recorded, whatever the state of the PHY.
+         */
+        ALL_SIGNALS,
+
+        /**
+         * While in SLEEP or TX, only signals that may still be in the air when
+         * the next receive window opens are recorded. Since the other ones
+         * can't overlap a reception, the outcome of receptions is the same as
+         * with ALL_SIGNALS.
+         */
+        RECEIVE_WINDOWS
+    };
+
     static TypeId GetTypeId();
 
     // Constructor and destructor
@@ -180,6 +199,13 @@ class EndDeviceLoraPhy : public LoraPhy
      */
     void SetFrequency(double frequencyMHz);
 
+    /**
+     * Get the frequency this EndDevice is listening on.
+     *
+     * \return The frequency [MHz] we are listening to.
+     */
+    double GetFrequency() const;
+
     /**
      * Set the Spreading Factor this EndDevice will listen for.
      *
@@ -214,6 +240,23 @@ class EndDeviceLoraPhy : public LoraPhy
      */
     void SwitchToSleep();
 
+    /**
+     * Inform the PHY of the time the next receive window opens.
+     *
+     * With the RECEIVE_WINDOWS bookkeeping, signals that end before the
+     * window opens are not recorded while the PHY is in SLEEP or TX. If no
+     * window is armed, or the armed one already opened, the next window is
+     * assumed to open no earlier than MinReceiveDelay from now.
+     *
+     * If the channel notifies end devices according to their subscriptions,
+     * the PHY stays subscribed to all frequencies while it waits for the
+     * window, so that signals that start before the window and overlap it
+     * still reach it.
+     *
+     * \param start The time the window opens.
+     */
+    void ArmReceiveWindow(Time start);
+
     /**
      * Add the input listener to the list of objects to be notified of PHY-level
      * events.
@@ -243,6 +286,22 @@ class EndDeviceLoraPhy : public LoraPhy
      */
     void SwitchToTx(double txPowerDbm);
 
+    /**
+     * Subscribe to the channel for our frequency if we are in a state in
+     * which we may receive packets, to all frequencies if a receive window
+     * is armed, or unsubscribe otherwise.
+     */
+    void UpdateSubscription();
+
+    /**
+     * Check whether an incoming signal needs to be recorded as an interferer,
+     * according to the bookkeeping mode and to the state of the PHY.
+     *
+     * \param duration The duration of the signal, which starts now.
+     * \return True if the signal may overlap a reception.
+     */
+    bool IsInterferenceRelevant(Time duration) const;
+
     /**
      * Trace source for when a packet is lost because it was using a SF different from
      * the one this EndDeviceLoraPhy was configured to listen for.
@@ -265,6 +324,16 @@ class EndDeviceLoraPhy : public LoraPhy
 
     uint8_t m_sf; //!< The Spreading Factor this device is listening for
 
+    InterferenceBookkeeping m_bookkeeping; //!< Which signals are recorded as interferers
+
+    /**
+     * The minimum time between the end of a transmission and the opening of
+     * a receive window.
+     */
+    Time m_minReceiveDelay;
+
+    Time m_receiveWindowStart; //!< The time the armed receive window opens
+
     /**
      * typedef for a list of EndDeviceLoraPhyListener
      */
@@ -526,27 +526,11 @@ EndDeviceLorawanMac::GetNextTransmissionDelay()
 
     //    Check duty cycle    //
 
-    // Pick a random channel to transmit on
-    std::vector<Ptr<LogicalLoraChannel>> logicalChannels;
-    logicalChannels =
-        m_channelHelper.GetEnabledChannelList(); // Use a separate list to do the shuffle
-    // logicalChannels = Shuffle (logicalChannels);
+    // Minimum waiting time over the enabled channels
+    Time waitingTime = m_channelHelper.GetMinWaitingTime();
 
-    Time waitingTime = Time::Max();
-
-    // Try every channel
-    std::vector<Ptr<LogicalLoraChannel>>::iterator it;
-    for (it = logicalChannels.begin(); it != logicalChannels.end(); ++it)
-    {
-        // Pointer to the current channel
-        Ptr<LogicalLoraChannel> logicalChannel = *it;
-        double frequency = logicalChannel->GetFrequency();
-
-        waitingTime = std::min(waitingTime, m_channelHelper.GetWaitingTime(logicalChannel));
-
-        NS_LOG_DEBUG("Waiting time before the next transmission in channel with frequecy "
-                     << frequency << " is = " << waitingTime.GetSeconds() << ".");
-    }
+    NS_LOG_DEBUG("Waiting time before the next transmission is = " << waitingTime.GetSeconds()
+                                                                   << ".");
 
     waitingTime = GetNextClassTransmissionDelay(waitingTime);
 
@@ -558,57 +542,16 @@ EndDeviceLorawanMac::GetChannelForTx()
 {
     NS_LOG_FUNCTION_NOARGS();
 
-    // Pick a random channel to transmit on
-    std::vector<Ptr<LogicalLoraChannel>> logicalChannels;
-    logicalChannels =
-        m_channelHelper.GetEnabledChannelList(); // Use a separate list to do the shuffle
-    logicalChannels = Shuffle(logicalChannels);
-
-    // Try every channel
-    std::vector<Ptr<LogicalLoraChannel>>::iterator it;
-    for (it = logicalChannels.begin(); it != logicalChannels.end(); ++it)
-    {
-        // Pointer to the current channel
-        Ptr<LogicalLoraChannel> logicalChannel = *it;
-        double frequency = logicalChannel->GetFrequency();
-
-        NS_LOG_DEBUG("Frequency of the current channel: " << frequency);
-
-        // Verify that we can send the packet
-        Time waitingTime = m_channelHelper.GetWaitingTime(logicalChannel);
-
-        NS_LOG_DEBUG("Waiting time for current channel = " << waitingTime.GetSeconds());
-
-        // Send immediately if we can
-        if (waitingTime == Seconds(0))
-        {
-            return *it;
-        }
-        else
-        {
-            NS_LOG_DEBUG("Packet cannot be immediately transmitted on "
-                         << "the current channel because of duty cycle limitations.");
-        }
-    }
-    return nullptr; // In this case, no suitable channel was found
-}
-
-std::vector<Ptr<LogicalLoraChannel>>
-EndDeviceLorawanMac::Shuffle(std::vector<Ptr<LogicalLoraChannel>> vector)
-{
-    NS_LOG_FUNCTION_NOARGS();
-
-    int size = vector.size();
+    // Pick a random channel among the ones that can be used right away
+    Ptr<LogicalLoraChannel> txChannel = m_channelHelper.GetRandomAvailableChannel(m_uniformRV);
 
-    for (int i = 0; i < size; ++i)
+    if (!txChannel)
     {
-        uint16_t random = std::floor(m_uniformRV->GetValue(0, size));
-        Ptr<LogicalLoraChannel> temp = vector.at(random);
-        vector.at(random) = vector.at(i);
-        vector.at(i) = temp;
+        NS_LOG_DEBUG("Packet cannot be immediately transmitted on any channel "
+                     << "because of duty cycle limitations.");
     }
 
-    return vector;
+    return txChannel; // Null if no suitable channel was found
 }
 
 /////////////////////////
@@ -783,17 +726,17 @@ EndDeviceLorawanMac::OnLinkAdrReq(uint8_t dataRate,
     if (channelMaskOk && dataRateOk && txPowerOk)
     {
         // Cycle over all channels in the list
-        for (uint32_t i = 0; i < m_channelHelper.GetChannelList().size(); i++)
+        for (int i = 0; i < channelListSize; i++)
         {
             if (std::find(enabledChannels.begin(), enabledChannels.end(), i) !=
                 enabledChannels.end())
             {
-                m_channelHelper.GetChannelList().at(i)->SetEnabledForUplink();
+                m_channelHelper.EnableChannel(i);
                 NS_LOG_DEBUG("Channel " << i << " enabled");
             }
             else
             {
-                m_channelHelper.GetChannelList().at(i)->DisableForUplink();
+                m_channelHelper.DisableChannel(i);
                 NS_LOG_DEBUG("Channel " << i << " disabled");
             }
         }
@@ -426,8 +426,8 @@ class EndDeviceLorawanMac : public LorawanMac
     struct LoraRetxParameters m_retxParams;
 
     /**
-     * An uniform random variable, used by the Shuffle method to randomly reorder
-     * the channel list.
+     * An uniform random variable, used to pick a random channel among the
+     * available ones.
      */
     Ptr<UniformRandomVariable> m_uniformRV;
 
@@ -443,13 +443,6 @@ class EndDeviceLorawanMac : public LorawanMac
     TracedCallback<uint8_t, bool, Time, Ptr<Packet>> m_requiredTxCallback;
 
   private:
-    /**
-     * Randomly shuffle a Ptr<LogicalLoraChannel> vector.
-     *
-     * Used to pick a random channel on which to send the packet.
-     */
-    std::vector<Ptr<LogicalLoraChannel>> Shuffle(std::vector<Ptr<LogicalLoraChannel>> vector);
-
     /**
      * Find the minimum waiting time before the next possible transmission.
      */
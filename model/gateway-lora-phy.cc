@@ -21,10 +21,16 @@
 
 #include "lora-tag.h"
 
+#include "ns3/abort.h"
+#include "ns3/double.h"
 #include "ns3/log-macros-enabled.h"
 #include "ns3/log.h"
 #include "ns3/simulator.h"
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
 namespace ns3
 {
 namespace lorawan
@@ -122,12 +128,28 @@ GatewayLoraPhy::GetTypeId()
             .AddTraceSource("OccupiedReceptionPaths",
                             "Number of currently occupied reception paths",
                             MakeTraceSourceAccessor(&GatewayLoraPhy::m_occupiedReceptionPaths),
-                            "ns3::TracedValueCallback::Int");
+                            "ns3::TracedValueCallback::Int")
+            .AddAttribute("InterferencePruningThreshold",
+                          "The power in dBm below which arriving signals are not "
+                          "tracked as interferers, but only accounted as background "
+                          "energy. It can't exceed the value given by "
+                          "GetMaxInterferencePruningThreshold (-148.5 dBm under the "
+                          "GOURSAUD collision matrix, and no pruning under ALOHA), so "
+                          "that a single pruned signal can't change the outcome of a "
+                          "reception. Several pruned signals overlapping a reception "
+                          "can still change its outcome.",
+                          DoubleValue(-std::numeric_limits<double>::infinity()),
+                          MakeDoubleAccessor(&GatewayLoraPhy::SetInterferencePruningThreshold,
+                                             &GatewayLoraPhy::GetInterferencePruningThreshold),
+                          MakeDoubleChecker<double>(-std::numeric_limits<double>::infinity()));
     return tid;
 }
 
 GatewayLoraPhy::GatewayLoraPhy()
-    : m_isTransmitting(false)
+    : m_isTransmitting(false),
+      m_interferencePruningThreshold(-std::numeric_limits<double>::infinity()),
+      m_prunedInterferers(0),
+      m_prunedInterferenceEnergy(0)
 {
     NS_LOG_FUNCTION_NOARGS();
 }
@@ -146,6 +168,7 @@ GatewayLoraPhy::AddReceptionPath()
 {
     NS_LOG_FUNCTION_NOARGS();
 
+    m_freeReceptionPaths.push_back(m_receptionPaths.size());
     m_receptionPaths.push_back(Create<GatewayLoraPhy::ReceptionPath>());
 }
 
@@ -154,7 +177,63 @@ GatewayLoraPhy::ResetReceptionPaths()
 {
     NS_LOG_FUNCTION(this);
 
+    // Pending receptions will not find their path when they end, since the
+    // events of the new paths are checked on release
     m_receptionPaths.clear();
+    m_freeReceptionPaths.clear();
+    m_occupiedReceptionPaths = 0;
+}
+
+uint32_t
+GatewayLoraPhy::GetNReceptionPaths() const
+{
+    return m_receptionPaths.size();
+}
+
+bool
+GatewayLoraPhy::CanLockReceptionPath(uint8_t sf, double frequencyMHz) const
+{
+    return !m_freeReceptionPaths.empty();
+}
+
+Ptr<GatewayLoraPhy::ReceptionPath>
+GatewayLoraPhy::LockReceptionPath(Ptr<LoraInterferenceHelper::Event> event)
+{
+    NS_LOG_FUNCTION(this << event);
+
+    if (m_freeReceptionPaths.empty())
+    {
+        return nullptr;
+    }
+
+    uint32_t index = m_freeReceptionPaths.back();
+    m_freeReceptionPaths.pop_back();
+
+    Ptr<ReceptionPath> path = m_receptionPaths[index];
+    path->LockOnEvent(event);
+    event->SetReceptionPath(index);
+    m_occupiedReceptionPaths++;
+
+    return path;
+}
+
+bool
+GatewayLoraPhy::ReleaseReceptionPath(Ptr<LoraInterferenceHelper::Event> event)
+{
+    NS_LOG_FUNCTION(this << event);
+
+    uint32_t index = event->GetReceptionPath();
+    if (index >= m_receptionPaths.size() || m_receptionPaths[index]->GetEvent() != event)
+    {
+        return false;
+    }
+
+    m_receptionPaths[index]->Free();
+    event->SetReceptionPath(LoraInterferenceHelper::Event::NO_RECEPTION_PATH);
+    m_freeReceptionPaths.push_back(index);
+    m_occupiedReceptionPaths--;
+
+    return true;
 }
 
 void
@@ -163,6 +242,52 @@ GatewayLoraPhy::TxFinished(Ptr<Packet> packet)
     m_isTransmitting = false;
 }
 
+void
+GatewayLoraPhy::StartDeviceTransmission(Ptr<Packet> packet, Time duration)
+{
+    NS_LOG_FUNCTION(this << packet << duration);
+
+    InterruptReceptions();
+
+    Simulator::Schedule(duration, &GatewayLoraPhy::TxFinished, this, packet);
+
+    m_isTransmitting = true;
+}
+
+void
+GatewayLoraPhy::InterruptReceptions()
+{
+    NS_LOG_FUNCTION_NOARGS();
+
+    for (uint32_t i = 0; m_occupiedReceptionPaths > 0 && i < m_receptionPaths.size(); i++)
+    {
+        Ptr<GatewayLoraPhy::ReceptionPath> currentPath = m_receptionPaths[i];
+
+        if (!currentPath->IsAvailable()) // Reception path is occupied
+        {
+            // Call the callback for reception interrupted by transmission
+            // Fire the trace source
+            if (m_device)
+            {
+                m_noReceptionBecauseTransmitting(currentPath->GetEvent()->GetPacket(),
+                                                 m_device->GetNode()->GetId());
+            }
+            else
+            {
+                m_noReceptionBecauseTransmitting(currentPath->GetEvent()->GetPacket(), 0);
+            }
+
+            // Cancel the scheduled EndReceive call
+            Simulator::Cancel(currentPath->GetEndReceive());
+            m_interference.UntrackEvent(currentPath->GetEvent());
+
+            // Free it
+            // This also resets all parameters like packet and endReceive call
+            ReleaseReceptionPath(currentPath->GetEvent());
+        }
+    }
+}
+
 bool
 GatewayLoraPhy::IsTransmitting()
 {
@@ -179,6 +304,79 @@ GatewayLoraPhy::AddFrequency(double frequencyMHz)
     NS_ASSERT(m_frequencies.size() <= 8);
 }
 
+void
+GatewayLoraPhy::SetInterferencePruningThreshold(double thresholdDbm)
+{
+    NS_LOG_FUNCTION(this << thresholdDbm);
+
+    // Pruned signals are not added to the interference helper, so they must
+    // neither be locked on by a reception path nor destroy a reception
+    NS_ABORT_MSG_IF(m_interference.GetCollisionMatrix() == LoraInterferenceHelper::ALOHA &&
+                        thresholdDbm > -std::numeric_limits<double>::infinity(),
+                    "Signals can't be pruned with the ALOHA collision matrix");
+    NS_ABORT_MSG_IF(thresholdDbm > GetMaxInterferencePruningThreshold(),
+                    "The pruning threshold can't exceed "
+                        << GetMaxInterferencePruningThreshold() << " dBm");
+
+    m_interferencePruningThreshold = thresholdDbm;
+}
+
+double
+GatewayLoraPhy::GetInterferencePruningThreshold() const
+{
+    return m_interferencePruningThreshold;
+}
+
+double
+GatewayLoraPhy::GetMaxInterferencePruningThreshold() const
+{
+    if (m_interference.GetCollisionMatrix() == LoraInterferenceHelper::ALOHA)
+    {
+        return -std::numeric_limits<double>::infinity();
+    }
+
+    // The weakest signal that can be received must survive any interferer
+    // below the threshold
+    double threshold = std::numeric_limits<double>::infinity();
+    for (unsigned sf = 0; sf < 6; sf++)
+    {
+        for (unsigned interfererSf = 0; interfererSf < 6; interfererSf++)
+        {
+            threshold = std::min(
+                threshold,
+                sensitivity[sf] - LoraInterferenceHelper::collisionSnirGoursaud[sf][interfererSf]);
+        }
+    }
+    return threshold;
+}
+
+uint64_t
+GatewayLoraPhy::GetPrunedInterferers() const
+{
+    return m_prunedInterferers;
+}
+
+double
+GatewayLoraPhy::GetPrunedInterferenceEnergy() const
+{
+    return m_prunedInterferenceEnergy;
+}
+
+bool
+GatewayLoraPhy::PruneInterferer(double rxPowerDbm, Time duration)
+{
+    if (rxPowerDbm >= m_interferencePruningThreshold)
+    {
+        return false;
+    }
+
+    NS_LOG_DEBUG("Not tracking a signal of " << rxPowerDbm << " dBm as interferer");
+
+    m_prunedInterferers++;
+    m_prunedInterferenceEnergy += std::pow(10, rxPowerDbm / 10) / 1000 * duration.GetSeconds();
+    return true;
+}
+
 bool
 GatewayLoraPhy::IsOnFrequency(double frequencyMHz)
 {
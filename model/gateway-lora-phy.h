@@ -30,6 +30,7 @@
 #include "ns3/traced-value.h"
 
 #include <list>
+#include <vector>
 
 namespace ns3
 {
@@ -71,6 +72,19 @@ class GatewayLoraPhy : public LoraPhy
 
     virtual void TxFinished(Ptr<Packet> packet);
 
+    /**
+     * Put this PHY in TX mode while another PHY of the same device, such as
+     * another sector of a multi-sector gateway, transmits a packet.
+     *
+     * The PHYs of a device share its radio, so ongoing receptions are
+     * interrupted and arriving packets are dropped until the transmission
+     * ends.
+     *
+     * \param packet The packet being transmitted.
+     * \param duration The duration of the transmission.
+     */
+    void StartDeviceTransmission(Ptr<Packet> packet, Time duration);
+
     bool IsTransmitting() override;
 
     bool IsOnFrequency(double frequencyMHz) override;
@@ -87,10 +101,72 @@ class GatewayLoraPhy : public LoraPhy
      */
     void ResetReceptionPaths();
 
+    /**
+     * Get the number of reception paths of this gateway.
+     *
+     * \return The number of reception paths.
+     */
+    uint32_t GetNReceptionPaths() const;
+
     /**
      * Add a frequency to the list of frequencies we are listening to.
      */
-    void AddFrequency(double frequencyMHz);
+    virtual void AddFrequency(double frequencyMHz);
+
+    /**
+     * Set the power below which arriving signals are not tracked as
+     * interferers.
+     *
+     * Signals this weak can't be received, and are assumed not to change the
+     * outcome of other receptions. Their energy is accumulated instead, and
+     * can be compared to the one of the received signals to check that the
+     * approximation holds.
+     *
+     * The threshold can't exceed GetMaxInterferencePruningThreshold, so that
+     * a pruned signal alone never changes an outcome. Several pruned signals
+     * overlapping the same reception can still add up to destroy it, and
+     * pruning them then changes the outcome.
+     *
+     * \param thresholdDbm The threshold.
+     */
+    void SetInterferencePruningThreshold(double thresholdDbm);
+
+    /**
+     * Get the power below which arriving signals are not tracked as
+     * interferers.
+     *
+     * \return The threshold, in dBm.
+     */
+    double GetInterferencePruningThreshold() const;
+
+    /**
+     * Get the highest pruning threshold for the collision matrix of this PHY.
+     *
+     * Under the GOURSAUD matrix, this is the lowest difference between the
+     * sensitivity of an SF and the isolation it needs from an interferer,
+     * so that a signal at the sensitivity survives any single pruned signal.
+     * Under the ALOHA matrix, any overlap with a signal of the same SF
+     * destroys a reception regardless of power, so no signal can be pruned.
+     *
+     * \return The threshold, in dBm.
+     */
+    double GetMaxInterferencePruningThreshold() const;
+
+    /**
+     * Get the number of arriving signals that were not tracked as
+     * interferers because their power was below the pruning threshold.
+     *
+     * \return The number of pruned signals.
+     */
+    uint64_t GetPrunedInterferers() const;
+
+    /**
+     * Get the total energy of the signals that were not tracked as
+     * interferers because their power was below the pruning threshold.
+     *
+     * \return The background energy of the pruned signals, in J.
+     */
+    double GetPrunedInterferenceEnergy() const;
 
     /**
      * A vector containing the sensitivities required to correctly decode
@@ -99,6 +175,22 @@ class GatewayLoraPhy : public LoraPhy
     static const double sensitivity[6];
 
   protected:
+    /**
+     * Check whether an arriving signal is below the pruning threshold, and
+     * account for its energy if it is.
+     *
+     * \param rxPowerDbm The power of the signal.
+     * \param duration The duration of the signal.
+     * \return Whether the signal should not be tracked as an interferer.
+     */
+    bool PruneInterferer(double rxPowerDbm, Time duration);
+
+    /**
+     * Interrupt all ongoing receptions, because the gateway starts
+     * transmitting.
+     */
+    void InterruptReceptions();
+
     /**
      * This class represents a configurable reception path.
      *
@@ -185,10 +277,46 @@ class GatewayLoraPhy : public LoraPhy
     };
 
     /**
-     * A list containing the various parallel receivers that are managed by this
-     * Gateway.
+     * Check whether a reception path can be locked on a signal.
+     *
+     * By default, this only requires a free reception path, but subclasses
+     * can add further constraints on the channel and SF of the signal.
+     *
+     * \param sf The spreading factor of the signal.
+     * \param frequencyMHz The frequency of the signal.
+     * \return Whether LockReceptionPath would succeed for the signal.
+     */
+    virtual bool CanLockReceptionPath(uint8_t sf, double frequencyMHz) const;
+
+    /**
+     * Lock a free reception path on an event.
+     *
+     * The index of the path is stored in the event, and the number of
+     * occupied reception paths is updated.
+     *
+     * \param event The event to lock the path on.
+     * \return The locked path, or nullptr if all paths are occupied.
+     */
+    virtual Ptr<ReceptionPath> LockReceptionPath(Ptr<LoraInterferenceHelper::Event> event);
+
+    /**
+     * Release the reception path locked on an event, if any.
+     *
+     * \param event The event the path is locked on.
+     * \return Whether a path was locked on the event.
+     */
+    virtual bool ReleaseReceptionPath(Ptr<LoraInterferenceHelper::Event> event);
+
+    /**
+     * The various parallel receivers that are managed by this Gateway.
      */
-    std::list<Ptr<ReceptionPath>> m_receptionPaths;
+    std::vector<Ptr<ReceptionPath>> m_receptionPaths;
+
+    /**
+     * The indices of the free reception paths, used as a stack so that
+     * finding and releasing a path take constant time.
+     */
+    std::vector<uint32_t> m_freeReceptionPaths;
 
     /**
      * The number of occupied reception paths.
@@ -214,6 +342,10 @@ class GatewayLoraPhy : public LoraPhy
     bool m_isTransmitting; //!< Flag indicating whether a transmission is going on
 
     std::list<double> m_frequencies;
+
+    double m_interferencePruningThreshold; //!< The pruning threshold, in dBm
+    uint64_t m_prunedInterferers;          //!< The number of pruned signals
+    double m_prunedInterferenceEnergy;     //!< The energy of the pruned signals, in J
 };
 
 } // namespace lorawan
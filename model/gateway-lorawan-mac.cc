@@ -24,6 +24,8 @@
 #include "lorawan-mac-header.h"
 
 #include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/trace-source-accessor.h"
 
 namespace ns3
 {
@@ -37,14 +39,29 @@ NS_OBJECT_ENSURE_REGISTERED(GatewayLorawanMac);
 TypeId
 GatewayLorawanMac::GetTypeId()
 {
-    static TypeId tid = TypeId("ns3::GatewayLorawanMac")
-                            .SetParent<LorawanMac>()
-                            .AddConstructor<GatewayLorawanMac>()
-                            .SetGroupName("lorawan");
+    static TypeId tid =
+        TypeId("ns3::GatewayLorawanMac")
+            .SetParent<LorawanMac>()
+            .AddConstructor<GatewayLorawanMac>()
+            .SetGroupName("lorawan")
+            .AddAttribute("DeduplicationWindow",
+                          "The time to wait for copies of a packet received by one of "
+                          "the PHYs of a multi-PHY device before forwarding the copy "
+                          "with the highest receive power. Copies received at the same "
+                          "time are always deduplicated",
+                          TimeValue(Seconds(0)),
+                          MakeTimeAccessor(&GatewayLorawanMac::m_deduplicationWindow),
+                          MakeTimeChecker(Seconds(0)))
+            .AddTraceSource("DroppedDuplicate",
+                            "Trace source indicating a copy of a packet received by "
+                            "more than one PHY was not forwarded",
+                            MakeTraceSourceAccessor(&GatewayLorawanMac::m_droppedDuplicate),
+                            "ns3::Packet::TracedCallback");
     return tid;
 }
 
 GatewayLorawanMac::GatewayLorawanMac()
+    : m_deduplicationWindow(Seconds(0))
 {
     NS_LOG_FUNCTION(this);
 }
@@ -123,20 +140,79 @@ GatewayLorawanMac::Receive(Ptr<const Packet> packet)
     LorawanMacHeader macHdr;
     packetCopy->PeekHeader(macHdr);
 
-    if (macHdr.IsUplink())
+    if (!macHdr.IsUplink())
     {
-        m_device->GetObject<LoraNetDevice>()->Receive(packetCopy);
+        NS_LOG_DEBUG("Not forwarding downlink message to NetDevice");
+        return;
+    }
+
+    // With a single PHY, there can't be duplicates
+    if (m_device->GetObject<LoraNetDevice>()->GetNPhys() <= 1)
+    {
+        ForwardUplink(packet, packetCopy);
+        return;
+    }
 
-        NS_LOG_DEBUG("Received packet: " << packet);
+    // The PHYs of a device receive the same packet, so its unique identifier
+    // tells copies apart from different packets
+    LoraTag tag;
+    packetCopy->PeekPacketTag(tag);
+    double rxPowerDbm = tag.GetReceivePower();
 
-        m_receivedPacket(packet);
+    auto it = m_pendingUplinks.find(packet->GetUid());
+    if (it == m_pendingUplinks.end())
+    {
+        m_pendingUplinks[packet->GetUid()] = {packet, packetCopy, rxPowerDbm};
+
+        // Receptions ending at the same time were scheduled before this
+        // event, so they are deduplicated even with no window
+        Simulator::Schedule(m_deduplicationWindow,
+                            &GatewayLorawanMac::ForwardPendingUplink,
+                            this,
+                            packet->GetUid());
+        return;
+    }
+
+    NS_LOG_DEBUG("Packet " << packet->GetUid() << " was already received by another PHY");
+
+    PendingUplink& pending = it->second;
+    if (rxPowerDbm > pending.rxPowerDbm)
+    {
+        m_droppedDuplicate(pending.packet);
+        pending = {packet, packetCopy, rxPowerDbm};
     }
     else
     {
-        NS_LOG_DEBUG("Not forwarding downlink message to NetDevice");
+        m_droppedDuplicate(packet);
     }
 }
 
+void
+GatewayLorawanMac::ForwardUplink(Ptr<const Packet> packet, Ptr<Packet> copy)
+{
+    NS_LOG_FUNCTION(this << packet);
+
+    m_device->GetObject<LoraNetDevice>()->Receive(copy);
+
+    NS_LOG_DEBUG("Received packet: " << packet);
+
+    m_receivedPacket(packet);
+}
+
+void
+GatewayLorawanMac::ForwardPendingUplink(uint64_t uid)
+{
+    NS_LOG_FUNCTION(this << uid);
+
+    auto it = m_pendingUplinks.find(uid);
+    NS_ASSERT(it != m_pendingUplinks.end());
+
+    PendingUplink pending = it->second;
+    m_pendingUplinks.erase(it);
+
+    ForwardUplink(pending.packet, pending.copy);
+}
+
 void
 GatewayLorawanMac::FailedReception(Ptr<const Packet> packet)
 {
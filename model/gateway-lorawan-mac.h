@@ -23,6 +23,11 @@
 #include "lora-tag.h"
 #include "lorawan-mac.h"
 
+#include "ns3/nstime.h"
+#include "ns3/traced-callback.h"
+
+#include <unordered_map>
+
 namespace ns3
 {
 namespace lorawan
@@ -59,6 +64,49 @@ class GatewayLorawanMac : public LorawanMac
     Time GetWaitingTime(double frequency);
 
   private:
+    /**
+     * A packet received by at least one PHY of a multi-PHY device, waiting
+     * for copies from the other PHYs.
+     */
+    struct PendingUplink
+    {
+        Ptr<const Packet> packet;   //!< The packet as received by the PHY.
+        Ptr<Packet> copy;           //!< The copy to forward to the NetDevice.
+        double rxPowerDbm;          //!< The receive power of the copy.
+    };
+
+    /**
+     * Forward an uplink packet to the NetDevice.
+     *
+     * \param packet The packet as received by the PHY.
+     * \param copy The copy to forward.
+     */
+    void ForwardUplink(Ptr<const Packet> packet, Ptr<Packet> copy);
+
+    /**
+     * Forward the best copy of a packet received by several PHYs.
+     *
+     * \param uid The unique identifier of the packet.
+     */
+    void ForwardPendingUplink(uint64_t uid);
+
+    /**
+     * The time to wait for copies of a packet received by one of the PHYs of
+     * a multi-PHY device.
+     */
+    Time m_deduplicationWindow;
+
+    /**
+     * The packets waiting for copies, by unique identifier.
+     */
+    std::unordered_map<uint64_t, PendingUplink> m_pendingUplinks;
+
+    /**
+     * The trace source fired when a copy of a packet received by more than
+     * one PHY is dropped.
+     */
+    TracedCallback<Ptr<const Packet>> m_droppedDuplicate;
+
   protected:
 };
 
@@ -40,7 +40,8 @@ LogicalLoraChannelHelper::GetTypeId()
 }
 
 LogicalLoraChannelHelper::LogicalLoraChannelHelper()
-    : m_nextAggregatedTransmissionTime(Seconds(0)),
+    : m_enabledChannels(0),
+      m_nextAggregatedTransmissionTime(Seconds(0)),
       m_aggregatedDutyCycle(1)
 {
     NS_LOG_FUNCTION(this);
@@ -69,29 +70,106 @@ LogicalLoraChannelHelper::GetEnabledChannelList()
 {
     NS_LOG_FUNCTION(this);
 
-    // Make a copy of the channel vector
-    std::vector<Ptr<LogicalLoraChannel>> vector;
-    vector.reserve(m_channelList.size());
-    std::copy(m_channelList.begin(),
-              m_channelList.end(),
-              std::back_inserter(vector)); // Working on a copy
-
     std::vector<Ptr<LogicalLoraChannel>> channels;
-    std::vector<Ptr<LogicalLoraChannel>>::iterator it;
-    for (it = vector.begin(); it != vector.end(); it++)
+    for (uint32_t i = 0; i < m_channelList.size(); i++)
     {
-        if ((*it)->IsEnabledForUplink())
+        if (m_enabledChannels & (uint64_t(1) << i))
         {
-            channels.push_back(*it);
+            channels.push_back(m_channelList[i]);
         }
     }
 
     return channels;
 }
 
+uint64_t
+LogicalLoraChannelHelper::GetEnabledChannelMask() const
+{
+    return m_enabledChannels;
+}
+
+Time
+LogicalLoraChannelHelper::GetMinWaitingTime()
+{
+    NS_LOG_FUNCTION(this);
+
+    Time waitingTime = Time::Max();
+    for (uint32_t i = 0; i < m_channelList.size(); i++)
+    {
+        if (m_enabledChannels & (uint64_t(1) << i))
+        {
+            NS_ABORT_MSG_IF(!m_channelSubBand[i],
+                            "Channel " << i << " is outside any known SubBand.");
+
+            waitingTime = std::min(waitingTime, GetSubBandWaitingTime(m_channelSubBand[i]));
+        }
+    }
+
+    NS_LOG_DEBUG("Minimum waiting time: " << waitingTime.GetSeconds());
+
+    return waitingTime;
+}
+
+Ptr<LogicalLoraChannel>
+LogicalLoraChannelHelper::GetRandomAvailableChannel(Ptr<UniformRandomVariable> rv)
+{
+    NS_LOG_FUNCTION(this << rv);
+
+    // Mark the enabled channels whose SubBand allows transmitting right away
+    uint64_t available = 0;
+    uint32_t nAvailable = 0;
+    for (uint32_t i = 0; i < m_channelList.size(); i++)
+    {
+        if (m_enabledChannels & (uint64_t(1) << i))
+        {
+            NS_ABORT_MSG_IF(!m_channelSubBand[i],
+                            "Channel " << i << " is outside any known SubBand.");
+
+            if (GetSubBandWaitingTime(m_channelSubBand[i]).IsZero())
+            {
+                available |= uint64_t(1) << i;
+                nAvailable++;
+            }
+        }
+    }
+
+    if (nAvailable == 0)
+    {
+        NS_LOG_DEBUG("No channel is available because of duty cycle limitations.");
+        return nullptr;
+    }
+
+    // Pick the n-th available channel, with n drawn uniformly
+    uint32_t n = rv->GetInteger(0, nAvailable - 1);
+    for (uint32_t i = 0; i < m_channelList.size(); i++)
+    {
+        if (available & (uint64_t(1) << i))
+        {
+            if (n == 0)
+            {
+                NS_LOG_DEBUG("Picked channel " << i << " out of " << nAvailable
+                                               << " available ones.");
+                return m_channelList[i];
+            }
+            n--;
+        }
+    }
+
+    return nullptr; // Never reached
+}
+
 Ptr<SubBand>
 LogicalLoraChannelHelper::GetSubBandFromChannel(Ptr<LogicalLoraChannel> channel)
 {
+    // Use the cached SubBand if the channel is registered on this helper
+    for (uint32_t i = 0; i < m_channelList.size(); i++)
+    {
+        if (m_channelList[i] == channel && m_channelSubBand[i])
+        {
+            return m_channelSubBand[i];
+        }
+    }
+
     return GetSubBandFromFrequency(channel->GetFrequency());
 }
 
@@ -124,6 +202,7 @@ LogicalLoraChannelHelper::AddChannel(double frequency)
 
     // Add it to the list
     m_channelList.push_back(channel);
+    UpdateChannelIndex(m_channelList.size() - 1);
 
     NS_LOG_DEBUG("Added a channel. Current number of channels in list is " << m_channelList.size());
 }
@@ -135,6 +214,7 @@ LogicalLoraChannelHelper::AddChannel(Ptr<LogicalLoraChannel> logicalChannel)
 
     // Add it to the list
     m_channelList.push_back(logicalChannel);
+    UpdateChannelIndex(m_channelList.size() - 1);
 }
 
 void
@@ -144,6 +224,7 @@ LogicalLoraChannelHelper::SetChannel(uint8_t chIndex, Ptr<LogicalLoraChannel> lo
     NS_LOG_FUNCTION(this << chIndex << logicalChannel);
 
     m_channelList.at(chIndex) = logicalChannel;
+    UpdateChannelIndex(chIndex);
 }
 
 void
@@ -156,7 +237,7 @@ LogicalLoraChannelHelper::AddSubBand(double firstFrequency,
 
     Ptr<SubBand> subBand = Create<SubBand>(firstFrequency, lastFrequency, dutyCycle, maxTxPowerDbm);
 
-    m_subBandList.push_back(subBand);
+    AddSubBand(subBand);
 }
 
 void
@@ -165,6 +246,15 @@ LogicalLoraChannelHelper::AddSubBand(Ptr<SubBand> subBand)
     NS_LOG_FUNCTION(this << subBand);
 
     m_subBandList.push_back(subBand);
+
+    // The new SubBand can only be the one of channels that had none
+    for (uint32_t i = 0; i < m_channelList.size(); i++)
+    {
+        if (!m_channelSubBand[i] && subBand->BelongsToSubBand(m_channelList[i]->GetFrequency()))
+        {
+            m_channelSubBand[i] = subBand;
+        }
+    }
 }
 
 void
@@ -177,7 +267,13 @@ LogicalLoraChannelHelper::RemoveChannel(Ptr<LogicalLoraChannel> logicalChannel)
         Ptr<LogicalLoraChannel> currentChannel = *it;
         if (currentChannel == logicalChannel)
         {
+            uint32_t index = it - m_channelList.begin();
             m_channelList.erase(it);
+            m_channelSubBand.erase(m_channelSubBand.begin() + index);
+
+            // Shift the mask bits of the following channels down by one
+            uint64_t lower = m_enabledChannels & ((uint64_t(1) << index) - 1);
+            m_enabledChannels = lower | ((m_enabledChannels >> (index + 1)) << index);
             return;
         }
     }
@@ -202,18 +298,23 @@ LogicalLoraChannelHelper::GetWaitingTime(Ptr<LogicalLoraChannel> channel)
 {
     NS_LOG_FUNCTION(this << channel);
 
-    // SubBand waiting time
-    Time subBandWaitingTime =
-        GetSubBandFromChannel(channel)->GetNextTransmissionTime() - Simulator::Now();
-
-    // Handle case in which waiting time is negative
-    subBandWaitingTime = Seconds(std::max(subBandWaitingTime.GetSeconds(), double(0)));
+    Time subBandWaitingTime = GetSubBandWaitingTime(GetSubBandFromChannel(channel));
 
     NS_LOG_DEBUG("Waiting time: " << subBandWaitingTime.GetSeconds());
 
     return subBandWaitingTime;
 }
 
+Time
+LogicalLoraChannelHelper::GetSubBandWaitingTime(Ptr<SubBand> subBand) const
+{
+    // SubBand waiting time
+    Time subBandWaitingTime = subBand->GetNextTransmissionTime() - Simulator::Now();
+
+    // Handle case in which waiting time is negative
+    return std::max(subBandWaitingTime, Time(0));
+}
+
 void
 LogicalLoraChannelHelper::AddEvent(Time duration, Ptr<LogicalLoraChannel> channel)
 {
@@ -266,6 +367,49 @@ LogicalLoraChannelHelper::DisableChannel(int index)
     NS_LOG_FUNCTION(this << index);
 
     m_channelList.at(index)->DisableForUplink();
+    m_enabledChannels &= ~(uint64_t(1) << index);
+}
+
+void
+LogicalLoraChannelHelper::EnableChannel(int index)
+{
+    NS_LOG_FUNCTION(this << index);
+
+    m_channelList.at(index)->SetEnabledForUplink();
+    m_enabledChannels |= uint64_t(1) << index;
+}
+
+void
+LogicalLoraChannelHelper::UpdateChannelIndex(uint32_t index)
+{
+    NS_LOG_FUNCTION(this << index);
+
+    NS_ABORT_MSG_IF(index >= 64, "The channel mask supports at most 64 channels.");
+
+    m_channelSubBand.resize(m_channelList.size());
+
+    Ptr<LogicalLoraChannel> channel = m_channelList[index];
+
+    // Channels outside any known SubBand are resolved when their SubBand is
+    // added, or make the duty cycle queries abort as before
+    m_channelSubBand[index] = nullptr;
+    for (auto& subBand : m_subBandList)
+    {
+        if (subBand->BelongsToSubBand(channel->GetFrequency()))
+        {
+            m_channelSubBand[index] = subBand;
+            break;
+        }
+    }
+
+    if (channel->IsEnabledForUplink())
+    {
+        m_enabledChannels |= uint64_t(1) << index;
+    }
+    else
+    {
+        m_enabledChannels &= ~(uint64_t(1) << index);
+    }
 }
 } // namespace lorawan
 } // namespace ns3
@@ -26,6 +26,7 @@
 #include "ns3/nstime.h"
 #include "ns3/object.h"
 #include "ns3/packet.h"
+#include "ns3/random-variable-stream.h"
 
 #include <iterator>
 #include <list>
@@ -44,6 +45,12 @@ namespace lorawan
  * This class also takes into account duty cycle limitations, by updating a list
  * of SubBand objects and providing methods to query whether transmission on a
  * set channel is admissible or not.
+ *
+ * The SubBand of each channel and the channel mask are cached when channels
+ * and SubBands are added, so that the queries performed for every uplink do
+ * not scan the SubBand list nor copy the channel list. For the cached mask to
+ * stay consistent, channels should be enabled and disabled through this
+ * helper rather than on the LogicalLoraChannel itself.
  */
 class LogicalLoraChannelHelper : public Object
 {
@@ -98,6 +105,34 @@ class LogicalLoraChannelHelper : public Object
      */
     std::vector<Ptr<LogicalLoraChannel>> GetEnabledChannelList();
 
+    /**
+     * Get the channel mask, i.e., which of the channels registered on this
+     * helper are enabled for Uplink transmission.
+     *
+     * \return A bitmask whose bit i is set if the channel at index i is enabled.
+     */
+    uint64_t GetEnabledChannelMask() const;
+
+    /**
+     * Get the minimum time it is necessary to wait for before transmitting on
+     * any of the channels enabled for Uplink transmission.
+     *
+     * \remark This function does not take into account aggregate waiting time.
+     *
+     * \return The minimum waiting time, or Time::Max () if no channel is
+     * enabled.
+     */
+    Time GetMinWaitingTime();
+
+    /**
+     * Pick a random channel among the ones enabled for Uplink transmission that
+     * can be used right away according to their SubBand's duty cycle.
+     *
+     * \param rv The random variable used to draw the channel.
+     * \return The chosen channel, or nullptr if no channel is available.
+     */
+    Ptr<LogicalLoraChannel> GetRandomAvailableChannel(Ptr<UniformRandomVariable> rv);
+
     /**
      * Add a new channel to the list.
      *
@@ -180,7 +215,30 @@ class LogicalLoraChannelHelper : public Object
      */
     void DisableChannel(int index);
 
+    /**
+     * Enable the channel at a specified index.
+     *
+     * \param index The index of the channel to enable.
+     */
+    void EnableChannel(int index);
+
   private:
+    /**
+     * Get the time it is necessary to wait for before transmitting on a
+     * SubBand.
+     *
+     * \param subBand The SubBand.
+     * \return The waiting time, which is never negative.
+     */
+    Time GetSubBandWaitingTime(Ptr<SubBand> subBand) const;
+
+    /**
+     * Update the cached SubBand and mask bit of the channel at an index.
+     *
+     * \param index The index of the channel in m_channelList.
+     */
+    void UpdateChannelIndex(uint32_t index);
+
     /**
      * A list of the SubBands that are currently registered within this helper.
      */
@@ -193,6 +251,18 @@ class LogicalLoraChannelHelper : public Object
      */
     std::vector<Ptr<LogicalLoraChannel>> m_channelList;
 
+    /**
+     * The SubBand each channel belongs to, indexed like m_channelList. Entries
+     * are null for channels outside of any known SubBand.
+     */
+    std::vector<Ptr<SubBand>> m_channelSubBand;
+
+    /**
+     * The channel mask, with bit i set if the channel at index i of
+     * m_channelList is enabled for Uplink transmission.
+     */
+    uint64_t m_enabledChannels;
+
     Time m_nextAggregatedTransmissionTime; //!< The next time at which
     //! transmission will be possible
     //! according to the aggregated
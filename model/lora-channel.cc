@@ -19,16 +19,38 @@
 
 #include "lora-channel.h"
 
+#include "building-penetration-loss.h"
+#include "correlated-shadowing-propagation-loss-model.h"
 #include "end-device-lora-phy.h"
+#include "end-device-lorawan-mac.h"
 #include "gateway-lora-phy.h"
+#include "lora-frame-header.h"
+#include "lora-net-device.h"
+#include "lora-origin-tag.h"
+#include "lora-remote-transmission-header.h"
+#include "lora-thread-pool.h"
+#include "lorawan-mac-header.h"
 
+#include "ns3/boolean.h"
+#include "ns3/constant-position-mobility-model.h"
+#include "ns3/double.h"
+#include "ns3/enum.h"
 #include "ns3/log.h"
 #include "ns3/object-factory.h"
 #include "ns3/packet.h"
 #include "ns3/pointer.h"
 #include "ns3/simulator.h"
+#include "ns3/uinteger.h"
+
+#ifdef NS3_MPI
+#include "ns3/distributed-simulator-impl.h"
+#include "ns3/mpi-interface.h"
+#include "ns3/mpi-receiver.h"
+#endif
 
 #include <algorithm>
+#include <cmath>
+#include <tuple>
 
 namespace ns3
 {
@@ -39,6 +61,89 @@ NS_LOG_COMPONENT_DEFINE("LoraChannel");
 
 NS_OBJECT_ENSURE_REGISTERED(LoraChannel);
 
+namespace
+{
+
+/**
+ * Compute the distance of a set of points from a position, as
+ * MobilityModel::GetDistanceFrom does.
+ *
+ * The squared distances are computed in a loop the compiler can vectorize,
+ * and the square roots in a separate one, since std::sqrt may set errno.
+ *
+ * \param position The position.
+ * \param x The x coordinates of the points.
+ * \param y The y coordinates of the points.
+ * \param z The z coordinates of the points.
+ * \param [out] distances The distances.
+ * \param n The number of points.
+ */
+void
+ComputeDistances(const Vector& position,
+                 const double* __restrict x,
+                 const double* __restrict y,
+                 const double* __restrict z,
+                 double* __restrict distances,
+                 std::size_t n)
+{
+    for (std::size_t k = 0; k < n; k++)
+    {
+        double dx = position.x - x[k];
+        double dy = position.y - y[k];
+        double dz = position.z - z[k];
+        distances[k] = dx * dx + dy * dy + dz * dz;
+    }
+    for (std::size_t k = 0; k < n; k++)
+    {
+        distances[k] = std::sqrt(distances[k]);
+    }
+}
+
+/**
+ * Turn distances into received powers, with the same operations as
+ * LogDistancePropagationLossModel::DoCalcRxPower.
+ *
+ * Distances within the reference distance are clamped to it, which gives
+ * the same result as the branch of the scalar model, since log10(1) is
+ * exactly 0. The clamping and the final arithmetic are branchless loops the
+ * compiler can vectorize, while the logarithm is the standard library one,
+ * computed in a loop of its own: an approximated vector logarithm would not
+ * give the bit-identical results the link budget cache and the thread pool
+ * rely on.
+ *
+ * \param txPowerDbm The transmission power.
+ * \param exponent The path loss exponent.
+ * \param referenceDistance The reference distance.
+ * \param referenceLoss The loss at the reference distance.
+ * \param [in,out] values The distances, replaced by the received powers.
+ * \param n The number of values.
+ */
+void
+ComputeLogDistanceRxPowers(double txPowerDbm,
+                           double exponent,
+                           double referenceDistance,
+                           double referenceLoss,
+                           double* __restrict values,
+                           std::size_t n)
+{
+    for (std::size_t k = 0; k < n; k++)
+    {
+        values[k] = std::max(values[k] / referenceDistance, 1.0);
+    }
+    for (std::size_t k = 0; k < n; k++)
+    {
+        values[k] = std::log10(values[k]);
+    }
+    for (std::size_t k = 0; k < n; k++)
+    {
+        double pathLossDb = 10 * exponent * values[k];
+        double rxc = -referenceLoss - pathLossDb;
+        values[k] = txPowerDbm + rxc;
+    }
+}
+
+} // namespace
+
 TypeId
 LoraChannel::GetTypeId()
 {
@@ -57,6 +162,99 @@ LoraChannel::GetTypeId()
                           PointerValue(),
                           MakePointerAccessor(&LoraChannel::m_delay),
                           MakePointerChecker<PropagationDelayModel>())
+            .AddAttribute("MaxRange",
+                          "The distance (in meters) beyond which receivers are not notified "
+                          "of transmissions, or 0 to notify all receivers. This should be "
+                          "set to a distance at which no transmission can be received, "
+                          "including the largest antenna gains of the PHYs (see "
+                          "LoraChannel::ComputeMaxRange)",
+                          DoubleValue(0),
+                          MakeDoubleAccessor(&LoraChannel::SetMaxRange, &LoraChannel::GetMaxRange),
+                          MakeDoubleChecker<double>(0))
+            .AddAttribute("LinkBudgetCache",
+                          "Whether to cache the received power and delay between PHYs "
+                          "that do not move. If enabled, PropagationLossModel should "
+                          "only contain deterministic components, and random ones should "
+                          "be set as PerPacketLossModel",
+                          BooleanValue(false),
+                          MakeBooleanAccessor(&LoraChannel::SetLinkBudgetCacheEnabled,
+                                              &LoraChannel::IsLinkBudgetCacheEnabled),
+                          MakeBooleanChecker())
+            .AddAttribute("PerPacketLossModel",
+                          "A pointer to a loss model applied to each transmission after "
+                          "PropagationLossModel, and whose result is never cached",
+                          PointerValue(),
+                          MakePointerAccessor(&LoraChannel::m_perPacketLoss),
+                          MakePointerChecker<PropagationLossModel>())
+            .AddAttribute("DeliveryPolicy",
+                          "Which PHYs are notified of a transmission",
+                          EnumValue(LoraChannel::BROADCAST),
+                          MakeEnumAccessor(&LoraChannel::m_deliveryPolicy),
+                          MakeEnumChecker(LoraChannel::BROADCAST,
+                                          "Broadcast",
+                                          LoraChannel::GATEWAYS_ONLY,
+                                          "GatewaysOnly",
+                                          LoraChannel::ADDRESSED,
+                                          "Addressed"))
+            .AddAttribute("EndDeviceInterference",
+                          "Whether end device transmissions also reach other end devices "
+                          "when DeliveryPolicy is not Broadcast",
+                          BooleanValue(false),
+                          MakeBooleanAccessor(&LoraChannel::m_endDeviceInterference),
+                          MakeBooleanChecker())
+            .AddAttribute("EndDeviceSubscription",
+                          "Whether end devices are only notified of transmissions while "
+                          "they are subscribed to the transmission's frequency, that is, "
+                          "while they are in STANDBY or RX state, or to all frequencies "
+                          "while they wait for an armed receive window. Since end devices "
+                          "are not notified of transmissions on other frequencies while "
+                          "they listen, their LostPacketBecauseWrongFrequency trace "
+                          "source no longer fires",
+                          BooleanValue(false),
+                          MakeBooleanAccessor(&LoraChannel::m_subscription),
+                          MakeBooleanChecker())
+            .AddAttribute("LinkBudgetThreads",
+                          "The number of threads computing the link budget of the "
+                          "receivers of a transmission. Only the log distance loss of a "
+                          "LogDistancePropagationLossModel at the head of the loss model "
+                          "chain is computed in parallel, while receptions are always "
+                          "scheduled by the simulation thread in the same order",
+                          UintegerValue(1),
+                          MakeUintegerAccessor(&LoraChannel::SetLinkBudgetThreads,
+                                               &LoraChannel::GetLinkBudgetThreads),
+                          MakeUintegerChecker<uint32_t>(1))
+            .AddAttribute("FanOut",
+                          "Whether to schedule a single reception event for all receivers "
+                          "with the same propagation delay, firing PacketSent once per "
+                          "transmission. Receptions then happen in the context of the sender",
+                          BooleanValue(false),
+                          MakeBooleanAccessor(&LoraChannel::m_fanOut),
+                          MakeBooleanChecker())
+            .AddAttribute("FanOutResolution",
+                          "The resolution to which propagation delays are rounded when "
+                          "FanOut is enabled, or 0 to group only equal delays",
+                          TimeValue(MicroSeconds(1)),
+                          MakeTimeAccessor(&LoraChannel::m_fanOutResolution),
+                          MakeTimeChecker())
+            .AddAttribute("SortSimultaneousArrivals",
+                          "Whether signals that reach a PHY at the same time are delivered "
+                          "sorted by the index of their sender, then by the uid of their "
+                          "packet, rather than in the order they were sent in. This makes "
+                          "distributed simulations deliver them in the same order as "
+                          "sequential ones, if both enable it. Not compatible with FanOut",
+                          BooleanValue(false),
+                          MakeBooleanAccessor(&LoraChannel::m_sortArrivals),
+                          MakeBooleanChecker())
+            .AddAttribute("Lookahead",
+                          "The delay after which transmissions are described to the other "
+                          "systems of a distributed simulation, or 0 if the simulation is "
+                          "not distributed. This must not exceed the propagation delay "
+                          "between PHYs on different systems, and must be smaller than it "
+                          "if SortSimultaneousArrivals is enabled (see "
+                          "LoraChannel::ComputeLookahead)",
+                          TimeValue(Seconds(0)),
+                          MakeTimeAccessor(&LoraChannel::SetLookahead, &LoraChannel::GetLookahead),
+                          MakeTimeChecker(Seconds(0)))
             .AddTraceSource("PacketSent",
                             "Trace source fired whenever a packet goes out on the channel",
                             MakeTraceSourceAccessor(&LoraChannel::m_packetSent),
@@ -65,17 +263,46 @@ LoraChannel::GetTypeId()
 }
 
 LoraChannel::LoraChannel()
+    : m_maxRange(0),
+      m_spatialIndexValid(false),
+      m_linkBudgetCache(false),
+      m_deliveryPolicy(BROADCAST),
+      m_endDeviceInterference(false),
+      m_subscription(false),
+      m_fanOut(false),
+      m_fanOutResolution(MicroSeconds(1)),
+      m_sortArrivals(false),
+      m_lookahead(Seconds(0)),
+      m_systemId(0)
 {
 }
 
 LoraChannel::~LoraChannel()
 {
+    for (const auto& mobility : m_watchedMobility)
+    {
+        mobility->TraceDisconnectWithoutContext(
+            "CourseChange",
+            MakeCallback(&LoraChannel::NotifyCourseChange, this));
+    }
+    m_watchedMobility.clear();
     m_phyList.clear();
 }
 
 LoraChannel::LoraChannel(Ptr<PropagationLossModel> loss, Ptr<PropagationDelayModel> delay)
     : m_loss(loss),
-      m_delay(delay)
+      m_delay(delay),
+      m_maxRange(0),
+      m_spatialIndexValid(false),
+      m_linkBudgetCache(false),
+      m_deliveryPolicy(BROADCAST),
+      m_endDeviceInterference(false),
+      m_subscription(false),
+      m_fanOut(false),
+      m_fanOutResolution(MicroSeconds(1)),
+      m_sortArrivals(false),
+      m_lookahead(Seconds(0)),
+      m_systemId(0)
 {
 }
 
@@ -86,6 +313,29 @@ LoraChannel::Add(Ptr<LoraPhy> phy)
 
     // Add the new phy to the vector
     m_phyList.push_back(phy);
+    m_phyGenerations.push_back(0);
+
+    uint32_t j = m_phyList.size() - 1;
+    bool isGateway = bool(DynamicCast<GatewayLoraPhy>(phy));
+    m_phyIndices[PeekPointer(phy)] = j;
+    m_isGatewayPhy.push_back(isGateway);
+    (isGateway ? m_gatewayPhys : m_endDevicePhys).push_back(j);
+    m_endDeviceAddresses.clear();
+    m_subscribedFrequencies.push_back(0);
+    if (!m_phySystemIds.empty())
+    {
+        m_phySystemIds.push_back(phy->GetDevice()->GetNode()->GetSystemId());
+    }
+
+    // The PHY may already be listening
+    Ptr<EndDeviceLoraPhy> edPhy = DynamicCast<EndDeviceLoraPhy>(phy);
+    if (edPhy && (edPhy->GetState() == EndDeviceLoraPhy::STANDBY ||
+                  edPhy->GetState() == EndDeviceLoraPhy::RX))
+    {
+        Subscribe(phy, edPhy->GetFrequency());
+    }
+
+    InvalidateSpatialIndex();
 }
 
 void
@@ -94,7 +344,19 @@ LoraChannel::Remove(Ptr<LoraPhy> phy)
     NS_LOG_FUNCTION(this << phy);
 
     // Remove the phy from the vector
-    m_phyList.erase(find(m_phyList.begin(), m_phyList.end(), phy));
+    auto it = find(m_phyList.begin(), m_phyList.end(), phy);
+    m_phyGenerations.erase(m_phyGenerations.begin() + (it - m_phyList.begin()));
+    m_subscribedFrequencies.erase(m_subscribedFrequencies.begin() + (it - m_phyList.begin()));
+    if (!m_phySystemIds.empty())
+    {
+        m_phySystemIds.erase(m_phySystemIds.begin() + (it - m_phyList.begin()));
+    }
+    m_phyList.erase(it);
+
+    // Indices of the following PHYs have changed
+    RebuildPhyIndices();
+    m_linkBudgets.clear();
+    InvalidateSpatialIndex();
 }
 
 std::size_t
@@ -124,89 +386,1436 @@ LoraChannel::Send(Ptr<LoraPhy> sender,
 
     NS_ASSERT(senderMobility); // Make sure it's available
 
-    NS_LOG_INFO("Starting cycle over all " << m_phyList.size() << " PHYs");
     NS_LOG_INFO("Sender mobility: " << senderMobility->GetPosition());
 
-    // Cycle over all registered PHYs
-    uint32_t j = 0;
-    std::vector<Ptr<LoraPhy>>::const_iterator i;
-    for (i = m_phyList.begin(); i != m_phyList.end(); i++, j++)
+    uint32_t i = GetPhyIndex(sender);
+
+#ifdef NS3_MPI
+    NS_ABORT_MSG_IF(m_phySystemIds.empty() && MpiInterface::IsEnabled() &&
+                        MpiInterface::GetSize() > 1,
+                    "LoraChannel needs a positive Lookahead in distributed simulations");
+#endif
+
+    if (!m_phySystemIds.empty() && i < m_phyList.size())
+    {
+        SendToRemoteSystems(i,
+                            senderMobility,
+                            packet,
+                            txPowerDbm,
+                            txParams,
+                            duration,
+                            frequencyMHz);
+    }
+
+    SendToLocalPhys(i,
+                    sender,
+                    senderMobility,
+                    packet,
+                    txPowerDbm,
+                    txParams,
+                    duration,
+                    frequencyMHz,
+                    Seconds(0));
+}
+
+void
+LoraChannel::SendToLocalPhys(uint32_t i,
+                             Ptr<LoraPhy> sender,
+                             Ptr<MobilityModel> senderMobility,
+                             Ptr<Packet> packet,
+                             double txPowerDbm,
+                             LoraTxParameters txParams,
+                             Time duration,
+                             double frequencyMHz,
+                             Time elapsed) const
+{
+    NS_LOG_FUNCTION(this << i << sender << packet << elapsed);
+
+    // Select the roles of the PHYs that should be notified
+    bool toGateways;
+    bool toEndDevices;
+    uint32_t addressed;
+    GetDeliveryTargets(i, packet, toGateways, toEndDevices, addressed);
+
+    NS_ABORT_MSG_IF(m_fanOut && m_sortArrivals,
+                    "FanOut and SortSimultaneousArrivals can't be enabled together");
+
+    // Receivers grouped by delay, if fan-out is enabled
+    FanOutGroups groups;
+
+    // Receivers whose link budget is computed in parallel, if enabled
+    std::vector<uint32_t> receivers;
+
+    // The other PHYs of the sender's device, such as the other sectors of a
+    // gateway, are transmitting too
+    Ptr<NetDevice> senderDevice = sender ? sender->GetDevice() : nullptr;
+
+    auto sendToPhy = [&](uint32_t j) {
+        // Do not deliver to the sender, or to the other PHYs of its device
+        if (sender == m_phyList[j] || (senderDevice && senderDevice == m_phyList[j]->GetDevice()))
+        {
+            return;
+        }
+
+        // PHYs of other systems are notified by their own system
+        if (!m_phySystemIds.empty() && m_phySystemIds[j] != m_systemId)
+        {
+            return;
+        }
+
+        if (m_maxRange > 0 &&
+            senderMobility->GetDistanceFrom(m_phyList[j]->GetMobility()) > m_maxRange)
+        {
+            NS_LOG_DEBUG("Skipping PHY " << j << " because it's out of range");
+            return;
+        }
+
+        // Link budgets are computed later, all at once
+        if (m_threadPool)
+        {
+            receivers.push_back(j);
+            return;
+        }
+
+        SendToPhy(i,
+                  j,
+                  senderMobility,
+                  packet,
+                  txPowerDbm,
+                  txParams,
+                  duration,
+                  frequencyMHz,
+                  elapsed,
+                  m_fanOut ? &groups : nullptr);
+    };
+
+    // End devices that subscribed to a different frequency, or that did not
+    // subscribe at all, are not notified
+    const std::set<uint32_t>* subscribers = nullptr;
+    std::set<uint32_t> mergedSubscribers;
+    if (m_subscription && toEndDevices)
     {
-        // Do not deliver to the sender (*i is the current PHY)
-        if (sender != (*i))
+        auto it = m_subscribers.find(frequencyMHz);
+        subscribers = (it != m_subscribers.end()) ? &it->second : &m_noSubscribers;
+
+        // End devices waiting for a receive window are notified on any
+        // frequency
+        auto all = m_subscribers.find(ALL_FREQUENCIES);
+        if (all != m_subscribers.end() && !all->second.empty())
+        {
+            mergedSubscribers = all->second;
+            mergedSubscribers.insert(subscribers->begin(), subscribers->end());
+            subscribers = &mergedSubscribers;
+        }
+    }
+
+    auto isReceiver = [&](uint32_t j) {
+        if (m_isGatewayPhy[j])
         {
-            // Get the receiver's mobility model
-            Ptr<MobilityModel> receiverMobility = (*i)->GetMobility()->GetObject<MobilityModel>();
+            return toGateways;
+        }
+        return toEndDevices && (!subscribers || subscribers->count(j) > 0);
+    };
 
-            NS_LOG_INFO("Receiver mobility: " << receiverMobility->GetPosition());
+    if (addressed < m_phyList.size())
+    {
+        NS_LOG_INFO("Only delivering to the addressed PHY " << addressed);
 
-            // Compute delay using the delay model
-            Time delay = m_delay->GetDelay(senderMobility, receiverMobility);
+        if (isReceiver(addressed))
+        {
+            sendToPhy(addressed);
+        }
+    }
+    else if (m_maxRange > 0)
+    {
+        // Only consider the PHYs that are close enough to the sender, in the
+        // same order as they appear in m_phyList
+        std::vector<uint32_t> candidates = GetCandidateReceivers(senderMobility->GetPosition());
 
-            // Compute received power using the loss model
-            double rxPowerDbm = GetRxPower(txPowerDbm, senderMobility, receiverMobility);
+        NS_LOG_INFO("Starting cycle over " << candidates.size() << " candidate PHYs");
 
-            NS_LOG_DEBUG("Propagation: txPower="
-                         << txPowerDbm << "dbm, rxPower=" << rxPowerDbm << "dbm, "
-                         << "distance=" << senderMobility->GetDistanceFrom(receiverMobility)
-                         << "m, delay=" << delay);
+        for (auto j : candidates)
+        {
+            if (isReceiver(j))
+            {
+                sendToPhy(j);
+            }
+        }
+    }
+    else if (subscribers)
+    {
+        NS_LOG_INFO("Starting cycle over " << subscribers->size() << " subscribed PHYs");
 
-            // Get the id of the destination PHY to correctly format the context
-            Ptr<NetDevice> dstNetDevice = m_phyList[j]->GetDevice();
-            uint32_t dstNode = 0;
-            if (dstNetDevice)
+        // Visit gateways and subscribed end devices in the order in which
+        // they appear in m_phyList
+        auto gw = toGateways ? m_gatewayPhys.begin() : m_gatewayPhys.end();
+        auto ed = subscribers->begin();
+        while (gw != m_gatewayPhys.end() || ed != subscribers->end())
+        {
+            if (ed == subscribers->end() || (gw != m_gatewayPhys.end() && *gw < *ed))
             {
-                NS_LOG_INFO("Getting node index from NetDevice, since it exists");
-                dstNode = dstNetDevice->GetNode()->GetId();
-                NS_LOG_DEBUG("dstNode = " << dstNode);
+                sendToPhy(*gw++);
             }
             else
             {
-                NS_LOG_INFO("No net device connected to the PHY, using context 0");
+                sendToPhy(*ed++);
+            }
+        }
+    }
+    else if (toGateways && toEndDevices)
+    {
+        NS_LOG_INFO("Starting cycle over all " << m_phyList.size() << " PHYs");
+
+        // Cycle over all registered PHYs
+        for (uint32_t j = 0; j < m_phyList.size(); j++)
+        {
+            sendToPhy(j);
+        }
+    }
+    else
+    {
+        const std::vector<uint32_t>& phys = toGateways ? m_gatewayPhys : m_endDevicePhys;
+
+        NS_LOG_INFO("Starting cycle over " << phys.size()
+                                           << (toGateways ? " gateway" : " end device")
+                                           << " PHYs");
+
+        for (auto j : phys)
+        {
+            sendToPhy(j);
+        }
+    }
+
+    if (!receivers.empty())
+    {
+        NS_LOG_INFO("Computing the link budget of " << receivers.size() << " PHYs with "
+                                                    << m_threadPool->GetNThreads()
+                                                    << " threads");
+
+        std::vector<Ptr<MobilityModel>> receiverMobilities;
+        std::vector<double> rxPowersDbm;
+        std::vector<Time> delays;
+        ComputeLinkBudgets(i,
+                           senderMobility,
+                           receivers,
+                           txPowerDbm,
+                           receiverMobilities,
+                           rxPowersDbm,
+                           delays);
+
+        // Schedule receptions serially, in the same order as the sequential
+        // loop would
+        for (std::size_t k = 0; k < receivers.size(); k++)
+        {
+            DeliverToPhy(i,
+                         receivers[k],
+                         senderMobility,
+                         receiverMobilities[k],
+                         packet,
+                         txPowerDbm,
+                         rxPowersDbm[k],
+                         delays[k],
+                         txParams,
+                         duration,
+                         frequencyMHz,
+                         elapsed,
+                         m_fanOut ? &groups : nullptr);
+        }
+    }
+
+    if (m_fanOut && !groups.empty())
+    {
+        NS_LOG_INFO("Scheduling reception of the packet at " << groups.size() << " times");
+
+        for (auto& [delay, group] : groups)
+        {
+            Simulator::Schedule(delay,
+                                &LoraChannel::ReceiveGroup,
+                                this,
+                                std::move(group),
+                                packet,
+                                txParams.sf,
+                                duration,
+                                frequencyMHz);
+        }
+
+        // Fire the trace source for sent packet
+        m_packetSent(packet);
+    }
+}
+
+void
+LoraChannel::Subscribe(Ptr<LoraPhy> phy, double frequencyMHz)
+{
+    NS_LOG_FUNCTION(this << phy << frequencyMHz);
+
+    uint32_t j = GetPhyIndex(phy);
+    if (j == m_phyList.size() || m_subscribedFrequencies[j] == frequencyMHz)
+    {
+        return;
+    }
+
+    Unsubscribe(phy);
+    m_subscribedFrequencies[j] = frequencyMHz;
+    m_subscribers[frequencyMHz].insert(j);
+}
+
+void
+LoraChannel::SubscribeToAllFrequencies(Ptr<LoraPhy> phy)
+{
+    NS_LOG_FUNCTION(this << phy);
+
+    Subscribe(phy, ALL_FREQUENCIES);
+}
+
+void
+LoraChannel::Unsubscribe(Ptr<LoraPhy> phy)
+{
+    NS_LOG_FUNCTION(this << phy);
+
+    uint32_t j = GetPhyIndex(phy);
+    if (j == m_phyList.size() || m_subscribedFrequencies[j] == 0)
+    {
+        return;
+    }
+
+    m_subscribers[m_subscribedFrequencies[j]].erase(j);
+    m_subscribedFrequencies[j] = 0;
+}
+
+uint32_t
+LoraChannel::GetPhyIndex(Ptr<LoraPhy> phy) const
+{
+    auto it = m_phyIndices.find(PeekPointer(phy));
+    if (it == m_phyIndices.end())
+    {
+        return m_phyList.size();
+    }
+    return it->second;
+}
+
+uint32_t
+LoraChannel::GetAddressedEndDevice(Ptr<Packet> packet) const
+{
+    NS_LOG_FUNCTION(this << packet);
+
+    // Work on a copy of the packet
+    Ptr<Packet> packetCopy = packet->Copy();
+
+    LorawanMacHeader mHdr;
+    if (packetCopy->GetSize() < mHdr.GetSerializedSize())
+    {
+        return m_phyList.size();
+    }
+    packetCopy->RemoveHeader(mHdr);
+    if (mHdr.IsUplink())
+    {
+        return m_phyList.size();
+    }
+
+    LoraFrameHeader fHdr;
+    fHdr.SetAsDownlink();
+    if (packetCopy->GetSize() < fHdr.GetSerializedSize())
+    {
+        return m_phyList.size();
+    }
+    packetCopy->RemoveHeader(fHdr);
+    uint32_t address = fHdr.GetAddress().Get();
+
+    if (m_endDeviceAddresses.find(address) == m_endDeviceAddresses.end())
+    {
+        // Addresses may have been assigned after we last looked them up
+        m_endDeviceAddresses.clear();
+        for (auto j : m_endDevicePhys)
+        {
+            Ptr<LoraNetDevice> device = DynamicCast<LoraNetDevice>(m_phyList[j]->GetDevice());
+            if (!device)
+            {
+                continue;
             }
+            Ptr<EndDeviceLorawanMac> mac = DynamicCast<EndDeviceLorawanMac>(device->GetMac());
+            if (mac)
+            {
+                m_endDeviceAddresses[mac->GetDeviceAddress().Get()] = j;
+            }
+        }
+    }
+
+    auto it = m_endDeviceAddresses.find(address);
+    if (it == m_endDeviceAddresses.end())
+    {
+        NS_LOG_DEBUG("No end device with address " << fHdr.GetAddress());
+        return m_phyList.size();
+    }
+    return it->second;
+}
+
+void
+LoraChannel::GetDeliveryTargets(uint32_t i,
+                                Ptr<Packet> packet,
+                                bool& toGateways,
+                                bool& toEndDevices,
+                                uint32_t& addressed) const
+{
+    toGateways = true;
+    toEndDevices = true;
+    addressed = m_phyList.size();
+    if (m_deliveryPolicy != BROADCAST)
+    {
+        if (i < m_phyList.size() && m_isGatewayPhy[i])
+        {
+            toGateways = false;
+            if (m_deliveryPolicy == ADDRESSED)
+            {
+                addressed = GetAddressedEndDevice(packet);
+            }
+        }
+        else
+        {
+            toEndDevices = m_endDeviceInterference;
+        }
+    }
+}
+
+void
+LoraChannel::RebuildPhyIndices()
+{
+    NS_LOG_FUNCTION(this);
+
+    m_phyIndices.clear();
+    m_isGatewayPhy.clear();
+    m_gatewayPhys.clear();
+    m_endDevicePhys.clear();
+    m_endDeviceAddresses.clear();
+    m_subscribers.clear();
+
+    for (uint32_t j = 0; j < m_phyList.size(); j++)
+    {
+        bool isGateway = bool(DynamicCast<GatewayLoraPhy>(m_phyList[j]));
+        m_phyIndices[PeekPointer(m_phyList[j])] = j;
+        m_isGatewayPhy.push_back(isGateway);
+        (isGateway ? m_gatewayPhys : m_endDevicePhys).push_back(j);
+        if (m_subscribedFrequencies[j] != 0)
+        {
+            m_subscribers[m_subscribedFrequencies[j]].insert(j);
+        }
+    }
+}
+
+void
+LoraChannel::SendToPhy(uint32_t i,
+                       uint32_t j,
+                       Ptr<MobilityModel> senderMobility,
+                       Ptr<Packet> packet,
+                       double txPowerDbm,
+                       LoraTxParameters txParams,
+                       Time duration,
+                       double frequencyMHz,
+                       Time elapsed,
+                       FanOutGroups* groups) const
+{
+    // Get the receiver's mobility model
+    Ptr<MobilityModel> receiverMobility = m_phyList[j]->GetMobility()->GetObject<MobilityModel>();
+
+    NS_LOG_INFO("Receiver mobility: " << receiverMobility->GetPosition());
+
+    // Compute delay and received power using the delay and loss models
+    Time delay;
+    double rxPowerDbm =
+        GetLinkBudget(i, j, senderMobility, receiverMobility, txPowerDbm, delay);
+
+    DeliverToPhy(i,
+                 j,
+                 senderMobility,
+                 receiverMobility,
+                 packet,
+                 txPowerDbm,
+                 rxPowerDbm,
+                 delay,
+                 txParams,
+                 duration,
+                 frequencyMHz,
+                 elapsed,
+                 groups);
+}
+
+void
+LoraChannel::DeliverToPhy(uint32_t i,
+                          uint32_t j,
+                          Ptr<MobilityModel> senderMobility,
+                          Ptr<MobilityModel> receiverMobility,
+                          Ptr<Packet> packet,
+                          double txPowerDbm,
+                          double rxPowerDbm,
+                          Time delay,
+                          LoraTxParameters txParams,
+                          Time duration,
+                          double frequencyMHz,
+                          Time elapsed,
+                          FanOutGroups* groups) const
+{
+    // Apply the random components of the loss, if any
+    if (m_perPacketLoss)
+    {
+        rxPowerDbm = m_perPacketLoss->CalcRxPower(rxPowerDbm, senderMobility, receiverMobility);
+    }
+
+    NS_LOG_DEBUG("Propagation: txPower="
+                 << txPowerDbm << "dbm, rxPower=" << rxPowerDbm << "dbm, "
+                 << "distance=" << senderMobility->GetDistanceFrom(receiverMobility)
+                 << "m, delay=" << delay);
+
+    if (groups)
+    {
+        // Round the delay to the fan-out resolution, so that receivers at
+        // similar distances share the same event
+        int64_t step = m_fanOutResolution.GetTimeStep();
+        if (step > 0)
+        {
+            delay = TimeStep((delay.GetTimeStep() + step / 2) / step * step);
+        }
+    }
 
-            // Create the parameters object based on the calculations above
-            LoraChannelParameters parameters;
-            parameters.rxPowerDbm = rxPowerDbm;
-            parameters.sf = txParams.sf;
-            parameters.duration = duration;
-            parameters.frequencyMHz = frequencyMHz;
+    // Part of the delay may have already elapsed on another system. Sorted
+    // signals also need to arrive after the lookahead, not with it.
+    if (elapsed.IsStrictlyPositive())
+    {
+        if (delay < elapsed || (m_sortArrivals && delay == elapsed))
+        {
+            NS_LOG_WARN("Lookahead " << elapsed << " exceeds the propagation delay " << delay
+                                     << " to PHY " << j);
+            delay = elapsed;
+        }
+        delay -= elapsed;
+    }
+
+    if (groups)
+    {
+        (*groups)[delay].emplace_back(j, rxPowerDbm);
+        return;
+    }
+
+    // Get the id of the destination PHY to correctly format the context
+    Ptr<NetDevice> dstNetDevice = m_phyList[j]->GetDevice();
+    uint32_t dstNode = 0;
+    if (dstNetDevice)
+    {
+        NS_LOG_INFO("Getting node index from NetDevice, since it exists");
+        dstNode = dstNetDevice->GetNode()->GetId();
+        NS_LOG_DEBUG("dstNode = " << dstNode);
+    }
+    else
+    {
+        NS_LOG_INFO("No net device connected to the PHY, using context 0");
+    }
 
-            // Schedule the receive event
+    // Create the parameters object based on the calculations above
+    LoraChannelParameters parameters;
+    parameters.rxPowerDbm = rxPowerDbm;
+    parameters.sf = txParams.sf;
+    parameters.duration = duration;
+    parameters.frequencyMHz = frequencyMHz;
+
+    if (m_sortArrivals)
+    {
+        // Signals that reach the PHY at the same time share a receive event,
+        // which sorts them. Packets from other systems carry their original
+        // uid, so that the order is the same on all systems.
+        LoraOriginTag origin;
+        uint64_t uid = packet->PeekPacketTag(origin) ? origin.GetPacketUid() : packet->GetUid();
+        Time arrivalTime = Simulator::Now() + delay;
+        std::vector<Arrival>& arrivals = m_arrivals[{arrivalTime, j}];
+        if (arrivals.empty())
+        {
             NS_LOG_INFO("Scheduling reception of the packet");
             Simulator::ScheduleWithContext(dstNode,
                                            delay,
-                                           &LoraChannel::Receive,
+                                           &LoraChannel::ReceiveArrivals,
                                            this,
                                            j,
-                                           packet,
-                                           parameters);
-
-            // Fire the trace source for sent packet
-            m_packetSent(packet);
+                                           arrivalTime);
         }
+        arrivals.push_back({i, uid, packet, parameters});
     }
+    else
+    {
+        // Schedule the receive event
+        NS_LOG_INFO("Scheduling reception of the packet");
+        Simulator::ScheduleWithContext(dstNode,
+                                       delay,
+                                       &LoraChannel::Receive,
+                                       this,
+                                       j,
+                                       packet,
+                                       parameters);
+    }
+
+    // Fire the trace source for sent packet
+    m_packetSent(packet);
 }
 
-void
-LoraChannel::Receive(uint32_t i, Ptr<Packet> packet, LoraChannelParameters parameters) const
+double
+LoraChannel::GetLinkBudget(uint32_t i,
+                           uint32_t j,
+                           Ptr<MobilityModel> senderMobility,
+                           Ptr<MobilityModel> receiverMobility,
+                           double txPowerDbm,
+                           Time& delay) const
 {
-    NS_LOG_FUNCTION(this << i << packet << parameters);
+    double rxPowerDbm;
+    if (LookupLinkBudget(i, j, senderMobility, receiverMobility, txPowerDbm, rxPowerDbm, delay))
+    {
+        return rxPowerDbm;
+    }
 
-    // Call the appropriate PHY instance to let it begin reception
-    m_phyList[i]->StartReceive(packet,
-                               parameters.rxPowerDbm,
-                               parameters.sf,
-                               parameters.duration,
-                               parameters.frequencyMHz);
+    delay = m_delay->GetDelay(senderMobility, receiverMobility);
+    rxPowerDbm = m_loss->CalcRxPower(txPowerDbm, senderMobility, receiverMobility);
+    rxPowerDbm += GetAntennaGain(i, j, senderMobility, receiverMobility);
+
+    StoreLinkBudget(i, j, senderMobility, receiverMobility, txPowerDbm, rxPowerDbm, delay);
+
+    return rxPowerDbm;
 }
 
 double
-LoraChannel::GetRxPower(double txPowerDbm,
-                        Ptr<MobilityModel> senderMobility,
-                        Ptr<MobilityModel> receiverMobility) const
+LoraChannel::GetAntennaGain(uint32_t i,
+                            uint32_t j,
+                            Ptr<MobilityModel> senderMobility,
+                            Ptr<MobilityModel> receiverMobility) const
 {
-    return m_loss->CalcRxPower(txPowerDbm, senderMobility, receiverMobility);
+    Ptr<AntennaModel> txAntenna = i < m_phyList.size() ? m_phyList[i]->GetAntenna() : nullptr;
+    Ptr<AntennaModel> rxAntenna = m_phyList[j]->GetAntenna();
+    if (!txAntenna && !rxAntenna)
+    {
+        return 0;
+    }
+
+    Vector senderPosition = senderMobility->GetPosition();
+    Vector receiverPosition = receiverMobility->GetPosition();
+
+    double gainDb = 0;
+    if (txAntenna)
+    {
+        gainDb += txAntenna->GetGainDb(Angles(receiverPosition, senderPosition));
+    }
+    if (rxAntenna)
+    {
+        gainDb += rxAntenna->GetGainDb(Angles(senderPosition, receiverPosition));
+    }
+
+    NS_LOG_DEBUG("Antenna gain between PHYs " << i << " and " << j << ": " << gainDb << " dB");
+    return gainDb;
+}
+
+void
+LoraChannel::ComputeLinkBudgets(uint32_t i,
+                                Ptr<MobilityModel> senderMobility,
+                                const std::vector<uint32_t>& receivers,
+                                double txPowerDbm,
+                                std::vector<Ptr<MobilityModel>>& receiverMobilities,
+                                std::vector<double>& rxPowersDbm,
+                                std::vector<Time>& delays) const
+{
+    NS_LOG_FUNCTION(this << i << senderMobility << receivers.size() << txPowerDbm);
+
+    std::size_t n = receivers.size();
+    receiverMobilities.resize(n);
+    rxPowersDbm.resize(n);
+    delays.resize(n);
+
+    for (std::size_t k = 0; k < n; k++)
+    {
+        receiverMobilities[k] = m_phyList[receivers[k]]->GetMobility();
+    }
+
+    // Loss models can only be evaluated on the simulation thread, since they
+    // use reference counted mobility models and random variables. Only the
+    // log distance loss, which is a function of the positions, can be
+    // computed by the thread pool.
+    if (m_loss->GetInstanceTypeId() != LogDistancePropagationLossModel::GetTypeId())
+    {
+        for (std::size_t k = 0; k < n; k++)
+        {
+            rxPowersDbm[k] = GetLinkBudget(i,
+                                           receivers[k],
+                                           senderMobility,
+                                           receiverMobilities[k],
+                                           txPowerDbm,
+                                           delays[k]);
+        }
+        return;
+    }
+
+    // Only compute the links that are not cached
+    std::vector<std::size_t> misses;
+    for (std::size_t k = 0; k < n; k++)
+    {
+        if (!LookupLinkBudget(i,
+                              receivers[k],
+                              senderMobility,
+                              receiverMobilities[k],
+                              txPowerDbm,
+                              rxPowersDbm[k],
+                              delays[k]))
+        {
+            misses.push_back(k);
+        }
+    }
+
+    std::size_t m = misses.size();
+    std::vector<double> x(m);
+    std::vector<double> y(m);
+    std::vector<double> z(m);
+    for (std::size_t p = 0; p < m; p++)
+    {
+        Vector position = receiverMobilities[misses[p]]->GetPosition();
+        x[p] = position.x;
+        y[p] = position.y;
+        z[p] = position.z;
+    }
+
+    DoubleValue exponent;
+    DoubleValue referenceDistance;
+    DoubleValue referenceLoss;
+    m_loss->GetAttribute("Exponent", exponent);
+    m_loss->GetAttribute("ReferenceDistance", referenceDistance);
+    m_loss->GetAttribute("ReferenceLoss", referenceLoss);
+
+    Vector senderPosition = senderMobility->GetPosition();
+    std::vector<double> distances(m);
+    std::vector<double> values(m);
+    m_threadPool->ParallelFor(m, [&](std::size_t begin, std::size_t end) {
+        ComputeDistances(senderPosition,
+                         x.data() + begin,
+                         y.data() + begin,
+                         z.data() + begin,
+                         distances.data() + begin,
+                         end - begin);
+        std::copy(distances.begin() + begin, distances.begin() + end, values.begin() + begin);
+        ComputeLogDistanceRxPowers(txPowerDbm,
+                                   exponent.Get(),
+                                   referenceDistance.Get(),
+                                   referenceLoss.Get(),
+                                   values.data() + begin,
+                                   end - begin);
+    });
+
+    // The delay of a ConstantSpeedPropagationDelayModel only depends on the
+    // distance we already have
+    bool constantSpeed =
+        m_delay->GetInstanceTypeId() == ConstantSpeedPropagationDelayModel::GetTypeId();
+    DoubleValue speed;
+    if (constantSpeed)
+    {
+        m_delay->GetAttribute("Speed", speed);
+    }
+
+    // Evaluate the rest of the chain serially, in receiver order
+    std::vector<Ptr<MobilityModel>> missMobilities(m);
+    for (std::size_t p = 0; p < m; p++)
+    {
+        missMobilities[p] = receiverMobilities[misses[p]];
+    }
+    CalcChainRxPowers(m_loss->GetNext(), senderMobility, missMobilities, values.data());
+
+    for (std::size_t p = 0; p < m; p++)
+    {
+        std::size_t k = misses[p];
+        delays[k] = constantSpeed ? Seconds(distances[p] / speed.Get())
+                                  : m_delay->GetDelay(senderMobility, receiverMobilities[k]);
+        rxPowersDbm[k] = values[p];
+        rxPowersDbm[k] += GetAntennaGain(i, receivers[k], senderMobility, receiverMobilities[k]);
+
+        StoreLinkBudget(i,
+                        receivers[k],
+                        senderMobility,
+                        receiverMobilities[k],
+                        txPowerDbm,
+                        rxPowersDbm[k],
+                        delays[k]);
+    }
+}
+
+bool
+LoraChannel::IsLinkCacheable(uint32_t i,
+                             Ptr<MobilityModel> senderMobility,
+                             Ptr<MobilityModel> receiverMobility) const
+{
+    // Links between PHYs that may move without notice cannot be cached
+    return m_linkBudgetCache && i < m_phyList.size() &&
+           DynamicCast<ConstantPositionMobilityModel>(senderMobility) &&
+           DynamicCast<ConstantPositionMobilityModel>(receiverMobility);
+}
+
+bool
+LoraChannel::LookupLinkBudget(uint32_t i,
+                              uint32_t j,
+                              Ptr<MobilityModel> senderMobility,
+                              Ptr<MobilityModel> receiverMobility,
+                              double txPowerDbm,
+                              double& rxPowerDbm,
+                              Time& delay) const
+{
+    if (!IsLinkCacheable(i, senderMobility, receiverMobility))
+    {
+        return false;
+    }
+
+    auto it = m_linkBudgets.find((uint64_t(i) << 32) | j);
+    if (it == m_linkBudgets.end())
+    {
+        return false;
+    }
+
+    const LinkBudget& link = it->second;
+    if (link.senderMobility != PeekPointer(senderMobility) ||
+        link.receiverMobility != PeekPointer(receiverMobility) ||
+        link.senderAntenna != PeekPointer(m_phyList[i]->GetAntenna()) ||
+        link.receiverAntenna != PeekPointer(m_phyList[j]->GetAntenna()) ||
+        link.senderGeneration != m_phyGenerations[i] ||
+        link.receiverGeneration != m_phyGenerations[j] || link.txPowerDbm != txPowerDbm)
+    {
+        return false;
+    }
+
+    NS_LOG_DEBUG("Using cached link budget between PHYs " << i << " and " << j);
+    rxPowerDbm = link.rxPowerDbm;
+    delay = link.delay;
+    return true;
+}
+
+void
+LoraChannel::StoreLinkBudget(uint32_t i,
+                             uint32_t j,
+                             Ptr<MobilityModel> senderMobility,
+                             Ptr<MobilityModel> receiverMobility,
+                             double txPowerDbm,
+                             double rxPowerDbm,
+                             Time delay) const
+{
+    if (!IsLinkCacheable(i, senderMobility, receiverMobility))
+    {
+        return;
+    }
+
+    // Positions of the sender received from another system (see
+    // ReceiveRemote) are not cached. Lookups need no such check, since they
+    // compare the mobility models of the entry.
+    if (senderMobility != m_phyList[i]->GetMobility())
+    {
+        return;
+    }
+
+    // Make sure we hear about position changes of both ends of the link
+    WatchMobility(senderMobility);
+    WatchMobility(receiverMobility);
+
+    LinkBudget& link = m_linkBudgets[(uint64_t(i) << 32) | j];
+    link.senderMobility = PeekPointer(senderMobility);
+    link.receiverMobility = PeekPointer(receiverMobility);
+    link.senderAntenna = PeekPointer(m_phyList[i]->GetAntenna());
+    link.receiverAntenna = PeekPointer(m_phyList[j]->GetAntenna());
+    link.senderGeneration = m_phyGenerations[i];
+    link.receiverGeneration = m_phyGenerations[j];
+    link.txPowerDbm = txPowerDbm;
+    link.rxPowerDbm = rxPowerDbm;
+    link.delay = delay;
+}
+
+void
+LoraChannel::WatchMobility(Ptr<MobilityModel> mobility) const
+{
+    if (m_watchedMobility.insert(mobility).second)
+    {
+        mobility->TraceConnectWithoutContext(
+            "CourseChange",
+            MakeCallback(&LoraChannel::NotifyCourseChange, this));
+    }
+}
+
+std::vector<uint32_t>
+LoraChannel::GetCandidateReceivers(const Vector& position) const
+{
+    if (!m_spatialIndexValid)
+    {
+        BuildSpatialIndex();
+    }
+
+    std::vector<uint32_t> candidates = m_unindexedPhys;
+
+    // Since cells are as large as the range, receivers in range can only be in
+    // the cell of the sender or in the neighboring ones
+    auto [x, y] = GetCell(position);
+    for (int64_t i = x - 1; i <= x + 1; i++)
+    {
+        for (int64_t k = y - 1; k <= y + 1; k++)
+        {
+            auto it = m_grid.find(std::make_pair(i, k));
+            if (it != m_grid.end())
+            {
+                candidates.insert(candidates.end(), it->second.begin(), it->second.end());
+            }
+        }
+    }
+
+    std::sort(candidates.begin(), candidates.end());
+
+    return candidates;
+}
+
+void
+LoraChannel::BuildSpatialIndex() const
+{
+    NS_LOG_FUNCTION(this);
+
+    m_grid.clear();
+    m_unindexedPhys.clear();
+
+    for (uint32_t j = 0; j < m_phyList.size(); j++)
+    {
+        Ptr<MobilityModel> mobility = m_phyList[j]->GetMobility();
+
+        // Only PHYs whose position changes are notified through CourseChange
+        // can be indexed
+        if (!DynamicCast<ConstantPositionMobilityModel>(mobility))
+        {
+            m_unindexedPhys.push_back(j);
+            continue;
+        }
+
+        WatchMobility(mobility);
+
+        m_grid[GetCell(mobility->GetPosition())].push_back(j);
+    }
+
+    NS_LOG_DEBUG("Indexed " << m_phyList.size() - m_unindexedPhys.size() << " PHYs in "
+                            << m_grid.size() << " cells");
+
+    m_spatialIndexValid = true;
+}
+
+void
+LoraChannel::InvalidateSpatialIndex() const
+{
+    m_spatialIndexValid = false;
+}
+
+void
+LoraChannel::NotifyCourseChange(Ptr<const MobilityModel> mobility) const
+{
+    NS_LOG_FUNCTION(this << mobility);
+
+    InvalidateSpatialIndex();
+
+    // Cached link budgets involving PHYs with this mobility model are stale
+    for (uint32_t j = 0; j < m_phyList.size(); j++)
+    {
+        if (m_phyList[j]->GetMobility() == mobility)
+        {
+            m_phyGenerations[j]++;
+        }
+    }
+}
+
+std::pair<int64_t, int64_t>
+LoraChannel::GetCell(const Vector& position) const
+{
+    return std::make_pair(int64_t(std::floor(position.x / m_maxRange)),
+                          int64_t(std::floor(position.y / m_maxRange)));
+}
+
+void
+LoraChannel::SetMaxRange(double maxRange)
+{
+    NS_LOG_FUNCTION(this << maxRange);
+
+    m_maxRange = maxRange;
+    InvalidateSpatialIndex();
+}
+
+double
+LoraChannel::GetMaxRange() const
+{
+    return m_maxRange;
+}
+
+void
+LoraChannel::SetLinkBudgetCacheEnabled(bool enabled)
+{
+    NS_LOG_FUNCTION(this << enabled);
+
+    m_linkBudgetCache = enabled;
+    m_linkBudgets.clear();
+}
+
+bool
+LoraChannel::IsLinkBudgetCacheEnabled() const
+{
+    return m_linkBudgetCache;
+}
+
+void
+LoraChannel::SetLinkBudgetThreads(uint32_t nThreads)
+{
+    NS_LOG_FUNCTION(this << nThreads);
+
+    m_threadPool.reset();
+    if (nThreads > 1)
+    {
+        m_threadPool = std::make_unique<LoraThreadPool>(nThreads);
+    }
+}
+
+uint32_t
+LoraChannel::GetLinkBudgetThreads() const
+{
+    return m_threadPool ? m_threadPool->GetNThreads() : 1;
+}
+
+void
+LoraChannel::SetPerPacketLossModel(Ptr<PropagationLossModel> loss)
+{
+    NS_LOG_FUNCTION(this << loss);
+
+    m_perPacketLoss = loss;
+}
+
+void
+LoraChannel::SetLookahead(Time lookahead)
+{
+    NS_LOG_FUNCTION(this << lookahead);
+
+    m_lookahead = lookahead;
+
+#ifdef NS3_MPI
+    if (m_lookahead.IsStrictlyPositive() && MpiInterface::IsEnabled() &&
+        MpiInterface::GetSize() > 1)
+    {
+        Ptr<DistributedSimulatorImpl> simulator =
+            DynamicCast<DistributedSimulatorImpl>(Simulator::GetImplementation());
+        NS_ABORT_MSG_UNLESS(simulator,
+                            "LoraChannel needs the granted time window distributed simulator");
+        simulator->BoundLookAhead(m_lookahead);
+
+        // Wait for all PHYs to be connected to find out where they are
+        if (!m_setupEvent.IsRunning())
+        {
+            m_setupEvent = Simulator::ScheduleNow(&LoraChannel::SetupDistribution, this);
+        }
+    }
+#endif
+}
+
+Time
+LoraChannel::GetLookahead() const
+{
+    return m_lookahead;
+}
+
+Time
+LoraChannel::ComputeLookahead() const
+{
+    NS_LOG_FUNCTION(this);
+
+    Time lookahead = Time::Max();
+    for (uint32_t i = 0; i < m_phyList.size(); i++)
+    {
+        uint32_t systemId = m_phyList[i]->GetDevice()->GetNode()->GetSystemId();
+        for (uint32_t j = i + 1; j < m_phyList.size(); j++)
+        {
+            if (m_phyList[j]->GetDevice()->GetNode()->GetSystemId() == systemId)
+            {
+                continue;
+            }
+            lookahead = std::min(lookahead,
+                                 m_delay->GetDelay(m_phyList[i]->GetMobility(),
+                                                   m_phyList[j]->GetMobility()) -
+                                     TimeStep(1));
+        }
+    }
+    return lookahead;
+}
+
+void
+LoraChannel::SetupDistribution()
+{
+    NS_LOG_FUNCTION(this);
+
+#ifdef NS3_MPI
+    m_systemId = MpiInterface::GetSystemId();
+    m_systems.assign(MpiInterface::GetSize(), RemoteSystem{});
+    for (auto& system : m_systems)
+    {
+        system.hasGateways = false;
+        system.hasEndDevices = false;
+        system.isStatic = true;
+    }
+
+    m_phySystemIds.resize(m_phyList.size());
+    for (uint32_t j = 0; j < m_phyList.size(); j++)
+    {
+        Ptr<NetDevice> device = m_phyList[j]->GetDevice();
+        NS_ABORT_MSG_UNLESS(device, "PHYs need a NetDevice in distributed simulations");
+        uint32_t systemId = device->GetNode()->GetSystemId();
+        NS_ABORT_MSG_UNLESS(systemId < m_systems.size(), "Invalid system id " << systemId);
+        m_phySystemIds[j] = systemId;
+
+        // Messages to a system are addressed to the device of its first PHY
+        RemoteSystem& system = m_systems[systemId];
+        Vector position = m_phyList[j]->GetMobility()->GetPosition();
+        if (!system.mailbox)
+        {
+            system.mailbox = device;
+            system.minPosition = position;
+            system.maxPosition = position;
+        }
+        system.hasGateways |= m_isGatewayPhy[j];
+        system.hasEndDevices |= !m_isGatewayPhy[j];
+        system.isStatic &=
+            bool(DynamicCast<ConstantPositionMobilityModel>(m_phyList[j]->GetMobility()));
+        system.minPosition.x = std::min(system.minPosition.x, position.x);
+        system.minPosition.y = std::min(system.minPosition.y, position.y);
+        system.minPosition.z = std::min(system.minPosition.z, position.z);
+        system.maxPosition.x = std::max(system.maxPosition.x, position.x);
+        system.maxPosition.y = std::max(system.maxPosition.y, position.y);
+        system.maxPosition.z = std::max(system.maxPosition.z, position.z);
+    }
+
+    Ptr<NetDevice> mailbox = m_systems[m_systemId].mailbox;
+    if (mailbox)
+    {
+        NS_ABORT_MSG_IF(mailbox->GetObject<MpiReceiver>(),
+                        "The device of PHY " << mailbox << " already receives MPI messages");
+        Ptr<MpiReceiver> receiver = CreateObject<MpiReceiver>();
+        receiver->SetReceiveCallback(MakeCallback(&LoraChannel::ReceiveRemote, this));
+        mailbox->AggregateObject(receiver);
+    }
+
+    NS_LOG_INFO("System " << m_systemId << " of " << m_systems.size() << " is ready");
+#endif
+}
+
+void
+LoraChannel::SendToRemoteSystems(uint32_t i,
+                                 Ptr<MobilityModel> senderMobility,
+                                 Ptr<Packet> packet,
+                                 double txPowerDbm,
+                                 LoraTxParameters txParams,
+                                 Time duration,
+                                 double frequencyMHz) const
+{
+    NS_LOG_FUNCTION(this << i << packet);
+
+#ifdef NS3_MPI
+    bool toGateways;
+    bool toEndDevices;
+    uint32_t addressed;
+    GetDeliveryTargets(i, packet, toGateways, toEndDevices, addressed);
+
+    LoraRemoteTransmissionHeader header;
+    header.SetSender(i);
+    header.SetPosition(senderMobility->GetPosition());
+    header.SetTxPower(txPowerDbm);
+    header.SetSpreadingFactor(txParams.sf);
+    header.SetFrequency(frequencyMHz);
+    header.SetDuration(duration);
+    header.SetPacketUid(packet->GetUid());
+
+    Vector position = header.GetPosition();
+    for (uint32_t systemId = 0; systemId < m_systems.size(); systemId++)
+    {
+        const RemoteSystem& system = m_systems[systemId];
+        if (systemId == m_systemId || !system.mailbox)
+        {
+            continue;
+        }
+
+        // Skip systems without PHYs to notify
+        if (addressed < m_phyList.size())
+        {
+            if (m_phySystemIds[addressed] != systemId)
+            {
+                continue;
+            }
+        }
+        else if (!(toGateways && system.hasGateways) && !(toEndDevices && system.hasEndDevices))
+        {
+            continue;
+        }
+
+        // Skip systems whose PHYs are all out of range
+        if (m_maxRange > 0 && system.isStatic)
+        {
+            double dx = std::max({system.minPosition.x - position.x,
+                                  position.x - system.maxPosition.x,
+                                  0.0});
+            double dy = std::max({system.minPosition.y - position.y,
+                                  position.y - system.maxPosition.y,
+                                  0.0});
+            double dz = std::max({system.minPosition.z - position.z,
+                                  position.z - system.maxPosition.z,
+                                  0.0});
+            if (std::sqrt(dx * dx + dy * dy + dz * dz) > m_maxRange)
+            {
+                NS_LOG_DEBUG("Skipping system " << systemId << " because it's out of range");
+                continue;
+            }
+        }
+
+        Ptr<Packet> message = packet->Copy();
+        message->AddHeader(header);
+        MpiInterface::SendPacket(message,
+                                 Simulator::Now() + m_lookahead,
+                                 system.mailbox->GetNode()->GetId(),
+                                 system.mailbox->GetIfIndex());
+    }
+#endif
+}
+
+void
+LoraChannel::ReceiveRemote(Ptr<Packet> message)
+{
+    NS_LOG_FUNCTION(this << message);
+
+    LoraRemoteTransmissionHeader header;
+    message->RemoveHeader(header);
+
+    uint32_t i = header.GetSender();
+    NS_ASSERT(i < m_phyList.size());
+    Ptr<LoraPhy> sender = m_phyList[i];
+
+    // Use the local copy of the sender's mobility model, unless it lags
+    // behind the sender's system. The sender keeps its index, which
+    // determines its role and antenna, while links computed from the
+    // position in the header are not cached (see StoreLinkBudget).
+    Ptr<MobilityModel> senderMobility = sender->GetMobility();
+    if (senderMobility->GetPosition() != header.GetPosition())
+    {
+        Ptr<ConstantPositionMobilityModel> mobility =
+            CreateObject<ConstantPositionMobilityModel>();
+        mobility->SetPosition(header.GetPosition());
+        senderMobility = mobility;
+    }
+
+    // Let the trackers of this system identify the packet
+    message->AddPacketTag(LoraOriginTag(m_phySystemIds[i], header.GetPacketUid()));
+
+    LoraTxParameters txParams;
+    txParams.sf = header.GetSpreadingFactor();
+
+    SendToLocalPhys(i,
+                    sender,
+                    senderMobility,
+                    message,
+                    header.GetTxPower(),
+                    txParams,
+                    header.GetDuration(),
+                    header.GetFrequency(),
+                    m_lookahead);
+}
+
+double
+LoraChannel::ComputeMaxRange(Ptr<PropagationLossModel> loss,
+                             double txPowerDbm,
+                             double sensitivityDbm,
+                             double maxDistance,
+                             double antennaGainDb)
+{
+    NS_LOG_FUNCTION(loss << txPowerDbm << sensitivityDbm << maxDistance << antennaGainDb);
+
+    Ptr<ConstantPositionMobilityModel> sender = CreateObject<ConstantPositionMobilityModel>();
+    Ptr<ConstantPositionMobilityModel> receiver = CreateObject<ConstantPositionMobilityModel>();
+    sender->SetPosition(Vector(0, 0, 0));
+
+    auto isReceivable = [&](double distance) {
+        receiver->SetPosition(Vector(distance, 0, 0));
+        return loss->CalcRxPower(txPowerDbm, sender, receiver) + antennaGainDb >= sensitivityDbm;
+    };
+
+    if (isReceivable(maxDistance))
+    {
+        NS_LOG_WARN("Signals are still above sensitivity at the maximum distance");
+        return maxDistance;
+    }
+
+    // Bisect until the range is known with a precision of one meter,
+    // returning the upper end of the interval to stay conservative
+    double low = 0;
+    double high = maxDistance;
+    while (high - low > 1)
+    {
+        double middle = (low + high) / 2;
+        if (isReceivable(middle))
+        {
+            low = middle;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+
+    NS_LOG_DEBUG("Maximum range: " << high << " m");
+
+    return high;
+}
+
+void
+LoraChannel::ReceiveGroup(std::vector<std::pair<uint32_t, double>> receivers,
+                          Ptr<Packet> packet,
+                          uint8_t sf,
+                          Time duration,
+                          double frequencyMHz) const
+{
+    NS_LOG_FUNCTION(this << receivers.size() << packet << unsigned(sf) << duration
+                         << frequencyMHz);
+
+    for (const auto& [i, rxPowerDbm] : receivers)
+    {
+        m_phyList[i]->StartReceive(packet, rxPowerDbm, sf, duration, frequencyMHz);
+    }
+}
+
+void
+LoraChannel::ReceiveArrivals(uint32_t i, Time arrivalTime) const
+{
+    NS_LOG_FUNCTION(this << i << arrivalTime);
+
+    auto it = m_arrivals.find({arrivalTime, i});
+    NS_ASSERT(it != m_arrivals.end());
+    std::vector<Arrival> arrivals = std::move(it->second);
+    m_arrivals.erase(it);
+
+    std::stable_sort(arrivals.begin(), arrivals.end(), [](const Arrival& a, const Arrival& b) {
+        return std::tie(a.sender, a.uid) < std::tie(b.sender, b.uid);
+    });
+
+    for (const auto& arrival : arrivals)
+    {
+        Receive(i, arrival.packet, arrival.parameters);
+    }
+}
+
+void
+LoraChannel::Receive(uint32_t i, Ptr<Packet> packet, LoraChannelParameters parameters) const
+{
+    NS_LOG_FUNCTION(this << i << packet << parameters);
+
+    // Call the appropriate PHY instance to let it begin reception
+    m_phyList[i]->StartReceive(packet,
+                               parameters.rxPowerDbm,
+                               parameters.sf,
+                               parameters.duration,
+                               parameters.frequencyMHz);
+}
+
+double
+LoraChannel::GetRxPower(double txPowerDbm,
+                        Ptr<MobilityModel> senderMobility,
+                        Ptr<MobilityModel> receiverMobility) const
+{
+    double rxPowerDbm = m_loss->CalcRxPower(txPowerDbm, senderMobility, receiverMobility);
+    if (m_perPacketLoss)
+    {
+        rxPowerDbm = m_perPacketLoss->CalcRxPower(rxPowerDbm, senderMobility, receiverMobility);
+    }
+    return rxPowerDbm;
+}
+
+void
+LoraChannel::GetRxPower(double txPowerDbm,
+                        Ptr<MobilityModel> senderMobility,
+                        const std::vector<Ptr<MobilityModel>>& receiverMobilities,
+                        std::vector<double>& rxPowersDbm) const
+{
+    NS_LOG_FUNCTION(this << txPowerDbm << senderMobility << receiverMobilities.size());
+
+    std::size_t n = receiverMobilities.size();
+    rxPowersDbm.resize(n);
+
+    // Subclasses may override the loss computation, so only the exact type
+    // can take the fast path
+    if (!m_loss ||
+        m_loss->GetInstanceTypeId() != LogDistancePropagationLossModel::GetTypeId())
+    {
+        for (std::size_t k = 0; k < n; k++)
+        {
+            rxPowersDbm[k] = GetRxPower(txPowerDbm, senderMobility, receiverMobilities[k]);
+        }
+        return;
+    }
+
+    DoubleValue exponent;
+    DoubleValue referenceDistance;
+    DoubleValue referenceLoss;
+    m_loss->GetAttribute("Exponent", exponent);
+    m_loss->GetAttribute("ReferenceDistance", referenceDistance);
+    m_loss->GetAttribute("ReferenceLoss", referenceLoss);
+
+    std::vector<double> x(n);
+    std::vector<double> y(n);
+    std::vector<double> z(n);
+    for (std::size_t k = 0; k < n; k++)
+    {
+        Vector position = receiverMobilities[k]->GetPosition();
+        x[k] = position.x;
+        y[k] = position.y;
+        z[k] = position.z;
+    }
+
+    ComputeDistances(senderMobility->GetPosition(),
+                     x.data(),
+                     y.data(),
+                     z.data(),
+                     rxPowersDbm.data(),
+                     n);
+    ComputeLogDistanceRxPowers(txPowerDbm,
+                               exponent.Get(),
+                               referenceDistance.Get(),
+                               referenceLoss.Get(),
+                               rxPowersDbm.data(),
+                               n);
+
+    // Evaluate the rest of the chain, and then the per-packet loss, with the
+    // same random draws as GetRxPower would
+    CalcChainRxPowers(m_loss->GetNext(), senderMobility, receiverMobilities, rxPowersDbm.data());
+    CalcChainRxPowers(m_perPacketLoss, senderMobility, receiverMobilities, rxPowersDbm.data());
+}
+
+void
+LoraChannel::CalcChainRxPowers(Ptr<PropagationLossModel> model,
+                               Ptr<MobilityModel> senderMobility,
+                               const std::vector<Ptr<MobilityModel>>& receiverMobilities,
+                               double* rxPowersDbm) const
+{
+    for (; model; model = model->GetNext())
+    {
+        // Subclasses may override the loss computation, so only the exact
+        // types can be applied to all receivers at once
+        TypeId tid = model->GetInstanceTypeId();
+        if (tid == CorrelatedShadowingPropagationLossModel::GetTypeId())
+        {
+            DynamicCast<CorrelatedShadowingPropagationLossModel>(model)->ApplyLoss(
+                senderMobility,
+                receiverMobilities,
+                rxPowersDbm);
+        }
+        else if (tid == BuildingPenetrationLoss::GetTypeId())
+        {
+            DynamicCast<BuildingPenetrationLoss>(model)->ApplyLoss(senderMobility,
+                                                                   receiverMobilities,
+                                                                   rxPowersDbm);
+        }
+        else
+        {
+            for (std::size_t k = 0; k < receiverMobilities.size(); k++)
+            {
+                rxPowersDbm[k] =
+                    model->CalcRxPower(rxPowersDbm[k], senderMobility, receiverMobilities[k]);
+            }
+            return;
+        }
+    }
 }
 
 std::ostream&
@@ -27,6 +27,7 @@
 #include "lora-phy.h"
 
 #include "ns3/channel.h"
+#include "ns3/event-id.h"
 #include "ns3/mobility-model.h"
 #include "ns3/net-device.h"
 #include "ns3/nstime.h"
@@ -34,6 +35,10 @@
 #include "ns3/propagation-delay-model.h"
 #include "ns3/propagation-loss-model.h"
 
+#include <map>
+#include <memory>
+#include <set>
+#include <unordered_map>
 #include <vector>
 
 namespace ns3
@@ -46,6 +51,7 @@ namespace lorawan
 {
 
 class LoraPhy;
+class LoraThreadPool;
 struct LoraTxParameters;
 
 /**
@@ -77,6 +83,18 @@ std::ostream& operator<<(std::ostream& os, const LoraChannelParameters& params);
 class LoraChannel : public Channel
 {
   public:
+    /**
+     * The PHYs that are notified of a transmission.
+     */
+    enum DeliveryPolicy
+    {
+        BROADCAST, //!< All PHYs except the sender.
+        GATEWAYS_ONLY, //!< End device transmissions only reach gateways, and
+                       //!< gateway transmissions only reach end devices.
+        ADDRESSED, //!< Like GATEWAYS_ONLY, but downlink packets only reach the
+                   //!< end device they are addressed to.
+    };
+
     // TypeId
     static TypeId GetTypeId();
 
@@ -149,7 +167,7 @@ class LoraChannel : public Channel
      *
      * This method can be used by external object to see the receive power of a
      * transmission from one point to another using this Channel's
-     * PropagationLossModel.
+     * PropagationLossModel, followed by its per-packet loss model, if any.
      *
      * \param txPowerDbm The power the transmitter is using, in dBm.
      * \param senderMobility The mobility model of the sender.
@@ -160,7 +178,572 @@ class LoraChannel : public Channel
                       Ptr<MobilityModel> senderMobility,
                       Ptr<MobilityModel> receiverMobility) const;
 
+    /**
+     * Compute the received power when transmitting from a point to several
+     * other ones.
+     *
+     * The result is the same as calling GetRxPower for each receiver in
+     * order. If the channel's loss model is a LogDistancePropagationLossModel,
+     * the distances and log distance losses of all receivers are computed in
+     * branchless loops the compiler can vectorize, except for the square
+     * roots and logarithms, which are the standard library ones so that
+     * results stay bit-identical.
+     * CorrelatedShadowingPropagationLossModel and BuildingPenetrationLoss
+     * models following it, as in the chain of the complete network example,
+     * are then also applied to all receivers at once (see CalcChainRxPowers),
+     * while other models are evaluated for each receiver.
+     *
+     * \param txPowerDbm The power the transmitter is using, in dBm.
+     * \param senderMobility The mobility model of the sender.
+     * \param receiverMobilities The mobility models of the receivers.
+     * \param [out] rxPowersDbm The received power at each receiver, in dBm.
+     */
+    void GetRxPower(double txPowerDbm,
+                    Ptr<MobilityModel> senderMobility,
+                    const std::vector<Ptr<MobilityModel>>& receiverMobilities,
+                    std::vector<double>& rxPowersDbm) const;
+
+    /**
+     * Compute the distance beyond which a transmission is always received
+     * below a given sensitivity.
+     *
+     * The distance is found by bisection, assuming that the loss model is
+     * deterministic and that the loss increases with distance. Since the
+     * loss model is evaluated between two nodes with no other property than
+     * their position, it should only contain the deterministic part of the
+     * channel's loss model (for example, a LogDistancePropagationLossModel
+     * without the shadowing and building penetration models chained to it).
+     * The result can be used to set the MaxRange attribute, using the maximum
+     * transmission power and the lowest sensitivity of the receivers (see
+     * GatewayLoraPhy::sensitivity and EndDeviceLoraPhy::sensitivity).
+     *
+     * Antenna gains are added to the received power after the loss model
+     * (see LoraPhy::SetAntenna), so if PHYs have antennas, antennaGainDb
+     * should be the largest sum of the gains of a transmitter and a receiver
+     * antenna, in any direction. Otherwise, receivers within reach thanks to
+     * their gain would be beyond the computed range.
+     *
+     * \param loss The deterministic loss model.
+     * \param txPowerDbm The transmission power, in dBm.
+     * \param sensitivityDbm The sensitivity, in dBm.
+     * \param maxDistance The largest distance to consider, in meters.
+     * \param antennaGainDb The largest antenna gain of a link, in dB.
+     * \return The range, in meters.
+     */
+    static double ComputeMaxRange(Ptr<PropagationLossModel> loss,
+                                  double txPowerDbm,
+                                  double sensitivityDbm,
+                                  double maxDistance = 1e6,
+                                  double antennaGainDb = 0);
+
+    /**
+     * Set the distance beyond which receivers are not notified of
+     * transmissions.
+     *
+     * \param maxRange The range, in meters, or 0 to notify all receivers.
+     */
+    void SetMaxRange(double maxRange);
+
+    /**
+     * Get the distance beyond which receivers are not notified of
+     * transmissions.
+     *
+     * \return The range, in meters, or 0 if all receivers are notified.
+     */
+    double GetMaxRange() const;
+
+    /**
+     * Enable or disable caching of the link budget between PHYs.
+     *
+     * When enabled, the received power given by the channel's loss model and
+     * the propagation delay are computed once per pair of PHYs with a
+     * ConstantPositionMobilityModel, and are reused until one of the two
+     * changes position. The loss model should then only contain
+     * deterministic components, while random ones are drawn for each packet
+     * by the loss model set with SetPerPacketLossModel.
+     *
+     * \param enabled Whether to cache the link budget.
+     */
+    void SetLinkBudgetCacheEnabled(bool enabled);
+
+    /**
+     * Check whether the link budget between PHYs is cached.
+     *
+     * \return True if the link budget is cached.
+     */
+    bool IsLinkBudgetCacheEnabled() const;
+
+    /**
+     * Set the loss model that is applied to each transmission on top of the
+     * channel's loss model, and whose result is never cached.
+     *
+     * \param loss The loss model, or nullptr to only use the channel's loss
+     * model.
+     */
+    void SetPerPacketLossModel(Ptr<PropagationLossModel> loss);
+
+    /**
+     * Set the number of threads computing the link budget of the receivers
+     * of a transmission.
+     *
+     * With more than one thread, the distances and log distance losses of
+     * all receivers are computed by a thread pool when the loss model chain
+     * starts with a LogDistancePropagationLossModel. The rest of the chain
+     * and the scheduling of receptions are handled by the simulation thread,
+     * in receiver order, so that results do not depend on the number of
+     * threads.
+     *
+     * \param nThreads The number of threads, including the simulation one.
+     */
+    void SetLinkBudgetThreads(uint32_t nThreads);
+
+    /**
+     * Get the number of threads computing the link budget of the receivers
+     * of a transmission.
+     *
+     * \return The number of threads, including the simulation one.
+     */
+    uint32_t GetLinkBudgetThreads() const;
+
+    /**
+     * Subscribe an end device PHY to transmissions on a frequency.
+     *
+     * If the EndDeviceSubscription attribute is set, end device PHYs are only
+     * notified of transmissions on the frequency they are subscribed to. A
+     * PHY can only be subscribed to a frequency at a time, so this replaces
+     * any previous subscription.
+     *
+     * \param phy The PHY, which must be connected to this channel.
+     * \param frequencyMHz The frequency the PHY is listening on.
+     */
+    void Subscribe(Ptr<LoraPhy> phy, double frequencyMHz);
+
+    /**
+     * Subscribe an end device PHY to transmissions on all frequencies.
+     *
+     * This is meant for PHYs that are not listening yet but have a receive
+     * window armed: a transmission that starts before the window opens may
+     * still be in the air when it does, and the frequency of the window may
+     * not be set yet. Like Subscribe, this replaces any previous
+     * subscription.
+     *
+     * \param phy The PHY, which must be connected to this channel.
+     */
+    void SubscribeToAllFrequencies(Ptr<LoraPhy> phy);
+
+    /**
+     * Cancel the subscription of an end device PHY.
+     *
+     * \param phy The PHY.
+     */
+    void Unsubscribe(Ptr<LoraPhy> phy);
+
+    /**
+     * Set the lookahead of distributed simulations.
+     *
+     * When the simulation is distributed with MPI, each rank only schedules
+     * receptions at the PHYs of its own nodes, and describes transmissions
+     * to the other ranks with a message that is delivered after the
+     * lookahead. The remote ranks then schedule receptions at the same time
+     * as a sequential simulation would, provided that the lookahead does not
+     * exceed the propagation delay between any two PHYs on different ranks
+     * (see ComputeLookahead). The simulator's lookahead is bounded
+     * accordingly, so this must be set before the simulation starts.
+     *
+     * Signals that reach a PHY at the same time are delivered in the order
+     * they were sent in, which differs among ranks, since a rank learns about
+     * remote transmissions after its own ones. With the
+     * SortSimultaneousArrivals attribute, they are delivered in the same
+     * order as in a sequential simulation with the attribute, provided that
+     * the lookahead is smaller than the propagation delays.
+     *
+     * Such a lookahead is only a few microseconds, but the systems don't
+     * synchronize once per lookahead: each round lets them run up to the
+     * earliest pending event of any system plus the lookahead, so a round
+     * is needed per burst of transmissions rather than per microsecond.
+     *
+     * \param lookahead The lookahead, or 0 if the simulation is not
+     * distributed.
+     */
+    void SetLookahead(Time lookahead);
+
+    /**
+     * Get the lookahead of distributed simulations.
+     *
+     * \return The lookahead, or 0 if the simulation is not distributed.
+     */
+    Time GetLookahead() const;
+
+    /**
+     * Compute the largest valid lookahead, that is, the smallest propagation
+     * delay between two PHYs whose nodes belong to different systems, minus
+     * a time step, so that other systems learn about a transmission strictly
+     * before its signal reaches their PHYs.
+     *
+     * Since all pairs of PHYs are considered, this is meant to be called
+     * once, after the nodes are placed.
+     *
+     * \return The lookahead, or Time::Max() if all PHYs belong to the same
+     * system.
+     */
+    Time ComputeLookahead() const;
+
   private:
+    /**
+     * Get the index of a PHY in m_phyList.
+     *
+     * \param phy The PHY.
+     * \return The index of the PHY, or m_phyList.size() if it's not connected
+     * to the channel.
+     */
+    uint32_t GetPhyIndex(Ptr<LoraPhy> phy) const;
+
+    /**
+     * Get the index of the end device PHY a downlink packet is addressed to.
+     *
+     * \param packet The packet sent by a gateway.
+     * \return The index of the PHY, or m_phyList.size() if the packet is not
+     * a downlink packet or no end device has its address.
+     */
+    uint32_t GetAddressedEndDevice(Ptr<Packet> packet) const;
+
+    /**
+     * Select the roles of the PHYs that are notified of a transmission.
+     *
+     * \param i The index of the sending PHY, or m_phyList.size() if unknown.
+     * \param packet The packet being sent.
+     * \param [out] toGateways Whether gateway PHYs are notified.
+     * \param [out] toEndDevices Whether end device PHYs are notified.
+     * \param [out] addressed The index of the only PHY to notify, or
+     * m_phyList.size() if the packet is not addressed to a single PHY.
+     */
+    void GetDeliveryTargets(uint32_t i,
+                            Ptr<Packet> packet,
+                            bool& toGateways,
+                            bool& toEndDevices,
+                            uint32_t& addressed) const;
+
+    /**
+     * Rebuild the index of the PHYs by role and by pointer.
+     */
+    void RebuildPhyIndices();
+
+    /**
+     * The cached link budget between two PHYs.
+     */
+    struct LinkBudget
+    {
+        const MobilityModel* senderMobility;   //!< The mobility model of the sender.
+        const MobilityModel* receiverMobility; //!< The mobility model of the receiver.
+        const AntennaModel* senderAntenna;     //!< The antenna model of the sender.
+        const AntennaModel* receiverAntenna;   //!< The antenna model of the receiver.
+        uint32_t senderGeneration;   //!< The position generation of the sender.
+        uint32_t receiverGeneration; //!< The position generation of the receiver.
+        double txPowerDbm;           //!< The transmission power.
+        double rxPowerDbm;           //!< The power given by the channel's loss model.
+        Time delay;                  //!< The propagation delay.
+    };
+
+    /**
+     * Compute the sum of the antenna gains of two PHYs in the direction of
+     * each other.
+     *
+     * \param i The index of the sending PHY, or m_phyList.size() if unknown.
+     * \param j The index of the receiving PHY.
+     * \param senderMobility The mobility model of the sender.
+     * \param receiverMobility The mobility model of the receiver.
+     * \return The gain in dB, 0 if neither PHY has an antenna model.
+     */
+    double GetAntennaGain(uint32_t i,
+                          uint32_t j,
+                          Ptr<MobilityModel> senderMobility,
+                          Ptr<MobilityModel> receiverMobility) const;
+
+    /**
+     * Get the received power and propagation delay of a transmission between
+     * two PHYs, using the link budget cache if possible.
+     *
+     * \param i The index of the sending PHY, or m_phyList.size() if unknown.
+     * \param j The index of the receiving PHY.
+     * \param senderMobility The mobility model of the sender.
+     * \param receiverMobility The mobility model of the receiver.
+     * \param txPowerDbm The power of the transmission.
+     * \param [out] delay The propagation delay.
+     * \return The received power given by the channel's loss model and the
+     * antennas of the PHYs, in dBm.
+     */
+    double GetLinkBudget(uint32_t i,
+                         uint32_t j,
+                         Ptr<MobilityModel> senderMobility,
+                         Ptr<MobilityModel> receiverMobility,
+                         double txPowerDbm,
+                         Time& delay) const;
+
+    /**
+     * Evaluate a loss model, followed by the rest of its chain, for several
+     * receivers of the same transmission.
+     *
+     * CorrelatedShadowingPropagationLossModel and BuildingPenetrationLoss
+     * instances are applied to all receivers at once, while the chain is
+     * evaluated for each receiver from the first model of another type on.
+     * Since each model draws its own random values in receiver order, the
+     * result is the same as evaluating the whole chain for each receiver in
+     * turn.
+     *
+     * \param model The first model to evaluate, or nullptr.
+     * \param senderMobility The mobility model of the sender.
+     * \param receiverMobilities The mobility models of the receivers.
+     * \param [in,out] rxPowersDbm The received power at each receiver, in dBm.
+     */
+    void CalcChainRxPowers(Ptr<PropagationLossModel> model,
+                           Ptr<MobilityModel> senderMobility,
+                           const std::vector<Ptr<MobilityModel>>& receiverMobilities,
+                           double* rxPowersDbm) const;
+
+    /**
+     * Compute the received power and propagation delay of a transmission at
+     * several PHYs, using the link budget cache and the thread pool.
+     *
+     * \param i The index of the sending PHY, or m_phyList.size() if unknown.
+     * \param senderMobility The mobility model of the sender.
+     * \param receivers The indices of the receiving PHYs.
+     * \param txPowerDbm The power of the transmission.
+     * \param [out] receiverMobilities The mobility models of the receivers.
+     * \param [out] rxPowersDbm The received powers given by the channel's
+     * loss model and the antennas of the PHYs, in dBm.
+     * \param [out] delays The propagation delays.
+     */
+    void ComputeLinkBudgets(uint32_t i,
+                            Ptr<MobilityModel> senderMobility,
+                            const std::vector<uint32_t>& receivers,
+                            double txPowerDbm,
+                            std::vector<Ptr<MobilityModel>>& receiverMobilities,
+                            std::vector<double>& rxPowersDbm,
+                            std::vector<Time>& delays) const;
+
+    /**
+     * Check whether the link budget between two PHYs can be cached.
+     *
+     * \param i The index of the sending PHY, or m_phyList.size() if unknown.
+     * \param senderMobility The mobility model of the sender.
+     * \param receiverMobility The mobility model of the receiver.
+     * \return True if the link budget can be cached.
+     */
+    bool IsLinkCacheable(uint32_t i,
+                         Ptr<MobilityModel> senderMobility,
+                         Ptr<MobilityModel> receiverMobility) const;
+
+    /**
+     * Look up a valid cached link budget.
+     *
+     * \param i The index of the sending PHY, or m_phyList.size() if unknown.
+     * \param j The index of the receiving PHY.
+     * \param senderMobility The mobility model of the sender.
+     * \param receiverMobility The mobility model of the receiver.
+     * \param txPowerDbm The power of the transmission.
+     * \param [out] rxPowerDbm The cached received power.
+     * \param [out] delay The cached propagation delay.
+     * \return True if a valid entry was found.
+     */
+    bool LookupLinkBudget(uint32_t i,
+                          uint32_t j,
+                          Ptr<MobilityModel> senderMobility,
+                          Ptr<MobilityModel> receiverMobility,
+                          double txPowerDbm,
+                          double& rxPowerDbm,
+                          Time& delay) const;
+
+    /**
+     * Cache the link budget between two PHYs, if possible.
+     *
+     * \param i The index of the sending PHY, or m_phyList.size() if unknown.
+     * \param j The index of the receiving PHY.
+     * \param senderMobility The mobility model of the sender.
+     * \param receiverMobility The mobility model of the receiver.
+     * \param txPowerDbm The power of the transmission.
+     * \param rxPowerDbm The received power.
+     * \param delay The propagation delay.
+     */
+    void StoreLinkBudget(uint32_t i,
+                         uint32_t j,
+                         Ptr<MobilityModel> senderMobility,
+                         Ptr<MobilityModel> receiverMobility,
+                         double txPowerDbm,
+                         double rxPowerDbm,
+                         Time delay) const;
+
+    /**
+     * Connect to the CourseChange trace source of a mobility model, unless
+     * already connected.
+     *
+     * \param mobility The mobility model.
+     */
+    void WatchMobility(Ptr<MobilityModel> mobility) const;
+
+    /**
+     * Receivers of a transmission, as (PHY index, received power in dBm)
+     * pairs, grouped by propagation delay.
+     */
+    using FanOutGroups = std::map<Time, std::vector<std::pair<uint32_t, double>>>;
+
+    /**
+     * Compute the reception parameters of a transmission at a PHY, and
+     * schedule the corresponding Receive call, or add the PHY to the
+     * receivers with the same delay.
+     *
+     * \param i The index of the sending PHY, or m_phyList.size() if unknown.
+     * \param j The index of the receiving PHY.
+     * \param senderMobility The mobility model of the sender.
+     * \param packet The packet being sent.
+     * \param txPowerDbm The power of the transmission.
+     * \param txParams The set of parameters that are used by the transmitter.
+     * \param duration The on-air duration of this packet.
+     * \param frequencyMHz The frequency this transmission will happen at.
+     * \param elapsed The time elapsed since the start of the transmission.
+     * \param groups The receivers grouped by delay, or nullptr to schedule a
+     * Receive call for this PHY only.
+     */
+    void SendToPhy(uint32_t i,
+                   uint32_t j,
+                   Ptr<MobilityModel> senderMobility,
+                   Ptr<Packet> packet,
+                   double txPowerDbm,
+                   LoraTxParameters txParams,
+                   Time duration,
+                   double frequencyMHz,
+                   Time elapsed,
+                   FanOutGroups* groups) const;
+
+    /**
+     * Apply the per-packet loss to the link budget of a PHY, and schedule the
+     * corresponding Receive call, or add the PHY to the receivers with the
+     * same delay.
+     *
+     * \param i The index of the sending PHY, or m_phyList.size() if unknown.
+     * \param j The index of the receiving PHY.
+     * \param senderMobility The mobility model of the sender.
+     * \param receiverMobility The mobility model of the receiver.
+     * \param packet The packet being sent.
+     * \param txPowerDbm The power of the transmission.
+     * \param rxPowerDbm The received power given by the channel's loss model.
+     * \param delay The propagation delay.
+     * \param txParams The set of parameters that are used by the transmitter.
+     * \param duration The on-air duration of this packet.
+     * \param frequencyMHz The frequency this transmission will happen at.
+     * \param elapsed The time elapsed since the start of the transmission,
+     * which is subtracted from the delay.
+     * \param groups The receivers grouped by delay, or nullptr to schedule a
+     * Receive call for this PHY only.
+     */
+    void DeliverToPhy(uint32_t i,
+                      uint32_t j,
+                      Ptr<MobilityModel> senderMobility,
+                      Ptr<MobilityModel> receiverMobility,
+                      Ptr<Packet> packet,
+                      double txPowerDbm,
+                      double rxPowerDbm,
+                      Time delay,
+                      LoraTxParameters txParams,
+                      Time duration,
+                      double frequencyMHz,
+                      Time elapsed,
+                      FanOutGroups* groups) const;
+
+    /**
+     * Notify the PHYs of this system of a transmission.
+     *
+     * \param i The index of the sending PHY, or m_phyList.size() if unknown.
+     * \param sender The sending PHY.
+     * \param senderMobility The mobility model of the sender.
+     * \param packet The packet being sent.
+     * \param txPowerDbm The power of the transmission.
+     * \param txParams The set of parameters that are used by the transmitter.
+     * \param duration The on-air duration of this packet.
+     * \param frequencyMHz The frequency this transmission will happen at.
+     * \param elapsed The time elapsed since the start of the transmission.
+     */
+    void SendToLocalPhys(uint32_t i,
+                         Ptr<LoraPhy> sender,
+                         Ptr<MobilityModel> senderMobility,
+                         Ptr<Packet> packet,
+                         double txPowerDbm,
+                         LoraTxParameters txParams,
+                         Time duration,
+                         double frequencyMHz,
+                         Time elapsed) const;
+
+    /**
+     * Describe a transmission to the other systems of a distributed
+     * simulation that have PHYs to notify.
+     *
+     * \param i The index of the sending PHY.
+     * \param senderMobility The mobility model of the sender.
+     * \param packet The packet being sent.
+     * \param txPowerDbm The power of the transmission.
+     * \param txParams The set of parameters that are used by the transmitter.
+     * \param duration The on-air duration of this packet.
+     * \param frequencyMHz The frequency this transmission will happen at.
+     */
+    void SendToRemoteSystems(uint32_t i,
+                             Ptr<MobilityModel> senderMobility,
+                             Ptr<Packet> packet,
+                             double txPowerDbm,
+                             LoraTxParameters txParams,
+                             Time duration,
+                             double frequencyMHz) const;
+
+    /**
+     * Notify the PHYs of this system of a transmission described by another
+     * system of a distributed simulation.
+     *
+     * \param message The packet being sent, with a
+     * LoraRemoteTransmissionHeader.
+     */
+    void ReceiveRemote(Ptr<Packet> message);
+
+    /**
+     * Find the system of each PHY, and set up the reception of messages from
+     * the other systems of a distributed simulation.
+     */
+    void SetupDistribution();
+
+    /**
+     * Get the indices of the PHYs that may be within MaxRange of a position.
+     *
+     * PHYs with a ConstantPositionMobilityModel are looked up in a uniform
+     * grid with cells as large as MaxRange, while the other PHYs, which may
+     * move without notice, are always returned.
+     *
+     * \param position The position of the sender.
+     * \return The indices of the candidate receivers, in increasing order.
+     */
+    std::vector<uint32_t> GetCandidateReceivers(const Vector& position) const;
+
+    /**
+     * Build the spatial index of the PHYs.
+     */
+    void BuildSpatialIndex() const;
+
+    /**
+     * Invalidate the spatial index, which will be rebuilt at the next
+     * transmission.
+     */
+    void InvalidateSpatialIndex() const;
+
+    /**
+     * Callback invoked when a watched mobility model changes position.
+     *
+     * \param mobility The mobility model of the PHY.
+     */
+    void NotifyCourseChange(Ptr<const MobilityModel> mobility) const;
+
+    /**
+     * Get the coordinates of the grid cell containing a position.
+     *
+     * \param position The position.
+     * \return The coordinates of the cell.
+     */
+    std::pair<int64_t, int64_t> GetCell(const Vector& position) const;
     /**
      * Private method that is scheduled by LoraChannel's Send method to happen
      * after the channel delay, for each of the connected PHY layers.
@@ -174,6 +757,35 @@ class LoraChannel : public Channel
      */
     void Receive(uint32_t i, Ptr<Packet> packet, LoraChannelParameters parameters) const;
 
+    /**
+     * Private method that is scheduled by LoraChannel's Send method when
+     * FanOut is enabled, to start reception at a group of PHYs with the same
+     * delay.
+     *
+     * \param receivers The indices of the PHYs and their received power.
+     * \param packet The packet the PHYs will receive.
+     * \param sf The Spreading Factor of the transmission.
+     * \param duration The duration of the transmission.
+     * \param frequencyMHz The frequency of the transmission.
+     */
+    void ReceiveGroup(std::vector<std::pair<uint32_t, double>> receivers,
+                      Ptr<Packet> packet,
+                      uint8_t sf,
+                      Time duration,
+                      double frequencyMHz) const;
+
+    /**
+     * Private method that is scheduled by LoraChannel's Send method when
+     * SortSimultaneousArrivals is enabled, to start reception of all the
+     * signals that reach a PHY at the same time, sorted by the index of
+     * their sender, then by the uid their packet has on the system it was
+     * sent from.
+     *
+     * \param i The index of the phy to start reception on.
+     * \param arrivalTime The time the signals reach the PHY, that is, now.
+     */
+    void ReceiveArrivals(uint32_t i, Time arrivalTime) const;
+
     /**
      * The vector containing the PHYs that are currently connected to the
      * channel.
@@ -197,6 +809,204 @@ class LoraChannel : public Channel
      * Callback for when a packet is being sent on the channel.
      */
     TracedCallback<Ptr<const Packet>> m_packetSent;
+
+    /**
+     * The distance beyond which receivers are not notified of a transmission,
+     * or 0 to notify all receivers.
+     */
+    double m_maxRange;
+
+    /**
+     * Whether the spatial index reflects the current PHYs and their positions.
+     */
+    mutable bool m_spatialIndexValid;
+
+    /**
+     * The indices of the PHYs with a constant position, by grid cell.
+     */
+    mutable std::map<std::pair<int64_t, int64_t>, std::vector<uint32_t>> m_grid;
+
+    /**
+     * The indices of the PHYs that are not in the grid.
+     */
+    mutable std::vector<uint32_t> m_unindexedPhys;
+
+    /**
+     * The mobility models whose CourseChange trace source is connected to
+     * NotifyCourseChange.
+     */
+    mutable std::set<Ptr<MobilityModel>> m_watchedMobility;
+
+    /**
+     * Whether the link budget between PHYs is cached.
+     */
+    bool m_linkBudgetCache;
+
+    /**
+     * The loss model applied to each transmission after the (possibly cached)
+     * channel's loss model.
+     */
+    Ptr<PropagationLossModel> m_perPacketLoss;
+
+    /**
+     * The cached link budgets, keyed by the index of the sender in the upper
+     * 32 bits and by the index of the receiver in the lower 32 bits.
+     */
+    mutable std::unordered_map<uint64_t, LinkBudget> m_linkBudgets;
+
+    /**
+     * For each PHY, a counter that is incremented every time it changes
+     * position, used to detect stale entries of m_linkBudgets.
+     */
+    mutable std::vector<uint32_t> m_phyGenerations;
+
+    /**
+     * Which PHYs are notified of transmissions.
+     */
+    DeliveryPolicy m_deliveryPolicy;
+
+    /**
+     * Whether end device transmissions also reach other end devices when the
+     * delivery policy is not BROADCAST.
+     */
+    bool m_endDeviceInterference;
+
+    /**
+     * The index of each PHY in m_phyList.
+     */
+    std::unordered_map<const LoraPhy*, uint32_t> m_phyIndices;
+
+    /**
+     * Whether each PHY in m_phyList is a GatewayLoraPhy.
+     */
+    std::vector<bool> m_isGatewayPhy;
+
+    /**
+     * The indices of the gateway PHYs, in increasing order.
+     */
+    std::vector<uint32_t> m_gatewayPhys;
+
+    /**
+     * The indices of the other PHYs, in increasing order.
+     */
+    std::vector<uint32_t> m_endDevicePhys;
+
+    /**
+     * The index of the end device PHYs, by device address. This is built at
+     * the first addressed downlink, since addresses are assigned after the
+     * PHYs are connected to the channel.
+     */
+    mutable std::unordered_map<uint32_t, uint32_t> m_endDeviceAddresses;
+
+    /**
+     * Whether end device PHYs are only notified of transmissions on the
+     * frequency they are subscribed to.
+     */
+    bool m_subscription;
+
+    /**
+     * The frequency each PHY is subscribed to, ALL_FREQUENCIES if it's
+     * subscribed to all of them, or 0 if it's not subscribed.
+     */
+    std::vector<double> m_subscribedFrequencies;
+
+    /**
+     * The key of m_subscribers for the PHYs subscribed to all frequencies.
+     */
+    static constexpr double ALL_FREQUENCIES = -1;
+
+    /**
+     * The indices of the subscribed PHYs, by frequency.
+     */
+    std::map<double, std::set<uint32_t>> m_subscribers;
+
+    /**
+     * An empty set of subscribers.
+     */
+    const std::set<uint32_t> m_noSubscribers;
+
+    /**
+     * Whether a single Receive event is scheduled for all PHYs with the same
+     * delay.
+     */
+    bool m_fanOut;
+
+    /**
+     * The resolution to which delays are rounded in fan-out mode.
+     */
+    Time m_fanOutResolution;
+
+    /**
+     * Whether signals that reach a PHY at the same time are delivered in an
+     * order that doesn't depend on the order they were sent in.
+     */
+    bool m_sortArrivals;
+
+    /**
+     * A signal that is going to reach a PHY, when SortSimultaneousArrivals
+     * is enabled.
+     */
+    struct Arrival
+    {
+        uint32_t sender;                  //!< The index of the sending PHY.
+        uint64_t uid;                     //!< The packet's uid on the sender's system.
+        Ptr<Packet> packet;               //!< The packet.
+        LoraChannelParameters parameters; //!< The parameters of the signal.
+    };
+
+    /**
+     * The signals that are going to reach the PHYs, by arrival time and
+     * index of the receiving PHY.
+     */
+    mutable std::map<std::pair<Time, uint32_t>, std::vector<Arrival>> m_arrivals;
+
+    /**
+     * The pool computing link budgets in parallel, or nullptr if they are
+     * computed by the simulation thread only.
+     */
+    std::unique_ptr<LoraThreadPool> m_threadPool;
+
+    /**
+     * The delay after which the description of a transmission is delivered to
+     * the other systems of a distributed simulation, or 0 if the simulation
+     * is not distributed.
+     */
+    Time m_lookahead;
+
+    /**
+     * The event setting up the distributed simulation.
+     */
+    EventId m_setupEvent;
+
+    /**
+     * The system each PHY belongs to, or an empty vector if the simulation is
+     * not distributed.
+     */
+    std::vector<uint32_t> m_phySystemIds;
+
+    /**
+     * The system this simulation is running as.
+     */
+    uint32_t m_systemId;
+
+    /**
+     * What this system knows about another system of a distributed
+     * simulation.
+     */
+    struct RemoteSystem
+    {
+        Ptr<NetDevice> mailbox; //!< The device receiving messages, if any.
+        bool hasGateways;       //!< Whether the system has gateway PHYs.
+        bool hasEndDevices;     //!< Whether the system has end device PHYs.
+        bool isStatic;          //!< Whether all PHYs have a constant position.
+        Vector minPosition;     //!< The lower corner of the PHYs' bounding box.
+        Vector maxPosition;     //!< The upper corner of the PHYs' bounding box.
+    };
+
+    /**
+     * The systems of a distributed simulation, by system id.
+     */
+    std::vector<RemoteSystem> m_systems;
 };
 
 } // namespace lorawan
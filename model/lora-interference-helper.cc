@@ -19,10 +19,14 @@
 
 #include "lora-interference-helper.h"
 
+#include "ns3/boolean.h"
 #include "ns3/enum.h"
 #include "ns3/log.h"
+#include "ns3/nstime.h"
 
+#include <algorithm>
 #include <limits>
+#include <new>
 
 namespace ns3
 {
@@ -45,8 +49,10 @@ LoraInterferenceHelper::Event::Event(Time duration,
       m_endTime(m_startTime + duration),
       m_sf(spreadingFactor),
       m_rxPowerdBm(rxPowerdBm),
+      m_rxPowerW(pow(10, rxPowerdBm / 10) / 1000),
       m_packet(packet),
-      m_frequencyMHz(frequencyMHz)
+      m_frequencyMHz(frequencyMHz),
+      m_receptionPath(NO_RECEPTION_PATH)
 {
     // NS_LOG_FUNCTION_NOARGS ();
 }
@@ -82,6 +88,12 @@ LoraInterferenceHelper::Event::GetRxPowerdBm() const
     return m_rxPowerdBm;
 }
 
+double
+LoraInterferenceHelper::Event::GetRxPowerW() const
+{
+    return m_rxPowerW;
+}
+
 uint8_t
 LoraInterferenceHelper::Event::GetSpreadingFactor() const
 {
@@ -94,6 +106,24 @@ LoraInterferenceHelper::Event::GetPacket() const
     return m_packet;
 }
 
+void
+LoraInterferenceHelper::Event::SetPacket(Ptr<Packet> packet)
+{
+    m_packet = packet;
+}
+
+uint32_t
+LoraInterferenceHelper::Event::GetReceptionPath() const
+{
+    return m_receptionPath;
+}
+
+void
+LoraInterferenceHelper::Event::SetReceptionPath(uint32_t index)
+{
+    m_receptionPath = index;
+}
+
 double
 LoraInterferenceHelper::Event::GetFrequency() const
 {
@@ -115,35 +145,166 @@ operator<<(std::ostream& os, const LoraInterferenceHelper::Event& event)
     return os;
 }
 
+/***************************************
+ * LoraInterferenceHelper::EventPool  *
+ ***************************************/
+
+void
+LoraInterferenceHelper::EventDeleter::Delete(LoraInterferenceHelper::Event* event)
+{
+    if (!event->m_pool)
+    {
+        delete event;
+        return;
+    }
+
+    // The event may hold the last reference to its pool: keep the pool alive
+    // until the event has been destroyed
+    Ptr<LoraInterferenceHelper::EventPool> pool = event->m_pool;
+    pool->Release(event);
+}
+
+LoraInterferenceHelper::EventPool::EventPool()
+{
+    NS_LOG_FUNCTION(this);
+}
+
+LoraInterferenceHelper::EventPool::~EventPool()
+{
+    NS_LOG_FUNCTION(this);
+}
+
+Ptr<LoraInterferenceHelper::Event>
+LoraInterferenceHelper::EventPool::Allocate(Time duration,
+                                            double rxPowerdBm,
+                                            uint8_t spreadingFactor,
+                                            double frequencyMHz)
+{
+    if (m_freeSlots.empty())
+    {
+        NS_LOG_DEBUG("Allocating a new slab of " << SLAB_SIZE << " events");
+
+        m_slabs.emplace_back(new Slot[SLAB_SIZE]);
+        // Push the slots in reverse order, so that they are used in order
+        for (std::size_t i = SLAB_SIZE; i > 0; i--)
+        {
+            m_freeSlots.push_back(&m_slabs.back()[i - 1]);
+        }
+    }
+
+    Slot* slot = m_freeSlots.back();
+    m_freeSlots.pop_back();
+
+    auto event = new (slot->storage)
+        LoraInterferenceHelper::Event(duration, rxPowerdBm, spreadingFactor, nullptr, frequencyMHz);
+    event->m_pool = this;
+
+    return Ptr<LoraInterferenceHelper::Event>(event, false);
+}
+
+void
+LoraInterferenceHelper::EventPool::Release(LoraInterferenceHelper::Event* event)
+{
+    event->~Event();
+    m_freeSlots.push_back(reinterpret_cast<Slot*>(event));
+}
+
+std::size_t
+LoraInterferenceHelper::EventPool::GetCapacity() const
+{
+    return m_slabs.size() * SLAB_SIZE;
+}
+
+std::size_t
+LoraInterferenceHelper::EventPool::GetSize() const
+{
+    return GetCapacity() - m_freeSlots.size();
+}
+
 /****************************
  *  LoraInterferenceHelper  *
  ****************************/
-// This collision matrix can be used for comparisons with the performance of Aloha
-// systems, where collisions imply the loss of both packets.
-double inf = std::numeric_limits<double>::max();
-std::vector<std::vector<double>> LoraInterferenceHelper::collisionSnirAloha = {
-    //   7   8   9  10  11  12
-    {inf, -inf, -inf, -inf, -inf, -inf}, // SF7
-    {-inf, inf, -inf, -inf, -inf, -inf}, // SF8
-    {-inf, -inf, inf, -inf, -inf, -inf}, // SF9
-    {-inf, -inf, -inf, inf, -inf, -inf}, // SF10
-    {-inf, -inf, -inf, -inf, inf, -inf}, // SF11
-    {-inf, -inf, -inf, -inf, -inf, inf}  // SF12
-};
-
-// LoRa Collision Matrix (Goursaud)
-// Values are inverted w.r.t. the paper since here we interpret this as an
-// _isolation_ matrix instead of a cochannel _rejection_ matrix like in
-// Goursaud's paper.
-std::vector<std::vector<double>> LoraInterferenceHelper::collisionSnirGoursaud = {
-    // SF7  SF8  SF9  SF10 SF11 SF12
-    {6, -16, -18, -19, -19, -20}, // SF7
-    {-24, 6, -20, -22, -22, -22}, // SF8
-    {-27, -27, 6, -23, -25, -25}, // SF9
-    {-30, -30, -30, 6, -26, -28}, // SF10
-    {-33, -33, -33, -33, 6, -29}, // SF11
-    {-36, -36, -36, -36, -36, 6}  // SF12
-};
+
+namespace
+{
+
+/**
+ * Get the number of time steps in a second, with the current time resolution.
+ */
+double
+GetStepsPerSecond()
+{
+    return double(Seconds(1).GetTimeStep());
+}
+
+/**
+ * Compute the energy of the interference caused on the [start, end) interval
+ * by an event. All times are expressed in time steps.
+ *
+ * \param start The beginning of the interval.
+ * \param end The end of the interval.
+ * \param interfererStart The start time of the interferer.
+ * \param interfererEnd The end time of the interferer.
+ * \param interfererPowerW The power of the interferer, in W.
+ * \param stepsPerSecond The number of time steps in a second.
+ * \return The interference energy, in J.
+ */
+inline double
+GetInterferenceEnergy(double start,
+                      double end,
+                      double interfererStart,
+                      double interfererEnd,
+                      double interfererPowerW,
+                      double stepsPerSecond)
+{
+    // These comparisons are written so that they map to vector min and max
+    // instructions. Non-overlapping events yield an empty interval.
+    double overlapStart = interfererStart > start ? interfererStart : start;
+    double overlapEnd = interfererEnd < end ? interfererEnd : end;
+    overlapEnd = overlapEnd > overlapStart ? overlapEnd : overlapStart;
+
+    // Energy [J] = Time [s] * Power [W]
+    return (overlapEnd - overlapStart) / stepsPerSecond * interfererPowerW;
+}
+
+/**
+ * Compute the energy of the interference caused on the [start, end) interval
+ * by each of a set of events.
+ *
+ * The loop has no branches and only works on contiguous arrays, so that the
+ * compiler can vectorize it.
+ *
+ * \param startTimes The start times of the events, in time steps.
+ * \param endTimes The end times of the events, in time steps.
+ * \param rxPowersW The power of the events, in W.
+ * \param n The number of events.
+ * \param start The beginning of the interval, in time steps.
+ * \param end The end of the interval, in time steps.
+ * \param stepsPerSecond The number of time steps in a second.
+ * \param energies The array where the energy of each event is stored.
+ */
+void
+ComputeInterferenceEnergies(const double* __restrict startTimes,
+                            const double* __restrict endTimes,
+                            const double* __restrict rxPowersW,
+                            std::size_t n,
+                            double start,
+                            double end,
+                            double stepsPerSecond,
+                            double* __restrict energies)
+{
+    for (std::size_t i = 0; i < n; i++)
+    {
+        energies[i] = GetInterferenceEnergy(start,
+                                            end,
+                                            startTimes[i],
+                                            endTimes[i],
+                                            rxPowersW[i],
+                                            stepsPerSecond);
+    }
+}
+
+} // namespace
 
 LoraInterferenceHelper::CollisionMatrix LoraInterferenceHelper::collisionMatrix =
     LoraInterferenceHelper::GOURSAUD;
@@ -158,29 +319,62 @@ LoraInterferenceHelper::SetCollisionMatrix(
     {
     case LoraInterferenceHelper::ALOHA:
         NS_LOG_DEBUG("Setting the ALOHA collision matrix");
-        m_collisionSnir = LoraInterferenceHelper::collisionSnirAloha;
         break;
     case LoraInterferenceHelper::GOURSAUD:
         NS_LOG_DEBUG("Setting the GOURSAUD collision matrix");
-        m_collisionSnir = LoraInterferenceHelper::collisionSnirGoursaud;
         break;
     }
+    m_collisionMatrix = collisionMatrix;
+}
+
+LoraInterferenceHelper::CollisionMatrix
+LoraInterferenceHelper::GetCollisionMatrix() const
+{
+    return m_collisionMatrix;
 }
 
 TypeId
 LoraInterferenceHelper::GetTypeId()
 {
     static TypeId tid =
-        TypeId("ns3::LoraInterferenceHelper").SetParent<Object>().SetGroupName("lorawan");
+        TypeId("ns3::LoraInterferenceHelper")
+            .SetParent<ObjectBase>()
+            .SetGroupName("lorawan")
+            .AddAttribute("RetentionTime",
+                          "The time an event is kept after it has ended, "
+                          "before being removed from the list of interferers",
+                          TimeValue(Seconds(2)),
+                          MakeTimeAccessor(&LoraInterferenceHelper::m_retentionTime),
+                          MakeTimeChecker())
+            .AddAttribute("IncrementalInterference",
+                          "Whether to accumulate the interference on tracked events as "
+                          "interferers are added, instead of computing it when the "
+                          "reception ends",
+                          BooleanValue(false),
+                          MakeBooleanAccessor(&LoraInterferenceHelper::m_incrementalInterference),
+                          MakeBooleanChecker());
 
     return tid;
 }
 
+TypeId
+LoraInterferenceHelper::GetInstanceTypeId() const
+{
+    return GetTypeId();
+}
+
 LoraInterferenceHelper::LoraInterferenceHelper()
-    : m_collisionSnir(LoraInterferenceHelper::collisionSnirGoursaud)
+    : m_collisionMatrix(LoraInterferenceHelper::GOURSAUD),
+      m_nEvents(0),
+      m_incrementalInterference(false),
+      m_eventPool(Create<LoraInterferenceHelper::EventPool>())
 {
     NS_LOG_FUNCTION(this);
 
+    // This class is not created through the object factory, so attributes
+    // need to be initialized to their default values here.
+    ObjectBase::ConstructSelf(AttributeConstructionList());
+
     SetCollisionMatrix(collisionMatrix);
 }
 
@@ -189,8 +383,6 @@ LoraInterferenceHelper::~LoraInterferenceHelper()
     NS_LOG_FUNCTION(this);
 }
 
-Time LoraInterferenceHelper::oldEventThreshold = Seconds(2);
-
 Ptr<LoraInterferenceHelper::Event>
 LoraInterferenceHelper::Add(Time duration,
                             double rxPower,
@@ -201,23 +393,38 @@ LoraInterferenceHelper::Add(Time duration,
     NS_LOG_FUNCTION(this << duration.GetSeconds() << rxPower << unsigned(spreadingFactor) << packet
                          << frequencyMHz);
 
-    // Create an event based on the parameters
+    // Create an event based on the parameters. The packet is only attached to
+    // the event if a receiver locks on it.
     Ptr<LoraInterferenceHelper::Event> event =
-        Create<LoraInterferenceHelper::Event>(duration,
-                                              rxPower,
-                                              spreadingFactor,
-                                              packet,
-                                              frequencyMHz);
-
-    // Add the event to the list
-    m_events.push_back(event);
-
-    // Clean the event list
-    if (m_events.size() > 100)
+        m_eventPool->Allocate(duration, rxPower, spreadingFactor, frequencyMHz);
+
+    // Add the event to the events of its channel, keeping them sorted by start
+    // time. Since events are created at the current time, this is usually an
+    // insertion at the back.
+    ChannelEvents& channel = m_events[frequencyMHz];
+    double startTime = event->GetStartTime().GetTimeStep();
+    auto position = std::upper_bound(channel.startTimes.begin() + channel.head,
+                                     channel.startTimes.end(),
+                                     startTime) -
+                    channel.startTimes.begin();
+    channel.events.insert(channel.events.begin() + position, event);
+    channel.startTimes.insert(channel.startTimes.begin() + position, startTime);
+    channel.endTimes.insert(channel.endTimes.begin() + position,
+                            event->GetEndTime().GetTimeStep());
+    channel.rxPowersW.insert(channel.rxPowersW.begin() + position, event->GetRxPowerW());
+    channel.sfs.insert(channel.sfs.begin() + position, spreadingFactor);
+    channel.maxDuration = std::max(channel.maxDuration, double(duration.GetTimeStep()));
+    m_nEvents++;
+
+    // Update the interference accumulated by the receptions in progress
+    for (auto& tracked : channel.tracked)
     {
-        CleanOldEvents();
+        AddInterferenceEnergy(tracked.event, event, tracked.cumulativeInterferenceEnergy);
     }
 
+    // Clean the event list
+    CleanOldEvents(channel);
+
     return event;
 }
 
@@ -226,24 +433,64 @@ LoraInterferenceHelper::CleanOldEvents()
 {
     NS_LOG_FUNCTION(this);
 
-    // Cycle the events, and clean up if an event is old.
-    for (auto it = m_events.begin(); it != m_events.end();)
+    for (auto& [frequency, channel] : m_events)
     {
-        if ((*it)->GetEndTime() + oldEventThreshold < Simulator::Now())
-        {
-            it = m_events.erase(it);
-        }
-        else
-        {
-            it++;
-        }
+        CleanOldEvents(channel);
+    }
+}
+
+void
+LoraInterferenceHelper::CleanOldEvents(ChannelEvents& channel)
+{
+    // An event may still overlap with a reception that is in progress as long
+    // as it ended less than maxDuration ago: never discard events before that,
+    // even if the retention time is shorter.
+    double threshold = (Simulator::Now() - m_retentionTime).GetTimeStep();
+    threshold = std::min(threshold, Simulator::Now().GetTimeStep() - channel.maxDuration);
+
+    while (channel.head < channel.events.size() && channel.endTimes[channel.head] < threshold)
+    {
+        // Release the event right away, its slot is reclaimed on compaction
+        channel.events[channel.head] = nullptr;
+        channel.head++;
+        m_nEvents--;
+    }
+
+    // Reclaim the space of the discarded events once they make up most of the
+    // arrays, so that each event is moved a bounded number of times.
+    if (channel.head > 0 && channel.head >= channel.events.size() / 2)
+    {
+        channel.events.erase(channel.events.begin(), channel.events.begin() + channel.head);
+        channel.startTimes.erase(channel.startTimes.begin(),
+                                 channel.startTimes.begin() + channel.head);
+        channel.endTimes.erase(channel.endTimes.begin(), channel.endTimes.begin() + channel.head);
+        channel.rxPowersW.erase(channel.rxPowersW.begin(),
+                                channel.rxPowersW.begin() + channel.head);
+        channel.sfs.erase(channel.sfs.begin(), channel.sfs.begin() + channel.head);
+        channel.head = 0;
     }
 }
 
 std::list<Ptr<LoraInterferenceHelper::Event>>
 LoraInterferenceHelper::GetInterferers()
 {
-    return m_events;
+    std::list<Ptr<LoraInterferenceHelper::Event>> interferers;
+
+    for (const auto& [frequency, channel] : m_events)
+    {
+        interferers.insert(interferers.end(),
+                           channel.events.begin() + channel.head,
+                           channel.events.end());
+    }
+
+    // Merge the events of the different channels in chronological order
+    interferers.sort(
+        [](const Ptr<LoraInterferenceHelper::Event>& a,
+           const Ptr<LoraInterferenceHelper::Event>& b) {
+            return a->GetStartTime() < b->GetStartTime();
+        });
+
+    return interferers;
 }
 
 void
@@ -253,101 +500,352 @@ LoraInterferenceHelper::PrintEvents(std::ostream& stream)
 
     stream << "Currently registered events:" << std::endl;
 
-    for (auto it = m_events.begin(); it != m_events.end(); it++)
+    for (const auto& event : GetInterferers())
     {
-        (*it)->Print(stream);
+        event->Print(stream);
         stream << std::endl;
     }
 }
 
+std::pair<std::size_t, std::size_t>
+LoraInterferenceHelper::GetCandidateInterferers(const ChannelEvents& channel,
+                                                double start,
+                                                double end)
+{
+    // An event can only overlap with the interval if it starts before the end
+    // of the interval and, since no event lasts longer than maxDuration, if it
+    // starts after start - maxDuration.
+    auto first = std::lower_bound(channel.startTimes.begin() + channel.head,
+                                  channel.startTimes.end(),
+                                  start - channel.maxDuration);
+    auto last = std::lower_bound(first, channel.startTimes.end(), end);
+
+    return std::make_pair(first - channel.startTimes.begin(), last - channel.startTimes.begin());
+}
+
+void
+LoraInterferenceHelper::TrackEvent(Ptr<LoraInterferenceHelper::Event> event)
+{
+    NS_LOG_FUNCTION(this << event);
+
+    // Under the ALOHA collision matrix the outcome of a reception only
+    // depends on the overlap with other events, so there is no energy to
+    // accumulate
+    if (!m_incrementalInterference || m_collisionMatrix == LoraInterferenceHelper::ALOHA)
+    {
+        return;
+    }
+
+    // Initialize the accumulators with the interference caused by the events
+    // that are already registered. Events added from now on will update them
+    // as they are added.
+    TrackedEvent tracked;
+    tracked.event = event;
+    tracked.cumulativeInterferenceEnergy = GetCumulativeInterferenceEnergy(event);
+    m_events[event->GetFrequency()].tracked.push_back(tracked);
+}
+
+void
+LoraInterferenceHelper::UntrackEvent(Ptr<LoraInterferenceHelper::Event> event)
+{
+    NS_LOG_FUNCTION(this << event);
+
+    auto channelIt = m_events.find(event->GetFrequency());
+    if (channelIt == m_events.end())
+    {
+        return;
+    }
+
+    auto& tracked = channelIt->second.tracked;
+    tracked.erase(std::remove_if(tracked.begin(),
+                                 tracked.end(),
+                                 [event](const TrackedEvent& t) { return t.event == event; }),
+                  tracked.end());
+}
+
+void
+LoraInterferenceHelper::AddInterferenceEnergy(
+    Ptr<LoraInterferenceHelper::Event> event,
+    Ptr<LoraInterferenceHelper::Event> interferer,
+    std::vector<double>& cumulativeInterferenceEnergy)
+{
+    // Gather information about this interferer
+    uint8_t interfererSf = interferer->GetSpreadingFactor();
+    double interfererPower = interferer->GetRxPowerdBm();
+    Time interfererStartTime = interferer->GetStartTime();
+    Time interfererEndTime = interferer->GetEndTime();
+
+    NS_LOG_INFO("Found an interferer: sf = " << unsigned(interfererSf)
+                                             << ", power = " << interfererPower
+                                             << ", start time = " << interfererStartTime
+                                             << ", end time = " << interfererEndTime);
+
+    // Compute the equivalent energy of the interference
+    double interferenceEnergy = GetInterferenceEnergy(event->GetStartTime().GetTimeStep(),
+                                                      event->GetEndTime().GetTimeStep(),
+                                                      interfererStartTime.GetTimeStep(),
+                                                      interfererEndTime.GetTimeStep(),
+                                                      interferer->GetRxPowerW(),
+                                                      GetStepsPerSecond());
+    cumulativeInterferenceEnergy.at(unsigned(interfererSf) - 7) += interferenceEnergy;
+    NS_LOG_DEBUG("Interferer power in W: " << interferer->GetRxPowerW());
+    NS_LOG_DEBUG("Interference energy: " << interferenceEnergy);
+}
+
+std::vector<double>
+LoraInterferenceHelper::GetCumulativeInterferenceEnergy(Ptr<LoraInterferenceHelper::Event> event)
+{
+    // Energy for interferers of various SFs
+    std::vector<double> cumulativeInterferenceEnergy(6, 0);
+
+    // Only consider events on the same channel: we assume there's no
+    // interchannel interference.
+    auto channelIt = m_events.find(event->GetFrequency());
+    if (channelIt == m_events.end())
+    {
+        return cumulativeInterferenceEnergy;
+    }
+
+    auto [first, last] = GetCandidateInterferers(channelIt->second,
+                                                 event->GetStartTime().GetTimeStep(),
+                                                 event->GetEndTime().GetTimeStep());
+    AddInterferenceEnergy(channelIt->second, first, last, event, cumulativeInterferenceEnergy);
+
+    return cumulativeInterferenceEnergy;
+}
+
+void
+LoraInterferenceHelper::AddInterferenceEnergy(const ChannelEvents& channel,
+                                              std::size_t first,
+                                              std::size_t last,
+                                              Ptr<LoraInterferenceHelper::Event> event,
+                                              std::vector<double>& cumulativeInterferenceEnergy)
+{
+    double start = event->GetStartTime().GetTimeStep();
+    double end = event->GetEndTime().GetTimeStep();
+
+    // Compute the energy of all the events that may overlap with this one in a
+    // single pass, then sort it by SF
+    m_interferenceEnergies.resize(last - first);
+    ComputeInterferenceEnergies(channel.startTimes.data() + first,
+                                channel.endTimes.data() + first,
+                                channel.rxPowersW.data() + first,
+                                last - first,
+                                start,
+                                end,
+                                GetStepsPerSecond(),
+                                m_interferenceEnergies.data());
+
+    for (std::size_t i = first; i < last; i++)
+    {
+        // Skip the current event if it's the same that we want to analyze.
+        if (channel.events[i] == event)
+        {
+            NS_LOG_DEBUG("Same event");
+            continue;
+        }
+
+        cumulativeInterferenceEnergy[unsigned(channel.sfs[i]) - 7] +=
+            m_interferenceEnergies[i - first];
+    }
+}
+
+bool
+LoraInterferenceHelper::TakeAccumulatedInterferenceEnergy(
+    Ptr<LoraInterferenceHelper::Event> event,
+    std::vector<double>& cumulativeInterferenceEnergy)
+{
+    auto channelIt = m_events.find(event->GetFrequency());
+    if (channelIt == m_events.end())
+    {
+        return false;
+    }
+
+    auto& trackedEvents = channelIt->second.tracked;
+    for (auto it = trackedEvents.begin(); it != trackedEvents.end(); ++it)
+    {
+        if (it->event == event)
+        {
+            NS_LOG_DEBUG("Using accumulated interference energy");
+            cumulativeInterferenceEnergy = std::move(it->cumulativeInterferenceEnergy);
+            trackedEvents.erase(it);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool
+LoraInterferenceHelper::HasSameSfInterferer(Ptr<LoraInterferenceHelper::Event> event)
+{
+    auto channelIt = m_events.find(event->GetFrequency());
+    if (channelIt == m_events.end())
+    {
+        return false;
+    }
+
+    const ChannelEvents& channel = channelIt->second;
+    double start = event->GetStartTime().GetTimeStep();
+    double end = event->GetEndTime().GetTimeStep();
+    uint8_t sf = event->GetSpreadingFactor();
+    auto [first, last] = GetCandidateInterferers(channel, start, end);
+
+    for (std::size_t i = first; i < last; i++)
+    {
+        if (channel.sfs[i] == sf && channel.endTimes[i] > start && channel.startTimes[i] < end &&
+            channel.events[i] != event)
+        {
+            NS_LOG_DEBUG("Found an overlapping interferer with the same SF");
+            return true;
+        }
+    }
+    return false;
+}
+
+uint8_t
+LoraInterferenceHelper::IsDestroyedByInterference(Ptr<LoraInterferenceHelper::Event> event)
+{
+    switch (m_collisionMatrix)
+    {
+    case LoraInterferenceHelper::ALOHA:
+        return IsDestroyedByInterference<AlohaInterferencePolicy>(event);
+    case LoraInterferenceHelper::GOURSAUD:
+        return IsDestroyedByInterference<GoursaudInterferencePolicy>(event);
+    }
+    return IsDestroyedByInterference<GoursaudInterferencePolicy>(event);
+}
+
+template <typename Policy>
 uint8_t
 LoraInterferenceHelper::IsDestroyedByInterference(Ptr<LoraInterferenceHelper::Event> event)
 {
     NS_LOG_FUNCTION(this << event);
 
-    NS_LOG_INFO("Current number of events in LoraInterferenceHelper: " << m_events.size());
+    NS_LOG_INFO("Current number of events in LoraInterferenceHelper: " << m_nEvents);
+
+    if constexpr (Policy::overlapOnly)
+    {
+        // The packet is lost if it overlaps with any other packet with the
+        // same SF, regardless of the power of the signals: a pure overlap test
+        // is enough.
+        UntrackEvent(event);
+        if (HasSameSfInterferer(event))
+        {
+            NS_LOG_DEBUG("Packet destroyed by interference with SF"
+                         << unsigned(event->GetSpreadingFactor()));
+            return event->GetSpreadingFactor();
+        }
+        NS_LOG_DEBUG("Packet survived all interference");
+        return uint8_t(0);
+    }
 
     // We want to see the interference affecting this event: cycle through events
     // that overlap with this one and see whether it survives the interference or
     // not.
 
-    // Gather information about the event
-    double rxPowerDbm = event->GetRxPowerdBm();
-    uint8_t sf = event->GetSpreadingFactor();
-    double frequency = event->GetFrequency();
+    // Energy for interferers of various SFs
+    std::vector<double> cumulativeInterferenceEnergy;
 
-    // Handy information about the time frame when the packet was received
-    Time now = Simulator::Now();
-    Time duration = event->GetDuration();
-    Time packetStartTime = now - duration;
+    // If the interference on this event was accumulated while it was being
+    // received, use the accumulators. Otherwise, compute the interference from
+    // the list of events.
+    if (!TakeAccumulatedInterferenceEnergy(event, cumulativeInterferenceEnergy))
+    {
+        cumulativeInterferenceEnergy = GetCumulativeInterferenceEnergy(event);
+    }
 
-    // Get the list of interfering events
-    std::list<Ptr<LoraInterferenceHelper::Event>>::iterator it;
+    return CheckInterference<Policy>(event, cumulativeInterferenceEnergy);
+}
 
-    // Energy for interferers of various SFs
-    std::vector<double> cumulativeInterferenceEnergy(6, 0);
+std::vector<uint8_t>
+LoraInterferenceHelper::IsDestroyedByInterference(
+    const std::vector<Ptr<LoraInterferenceHelper::Event>>& events)
+{
+    NS_LOG_FUNCTION(this << events.size());
 
-    // Cycle over the events
-    for (it = m_events.begin(); it != m_events.end();)
+    std::vector<uint8_t> outcomes(events.size(), 0);
+
+    // The ALOHA policy doesn't compute any energy, so there is nothing to share
+    if (m_collisionMatrix == LoraInterferenceHelper::ALOHA)
+    {
+        for (std::size_t i = 0; i < events.size(); i++)
+        {
+            outcomes[i] = IsDestroyedByInterference<AlohaInterferencePolicy>(events[i]);
+        }
+        return outcomes;
+    }
+
+    // Use the accumulators of the tracked events, and group the other events
+    // by channel
+    std::vector<std::vector<double>> energies(events.size());
+    std::map<double, std::vector<std::size_t>> untracked;
+    for (std::size_t i = 0; i < events.size(); i++)
+    {
+        if (!TakeAccumulatedInterferenceEnergy(events[i], energies[i]))
+        {
+            energies[i].assign(6, 0);
+            untracked[events[i]->GetFrequency()].push_back(i);
+        }
+    }
+
+    // Find the interferers of all the events of a channel with a single
+    // search, over the union of their time intervals. Summing the energy of
+    // interferers that don't overlap with an event adds zeros, so the result
+    // is the same as for a search over each event's own interval.
+    for (const auto& [frequency, indices] : untracked)
     {
-        // Pointer to the current interferer
-        Ptr<LoraInterferenceHelper::Event> interferer = *it;
+        auto channelIt = m_events.find(frequency);
+        if (channelIt == m_events.end())
+        {
+            continue;
+        }
+
+        Time start = events[indices.front()]->GetStartTime();
+        Time end = events[indices.front()]->GetEndTime();
+        for (auto i : indices)
+        {
+            start = std::min(start, events[i]->GetStartTime());
+            end = std::max(end, events[i]->GetEndTime());
+        }
+        auto [first, last] =
+            GetCandidateInterferers(channelIt->second, start.GetTimeStep(), end.GetTimeStep());
 
-        // Only consider the current event if the channel is the same: we
-        // assume there's no interchannel interference. Also skip the current
-        // event if it's the same that we want to analyze.
-        if (!(interferer->GetFrequency() == frequency) || interferer == event)
+        for (auto i : indices)
         {
-            NS_LOG_DEBUG("Different channel or same event");
-            it++;
-            continue; // Continues from the first line inside the for cycle
+            AddInterferenceEnergy(channelIt->second, first, last, events[i], energies[i]);
         }
+    }
 
-        NS_LOG_DEBUG("Interferer on same channel");
-
-        // Gather information about this interferer
-        uint8_t interfererSf = interferer->GetSpreadingFactor();
-        double interfererPower = interferer->GetRxPowerdBm();
-        Time interfererStartTime = interferer->GetStartTime();
-        Time interfererEndTime = interferer->GetEndTime();
-
-        NS_LOG_INFO("Found an interferer: sf = " << unsigned(interfererSf)
-                                                 << ", power = " << interfererPower
-                                                 << ", start time = " << interfererStartTime
-                                                 << ", end time = " << interfererEndTime);
-
-        // Compute the fraction of time the two events are overlapping
-        Time overlap = GetOverlapTime(event, interferer);
-
-        NS_LOG_DEBUG("The two events overlap for " << overlap.GetSeconds() << " s.");
-
-        // Compute the equivalent energy of the interference
-        // Power [mW] = 10^(Power[dBm]/10)
-        // Power [W] = Power [mW] / 1000
-        double interfererPowerW = pow(10, interfererPower / 10) / 1000;
-        // Energy [J] = Time [s] * Power [W]
-        double interferenceEnergy = overlap.GetSeconds() * interfererPowerW;
-        cumulativeInterferenceEnergy.at(unsigned(interfererSf) - 7) += interferenceEnergy;
-        NS_LOG_DEBUG("Interferer power in W: " << interfererPowerW);
-        NS_LOG_DEBUG("Interference energy: " << interferenceEnergy);
-        it++;
+    for (std::size_t i = 0; i < events.size(); i++)
+    {
+        outcomes[i] = CheckInterference<GoursaudInterferencePolicy>(events[i], energies[i]);
     }
 
+    return outcomes;
+}
+
+template <typename Policy>
+uint8_t
+LoraInterferenceHelper::CheckInterference(Ptr<LoraInterferenceHelper::Event> event,
+                                          const std::vector<double>& cumulativeInterferenceEnergy)
+{
+    // Gather information about the event
+    uint8_t sf = event->GetSpreadingFactor();
+
+    // Compute the energy of the signal
+    double signalPowerW = event->GetRxPowerW();
+    double signalEnergy = event->GetDuration().GetTimeStep() / GetStepsPerSecond() * signalPowerW;
+    NS_LOG_DEBUG("Signal power in W: " << signalPowerW);
+    NS_LOG_DEBUG("Signal energy: " << signalEnergy);
+
     // For each SF, check if there was destructive interference
     for (auto currentSf = uint8_t(7); currentSf <= uint8_t(12); currentSf++)
     {
         NS_LOG_DEBUG("Cumulative Interference Energy: "
                      << cumulativeInterferenceEnergy.at(unsigned(currentSf) - 7));
 
-        // Use the computed cumulativeInterferenceEnergy to determine whether the
-        // interference with this SF destroys the packet
-        double signalPowerW = pow(10, rxPowerDbm / 10) / 1000;
-        double signalEnergy = duration.GetSeconds() * signalPowerW;
-        NS_LOG_DEBUG("Signal power in W: " << signalPowerW);
-        NS_LOG_DEBUG("Signal energy: " << signalEnergy);
-
         // Check whether the packet survives the interference of this SF
-        double snirIsolation = m_collisionSnir[unsigned(sf) - 7][unsigned(currentSf) - 7];
+        double snirIsolation = Policy::collisionSnir[unsigned(sf) - 7][unsigned(currentSf) - 7];
         NS_LOG_DEBUG("The needed isolation to survive is " << snirIsolation << " dB");
         double snir =
             10 * log10(signalEnergy / cumulativeInterferenceEnergy.at(unsigned(currentSf) - 7));
@@ -372,12 +870,18 @@ LoraInterferenceHelper::IsDestroyedByInterference(Ptr<LoraInterferenceHelper::Ev
     return uint8_t(0);
 }
 
+template uint8_t LoraInterferenceHelper::IsDestroyedByInterference<AlohaInterferencePolicy>(
+    Ptr<LoraInterferenceHelper::Event> event);
+template uint8_t LoraInterferenceHelper::IsDestroyedByInterference<GoursaudInterferencePolicy>(
+    Ptr<LoraInterferenceHelper::Event> event);
+
 void
 LoraInterferenceHelper::ClearAllEvents()
 {
     NS_LOG_FUNCTION_NOARGS();
 
     m_events.clear();
+    m_nEvents = 0;
 }
 
 Time
@@ -29,7 +29,12 @@
 #include "ns3/simulator.h"
 #include "ns3/traced-callback.h"
 
+#include <array>
+#include <limits>
 #include <list>
+#include <map>
+#include <memory>
+#include <vector>
 
 namespace ns3
 {
@@ -43,16 +48,35 @@ namespace lorawan
  * device, in order to compute which ones can be correctly received and which
  * ones are lost due to interference.
  */
-class LoraInterferenceHelper
+class LoraInterferenceHelper : public ObjectBase
 {
   public:
+    class Event;
+    class EventPool;
+
+    /**
+     * Deleter for events, which returns the events allocated by an EventPool
+     * to their pool instead of freeing them.
+     */
+    struct EventDeleter
+    {
+        /**
+         * Destroy an event.
+         *
+         * \param event The event to destroy.
+         */
+        static void Delete(LoraInterferenceHelper::Event* event);
+    };
+
     /**
      * A class representing a signal in time.
      *
      * Used in LoraInterferenceHelper to keep track of which signals overlap and
      * cause destructive interference.
      */
-    class Event : public SimpleRefCount<LoraInterferenceHelper::Event>
+    class Event : public SimpleRefCount<LoraInterferenceHelper::Event,
+                                        Empty,
+                                        LoraInterferenceHelper::EventDeleter>
     {
       public:
         Event(Time duration,
@@ -82,6 +106,11 @@ class LoraInterferenceHelper
          */
         double GetRxPowerdBm() const;
 
+        /**
+         * Get the power of the event in W.
+         */
+        double GetRxPowerW() const;
+
         /**
          * Get the spreading factor used by this signal.
          */
@@ -89,9 +118,42 @@ class LoraInterferenceHelper
 
         /**
          * Get the packet this event was generated for.
+         *
+         * Events only keep a reference to their packet once a receiver locks
+         * on them (see SetPacket), so that the packets of the interferers are
+         * not kept alive for the whole time they are stored in the
+         * LoraInterferenceHelper.
+         *
+         * \return The packet, or nullptr if it was never set.
          */
         Ptr<Packet> GetPacket() const;
 
+        /**
+         * Set the packet this event was generated for.
+         *
+         * \param packet The packet.
+         */
+        void SetPacket(Ptr<Packet> packet);
+
+        /**
+         * Get the index of the gateway reception path locked on this event.
+         *
+         * \return The index, or NO_RECEPTION_PATH if no path is locked on it.
+         */
+        uint32_t GetReceptionPath() const;
+
+        /**
+         * Set the index of the gateway reception path locked on this event.
+         *
+         * \param index The index, or NO_RECEPTION_PATH to unset it.
+         */
+        void SetReceptionPath(uint32_t index);
+
+        /**
+         * The value of the reception path index of events no path is locked on.
+         */
+        static constexpr uint32_t NO_RECEPTION_PATH = std::numeric_limits<uint32_t>::max();
+
         /**
          * Get the frequency this event was on.
          */
@@ -123,6 +185,12 @@ class LoraInterferenceHelper
          */
         double m_rxPowerdBm;
 
+        /**
+         * The power of this event in W (at the device), precomputed so that
+         * interference computations don't need to convert it every time.
+         */
+        double m_rxPowerW;
+
         /**
          * The packet this event was generated for.
          */
@@ -132,6 +200,91 @@ class LoraInterferenceHelper
          * The frequency this event was on.
          */
         double m_frequencyMHz;
+
+        /**
+         * The index of the reception path locked on this event, so that
+         * gateways can release it without searching for it.
+         */
+        uint32_t m_receptionPath;
+
+        /**
+         * The pool this event was allocated from, or nullptr if it was
+         * allocated on the heap.
+         */
+        Ptr<EventPool> m_pool;
+
+        friend class EventPool;
+        friend struct EventDeleter;
+    };
+
+    /**
+     * A pool of events.
+     *
+     * Events are constructed in slabs of preallocated slots, and slots are
+     * recycled when events are destroyed. This avoids a heap allocation for
+     * each signal impinging on the device. The pool is reference counted, and
+     * each event it allocates holds a reference to it, so that events can
+     * outlive the LoraInterferenceHelper that created them.
+     */
+    class EventPool : public SimpleRefCount<LoraInterferenceHelper::EventPool>
+    {
+      public:
+        EventPool();
+        ~EventPool();
+
+        /**
+         * Construct an event in a free slot of the pool.
+         *
+         * \param duration the duration of the event.
+         * \param rxPowerdBm the received power in dBm.
+         * \param spreadingFactor the spreading factor of the signal.
+         * \param frequencyMHz the frequency of the signal.
+         *
+         * \return The event.
+         */
+        Ptr<LoraInterferenceHelper::Event> Allocate(Time duration,
+                                                    double rxPowerdBm,
+                                                    uint8_t spreadingFactor,
+                                                    double frequencyMHz);
+
+        /**
+         * Destroy an event allocated by this pool, and recycle its slot.
+         *
+         * \param event The event.
+         */
+        void Release(LoraInterferenceHelper::Event* event);
+
+        /**
+         * Get the number of slots allocated by this pool.
+         *
+         * \return The number of slots, free or in use.
+         */
+        std::size_t GetCapacity() const;
+
+        /**
+         * Get the number of events currently allocated from this pool.
+         *
+         * \return The number of slots in use.
+         */
+        std::size_t GetSize() const;
+
+      private:
+        /**
+         * Storage for a single event.
+         */
+        struct Slot
+        {
+            alignas(LoraInterferenceHelper::Event) unsigned char
+                storage[sizeof(LoraInterferenceHelper::Event)]; //!< The raw memory
+        };
+
+        /**
+         * The number of slots in each slab.
+         */
+        static const std::size_t SLAB_SIZE = 256;
+
+        std::vector<std::unique_ptr<Slot[]>> m_slabs; //!< The slabs of slots
+        std::vector<Slot*> m_freeSlots;               //!< The slots that are not in use
     };
 
     enum CollisionMatrix
@@ -140,10 +293,19 @@ class LoraInterferenceHelper
         ALOHA,
     };
 
+    /**
+     * A matrix of the isolation (in dB) needed by a signal to survive the
+     * interference of another signal, indexed by the SF of the signal minus 7
+     * and by the SF of the interferer minus 7.
+     */
+    using CollisionSnirMatrix = std::array<std::array<double, 6>, 6>;
+
     static TypeId GetTypeId();
 
+    TypeId GetInstanceTypeId() const override;
+
     LoraInterferenceHelper();
-    virtual ~LoraInterferenceHelper();
+    ~LoraInterferenceHelper() override;
 
     /**
      * Add an event to the InterferenceHelper
@@ -151,7 +313,9 @@ class LoraInterferenceHelper
      * \param duration the duration of the packet.
      * \param rxPower the received power in dBm.
      * \param spreadingFactor the spreading factor used by the transmission.
-     * \param packet The packet carried by this transmission.
+     * \param packet The packet carried by this transmission. The event does not
+     * keep a reference to it: receivers locking on the event should call
+     * Event::SetPacket.
      * \param frequencyMHz The frequency this event was sent at.
      *
      * \return the newly created event
@@ -164,7 +328,7 @@ class LoraInterferenceHelper
 
     /**
      * Get a list of the interferers currently registered at this
-     * InterferenceHelper.
+     * InterferenceHelper, ordered by start time.
      */
     std::list<Ptr<LoraInterferenceHelper::Event>> GetInterferers();
 
@@ -184,6 +348,64 @@ class LoraInterferenceHelper
      */
     uint8_t IsDestroyedByInterference(Ptr<LoraInterferenceHelper::Event> event);
 
+    /**
+     * Determine whether the event was destroyed by interference or not, using
+     * the collision model of a policy instead of the collision matrix of this
+     * helper.
+     *
+     * This is instantiated for AlohaInterferencePolicy and
+     * GoursaudInterferencePolicy, so that the collision model is resolved at
+     * compile time.
+     *
+     * \param event The event for which to check the outcome.
+     * \return The sf of the packets that caused the loss, or 0 if there was no
+     * loss.
+     */
+    template <typename Policy>
+    uint8_t IsDestroyedByInterference(Ptr<LoraInterferenceHelper::Event> event);
+
+    /**
+     * Determine whether each of a set of events was destroyed by interference
+     * or not.
+     *
+     * The outcome of each event is the same as the one returned by
+     * IsDestroyedByInterference for that event, but the events that are on
+     * the same channel share a single search for their interferers. This is
+     * useful when several receptions end at the same time.
+     *
+     * \param events The events for which to check the outcome.
+     * \return For each event, the sf of the packets that caused the loss, or 0
+     * if there was no loss.
+     */
+    std::vector<uint8_t> IsDestroyedByInterference(
+        const std::vector<Ptr<LoraInterferenceHelper::Event>>& events);
+
+    /**
+     * Start accumulating the interference on an event as interferers are
+     * added.
+     *
+     * This should be called when a receiver locks on the event. If the
+     * IncrementalInterference attribute is set, the interference energy of
+     * the event is updated every time a new event is added on its channel, and
+     * IsDestroyedByInterference only needs to compare the accumulated energy
+     * with the SNIR thresholds. If the attribute is not set, or if the ALOHA
+     * collision matrix is used (since it only needs an overlap test), this
+     * method does nothing.
+     *
+     * \param event The event to track.
+     */
+    void TrackEvent(Ptr<LoraInterferenceHelper::Event> event);
+
+    /**
+     * Stop accumulating the interference on an event.
+     *
+     * This should be called when a reception is aborted before its end, since
+     * the outcome of the event will never be checked.
+     *
+     * \param event The event to stop tracking.
+     */
+    void UntrackEvent(Ptr<LoraInterferenceHelper::Event> event);
+
     /**
      * Compute the time duration in which two given events are overlapping.
      *
@@ -202,32 +424,266 @@ class LoraInterferenceHelper
 
     /**
      * Delete old events in this LoraInterferenceHelper.
+     *
+     * Events are discarded once they ended more than RetentionTime ago. Old
+     * events are also discarded automatically whenever a new event is added on
+     * the same channel, so calling this method is only needed to release memory
+     * on channels that are no longer in use.
      */
     void CleanOldEvents();
 
     static CollisionMatrix collisionMatrix;
 
-    static std::vector<std::vector<double>> collisionSnirAloha;
-    static std::vector<std::vector<double>> collisionSnirGoursaud;
+    /**
+     * The isolation used to represent a signal that can never survive.
+     */
+    static constexpr double inf = std::numeric_limits<double>::max();
+
+    /**
+     * This collision matrix can be used for comparisons with the performance
+     * of Aloha systems, where collisions imply the loss of both packets.
+     */
+    static constexpr CollisionSnirMatrix collisionSnirAloha = {{
+        //   7     8     9    10    11    12
+        {{inf, -inf, -inf, -inf, -inf, -inf}}, // SF7
+        {{-inf, inf, -inf, -inf, -inf, -inf}}, // SF8
+        {{-inf, -inf, inf, -inf, -inf, -inf}}, // SF9
+        {{-inf, -inf, -inf, inf, -inf, -inf}}, // SF10
+        {{-inf, -inf, -inf, -inf, inf, -inf}}, // SF11
+        {{-inf, -inf, -inf, -inf, -inf, inf}}  // SF12
+    }};
+
+    /**
+     * LoRa Collision Matrix (Goursaud).
+     *
+     * Values are inverted w.r.t. the paper since here we interpret this as an
+     * _isolation_ matrix instead of a cochannel _rejection_ matrix like in
+     * Goursaud's paper.
+     */
+    static constexpr CollisionSnirMatrix collisionSnirGoursaud = {{
+        // SF7  SF8  SF9  SF10 SF11 SF12
+        {{6, -16, -18, -19, -19, -20}}, // SF7
+        {{-24, 6, -20, -22, -22, -22}}, // SF8
+        {{-27, -27, 6, -23, -25, -25}}, // SF9
+        {{-30, -30, -30, 6, -26, -28}}, // SF10
+        {{-33, -33, -33, -33, 6, -29}}, // SF11
+        {{-36, -36, -36, -36, -36, 6}}  // SF12
+    }};
+
+    /**
+     * Get the collision matrix used by this helper.
+     *
+     * \return The collision matrix.
+     */
+    CollisionMatrix GetCollisionMatrix() const;
 
   private:
     void SetCollisionMatrix(enum CollisionMatrix collisionMatrix);
 
-    std::vector<std::vector<double>> m_collisionSnir;
+    /**
+     * The collision matrix used by this helper.
+     */
+    CollisionMatrix m_collisionMatrix;
+
+    /**
+     * Check whether an event overlaps with another event with the same SF.
+     *
+     * \param event The event being interfered.
+     * \return Whether an overlapping event with the same SF was found.
+     */
+    bool HasSameSfInterferer(Ptr<LoraInterferenceHelper::Event> event);
+
+    /**
+     * An event whose interference energy is updated as interferers are added.
+     */
+    struct TrackedEvent
+    {
+        Ptr<LoraInterferenceHelper::Event> event; //!< The event being received
+        std::vector<double> cumulativeInterferenceEnergy; //!< Interference energy per SF
+    };
+
+    /**
+     * The events registered on a single frequency.
+     *
+     * Events are kept ordered by start time. Together with the duration of the
+     * longest event ever seen on the channel, this bounds the range of events
+     * that can overlap with a given time interval, so that interferers can be
+     * found with a binary search instead of a scan of all events.
+     *
+     * The quantities needed by the interference computation are stored in
+     * parallel arrays, so that the energy of all candidate interferers can be
+     * computed in a single pass over contiguous memory. Times are integer
+     * numbers of time steps, stored as doubles (which represent them exactly)
+     * so that the computation can be vectorized. Events before head have been
+     * discarded, and are periodically compacted away.
+     */
+    struct ChannelEvents
+    {
+        std::vector<Ptr<LoraInterferenceHelper::Event>> events; //!< Events sorted by start time
+        std::vector<double> startTimes;  //!< Start time of each event, in time steps
+        std::vector<double> endTimes;    //!< End time of each event, in time steps
+        std::vector<double> rxPowersW;   //!< Power of each event, in W
+        std::vector<uint8_t> sfs;        //!< Spreading factor of each event
+        std::size_t head = 0;            //!< Index of the oldest event still stored
+        double maxDuration = 0; //!< Duration of the longest event on this channel, in time steps
+        std::vector<TrackedEvent> tracked; //!< Receptions in progress on this channel
+    };
 
     /**
-     * A list of the events this LoraInterferenceHelper is keeping track of.
+     * Add the energy of the interference caused by an interferer on an event
+     * to the per-SF accumulators.
+     *
+     * \param event The event being interfered.
+     * \param interferer The interfering event.
+     * \param cumulativeInterferenceEnergy The accumulators to update.
+     */
+    void AddInterferenceEnergy(Ptr<LoraInterferenceHelper::Event> event,
+                               Ptr<LoraInterferenceHelper::Event> interferer,
+                               std::vector<double>& cumulativeInterferenceEnergy);
+
+    /**
+     * Add the energy of the interference caused on an event by a range of the
+     * events of a channel to the per-SF accumulators.
+     *
+     * \param channel The channel of the event.
+     * \param first The index of the first candidate interferer.
+     * \param last The index past the last candidate interferer.
+     * \param event The event being interfered.
+     * \param cumulativeInterferenceEnergy The accumulators to update.
      */
-    std::list<Ptr<LoraInterferenceHelper::Event>> m_events;
+    void AddInterferenceEnergy(const ChannelEvents& channel,
+                               std::size_t first,
+                               std::size_t last,
+                               Ptr<LoraInterferenceHelper::Event> event,
+                               std::vector<double>& cumulativeInterferenceEnergy);
 
     /**
-     * The matrix containing information about how packets survive interference.
+     * Retrieve the interference energy accumulated on a tracked event, and
+     * stop tracking it.
+     *
+     * \param event The event being interfered.
+     * \param cumulativeInterferenceEnergy Where to store the accumulators.
+     * \return Whether the event was tracked.
+     */
+    bool TakeAccumulatedInterferenceEnergy(Ptr<LoraInterferenceHelper::Event> event,
+                                           std::vector<double>& cumulativeInterferenceEnergy);
+
+    /**
+     * Compare the interference energy on an event with the isolation required
+     * by a policy.
+     *
+     * \param event The event for which to check the outcome.
+     * \param cumulativeInterferenceEnergy The interference energy for each SF.
+     * \return The sf of the packets that caused the loss, or 0 if there was no
+     * loss.
+     */
+    template <typename Policy>
+    uint8_t CheckInterference(Ptr<LoraInterferenceHelper::Event> event,
+                              const std::vector<double>& cumulativeInterferenceEnergy);
+
+    /**
+     * Compute the interference energy per SF on an event from the list of
+     * registered events.
+     *
+     * \param event The event being interfered.
+     * \return The interference energy for each SF.
      */
+    std::vector<double> GetCumulativeInterferenceEnergy(Ptr<LoraInterferenceHelper::Event> event);
+
+    /**
+     * Get the range of events on a channel that may overlap with the
+     * [start, end) interval.
+     *
+     * \param channel The channel to search.
+     * \param start The beginning of the interval, in time steps.
+     * \param end The end of the interval, in time steps.
+     * \return A pair of indices delimiting the candidate interferers.
+     */
+    static std::pair<std::size_t, std::size_t> GetCandidateInterferers(
+        const ChannelEvents& channel,
+        double start,
+        double end);
+
+    /**
+     * The events this LoraInterferenceHelper is keeping track of, indexed by
+     * frequency.
+     */
+    std::map<double, ChannelEvents> m_events;
+
+    /**
+     * Delete the old events of a channel.
+     *
+     * Since events are sorted by start time, old events are popped from the
+     * front of the channel until an event that is still needed is found. This
+     * guarantees that each event is visited exactly once by the removal
+     * process.
+     *
+     * \param channel The channel to clean.
+     */
+    void CleanOldEvents(ChannelEvents& channel);
+
+    /**
+     * The total number of events stored in m_events.
+     */
+    std::size_t m_nEvents;
+
+    /**
+     * The time after which an event that has ended is considered old and
+     * removed from the list.
+     */
+    Time m_retentionTime;
+
+    /**
+     * Whether to accumulate the interference of tracked events incrementally.
+     */
+    bool m_incrementalInterference;
+
+    /**
+     * The pool events are allocated from.
+     */
+    Ptr<EventPool> m_eventPool;
+
+    /**
+     * Scratch buffer for the interference energy of each candidate interferer.
+     */
+    std::vector<double> m_interferenceEnergies;
+};
+
+/**
+ * Interference policy for LoraInterferenceHelper::IsDestroyedByInterference
+ * modeling an Aloha system: a packet is lost as soon as it overlaps with
+ * another packet using the same SF.
+ */
+struct AlohaInterferencePolicy
+{
+    /**
+     * Whether the outcome only depends on the overlap between signals.
+     */
+    static constexpr bool overlapOnly = true;
+
+    /**
+     * The isolation matrix of the policy.
+     */
+    static constexpr const LoraInterferenceHelper::CollisionSnirMatrix& collisionSnir =
+        LoraInterferenceHelper::collisionSnirAloha;
+};
+
+/**
+ * Interference policy for LoraInterferenceHelper::IsDestroyedByInterference
+ * using the isolation matrix from Goursaud's paper.
+ */
+struct GoursaudInterferencePolicy
+{
+    /**
+     * Whether the outcome only depends on the overlap between signals.
+     */
+    static constexpr bool overlapOnly = false;
+
     /**
-     * The threshold after which an event is considered old and removed from the
-     * list.
+     * The isolation matrix of the policy.
      */
-    static Time oldEventThreshold;
+    static constexpr const LoraInterferenceHelper::CollisionSnirMatrix& collisionSnir =
+        LoraInterferenceHelper::collisionSnirGoursaud;
 };
 
 /**
@@ -49,7 +49,9 @@ LoraNetDevice::GetTypeId()
             .AddAttribute("Phy",
                           "The PHY layer attached to this device.",
                           PointerValue(),
-                          MakePointerAccessor(&LoraNetDevice::GetPhy, &LoraNetDevice::SetPhy),
+                          MakePointerAccessor(
+                              (Ptr<LoraPhy>(LoraNetDevice::*)() const)&LoraNetDevice::GetPhy,
+                              &LoraNetDevice::SetPhy),
                           MakePointerChecker<LoraPhy>())
             .AddAttribute("Mac",
                           "The MAC layer attached to this device.",
@@ -97,6 +99,35 @@ LoraNetDevice::GetPhy() const
     return m_phy;
 }
 
+void
+LoraNetDevice::AddPhy(Ptr<LoraPhy> phy)
+{
+    NS_LOG_FUNCTION(this << phy);
+
+    m_additionalPhys.push_back(phy);
+    phy->SetDevice(this);
+
+    // PHYs added after the configuration was completed are connected here
+    if (m_configComplete)
+    {
+        ConnectAdditionalPhy(phy);
+    }
+}
+
+uint32_t
+LoraNetDevice::GetNPhys() const
+{
+    return (m_phy ? 1 : 0) + m_additionalPhys.size();
+}
+
+Ptr<LoraPhy>
+LoraNetDevice::GetPhy(uint32_t i) const
+{
+    NS_ASSERT(i < GetNPhys());
+
+    return i == 0 ? m_phy : m_additionalPhys[i - 1];
+}
+
 void
 LoraNetDevice::CompleteConfig()
 {
@@ -109,9 +140,25 @@ LoraNetDevice::CompleteConfig()
     }
 
     m_mac->SetPhy(m_phy);
+    for (const auto& phy : m_additionalPhys)
+    {
+        ConnectAdditionalPhy(phy);
+    }
     m_configComplete = true;
 }
 
+void
+LoraNetDevice::ConnectAdditionalPhy(Ptr<LoraPhy> phy)
+{
+    NS_LOG_FUNCTION(this << phy);
+
+    // Only the primary PHY is used for transmission, so it is the one the MAC
+    // keeps a reference to
+    phy->SetReceiveOkCallback(MakeCallback(&LorawanMac::Receive, m_mac));
+    phy->SetReceiveFailedCallback(MakeCallback(&LorawanMac::FailedReception, m_mac));
+    phy->SetTxFinishedCallback(MakeCallback(&LorawanMac::TxFinished, m_mac));
+}
+
 void
 LoraNetDevice::Send(Ptr<Packet> packet)
 {
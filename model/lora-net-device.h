@@ -26,6 +26,8 @@
 
 #include "ns3/net-device.h"
 
+#include <vector>
+
 namespace ns3
 {
 namespace lorawan
@@ -80,6 +82,35 @@ class LoraNetDevice : public NetDevice
      */
     Ptr<LoraPhy> GetPhy() const;
 
+    /**
+     * Add a PHY that receives packets for this device, besides the one set
+     * with SetPhy.
+     *
+     * This can be used to model the sectors of a gateway, each with its own
+     * antenna and demodulators. Packets received by any PHY are passed to the
+     * same LorawanMac, while packets are always sent through the PHY set with
+     * SetPhy.
+     *
+     * \param phy The additional PHY.
+     */
+    void AddPhy(Ptr<LoraPhy> phy);
+
+    /**
+     * Get the number of PHYs of this device.
+     *
+     * \return The number of PHYs, including the one set with SetPhy.
+     */
+    uint32_t GetNPhys() const;
+
+    /**
+     * Get a PHY of this device.
+     *
+     * \param i The index of the PHY, where 0 is the one set with SetPhy and
+     * the following ones were added with AddPhy.
+     * \return The PHY.
+     */
+    Ptr<LoraPhy> GetPhy(uint32_t i) const;
+
     /**
      * Send a packet through the LoRaWAN stack.
      *
@@ -154,10 +185,18 @@ class LoraNetDevice : public NetDevice
      */
     void CompleteConfig();
 
+    /**
+     * Connect a PHY added with AddPhy to the MAC layer.
+     *
+     * \param phy The PHY.
+     */
+    void ConnectAdditionalPhy(Ptr<LoraPhy> phy);
+
     // Member variables
     Ptr<Node> m_node;      //!< The Node this NetDevice is connected to.
     Ptr<LoraPhy> m_phy;    //!< The LoraPhy this NetDevice is connected to.
     Ptr<LorawanMac> m_mac; //!< The LorawanMac this NetDevice is connected to.
+    std::vector<Ptr<LoraPhy>> m_additionalPhys; //!< The PHYs added with AddPhy.
     bool m_configComplete; //!< Whether the configuration was already completed.
 
     /**
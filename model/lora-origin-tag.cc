@@ -0,0 +1,90 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "lora-origin-tag.h"
+
+namespace ns3
+{
+namespace lorawan
+{
+
+NS_OBJECT_ENSURE_REGISTERED(LoraOriginTag);
+
+TypeId
+LoraOriginTag::GetTypeId()
+{
+    static TypeId tid = TypeId("ns3::LoraOriginTag")
+                            .SetParent<Tag>()
+                            .SetGroupName("lorawan")
+                            .AddConstructor<LoraOriginTag>();
+    return tid;
+}
+
+TypeId
+LoraOriginTag::GetInstanceTypeId() const
+{
+    return GetTypeId();
+}
+
+LoraOriginTag::LoraOriginTag(uint32_t systemId, uint64_t packetUid)
+    : m_systemId(systemId),
+      m_packetUid(packetUid)
+{
+}
+
+LoraOriginTag::~LoraOriginTag()
+{
+}
+
+uint32_t
+LoraOriginTag::GetSerializedSize() const
+{
+    return 4 + 8;
+}
+
+void
+LoraOriginTag::Serialize(TagBuffer i) const
+{
+    i.WriteU32(m_systemId);
+    i.WriteU64(m_packetUid);
+}
+
+void
+LoraOriginTag::Deserialize(TagBuffer i)
+{
+    m_systemId = i.ReadU32();
+    m_packetUid = i.ReadU64();
+}
+
+void
+LoraOriginTag::Print(std::ostream& os) const
+{
+    os << "SystemId=" << m_systemId << " PacketUid=" << m_packetUid;
+}
+
+uint32_t
+LoraOriginTag::GetSystemId() const
+{
+    return m_systemId;
+}
+
+uint64_t
+LoraOriginTag::GetPacketUid() const
+{
+    return m_packetUid;
+}
+
+} // namespace lorawan
+} // namespace ns3
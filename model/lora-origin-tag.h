@@ -0,0 +1,77 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef LORA_ORIGIN_TAG_H
+#define LORA_ORIGIN_TAG_H
+
+#include "ns3/tag.h"
+
+namespace ns3
+{
+namespace lorawan
+{
+
+/**
+ * Tag identifying a packet received from another system of a distributed
+ * simulation.
+ *
+ * Packet uids are only unique within a system, so the packet is identified
+ * by the system it was sent from and its uid there. LoraPacketTracker uses
+ * this to merge the entries of the same packet across systems.
+ */
+class LoraOriginTag : public Tag
+{
+  public:
+    static TypeId GetTypeId();
+    TypeId GetInstanceTypeId() const override;
+
+    /**
+     * Create a LoraOriginTag.
+     *
+     * \param systemId The system the packet was sent from.
+     * \param packetUid The uid of the packet on that system.
+     */
+    LoraOriginTag(uint32_t systemId = 0, uint64_t packetUid = 0);
+
+    ~LoraOriginTag() override;
+
+    void Serialize(TagBuffer i) const override;
+    void Deserialize(TagBuffer i) override;
+    uint32_t GetSerializedSize() const override;
+    void Print(std::ostream& os) const override;
+
+    /**
+     * Get the system the packet was sent from.
+     *
+     * \return The system id.
+     */
+    uint32_t GetSystemId() const;
+
+    /**
+     * Get the uid of the packet on the system it was sent from.
+     *
+     * \return The packet uid.
+     */
+    uint64_t GetPacketUid() const;
+
+  private:
+    uint32_t m_systemId;  //!< The system the packet was sent from.
+    uint64_t m_packetUid; //!< The uid of the packet on that system.
+};
+
+} // namespace lorawan
+
+} // namespace ns3
+#endif /* LORA_ORIGIN_TAG_H */
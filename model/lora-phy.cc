@@ -20,6 +20,7 @@
 #include "lora-phy.h"
 
 #include "ns3/log.h"
+#include "ns3/pointer.h"
 #include "ns3/simulator.h"
 
 #include <algorithm>
@@ -40,6 +41,12 @@ LoraPhy::GetTypeId()
         TypeId("ns3::LoraPhy")
             .SetParent<Object>()
             .SetGroupName("lorawan")
+            .AddAttribute("Antenna",
+                          "The antenna model of this PHY, or none for an isotropic "
+                          "antenna with no gain",
+                          PointerValue(),
+                          MakePointerAccessor(&LoraPhy::m_antenna),
+                          MakePointerChecker<AntennaModel>())
             .AddTraceSource("StartSending",
                             "Trace source indicating the PHY layer"
                             "has begun the sending process for a packet",
@@ -98,6 +105,12 @@ LoraPhy::SetDevice(Ptr<NetDevice> device)
     m_device = device;
 }
 
+LoraInterferenceHelper&
+LoraPhy::GetInterferenceHelper()
+{
+    return m_interference;
+}
+
 Ptr<LoraChannel>
 LoraPhy::GetChannel() const
 {
@@ -131,6 +144,20 @@ LoraPhy::SetMobility(Ptr<MobilityModel> mobility)
     m_mobility = mobility;
 }
 
+Ptr<AntennaModel>
+LoraPhy::GetAntenna() const
+{
+    return m_antenna;
+}
+
+void
+LoraPhy::SetAntenna(Ptr<AntennaModel> antenna)
+{
+    NS_LOG_FUNCTION(this << antenna);
+
+    m_antenna = antenna;
+}
+
 void
 LoraPhy::SetChannel(Ptr<LoraChannel> channel)
 {
@@ -23,6 +23,7 @@
 #include "lora-channel.h"
 #include "lora-interference-helper.h"
 
+#include "ns3/antenna-model.h"
 #include "ns3/callback.h"
 #include "ns3/mobility-model.h"
 #include "ns3/net-device.h"
@@ -207,6 +208,27 @@ class LoraPhy : public Object
      */
     void SetMobility(Ptr<MobilityModel> mobility);
 
+    /**
+     * Get the antenna model of this PHY.
+     *
+     * \return The AntennaModel of this PHY, or nullptr if the antenna is
+     * isotropic with no gain.
+     */
+    Ptr<AntennaModel> GetAntenna() const;
+
+    /**
+     * Set the antenna model of this PHY.
+     *
+     * The gain of the antenna in the direction of the other end of a link is
+     * added to the received power by the LoraChannel, and cached with the link
+     * budget. Hence, the attributes of an antenna should not change while it's
+     * in use.
+     *
+     * \param antenna The antenna model, or nullptr for an isotropic antenna
+     * with no gain.
+     */
+    void SetAntenna(Ptr<AntennaModel> antenna);
+
     /**
      * Set the LoraChannel instance PHY transmits on.
      *
@@ -237,6 +259,17 @@ class LoraPhy : public Object
      */
     void SetDevice(Ptr<NetDevice> device);
 
+    /**
+     * Get the LoraInterferenceHelper this PHY uses to keep track of
+     * interfering signals.
+     *
+     * This can be used to configure the attributes of the helper of a single
+     * PHY.
+     *
+     * \return The LoraInterferenceHelper associated to this PHY.
+     */
+    LoraInterferenceHelper& GetInterferenceHelper();
+
     /**
      * Compute the symbol time from SF and BW.
      *
@@ -262,6 +295,8 @@ class LoraPhy : public Object
   private:
     Ptr<MobilityModel> m_mobility; //!< The mobility model associated to this PHY.
 
+    Ptr<AntennaModel> m_antenna; //!< The antenna model of this PHY.
+
   protected:
     // Member objects
 
@@ -0,0 +1,231 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "lora-remote-transmission-header.h"
+
+#include "ns3/log.h"
+
+#include <cstring>
+
+namespace ns3
+{
+namespace lorawan
+{
+
+NS_LOG_COMPONENT_DEFINE("LoraRemoteTransmissionHeader");
+
+namespace
+{
+
+/**
+ * Write a double to a buffer, bit by bit.
+ *
+ * \param i The buffer iterator.
+ * \param value The value.
+ */
+void
+WriteDouble(Buffer::Iterator& i, double value)
+{
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    i.WriteHtonU64(bits);
+}
+
+/**
+ * Read a double written by WriteDouble.
+ *
+ * \param i The buffer iterator.
+ * \return The value.
+ */
+double
+ReadDouble(Buffer::Iterator& i)
+{
+    uint64_t bits = i.ReadNtohU64();
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+} // namespace
+
+LoraRemoteTransmissionHeader::LoraRemoteTransmissionHeader()
+    : m_sender(0),
+      m_txPowerDbm(0),
+      m_sf(0),
+      m_frequencyMHz(0),
+      m_packetUid(0)
+{
+}
+
+LoraRemoteTransmissionHeader::~LoraRemoteTransmissionHeader()
+{
+}
+
+TypeId
+LoraRemoteTransmissionHeader::GetTypeId()
+{
+    static TypeId tid = TypeId("LoraRemoteTransmissionHeader")
+                            .SetParent<Header>()
+                            .AddConstructor<LoraRemoteTransmissionHeader>();
+    return tid;
+}
+
+TypeId
+LoraRemoteTransmissionHeader::GetInstanceTypeId() const
+{
+    return GetTypeId();
+}
+
+uint32_t
+LoraRemoteTransmissionHeader::GetSerializedSize() const
+{
+    NS_LOG_FUNCTION_NOARGS();
+
+    // Sender, three coordinates, power, SF, frequency, duration and packet uid
+    return 4 + 3 * 8 + 8 + 1 + 8 + 8 + 8;
+}
+
+void
+LoraRemoteTransmissionHeader::Serialize(Buffer::Iterator start) const
+{
+    NS_LOG_FUNCTION_NOARGS();
+
+    start.WriteHtonU32(m_sender);
+    WriteDouble(start, m_position.x);
+    WriteDouble(start, m_position.y);
+    WriteDouble(start, m_position.z);
+    WriteDouble(start, m_txPowerDbm);
+    start.WriteU8(m_sf);
+    WriteDouble(start, m_frequencyMHz);
+    start.WriteHtonU64(m_duration.GetTimeStep());
+    start.WriteHtonU64(m_packetUid);
+}
+
+uint32_t
+LoraRemoteTransmissionHeader::Deserialize(Buffer::Iterator start)
+{
+    NS_LOG_FUNCTION_NOARGS();
+
+    m_sender = start.ReadNtohU32();
+    m_position.x = ReadDouble(start);
+    m_position.y = ReadDouble(start);
+    m_position.z = ReadDouble(start);
+    m_txPowerDbm = ReadDouble(start);
+    m_sf = start.ReadU8();
+    m_frequencyMHz = ReadDouble(start);
+    m_duration = TimeStep(start.ReadNtohU64());
+    m_packetUid = start.ReadNtohU64();
+
+    return GetSerializedSize();
+}
+
+void
+LoraRemoteTransmissionHeader::Print(std::ostream& os) const
+{
+    os << "Sender=" << m_sender << std::endl;
+    os << "Position=" << m_position << std::endl;
+    os << "TxPower=" << m_txPowerDbm << std::endl;
+    os << "SF=" << unsigned(m_sf) << std::endl;
+    os << "Frequency=" << m_frequencyMHz << std::endl;
+    os << "Duration=" << m_duration << std::endl;
+    os << "PacketUid=" << m_packetUid << std::endl;
+}
+
+void
+LoraRemoteTransmissionHeader::SetSender(uint32_t sender)
+{
+    m_sender = sender;
+}
+
+uint32_t
+LoraRemoteTransmissionHeader::GetSender() const
+{
+    return m_sender;
+}
+
+void
+LoraRemoteTransmissionHeader::SetPosition(const Vector& position)
+{
+    m_position = position;
+}
+
+Vector
+LoraRemoteTransmissionHeader::GetPosition() const
+{
+    return m_position;
+}
+
+void
+LoraRemoteTransmissionHeader::SetTxPower(double txPowerDbm)
+{
+    m_txPowerDbm = txPowerDbm;
+}
+
+double
+LoraRemoteTransmissionHeader::GetTxPower() const
+{
+    return m_txPowerDbm;
+}
+
+void
+LoraRemoteTransmissionHeader::SetSpreadingFactor(uint8_t sf)
+{
+    m_sf = sf;
+}
+
+uint8_t
+LoraRemoteTransmissionHeader::GetSpreadingFactor() const
+{
+    return m_sf;
+}
+
+void
+LoraRemoteTransmissionHeader::SetFrequency(double frequencyMHz)
+{
+    m_frequencyMHz = frequencyMHz;
+}
+
+double
+LoraRemoteTransmissionHeader::GetFrequency() const
+{
+    return m_frequencyMHz;
+}
+
+void
+LoraRemoteTransmissionHeader::SetDuration(Time duration)
+{
+    m_duration = duration;
+}
+
+Time
+LoraRemoteTransmissionHeader::GetDuration() const
+{
+    return m_duration;
+}
+
+void
+LoraRemoteTransmissionHeader::SetPacketUid(uint64_t packetUid)
+{
+    m_packetUid = packetUid;
+}
+
+uint64_t
+LoraRemoteTransmissionHeader::GetPacketUid() const
+{
+    return m_packetUid;
+}
+
+} // namespace lorawan
+} // namespace ns3
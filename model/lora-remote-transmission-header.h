@@ -0,0 +1,163 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef LORA_REMOTE_TRANSMISSION_HEADER_H
+#define LORA_REMOTE_TRANSMISSION_HEADER_H
+
+#include "ns3/header.h"
+#include "ns3/nstime.h"
+#include "ns3/vector.h"
+
+namespace ns3
+{
+namespace lorawan
+{
+
+/**
+ * This class represents the description of a transmission that a LoraChannel
+ * sends to the other ranks of a distributed simulation, on top of the
+ * transmitted packet.
+ *
+ * It only contains what remote ranks need to compute the reception
+ * parameters at their own PHYs: which PHY is sending and from where, and the
+ * power, spreading factor, frequency and duration of the transmission.
+ */
+class LoraRemoteTransmissionHeader : public Header
+{
+  public:
+    static TypeId GetTypeId();
+
+    LoraRemoteTransmissionHeader();
+    ~LoraRemoteTransmissionHeader() override;
+
+    // Pure virtual methods from Header that need to be implemented by this class
+    TypeId GetInstanceTypeId() const override;
+    uint32_t GetSerializedSize() const override;
+    void Serialize(Buffer::Iterator start) const override;
+    uint32_t Deserialize(Buffer::Iterator start) override;
+    void Print(std::ostream& os) const override;
+
+    /**
+     * Set the index of the sending PHY in the LoraChannel.
+     *
+     * \param sender The index of the PHY.
+     */
+    void SetSender(uint32_t sender);
+
+    /**
+     * Get the index of the sending PHY in the LoraChannel.
+     *
+     * \return The index of the PHY.
+     */
+    uint32_t GetSender() const;
+
+    /**
+     * Set the position of the sender at the start of the transmission.
+     *
+     * \param position The position.
+     */
+    void SetPosition(const Vector& position);
+
+    /**
+     * Get the position of the sender at the start of the transmission.
+     *
+     * \return The position.
+     */
+    Vector GetPosition() const;
+
+    /**
+     * Set the transmission power.
+     *
+     * \param txPowerDbm The power, in dBm.
+     */
+    void SetTxPower(double txPowerDbm);
+
+    /**
+     * Get the transmission power.
+     *
+     * \return The power, in dBm.
+     */
+    double GetTxPower() const;
+
+    /**
+     * Set the spreading factor of the transmission.
+     *
+     * \param sf The spreading factor.
+     */
+    void SetSpreadingFactor(uint8_t sf);
+
+    /**
+     * Get the spreading factor of the transmission.
+     *
+     * \return The spreading factor.
+     */
+    uint8_t GetSpreadingFactor() const;
+
+    /**
+     * Set the frequency of the transmission.
+     *
+     * \param frequencyMHz The frequency, in MHz.
+     */
+    void SetFrequency(double frequencyMHz);
+
+    /**
+     * Get the frequency of the transmission.
+     *
+     * \return The frequency, in MHz.
+     */
+    double GetFrequency() const;
+
+    /**
+     * Set the on-air duration of the transmission.
+     *
+     * \param duration The duration.
+     */
+    void SetDuration(Time duration);
+
+    /**
+     * Get the on-air duration of the transmission.
+     *
+     * \return The duration.
+     */
+    Time GetDuration() const;
+
+    /**
+     * Set the uid of the packet on the sender's system.
+     *
+     * \param packetUid The uid.
+     */
+    void SetPacketUid(uint64_t packetUid);
+
+    /**
+     * Get the uid of the packet on the sender's system.
+     *
+     * \return The uid.
+     */
+    uint64_t GetPacketUid() const;
+
+  private:
+    uint32_t m_sender;     //!< The index of the sending PHY.
+    Vector m_position;     //!< The position of the sender.
+    double m_txPowerDbm;   //!< The transmission power, in dBm.
+    uint8_t m_sf;          //!< The spreading factor.
+    double m_frequencyMHz; //!< The frequency, in MHz.
+    Time m_duration;       //!< The on-air duration.
+    uint64_t m_packetUid;  //!< The uid of the packet on the sender's system.
+};
+
+} // namespace lorawan
+
+} // namespace ns3
+#endif /* LORA_REMOTE_TRANSMISSION_HEADER_H */
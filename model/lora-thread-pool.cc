@@ -0,0 +1,124 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "lora-thread-pool.h"
+
+#include "ns3/log.h"
+
+#include <algorithm>
+
+namespace ns3
+{
+namespace lorawan
+{
+
+NS_LOG_COMPONENT_DEFINE("LoraThreadPool");
+
+LoraThreadPool::LoraThreadPool(uint32_t nThreads)
+    : m_nThreads(std::max<uint32_t>(nThreads, 1)),
+      m_generation(0),
+      m_pending(0),
+      m_stop(false),
+      m_n(0),
+      m_task(nullptr)
+{
+    NS_LOG_FUNCTION(this << nThreads);
+
+    for (uint32_t worker = 1; worker < m_nThreads; worker++)
+    {
+        m_workers.emplace_back(&LoraThreadPool::Work, this, worker);
+    }
+}
+
+LoraThreadPool::~LoraThreadPool()
+{
+    NS_LOG_FUNCTION(this);
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_start.notify_all();
+
+    for (auto& worker : m_workers)
+    {
+        worker.join();
+    }
+}
+
+uint32_t
+LoraThreadPool::GetNThreads() const
+{
+    return m_nThreads;
+}
+
+void
+LoraThreadPool::ParallelFor(std::size_t n,
+                            const std::function<void(std::size_t, std::size_t)>& task)
+{
+    // Waking up the workers is not worth it for small loops
+    if (m_nThreads == 1 || n < m_nThreads)
+    {
+        task(0, n);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_task = &task;
+        m_n = n;
+        m_pending = m_nThreads - 1;
+        m_generation++;
+    }
+    m_start.notify_all();
+
+    // The calling thread processes the first chunk
+    task(0, n / m_nThreads);
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done.wait(lock, [this] { return m_pending == 0; });
+    m_task = nullptr;
+}
+
+void
+LoraThreadPool::Work(uint32_t worker)
+{
+    uint64_t generation = 0;
+
+    while (true)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_start.wait(lock, [&] { return m_stop || m_generation != generation; });
+        if (m_stop)
+        {
+            return;
+        }
+        generation = m_generation;
+        const auto& task = *m_task;
+        std::size_t n = m_n;
+        lock.unlock();
+
+        task(n * worker / m_nThreads, n * (worker + 1) / m_nThreads);
+
+        lock.lock();
+        if (--m_pending == 0)
+        {
+            m_done.notify_one();
+        }
+    }
+}
+
+} // namespace lorawan
+} // namespace ns3
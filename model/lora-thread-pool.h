@@ -0,0 +1,98 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef LORA_THREAD_POOL_H
+#define LORA_THREAD_POOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ns3
+{
+namespace lorawan
+{
+
+/**
+ * A fixed set of worker threads that split loops over arrays.
+ *
+ * The calling thread takes part in the computation, so a pool of N threads
+ * only starts N - 1 workers. Tasks must not touch simulator state or
+ * reference counted objects, since neither is thread safe: they are meant to
+ * work on plain arrays prepared by the calling thread.
+ */
+class LoraThreadPool
+{
+  public:
+    /**
+     * Start the worker threads.
+     *
+     * \param nThreads The number of threads that run each loop, including
+     * the calling one.
+     */
+    LoraThreadPool(uint32_t nThreads);
+
+    /**
+     * Stop and join the worker threads.
+     */
+    ~LoraThreadPool();
+
+    LoraThreadPool(const LoraThreadPool&) = delete;
+    LoraThreadPool& operator=(const LoraThreadPool&) = delete;
+
+    /**
+     * Get the number of threads that run each loop.
+     *
+     * \return The number of threads, including the calling one.
+     */
+    uint32_t GetNThreads() const;
+
+    /**
+     * Run a loop over n elements, split in contiguous chunks among the
+     * threads, and wait for all chunks to be done.
+     *
+     * \param n The number of elements.
+     * \param task The function processing the elements in [begin, end).
+     */
+    void ParallelFor(std::size_t n, const std::function<void(std::size_t, std::size_t)>& task);
+
+  private:
+    /**
+     * The loop run by each worker thread.
+     *
+     * \param worker The index of the worker, starting from 1.
+     */
+    void Work(uint32_t worker);
+
+    uint32_t m_nThreads;                //!< The number of threads, including the caller.
+    std::vector<std::thread> m_workers; //!< The worker threads.
+    std::mutex m_mutex;                 //!< Protects the members below.
+    std::condition_variable m_start;    //!< Signals a new loop, or the stop.
+    std::condition_variable m_done;     //!< Signals the end of the last chunk.
+    uint64_t m_generation;              //!< The number of loops started so far.
+    uint32_t m_pending;                 //!< The number of chunks still running.
+    bool m_stop;                        //!< Whether workers should exit.
+    std::size_t m_n;                    //!< The size of the current loop.
+    const std::function<void(std::size_t, std::size_t)>* m_task; //!< The current task.
+};
+
+} // namespace lorawan
+} // namespace ns3
+
+#endif /* LORA_THREAD_POOL_H */
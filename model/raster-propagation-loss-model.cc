@@ -0,0 +1,411 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "raster-propagation-loss-model.h"
+
+#include "ns3/log.h"
+#include "ns3/string.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+#ifndef __WIN32__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace ns3
+{
+namespace lorawan
+{
+
+NS_LOG_COMPONENT_DEFINE("RasterPropagationLossModel");
+
+NS_OBJECT_ENSURE_REGISTERED(RasterPropagationLossModel);
+
+namespace
+{
+
+/**
+ * The string identifying raster files.
+ */
+const char RASTER_MAGIC[8] = {'L', 'O', 'R', 'A', 'R', 'A', 'S', 'T'};
+
+/**
+ * The version of the raster file format.
+ */
+const uint32_t RASTER_VERSION = 1;
+
+/**
+ * The offset of the samples in a raster file, so that they are aligned to
+ * pages. The header is at the beginning of the file, and contains the
+ * following fields, in the byte order of the machine:
+ *
+ *  offset  type      field
+ *       0  char[8]   magic string
+ *       8  uint32_t  version
+ *      12  uint32_t  width
+ *      16  uint32_t  height
+ *      20  uint32_t  tile size
+ *      24  double    origin x
+ *      32  double    origin y
+ *      40  double    resolution
+ *      48  uint32_t  whether there is an anchor
+ *      56  double    anchor x
+ *      64  double    anchor y
+ *      72  double    anchor z
+ *
+ * Samples are 32 bit floats. Tiles are stored row after row, and the samples
+ * of a tile are stored row after row too. Tiles at the edges are padded to
+ * the full tile size.
+ */
+const std::size_t RASTER_DATA_OFFSET = 4096;
+
+/**
+ * Copy a value to a buffer.
+ *
+ * \param buffer The buffer.
+ * \param offset The offset of the value in the buffer.
+ * \param value The value.
+ */
+template <typename T>
+void
+Put(std::vector<char>& buffer, std::size_t offset, T value)
+{
+    std::memcpy(buffer.data() + offset, &value, sizeof(T));
+}
+
+/**
+ * Copy a value from a buffer.
+ *
+ * \param buffer The buffer.
+ * \param offset The offset of the value in the buffer.
+ * \return The value.
+ */
+template <typename T>
+T
+Get(const char* buffer, std::size_t offset)
+{
+    T value;
+    std::memcpy(&value, buffer + offset, sizeof(T));
+    return value;
+}
+
+} // namespace
+
+TypeId
+RasterPropagationLossModel::GetTypeId()
+{
+    static TypeId tid =
+        TypeId("ns3::RasterPropagationLossModel")
+            .SetParent<PropagationLossModel>()
+            .SetGroupName("lorawan")
+            .AddConstructor<RasterPropagationLossModel>()
+            .AddAttribute("Filename",
+                          "The name of a raster file to use, in addition to those "
+                          "already added",
+                          StringValue(""),
+                          MakeStringAccessor(&RasterPropagationLossModel::AddRaster),
+                          MakeStringChecker());
+    return tid;
+}
+
+RasterPropagationLossModel::RasterPropagationLossModel()
+{
+    NS_LOG_FUNCTION(this);
+}
+
+RasterPropagationLossModel::~RasterPropagationLossModel()
+{
+    NS_LOG_FUNCTION(this);
+}
+
+void
+RasterPropagationLossModel::AddRaster(const std::string& filename)
+{
+    NS_LOG_FUNCTION(this << filename);
+
+    if (filename.empty())
+    {
+        return;
+    }
+
+    Ptr<Raster> raster = Create<Raster>(filename);
+    const RasterInfo& info = raster->GetInfo();
+    if (info.hasAnchor)
+    {
+        m_anchoredRasters[GetAnchorKey(std::floor(info.anchor.x), std::floor(info.anchor.y))]
+            .push_back(raster);
+    }
+    else
+    {
+        NS_ABORT_MSG_IF(m_raster, "Only one raster without anchor can be used");
+        m_raster = raster;
+    }
+}
+
+void
+RasterPropagationLossModel::WriteRaster(const std::string& filename,
+                                        const RasterInfo& info,
+                                        const std::function<double(double, double)>& loss)
+{
+    NS_LOG_FUNCTION(filename << info.width << info.height << info.tileSize);
+
+    NS_ABORT_MSG_IF(info.width == 0 || info.height == 0 || info.tileSize == 0,
+                    "Invalid raster size");
+
+    std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+    NS_ABORT_MSG_UNLESS(file, "Can't open " << filename);
+
+    std::vector<char> header(RASTER_DATA_OFFSET, 0);
+    std::memcpy(header.data(), RASTER_MAGIC, sizeof(RASTER_MAGIC));
+    Put<uint32_t>(header, 8, RASTER_VERSION);
+    Put<uint32_t>(header, 12, info.width);
+    Put<uint32_t>(header, 16, info.height);
+    Put<uint32_t>(header, 20, info.tileSize);
+    Put<double>(header, 24, info.originX);
+    Put<double>(header, 32, info.originY);
+    Put<double>(header, 40, info.resolution);
+    Put<uint32_t>(header, 48, info.hasAnchor);
+    Put<double>(header, 56, info.anchor.x);
+    Put<double>(header, 64, info.anchor.y);
+    Put<double>(header, 72, info.anchor.z);
+    file.write(header.data(), header.size());
+
+    uint32_t size = info.tileSize;
+    uint32_t tilesX = (info.width + size - 1) / size;
+    uint32_t tilesY = (info.height + size - 1) / size;
+    std::vector<float> tile(std::size_t(size) * size);
+    for (uint32_t ty = 0; ty < tilesY; ty++)
+    {
+        for (uint32_t tx = 0; tx < tilesX; tx++)
+        {
+            std::fill(tile.begin(), tile.end(), 0);
+            for (uint32_t j = ty * size; j < std::min((ty + 1) * size, info.height); j++)
+            {
+                for (uint32_t i = tx * size; i < std::min((tx + 1) * size, info.width); i++)
+                {
+                    tile[std::size_t(j - ty * size) * size + (i - tx * size)] =
+                        loss(info.originX + i * info.resolution,
+                             info.originY + j * info.resolution);
+                }
+            }
+            file.write(reinterpret_cast<const char*>(tile.data()), tile.size() * sizeof(float));
+        }
+        NS_LOG_DEBUG("Wrote row " << ty + 1 << " of " << tilesY << " tiles");
+    }
+
+    NS_ABORT_MSG_UNLESS(file, "Can't write " << filename);
+}
+
+double
+RasterPropagationLossModel::DoCalcRxPower(double txPowerDbm,
+                                          Ptr<MobilityModel> a,
+                                          Ptr<MobilityModel> b) const
+{
+    NS_LOG_FUNCTION(this << txPowerDbm << a << b);
+
+    Vector aPosition = a->GetPosition();
+    Vector bPosition = b->GetPosition();
+
+    // Look for a raster anchored at either end of the link, and look up the
+    // loss at the other end
+    if (!m_anchoredRasters.empty())
+    {
+        Ptr<Raster> anchored = FindAnchoredRaster(bPosition);
+        if (anchored)
+        {
+            return txPowerDbm - anchored->GetLoss(aPosition.x, aPosition.y);
+        }
+        anchored = FindAnchoredRaster(aPosition);
+        if (anchored)
+        {
+            return txPowerDbm - anchored->GetLoss(bPosition.x, bPosition.y);
+        }
+    }
+
+    NS_ABORT_MSG_UNLESS(m_raster,
+                        "No raster for the link between " << aPosition << " and " << bPosition);
+
+    return txPowerDbm - m_raster->GetLoss(bPosition.x, bPosition.y);
+}
+
+int64_t
+RasterPropagationLossModel::DoAssignStreams(int64_t stream)
+{
+    return 0;
+}
+
+Ptr<RasterPropagationLossModel::Raster>
+RasterPropagationLossModel::FindAnchoredRaster(const Vector& position) const
+{
+    // An anchor within 1 m is in one of the 9 cells around the position
+    int64_t x = std::floor(position.x);
+    int64_t y = std::floor(position.y);
+    Ptr<Raster> closest;
+    double closestDistance = 1;
+    for (int64_t i = x - 1; i <= x + 1; i++)
+    {
+        for (int64_t j = y - 1; j <= y + 1; j++)
+        {
+            auto it = m_anchoredRasters.find(GetAnchorKey(i, j));
+            if (it == m_anchoredRasters.end())
+            {
+                continue;
+            }
+            for (const auto& raster : it->second)
+            {
+                const Vector& anchor = raster->GetInfo().anchor;
+                double dx = position.x - anchor.x;
+                double dy = position.y - anchor.y;
+                double dz = position.z - anchor.z;
+                double distance = dx * dx + dy * dy + dz * dz;
+                if (distance <= closestDistance)
+                {
+                    closest = raster;
+                    closestDistance = distance;
+                }
+            }
+        }
+    }
+    return closest;
+}
+
+uint64_t
+RasterPropagationLossModel::GetAnchorKey(int64_t x, int64_t y)
+{
+    return (uint64_t(uint32_t(x)) << 32) | uint32_t(y);
+}
+
+/***************************
+ *  Raster implementation  *
+ ***************************/
+
+RasterPropagationLossModel::Raster::Raster(const std::string& filename)
+    : m_fd(-1),
+      m_mapping(nullptr),
+      m_size(0),
+      m_samples(nullptr)
+{
+    NS_LOG_FUNCTION(this << filename);
+
+#ifdef __WIN32__
+    // Without mmap, the whole file is read
+    std::ifstream file(filename, std::ios::binary);
+    NS_ABORT_MSG_UNLESS(file, "Can't open " << filename);
+    m_file.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    m_size = m_file.size();
+    NS_ABORT_MSG_IF(m_size < RASTER_DATA_OFFSET, filename << " is not a raster file");
+
+    const char* header = m_file.data();
+#else
+    m_fd = open(filename.c_str(), O_RDONLY);
+    NS_ABORT_MSG_IF(m_fd < 0, "Can't open " << filename);
+
+    struct stat status;
+    NS_ABORT_MSG_IF(fstat(m_fd, &status) != 0, "Can't get the size of " << filename);
+    m_size = status.st_size;
+    NS_ABORT_MSG_IF(m_size < RASTER_DATA_OFFSET, filename << " is not a raster file");
+
+    // Pages are only read when the corresponding tile is used
+    m_mapping = mmap(nullptr, m_size, PROT_READ, MAP_SHARED, m_fd, 0);
+    NS_ABORT_MSG_IF(m_mapping == MAP_FAILED, "Can't map " << filename);
+    madvise(m_mapping, m_size, MADV_RANDOM);
+
+    const char* header = static_cast<const char*>(m_mapping);
+#endif
+    NS_ABORT_MSG_IF(std::memcmp(header, RASTER_MAGIC, sizeof(RASTER_MAGIC)) != 0 ||
+                        Get<uint32_t>(header, 8) != RASTER_VERSION,
+                    filename << " is not a raster file");
+    m_info.width = Get<uint32_t>(header, 12);
+    m_info.height = Get<uint32_t>(header, 16);
+    m_info.tileSize = Get<uint32_t>(header, 20);
+    m_info.originX = Get<double>(header, 24);
+    m_info.originY = Get<double>(header, 32);
+    m_info.resolution = Get<double>(header, 40);
+    m_info.hasAnchor = Get<uint32_t>(header, 48);
+    m_info.anchor =
+        Vector(Get<double>(header, 56), Get<double>(header, 64), Get<double>(header, 72));
+
+    NS_ABORT_MSG_IF(m_info.width == 0 || m_info.height == 0 || m_info.tileSize == 0,
+                    filename << " is empty");
+    m_tilesX = (m_info.width + m_info.tileSize - 1) / m_info.tileSize;
+    uint32_t tilesY = (m_info.height + m_info.tileSize - 1) / m_info.tileSize;
+    std::size_t samples = std::size_t(m_tilesX) * tilesY * m_info.tileSize * m_info.tileSize;
+    NS_ABORT_MSG_IF(m_size < RASTER_DATA_OFFSET + samples * sizeof(float),
+                    filename << " is truncated");
+
+    m_samples = reinterpret_cast<const float*>(header + RASTER_DATA_OFFSET);
+
+    NS_LOG_INFO("Mapped a " << m_info.width << "x" << m_info.height << " raster from "
+                            << filename);
+}
+
+RasterPropagationLossModel::Raster::~Raster()
+{
+    NS_LOG_FUNCTION(this);
+
+#ifndef __WIN32__
+    if (m_mapping && m_mapping != MAP_FAILED)
+    {
+        munmap(m_mapping, m_size);
+    }
+    if (m_fd >= 0)
+    {
+        close(m_fd);
+    }
+#endif
+}
+
+const RasterPropagationLossModel::RasterInfo&
+RasterPropagationLossModel::Raster::GetInfo() const
+{
+    return m_info;
+}
+
+double
+RasterPropagationLossModel::Raster::GetLoss(double x, double y) const
+{
+    // Get the position in samples, clamped to the raster
+    double fx = std::clamp((x - m_info.originX) / m_info.resolution, 0.0, m_info.width - 1.0);
+    double fy = std::clamp((y - m_info.originY) / m_info.resolution, 0.0, m_info.height - 1.0);
+
+    uint32_t i0 = std::floor(fx);
+    uint32_t j0 = std::floor(fy);
+    uint32_t i1 = std::min(i0 + 1, m_info.width - 1);
+    uint32_t j1 = std::min(j0 + 1, m_info.height - 1);
+    double u = fx - i0;
+    double v = fy - j0;
+
+    return (1 - u) * (1 - v) * GetSample(i0, j0) + u * (1 - v) * GetSample(i1, j0) +
+           (1 - u) * v * GetSample(i0, j1) + u * v * GetSample(i1, j1);
+}
+
+double
+RasterPropagationLossModel::Raster::GetSample(uint32_t i, uint32_t j) const
+{
+    uint32_t size = m_info.tileSize;
+    std::size_t tile = std::size_t(j / size) * m_tilesX + i / size;
+    return m_samples[tile * size * size + std::size_t(j % size) * size + i % size];
+}
+
+} // namespace lorawan
+} // namespace ns3
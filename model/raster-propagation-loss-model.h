@@ -0,0 +1,194 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef RASTER_PROPAGATION_LOSS_MODEL_H
+#define RASTER_PROPAGATION_LOSS_MODEL_H
+
+#include "ns3/mobility-model.h"
+#include "ns3/propagation-loss-model.h"
+#include "ns3/vector.h"
+
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace ns3
+{
+class MobilityModel;
+
+namespace lorawan
+{
+
+/**
+ * A loss model reading precomputed losses from raster files.
+ *
+ * A raster is a grid of loss values (in dB) covering a rectangular region,
+ * with one sample every Resolution meters. Samples are stored in square tiles,
+ * so that the samples close to a position are close in the file too. On POSIX
+ * systems, files are memory-mapped, so that only the tiles that are actually
+ * used are read from disk, and a raster may be much larger than the available
+ * memory. Elsewhere (for example, with MinGW), files are read whole. The loss
+ * at a position is interpolated bilinearly between the 4 surrounding samples,
+ * while positions outside of the region take the value of the closest edge.
+ *
+ * A raster can have an anchor, typically the position of a gateway, in which
+ * case it contains the loss of the links between the anchor and each point of
+ * the region (see the generate-loss-raster example). It's then used for all
+ * links with an end within 1 m of the anchor, in both directions, and the
+ * closest anchor is used if there are several. A raster
+ * without anchor contains a loss that only depends on the position of the
+ * receiver, and is used for the links no anchored raster applies to.
+ *
+ * Raster files are written in the byte order of the machine that creates
+ * them.
+ */
+class RasterPropagationLossModel : public PropagationLossModel
+{
+  public:
+    /**
+     * The geometry of a raster.
+     */
+    struct RasterInfo
+    {
+        double originX = 0;      //!< The x coordinate of the first sample, in meters.
+        double originY = 0;      //!< The y coordinate of the first sample, in meters.
+        double resolution = 1;   //!< The distance between samples, in meters.
+        uint32_t width = 0;      //!< The number of samples along the x axis.
+        uint32_t height = 0;     //!< The number of samples along the y axis.
+        uint32_t tileSize = 256; //!< The number of samples on the side of a tile.
+        bool hasAnchor = false;  //!< Whether the raster has an anchor.
+        Vector anchor;           //!< The anchor, if any.
+    };
+
+    /**
+     * A memory-mapped raster file.
+     */
+    class Raster : public SimpleRefCount<Raster>
+    {
+      public:
+        /**
+         * Map a raster file.
+         *
+         * \param filename The name of the file.
+         */
+        Raster(const std::string& filename);
+
+        ~Raster();
+
+        /**
+         * Get the geometry of the raster.
+         *
+         * \return The geometry.
+         */
+        const RasterInfo& GetInfo() const;
+
+        /**
+         * Get the loss at a position, interpolating the surrounding samples.
+         *
+         * \param x The x coordinate of the position.
+         * \param y The y coordinate of the position.
+         * \return The loss, in dB.
+         */
+        double GetLoss(double x, double y) const;
+
+      private:
+        /**
+         * Get a sample of the raster.
+         *
+         * \param i The index of the sample along the x axis.
+         * \param j The index of the sample along the y axis.
+         * \return The sample.
+         */
+        double GetSample(uint32_t i, uint32_t j) const;
+
+        RasterInfo m_info;      //!< The geometry of the raster.
+        uint32_t m_tilesX;      //!< The number of tiles along the x axis.
+        int m_fd;                 //!< The file descriptor of the file.
+        void* m_mapping;          //!< The start of the mapping.
+        std::size_t m_size;       //!< The size of the mapping.
+        std::vector<char> m_file; //!< The file, where it can't be mapped.
+        const float* m_samples;   //!< The samples, tile after tile.
+    };
+
+    static TypeId GetTypeId();
+
+    RasterPropagationLossModel();
+
+    ~RasterPropagationLossModel() override;
+
+    /**
+     * Map a raster file and use it to compute losses.
+     *
+     * \param filename The name of the file.
+     */
+    void AddRaster(const std::string& filename);
+
+    /**
+     * Write a raster file.
+     *
+     * The loss function is called for each sample, one tile after the other,
+     * so that only a tile needs to be kept in memory.
+     *
+     * \param filename The name of the file.
+     * \param info The geometry of the raster.
+     * \param loss The function giving the loss (in dB) at each position.
+     */
+    static void WriteRaster(const std::string& filename,
+                            const RasterInfo& info,
+                            const std::function<double(double, double)>& loss);
+
+  private:
+    double DoCalcRxPower(double txPowerDbm,
+                         Ptr<MobilityModel> a,
+                         Ptr<MobilityModel> b) const override;
+
+    int64_t DoAssignStreams(int64_t stream) override;
+
+    /**
+     * Find the anchored raster that applies to a position, that is, the one
+     * with the closest anchor within 1 m of it.
+     *
+     * \param position The position.
+     * \return The raster, or nullptr if there is no anchor within 1 m.
+     */
+    Ptr<Raster> FindAnchoredRaster(const Vector& position) const;
+
+    /**
+     * Get the key of a cell of the 1 m grid indexing the anchors.
+     *
+     * \param x The x index of the cell, that is, the floor of x coordinates.
+     * \param y The y index of the cell, that is, the floor of y coordinates.
+     * \return The key.
+     */
+    static uint64_t GetAnchorKey(int64_t x, int64_t y);
+
+    /**
+     * The rasters with an anchor, keyed by the cell of the anchor (see
+     * GetAnchorKey), so that only the cells around a position need to be
+     * searched.
+     */
+    std::unordered_map<uint64_t, std::vector<Ptr<Raster>>> m_anchoredRasters;
+
+    /**
+     * The raster without anchor, if any.
+     */
+    Ptr<Raster> m_raster;
+};
+
+} // namespace lorawan
+
+} // namespace ns3
+#endif /* RASTER_PROPAGATION_LOSS_MODEL_H */
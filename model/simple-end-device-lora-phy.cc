@@ -131,10 +131,18 @@ SimpleEndDeviceLoraPhy::StartReceive(Ptr<Packet> packet,
     //
     // We need to do this regardless of our state or frequency, since these could
     // change (and making the interference relevant) while the interference is
-    // still incoming.
+    // still incoming. With the ReceiveWindows bookkeeping, signals that end
+    // before we can start a reception are skipped.
 
     Ptr<LoraInterferenceHelper::Event> event;
-    event = m_interference.Add(duration, rxPowerDbm, sf, packet, frequencyMHz);
+    if (IsInterferenceRelevant(duration))
+    {
+        event = m_interference.Add(duration, rxPowerDbm, sf, packet, frequencyMHz);
+    }
+    else
+    {
+        NS_LOG_INFO("Not recording a signal that ends before the next receive window");
+    }
 
     // Switch on the current PHY state
     switch (m_state)
@@ -238,6 +246,11 @@ SimpleEndDeviceLoraPhy::StartReceive(Ptr<Packet> packet,
             // Switch to RX state
             // EndReceive will handle the switch back to STANDBY state
             SwitchToRx();
+            event->SetPacket(packet);
+
+            // Keep track of the interference on this event while it's being
+            // received
+            m_interference.TrackEvent(event);
 
             // Schedule the end of the reception of the packet
             NS_LOG_INFO("Scheduling reception of a packet. End in " << duration.GetSeconds()
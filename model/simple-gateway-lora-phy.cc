@@ -19,8 +19,10 @@
 
 #include "simple-gateway-lora-phy.h"
 
+#include "lora-net-device.h"
 #include "lora-tag.h"
 
+#include "ns3/boolean.h"
 #include "ns3/log.h"
 #include "ns3/simulator.h"
 
@@ -40,15 +42,23 @@ NS_OBJECT_ENSURE_REGISTERED(SimpleGatewayLoraPhy);
 TypeId
 SimpleGatewayLoraPhy::GetTypeId()
 {
-    static TypeId tid = TypeId("ns3::SimpleGatewayLoraPhy")
-                            .SetParent<GatewayLoraPhy>()
-                            .SetGroupName("lorawan")
-                            .AddConstructor<SimpleGatewayLoraPhy>();
+    static TypeId tid =
+        TypeId("ns3::SimpleGatewayLoraPhy")
+            .SetParent<GatewayLoraPhy>()
+            .SetGroupName("lorawan")
+            .AddConstructor<SimpleGatewayLoraPhy>()
+            .AddAttribute("BatchEndReceive",
+                          "Whether to evaluate together the receptions that end at the "
+                          "same time, sharing the search for their interferers",
+                          BooleanValue(false),
+                          MakeBooleanAccessor(&SimpleGatewayLoraPhy::m_batchEndReceive),
+                          MakeBooleanChecker());
 
     return tid;
 }
 
 SimpleGatewayLoraPhy::SimpleGatewayLoraPhy()
+    : m_batchEndReceive(false)
 {
     NS_LOG_FUNCTION_NOARGS();
 }
@@ -71,32 +81,16 @@ SimpleGatewayLoraPhy::Send(Ptr<Packet> packet,
 
     NS_LOG_DEBUG("Duration of packet: " << duration << ", SF" << unsigned(txParams.sf));
 
-    // Interrupt all receive operations
-    std::list<Ptr<SimpleGatewayLoraPhy::ReceptionPath>>::iterator it;
-    for (it = m_receptionPaths.begin(); it != m_receptionPaths.end(); ++it)
+    // Interrupt all receive operations, on the other PHYs of the device too,
+    // since they share its radio
+    InterruptReceptions();
+    Ptr<LoraNetDevice> device = DynamicCast<LoraNetDevice>(m_device);
+    for (uint32_t i = 0; device && i < device->GetNPhys(); i++)
     {
-        Ptr<SimpleGatewayLoraPhy::ReceptionPath> currentPath = *it;
-
-        if (!currentPath->IsAvailable()) // Reception path is occupied
+        Ptr<GatewayLoraPhy> phy = DynamicCast<GatewayLoraPhy>(device->GetPhy(i));
+        if (phy && PeekPointer(phy) != this)
         {
-            // Call the callback for reception interrupted by transmission
-            // Fire the trace source
-            if (m_device)
-            {
-                m_noReceptionBecauseTransmitting(currentPath->GetEvent()->GetPacket(),
-                                                 m_device->GetNode()->GetId());
-            }
-            else
-            {
-                m_noReceptionBecauseTransmitting(currentPath->GetEvent()->GetPacket(), 0);
-            }
-
-            // Cancel the scheduled EndReceive call
-            Simulator::Cancel(currentPath->GetEndReceive());
-
-            // Free it
-            // This also resets all parameters like packet and endReceive call
-            currentPath->Free();
+            phy->StartDeviceTransmission(packet, duration);
         }
     }
 
@@ -151,62 +145,62 @@ SimpleGatewayLoraPhy::StartReceive(Ptr<Packet> packet,
         return;
     }
 
-    // Add the event to the LoraInterferenceHelper
+    // Add the event to the LoraInterferenceHelper, unless it is too weak to
+    // matter. Pruned signals are below the sensitivity, so they are never
+    // locked on below.
     Ptr<LoraInterferenceHelper::Event> event;
-    event = m_interference.Add(duration, rxPowerDbm, sf, packet, frequencyMHz);
-
-    // Cycle over the receive paths to check availability to receive the packet
-    std::list<Ptr<SimpleGatewayLoraPhy::ReceptionPath>>::iterator it;
+    if (!PruneInterferer(rxPowerDbm, duration))
+    {
+        event = m_interference.Add(duration, rxPowerDbm, sf, packet, frequencyMHz);
+    }
 
-    for (it = m_receptionPaths.begin(); it != m_receptionPaths.end(); ++it)
+    // Check whether a receive path is available to receive the packet
+    if (CanLockReceptionPath(sf, frequencyMHz))
     {
-        Ptr<SimpleGatewayLoraPhy::ReceptionPath> currentPath = *it;
+        // See whether the reception power is above or below the sensitivity
+        // for that spreading factor
+        double sensitivity = SimpleGatewayLoraPhy::sensitivity[unsigned(sf) - 7];
 
-        // If the receive path is available and listening on the channel of
-        // interest, we have a candidate
-        if (currentPath->IsAvailable())
+        if (rxPowerDbm < sensitivity) // Packet arrived below sensitivity
         {
-            // See whether the reception power is above or below the sensitivity
-            // for that spreading factor
-            double sensitivity = SimpleGatewayLoraPhy::sensitivity[unsigned(sf) - 7];
+            NS_LOG_INFO("Dropping packet reception of packet with sf = "
+                        << unsigned(sf) << " because under the sensitivity of " << sensitivity
+                        << " dBm");
 
-            if (rxPowerDbm < sensitivity) // Packet arrived below sensitivity
+            if (m_device)
             {
-                NS_LOG_INFO("Dropping packet reception of packet with sf = "
-                            << unsigned(sf) << " because under the sensitivity of " << sensitivity
-                            << " dBm");
-
-                if (m_device)
-                {
-                    m_underSensitivity(packet, m_device->GetNode()->GetId());
-                }
-                else
-                {
-                    m_underSensitivity(packet, 0);
-                }
-
-                // Since the packet is below sensitivity, it makes no sense to
-                // search for another ReceivePath
-                return;
+                m_underSensitivity(packet, m_device->GetNode()->GetId());
             }
-            else // We have sufficient sensitivity to start receiving
+            else
             {
-                NS_LOG_INFO("Scheduling reception of a packet, "
-                            << "occupying one demodulator");
+                m_underSensitivity(packet, 0);
+            }
 
-                // Block this resource
-                currentPath->LockOnEvent(event);
-                m_occupiedReceptionPaths++;
+            // Since the packet is below sensitivity, it makes no sense to
+            // search for another ReceivePath
+            return;
+        }
+        else // We have sufficient sensitivity to start receiving
+        {
+            NS_LOG_INFO("Scheduling reception of a packet, "
+                        << "occupying one demodulator");
 
-                // Schedule the end of the reception of the packet
-                EventId endReceiveEventId =
-                    Simulator::Schedule(duration, &LoraPhy::EndReceive, this, packet, event);
+            // Block this resource
+            Ptr<SimpleGatewayLoraPhy::ReceptionPath> currentPath = LockReceptionPath(event);
+            event->SetPacket(packet);
 
-                currentPath->SetEndReceive(endReceiveEventId);
+            // Keep track of the interference on this event while it's
+            // being received
+            m_interference.TrackEvent(event);
 
-                // Make sure we don't go on searching for other ReceivePaths
-                return;
-            }
+            // Schedule the end of the reception of the packet
+            EventId endReceiveEventId =
+                Simulator::Schedule(duration, &LoraPhy::EndReceive, this, packet, event);
+
+            currentPath->SetEndReceive(endReceiveEventId);
+
+            // Make sure we don't go on searching for other ReceivePaths
+            return;
         }
     }
     // If we get to this point, there are no demodulators we can use
@@ -230,6 +224,21 @@ SimpleGatewayLoraPhy::EndReceive(Ptr<Packet> packet, Ptr<LoraInterferenceHelper:
 {
     NS_LOG_FUNCTION(this << packet << *event);
 
+    if (m_batchEndReceive)
+    {
+        // The demodulator is released right away, as it would be without
+        // batching, while the outcome is determined once all the receptions
+        // ending at this time have been collected.
+        ReleaseReceptionPath(event);
+
+        if (m_pendingEndReceives.empty())
+        {
+            Simulator::ScheduleNow(&SimpleGatewayLoraPhy::EndReceiveBatch, this);
+        }
+        m_pendingEndReceives.emplace_back(packet, event);
+        return;
+    }
+
     // Call the trace source
     m_phyRxEndTrace(packet);
 
@@ -239,6 +248,41 @@ SimpleGatewayLoraPhy::EndReceive(Ptr<Packet> packet, Ptr<LoraInterferenceHelper:
     uint8_t packetDestroyed = 0;
     packetDestroyed = m_interference.IsDestroyedByInterference(event);
 
+    ReportReceptionOutcome(packet, event, packetDestroyed);
+
+    ReleaseReceptionPath(event);
+}
+
+void
+SimpleGatewayLoraPhy::EndReceiveBatch()
+{
+    NS_LOG_FUNCTION(this << m_pendingEndReceives.size());
+
+    // Take the pending receptions, in case the callbacks lead to new ones
+    std::vector<std::pair<Ptr<Packet>, Ptr<LoraInterferenceHelper::Event>>> receptions;
+    receptions.swap(m_pendingEndReceives);
+
+    std::vector<Ptr<LoraInterferenceHelper::Event>> events;
+    events.reserve(receptions.size());
+    for (const auto& reception : receptions)
+    {
+        events.push_back(reception.second);
+    }
+    std::vector<uint8_t> outcomes = m_interference.IsDestroyedByInterference(events);
+
+    // Fire the trace sources in the order in which the receptions ended
+    for (std::size_t i = 0; i < receptions.size(); i++)
+    {
+        m_phyRxEndTrace(receptions[i].first);
+        ReportReceptionOutcome(receptions[i].first, receptions[i].second, outcomes[i]);
+    }
+}
+
+void
+SimpleGatewayLoraPhy::ReportReceptionOutcome(Ptr<Packet> packet,
+                                             Ptr<LoraInterferenceHelper::Event> event,
+                                             uint8_t packetDestroyed)
+{
     // Check whether the packet was destroyed
     if (packetDestroyed != uint8_t(0))
     {
@@ -293,22 +337,6 @@ SimpleGatewayLoraPhy::EndReceive(Ptr<Packet> packet, Ptr<LoraInterferenceHelper:
             m_rxOkCallback(packet);
         }
     }
-
-    // Search for the demodulator that was locked on this event to free it.
-
-    std::list<Ptr<SimpleGatewayLoraPhy::ReceptionPath>>::iterator it;
-
-    for (it = m_receptionPaths.begin(); it != m_receptionPaths.end(); ++it)
-    {
-        Ptr<SimpleGatewayLoraPhy::ReceptionPath> currentPath = *it;
-
-        if (currentPath->GetEvent() == event)
-        {
-            currentPath->Free();
-            m_occupiedReceptionPaths--;
-            return;
-        }
-    }
 }
 
 } // namespace lorawan
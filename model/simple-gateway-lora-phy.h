@@ -30,6 +30,7 @@
 #include "ns3/traced-value.h"
 
 #include <list>
+#include <vector>
 
 namespace ns3
 {
@@ -62,7 +63,37 @@ class SimpleGatewayLoraPhy : public GatewayLoraPhy
               double frequencyMHz,
               double txPowerDbm) override;
 
+  protected:
+    /**
+     * Fire the trace sources corresponding to the outcome of a reception, and
+     * forward the packet to the upper layer if it was received correctly.
+     *
+     * \param packet The received packet.
+     * \param event The event of the reception.
+     * \param packetDestroyed The sf of the packets that caused the loss, or 0
+     * if there was no loss.
+     */
+    virtual void ReportReceptionOutcome(Ptr<Packet> packet,
+                                        Ptr<LoraInterferenceHelper::Event> event,
+                                        uint8_t packetDestroyed);
+
   private:
+    /**
+     * Determine the outcome of all the receptions that ended at the current
+     * time, and fire the corresponding trace sources.
+     */
+    void EndReceiveBatch();
+
+    /**
+     * Whether to evaluate together the receptions that end at the same time.
+     */
+    bool m_batchEndReceive;
+
+    /**
+     * The receptions that ended at the current time and whose outcome still
+     * needs to be determined.
+     */
+    std::vector<std::pair<Ptr<Packet>, Ptr<LoraInterferenceHelper::Event>>> m_pendingEndReceives;
 };
 
 } // namespace lorawan
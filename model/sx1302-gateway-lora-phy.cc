@@ -0,0 +1,253 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "sx1302-gateway-lora-phy.h"
+
+#include "ns3/boolean.h"
+#include "ns3/log.h"
+#include "ns3/trace-source-accessor.h"
+#include "ns3/uinteger.h"
+
+namespace ns3
+{
+namespace lorawan
+{
+
+NS_LOG_COMPONENT_DEFINE("Sx1302GatewayLoraPhy");
+
+NS_OBJECT_ENSURE_REGISTERED(Sx1302GatewayLoraPhy);
+
+TypeId
+Sx1302GatewayLoraPhy::GetTypeId()
+{
+    static TypeId tid =
+        TypeId("ns3::Sx1302GatewayLoraPhy")
+            .SetParent<SimpleGatewayLoraPhy>()
+            .SetGroupName("lorawan")
+            .AddConstructor<Sx1302GatewayLoraPhy>()
+            .AddAttribute("Demodulators",
+                          "The number of multi-SF demodulators shared by all IF chains",
+                          UintegerValue(16),
+                          MakeUintegerAccessor(&Sx1302GatewayLoraPhy::m_demodulators),
+                          MakeUintegerChecker<uint32_t>(1))
+            .AddAttribute("IfChainDemodulators",
+                          "The maximum number of packets an IF chain added by "
+                          "AddFrequency can receive at the same time",
+                          UintegerValue(16),
+                          MakeUintegerAccessor(&Sx1302GatewayLoraPhy::m_ifChainDemodulators),
+                          MakeUintegerChecker<uint32_t>(1))
+            .AddAttribute("SfDemodulators",
+                          "The maximum number of packets of the same SF an IF chain "
+                          "can receive at the same time",
+                          UintegerValue(16),
+                          MakeUintegerAccessor(&Sx1302GatewayLoraPhy::m_sfDemodulators),
+                          MakeUintegerChecker<uint32_t>(1))
+            .AddAttribute("FineTimestamp",
+                          "Whether to report the arrival time of correctly received "
+                          "packets through the FineTimestamp trace source",
+                          BooleanValue(false),
+                          MakeBooleanAccessor(&Sx1302GatewayLoraPhy::m_fineTimestamp),
+                          MakeBooleanChecker())
+            .AddTraceSource("FineTimestamp",
+                            "Trace source reporting the arrival time of a correctly "
+                            "received packet",
+                            MakeTraceSourceAccessor(&Sx1302GatewayLoraPhy::m_fineTimestampTrace),
+                            "ns3::lorawan::Sx1302GatewayLoraPhy::FineTimestampTracedCallback")
+            .AddTraceSource("LostPacketBecauseWrongFrequency",
+                            "Trace source indicating a packet "
+                            "could not be correctly decoded because "
+                            "no IF chain listens on its frequency",
+                            MakeTraceSourceAccessor(&Sx1302GatewayLoraPhy::m_wrongFrequency),
+                            "ns3::Packet::TracedCallback");
+
+    return tid;
+}
+
+Sx1302GatewayLoraPhy::Sx1302GatewayLoraPhy()
+    : m_demodulators(16),
+      m_ifChainDemodulators(16),
+      m_sfDemodulators(16),
+      m_fineTimestamp(false)
+{
+    NS_LOG_FUNCTION_NOARGS();
+}
+
+Sx1302GatewayLoraPhy::~Sx1302GatewayLoraPhy()
+{
+    NS_LOG_FUNCTION_NOARGS();
+}
+
+void
+Sx1302GatewayLoraPhy::AddFrequency(double frequencyMHz)
+{
+    NS_LOG_FUNCTION(this << frequencyMHz);
+
+    // Helpers may add the same frequency more than once
+    if (GetIfChain(frequencyMHz) < 0)
+    {
+        AddIfChain(frequencyMHz, m_ifChainDemodulators);
+    }
+}
+
+void
+Sx1302GatewayLoraPhy::AddIfChain(double frequencyMHz, uint32_t demodulators)
+{
+    NS_LOG_FUNCTION(this << frequencyMHz << demodulators);
+
+    int32_t ifChain = GetIfChain(frequencyMHz);
+    if (ifChain >= 0)
+    {
+        m_ifChains[ifChain].demodulators = demodulators;
+        return;
+    }
+
+    GatewayLoraPhy::AddFrequency(frequencyMHz);
+    m_ifChainIndex[frequencyMHz] = m_ifChains.size();
+    m_ifChains.push_back({demodulators, 0, {0, 0, 0, 0, 0, 0}});
+}
+
+uint32_t
+Sx1302GatewayLoraPhy::GetOccupiedDemodulators(double frequencyMHz) const
+{
+    int32_t ifChain = GetIfChain(frequencyMHz);
+    return ifChain < 0 ? 0 : m_ifChains[ifChain].occupied;
+}
+
+int32_t
+Sx1302GatewayLoraPhy::GetIfChain(double frequencyMHz) const
+{
+    auto it = m_ifChainIndex.find(frequencyMHz);
+    return it == m_ifChainIndex.end() ? -1 : it->second;
+}
+
+void
+Sx1302GatewayLoraPhy::StartReceive(Ptr<Packet> packet,
+                                   double rxPowerDbm,
+                                   uint8_t sf,
+                                   Time duration,
+                                   double frequencyMHz)
+{
+    NS_LOG_FUNCTION(this << packet << rxPowerDbm << duration << frequencyMHz);
+
+    // Signals outside of the channels of the IF chains are filtered out, and
+    // can't interfere with the ones inside
+    if (GetIfChain(frequencyMHz) < 0)
+    {
+        NS_LOG_INFO("Packet lost because no IF chain listens on frequency " << frequencyMHz
+                                                                             << " MHz");
+
+        if (m_device)
+        {
+            m_wrongFrequency(packet, m_device->GetNode()->GetId());
+        }
+        else
+        {
+            m_wrongFrequency(packet, 0);
+        }
+        return;
+    }
+
+    SimpleGatewayLoraPhy::StartReceive(packet, rxPowerDbm, sf, duration, frequencyMHz);
+}
+
+bool
+Sx1302GatewayLoraPhy::CanLockReceptionPath(uint8_t sf, double frequencyMHz) const
+{
+    if (uint32_t(m_occupiedReceptionPaths) >= m_demodulators)
+    {
+        NS_LOG_DEBUG("All demodulators are occupied");
+        return false;
+    }
+
+    int32_t ifChain = GetIfChain(frequencyMHz);
+    if (ifChain < 0)
+    {
+        return false;
+    }
+
+    const IfChain& chain = m_ifChains[ifChain];
+    if (chain.occupied >= chain.demodulators)
+    {
+        NS_LOG_DEBUG("All demodulators of the IF chain on " << frequencyMHz
+                                                            << " MHz are occupied");
+        return false;
+    }
+    if (chain.occupiedPerSf[sf - 7] >= m_sfDemodulators)
+    {
+        NS_LOG_DEBUG("All SF" << unsigned(sf) << " demodulators of the IF chain on "
+                              << frequencyMHz << " MHz are occupied");
+        return false;
+    }
+
+    return true;
+}
+
+Ptr<GatewayLoraPhy::ReceptionPath>
+Sx1302GatewayLoraPhy::LockReceptionPath(Ptr<LoraInterferenceHelper::Event> event)
+{
+    NS_LOG_FUNCTION(this << event);
+
+    // The pool of demodulators is bounded by the Demodulators attribute, not
+    // by the paths configured by the helpers
+    if (m_freeReceptionPaths.empty())
+    {
+        AddReceptionPath();
+    }
+    m_pathIfChain.resize(m_receptionPaths.size());
+
+    Ptr<ReceptionPath> path = GatewayLoraPhy::LockReceptionPath(event);
+
+    uint32_t ifChain = GetIfChain(event->GetFrequency());
+    m_pathIfChain[event->GetReceptionPath()] = ifChain;
+    m_ifChains[ifChain].occupied++;
+    m_ifChains[ifChain].occupiedPerSf[event->GetSpreadingFactor() - 7]++;
+
+    return path;
+}
+
+bool
+Sx1302GatewayLoraPhy::ReleaseReceptionPath(Ptr<LoraInterferenceHelper::Event> event)
+{
+    NS_LOG_FUNCTION(this << event);
+
+    uint32_t index = event->GetReceptionPath();
+    if (!GatewayLoraPhy::ReleaseReceptionPath(event))
+    {
+        return false;
+    }
+
+    IfChain& chain = m_ifChains[m_pathIfChain[index]];
+    chain.occupied--;
+    chain.occupiedPerSf[event->GetSpreadingFactor() - 7]--;
+
+    return true;
+}
+
+void
+Sx1302GatewayLoraPhy::ReportReceptionOutcome(Ptr<Packet> packet,
+                                             Ptr<LoraInterferenceHelper::Event> event,
+                                             uint8_t packetDestroyed)
+{
+    // Report the timestamp before the packet is forwarded to the upper layer
+    if (m_fineTimestamp && packetDestroyed == uint8_t(0))
+    {
+        m_fineTimestampTrace(packet, event->GetStartTime());
+    }
+
+    SimpleGatewayLoraPhy::ReportReceptionOutcome(packet, event, packetDestroyed);
+}
+
+} // namespace lorawan
+} // namespace ns3
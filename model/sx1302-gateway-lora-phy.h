@@ -0,0 +1,160 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef SX1302_GATEWAY_LORA_PHY_H
+#define SX1302_GATEWAY_LORA_PHY_H
+
+#include "simple-gateway-lora-phy.h"
+
+#include "ns3/nstime.h"
+#include "ns3/traced-callback.h"
+
+#include <array>
+#include <unordered_map>
+#include <vector>
+
+namespace ns3
+{
+namespace lorawan
+{
+
+/**
+ * Class modeling a Lora SX1302/SX1303 chip.
+ *
+ * Differently from the SX1301, these chips have a pool of multi-SF
+ * demodulators that is shared by all the IF chains, each of which listens on
+ * one channel. The number of packets that can be received at the same time is
+ * limited by the size of the pool, by the budget of demodulators of each IF
+ * chain, and by the number of packets of the same SF each IF chain can
+ * receive. All limits are checked with counters, so admitting a packet takes
+ * constant time.
+ *
+ * Reception paths are added as needed up to the Demodulators attribute, so
+ * the number of paths configured by the helpers has no effect. Each frequency
+ * added with AddFrequency gets an IF chain with the budget given by the
+ * IfChainDemodulators attribute, unless it was added with AddIfChain.
+ * Packets on frequencies without an IF chain are not received.
+ *
+ * Optionally, the arrival time of correctly received packets is reported by
+ * the FineTimestamp trace source, as done by the fine timestamping feature
+ * of these chips.
+ */
+class Sx1302GatewayLoraPhy : public SimpleGatewayLoraPhy
+{
+  public:
+    static TypeId GetTypeId();
+
+    Sx1302GatewayLoraPhy();
+    ~Sx1302GatewayLoraPhy() override;
+
+    void StartReceive(Ptr<Packet> packet,
+                      double rxPowerDbm,
+                      uint8_t sf,
+                      Time duration,
+                      double frequencyMHz) override;
+
+    void AddFrequency(double frequencyMHz) override;
+
+    /**
+     * Add an IF chain listening on a frequency, or change the budget of the
+     * IF chain already listening on it.
+     *
+     * \param frequencyMHz The frequency of the IF chain.
+     * \param demodulators The maximum number of packets the IF chain can
+     * receive at the same time.
+     */
+    void AddIfChain(double frequencyMHz, uint32_t demodulators);
+
+    /**
+     * Get the number of packets being received on a frequency.
+     *
+     * \param frequencyMHz The frequency of the IF chain.
+     * \return The number of occupied demodulators of the IF chain, or 0 if
+     * there is no IF chain on the frequency.
+     */
+    uint32_t GetOccupiedDemodulators(double frequencyMHz) const;
+
+    /**
+     * TracedCallback signature for the fine timestamp of a packet.
+     *
+     * \param packet The correctly received packet.
+     * \param arrivalTime The time the packet started arriving at the gateway.
+     */
+    typedef void (*FineTimestampTracedCallback)(Ptr<const Packet> packet, Time arrivalTime);
+
+  protected:
+    bool CanLockReceptionPath(uint8_t sf, double frequencyMHz) const override;
+
+    Ptr<ReceptionPath> LockReceptionPath(Ptr<LoraInterferenceHelper::Event> event) override;
+
+    bool ReleaseReceptionPath(Ptr<LoraInterferenceHelper::Event> event) override;
+
+    void ReportReceptionOutcome(Ptr<Packet> packet,
+                                Ptr<LoraInterferenceHelper::Event> event,
+                                uint8_t packetDestroyed) override;
+
+  private:
+    /**
+     * The state of an IF chain.
+     */
+    struct IfChain
+    {
+        uint32_t demodulators;                 //!< The budget of demodulators
+        uint32_t occupied;                     //!< The number of occupied demodulators
+        std::array<uint32_t, 6> occupiedPerSf; //!< The occupied demodulators of each SF
+    };
+
+    /**
+     * Get the index of the IF chain listening on a frequency.
+     *
+     * \param frequencyMHz The frequency.
+     * \return The index in m_ifChains, or -1 if no IF chain listens on it.
+     */
+    int32_t GetIfChain(double frequencyMHz) const;
+
+    std::vector<IfChain> m_ifChains; //!< The IF chains
+
+    /**
+     * The index in m_ifChains of the IF chain of each frequency
+     */
+    std::unordered_map<double, uint32_t> m_ifChainIndex;
+
+    /**
+     * The IF chain each reception path is locked for, indexed like the paths
+     */
+    std::vector<uint32_t> m_pathIfChain;
+
+    uint32_t m_demodulators;        //!< The size of the shared pool of demodulators
+    uint32_t m_ifChainDemodulators; //!< The budget of IF chains added by AddFrequency
+    uint32_t m_sfDemodulators;      //!< The per-SF budget of each IF chain
+    bool m_fineTimestamp;           //!< Whether to report fine timestamps
+
+    /**
+     * Trace source fired with the arrival time of correctly received packets,
+     * when fine timestamps are enabled.
+     */
+    TracedCallback<Ptr<const Packet>, Time> m_fineTimestampTrace;
+
+    /**
+     * Trace source fired when a packet is not received because no IF chain
+     * listens on its frequency.
+     */
+    TracedCallback<Ptr<const Packet>, uint32_t> m_wrongFrequency;
+};
+
+} // namespace lorawan
+
+} // namespace ns3
+#endif /* SX1302_GATEWAY_LORA_PHY_H */
@@ -0,0 +1,227 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// Include headers of classes to test
+#include "ns3/log.h"
+#include "ns3/lora-interference-helper.h"
+#include "ns3/nstime.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/simulator.h"
+
+// An essential include is test.h
+#include "ns3/test.h"
+
+#include <algorithm>
+#include <chrono>
+
+using namespace ns3;
+using namespace lorawan;
+
+NS_LOG_COMPONENT_DEFINE("LoraInterferenceBenchmarkTestSuite");
+
+/*******************************
+ * InterferenceKernelBenchmark *
+ *******************************/
+
+/**
+ * Compare the time needed by LoraInterferenceHelper to determine the outcome
+ * of a set of receptions with the time needed by a loop that converts the
+ * power and the overlap of each interferer on the fly, as the helper used to
+ * do.
+ */
+class InterferenceKernelBenchmark : public TestCase
+{
+  public:
+    InterferenceKernelBenchmark();
+    ~InterferenceKernelBenchmark() override;
+
+  private:
+    void DoRun() override;
+
+    /**
+     * Add an event with random parameters to the helper.
+     */
+    void AddEvent();
+
+    /**
+     * Determine whether an event is destroyed by interference by converting
+     * the power and the overlap time of each candidate interferer.
+     *
+     * \param event The event for which to check the outcome.
+     * \return The sf of the packets that caused the loss, or 0 if there was no
+     * loss.
+     */
+    uint8_t ReferenceIsDestroyedByInterference(Ptr<LoraInterferenceHelper::Event> event);
+
+    LoraInterferenceHelper m_helper; //!< The helper under test
+    std::vector<Ptr<LoraInterferenceHelper::Event>> m_events; //!< Events, by start time
+    Time m_maxDuration; //!< The duration of the longest event
+    Ptr<UniformRandomVariable> m_rv; //!< Random variable for the event parameters
+};
+
+// Add some help text to this case to describe what it is intended to test
+InterferenceKernelBenchmark::InterferenceKernelBenchmark()
+    : TestCase("Measure the speedup of the interference energy computation")
+{
+}
+
+// Reminder that the test case should clean up after itself
+InterferenceKernelBenchmark::~InterferenceKernelBenchmark()
+{
+}
+
+void
+InterferenceKernelBenchmark::AddEvent()
+{
+    // Durations roughly span the time on air of LoRa packets from SF7 to SF12
+    auto sf = uint8_t(m_rv->GetInteger(7, 12));
+    Time duration = MilliSeconds(m_rv->GetInteger(40, 1500));
+    double rxPower = m_rv->GetValue(-130, -90);
+
+    m_events.push_back(m_helper.Add(duration, rxPower, sf, nullptr, 868.1));
+    m_maxDuration = std::max(m_maxDuration, duration);
+}
+
+uint8_t
+InterferenceKernelBenchmark::ReferenceIsDestroyedByInterference(
+    Ptr<LoraInterferenceHelper::Event> event)
+{
+    std::vector<double> cumulativeInterferenceEnergy(6, 0);
+
+    // Use the same candidate window as the helper, so that only the energy
+    // computation differs
+    auto first = std::lower_bound(
+        m_events.begin(),
+        m_events.end(),
+        event->GetStartTime() - m_maxDuration,
+        [](const Ptr<LoraInterferenceHelper::Event>& e, Time time) {
+            return e->GetStartTime() < time;
+        });
+    auto last = std::lower_bound(
+        first,
+        m_events.end(),
+        event->GetEndTime(),
+        [](const Ptr<LoraInterferenceHelper::Event>& e, Time time) {
+            return e->GetStartTime() < time;
+        });
+
+    for (auto it = first; it != last; ++it)
+    {
+        if (*it == event)
+        {
+            continue;
+        }
+        Time overlap = m_helper.GetOverlapTime(event, *it);
+        double interfererPowerW = pow(10, (*it)->GetRxPowerdBm() / 10) / 1000;
+        cumulativeInterferenceEnergy.at(unsigned((*it)->GetSpreadingFactor()) - 7) +=
+            overlap.GetSeconds() * interfererPowerW;
+    }
+
+    uint8_t sf = event->GetSpreadingFactor();
+    for (auto currentSf = uint8_t(7); currentSf <= uint8_t(12); currentSf++)
+    {
+        double signalPowerW = pow(10, event->GetRxPowerdBm() / 10) / 1000;
+        double signalEnergy = event->GetDuration().GetSeconds() * signalPowerW;
+        double snirIsolation =
+            LoraInterferenceHelper::collisionSnirGoursaud[sf - 7][currentSf - 7];
+        double snir =
+            10 * log10(signalEnergy / cumulativeInterferenceEnergy.at(unsigned(currentSf) - 7));
+        if (snir < snirIsolation)
+        {
+            return currentSf;
+        }
+    }
+    return uint8_t(0);
+}
+
+void
+InterferenceKernelBenchmark::DoRun()
+{
+    NS_LOG_DEBUG("InterferenceKernelBenchmark");
+
+    const int nEvents = 20000;
+    const int nRepetitions = 5;
+
+    m_rv = CreateObject<UniformRandomVariable>();
+    m_helper.SetAttribute("RetentionTime", TimeValue(Hours(1)));
+    m_maxDuration = Seconds(0);
+
+    // Generate one event every 10 ms on average, so that each reception
+    // overlaps with tens of interferers
+    Time startTime = Seconds(0);
+    for (int i = 0; i < nEvents; i++)
+    {
+        startTime += MicroSeconds(m_rv->GetInteger(0, 20000));
+        Simulator::Schedule(startTime, &InterferenceKernelBenchmark::AddEvent, this);
+    }
+    Simulator::Run();
+
+    // Evaluate the events of the second half, when the channel is loaded
+    std::vector<uint8_t> referenceOutcomes;
+    std::vector<uint8_t> outcomes;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < nRepetitions; r++)
+    {
+        referenceOutcomes.clear();
+        for (auto it = m_events.begin() + nEvents / 2; it != m_events.end(); ++it)
+        {
+            referenceOutcomes.push_back(ReferenceIsDestroyedByInterference(*it));
+        }
+    }
+    std::chrono::duration<double> referenceTime = std::chrono::steady_clock::now() - start;
+
+    start = std::chrono::steady_clock::now();
+    for (int r = 0; r < nRepetitions; r++)
+    {
+        outcomes.clear();
+        for (auto it = m_events.begin() + nEvents / 2; it != m_events.end(); ++it)
+        {
+            outcomes.push_back(m_helper.IsDestroyedByInterference(*it));
+        }
+    }
+    std::chrono::duration<double> kernelTime = std::chrono::steady_clock::now() - start;
+
+    NS_LOG_INFO("Interference check of " << outcomes.size() << " events: reference loop "
+                                         << referenceTime.count() << " s, kernel "
+                                         << kernelTime.count() << " s, speedup "
+                                         << referenceTime.count() / kernelTime.count() << "x");
+
+    NS_TEST_EXPECT_MSG_EQ((outcomes == referenceOutcomes),
+                          true,
+                          "The kernel and the reference loop gave different outcomes");
+
+    Simulator::Destroy();
+}
+
+/**************
+ * Test Suite *
+ **************/
+
+class LoraInterferenceBenchmarkTestSuite : public TestSuite
+{
+  public:
+    LoraInterferenceBenchmarkTestSuite();
+};
+
+LoraInterferenceBenchmarkTestSuite::LoraInterferenceBenchmarkTestSuite()
+    : TestSuite("lora-interference-benchmark", PERFORMANCE)
+{
+    LogComponentEnable("LoraInterferenceBenchmarkTestSuite", LOG_LEVEL_DEBUG);
+    AddTestCase(new InterferenceKernelBenchmark, TestCase::QUICK);
+}
+
+// Do not forget to allocate an instance of this TestSuite
+static LoraInterferenceBenchmarkTestSuite loraInterferenceBenchmarkTestSuite;
@@ -0,0 +1,158 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/example-as-test.h"
+
+// An essential include is test.h
+#include "ns3/test.h"
+
+#include <sstream>
+
+using namespace ns3;
+
+/**********************************
+ * DistributedNetworkExampleTest *
+ **********************************/
+
+/**
+ * Run distributed-network-example over a number of MPI processes, and
+ * compare the packet counts it prints to a reference output.
+ *
+ * The reference output is the same for any number of processes, including a
+ * sequential run: transmissions must reach the PHYs of other processes, and
+ * the packet trackers of all processes must be merged, exactly as in a
+ * sequential simulation.
+ */
+class DistributedNetworkExampleTest : public ExampleAsTestCase
+{
+  public:
+    /**
+     * Constructor.
+     *
+     * \param name The name of the test case, and of its reference output.
+     * \param program The example program.
+     * \param dataDir The directory of the reference output.
+     * \param ranks The number of MPI processes, or 1 for a sequential run.
+     * \param args The arguments of the example.
+     */
+    DistributedNetworkExampleTest(const std::string name,
+                                  const std::string program,
+                                  const std::string dataDir,
+                                  const uint32_t ranks,
+                                  const std::string args = "");
+
+    std::string GetCommandTemplate() const override;
+    std::string GetPostProcessingCommand() const override;
+
+  private:
+    uint32_t m_ranks; //!< The number of MPI processes
+};
+
+DistributedNetworkExampleTest::DistributedNetworkExampleTest(const std::string name,
+                                                             const std::string program,
+                                                             const std::string dataDir,
+                                                             const uint32_t ranks,
+                                                             const std::string args)
+    : ExampleAsTestCase(name, program, dataDir, args),
+      m_ranks(ranks)
+{
+}
+
+std::string
+DistributedNetworkExampleTest::GetCommandTemplate() const
+{
+    std::stringstream command;
+    if (m_ranks > 1)
+    {
+        command << "mpiexec -n " << m_ranks << " %s --distributed";
+    }
+    else
+    {
+        command << "%s";
+    }
+    command << " --test " << m_args;
+    return command.str();
+}
+
+std::string
+DistributedNetworkExampleTest::GetPostProcessingCommand() const
+{
+    // Only keep the packet counts, in an order that doesn't depend on the
+    // process printing them
+    return "| grep TEST | sort ";
+}
+
+/**************
+ * Test Suite *
+ **************/
+
+// This suite is only built when MPI and examples are enabled
+class LorawanDistributedTestSuite : public TestSuite
+{
+  public:
+    /**
+     * Constructor.
+     *
+     * \param name The name of the test suite, and of its reference output.
+     * \param program The example program.
+     * \param dataDir The directory of the reference output.
+     * \param ranks The number of MPI processes, or 1 for a sequential run.
+     * \param args The arguments of the example.
+     * \param duration The duration of the test case.
+     */
+    LorawanDistributedTestSuite(const std::string name,
+                                const std::string program,
+                                const std::string dataDir,
+                                const uint32_t ranks,
+                                const std::string args = "",
+                                const TestDuration duration = QUICK);
+};
+
+LorawanDistributedTestSuite::LorawanDistributedTestSuite(const std::string name,
+                                                         const std::string program,
+                                                         const std::string dataDir,
+                                                         const uint32_t ranks,
+                                                         const std::string args,
+                                                         const TestDuration duration)
+    : TestSuite(name, EXAMPLE)
+{
+    AddTestCase(new DistributedNetworkExampleTest(name, program, dataDir, ranks, args),
+                duration);
+}
+
+// A device per gateway, and gateways far enough apart that each one receives
+// the packets of its device and gets the others under sensitivity, whatever
+// the random draws. Each device sends two packets.
+static const std::string distributedExampleArgs =
+    "--nDevices=4 --nGateways=4 --gatewayDistance=50000 --clusterRadius=100 "
+    "--simulationTime=1200 --appPeriod=600";
+
+// Do not forget to allocate an instance of each TestSuite
+static LorawanDistributedTestSuite g_lorawanDistributed1("lorawan-distributed-example-1",
+                                                         "distributed-network-example",
+                                                         NS_TEST_SOURCEDIR,
+                                                         1,
+                                                         distributedExampleArgs);
+static LorawanDistributedTestSuite g_lorawanDistributed2("lorawan-distributed-example-2",
+                                                         "distributed-network-example",
+                                                         NS_TEST_SOURCEDIR,
+                                                         2,
+                                                         distributedExampleArgs);
+static LorawanDistributedTestSuite g_lorawanDistributed4("lorawan-distributed-example-4",
+                                                         "distributed-network-example",
+                                                         NS_TEST_SOURCEDIR,
+                                                         4,
+                                                         distributedExampleArgs,
+                                                         TestCase::EXTENSIVE);
@@ -1,16 +1,39 @@
 
 // Include headers of classes to test
+#include "ns3/boolean.h"
+#include "ns3/building-penetration-loss.h"
+#include "ns3/building.h"
+#include "ns3/buildings-helper.h"
 #include "ns3/constant-position-mobility-model.h"
+#include "ns3/correlated-shadowing-propagation-loss-model.h"
+#include "ns3/double.h"
+#include "ns3/enum.h"
+#include "ns3/gateway-lorawan-mac.h"
+#include "ns3/isotropic-antenna-model.h"
 #include "ns3/log.h"
 #include "ns3/lora-helper.h"
+#include "ns3/lora-remote-transmission-header.h"
+#include "ns3/lora-tag.h"
 #include "ns3/mobility-helper.h"
 #include "ns3/one-shot-sender-helper.h"
+#include "ns3/parabolic-antenna-model.h"
+#include "ns3/pointer.h"
+#include "ns3/raster-propagation-loss-model.h"
+#include "ns3/rng-seed-manager.h"
 #include "ns3/simple-end-device-lora-phy.h"
 #include "ns3/simple-gateway-lora-phy.h"
+#include "ns3/string.h"
+#include "ns3/sx1302-gateway-lora-phy.h"
+#include "ns3/uinteger.h"
 
 // An essential include is test.h
 #include "ns3/test.h"
 
+#include <iomanip>
+#include <limits>
+#include <map>
+#include <sstream>
+
 using namespace ns3;
 using namespace lorawan;
 
@@ -176,6 +199,210 @@ InterferenceTest::DoRun()
                           0,
                           "Packet did not survive interference as expected");
     interferenceHelper.ClearAllEvents();
+
+    // Events on all channels are reported as interferers
+    interferenceHelper.Add(Seconds(2), 14, 7, nullptr, frequency);
+    interferenceHelper.Add(Seconds(1), 14, 8, nullptr, differentFrequency);
+    interferenceHelper.Add(Seconds(2), 14, 9, nullptr, frequency);
+    NS_TEST_EXPECT_MSG_EQ(interferenceHelper.GetInterferers().size(),
+                          3,
+                          "Unexpected number of registered interferers");
+    interferenceHelper.ClearAllEvents();
+    NS_TEST_EXPECT_MSG_EQ(interferenceHelper.GetInterferers().size(),
+                          0,
+                          "Events were not cleared as expected");
+
+    // Events are removed once the retention time has elapsed
+    interferenceHelper.SetAttribute("RetentionTime", TimeValue(Seconds(5)));
+    interferenceHelper.Add(Seconds(2), 14, 7, nullptr, frequency);
+    Simulator::Schedule(Seconds(6), [&interferenceHelper, frequency]() {
+        interferenceHelper.Add(Seconds(2), 14, 7, nullptr, frequency);
+    });
+    Simulator::Schedule(Seconds(8), [&interferenceHelper, frequency]() {
+        interferenceHelper.Add(Seconds(2), 14, 7, nullptr, frequency);
+    });
+    Simulator::Stop(Seconds(7));
+    Simulator::Run();
+    NS_TEST_EXPECT_MSG_EQ(interferenceHelper.GetInterferers().size(),
+                          2,
+                          "Event was removed before the end of the retention time");
+    Simulator::Stop(Seconds(2));
+    Simulator::Run();
+    NS_TEST_EXPECT_MSG_EQ(interferenceHelper.GetInterferers().size(),
+                          2,
+                          "Event was not removed after the end of the retention time");
+    Simulator::Destroy();
+    interferenceHelper.ClearAllEvents();
+
+    // Events only keep their packet once a receiver locks on them
+    Ptr<Packet> packet = Create<Packet>(10);
+    event = interferenceHelper.Add(Seconds(2), 14, 7, packet, frequency);
+    NS_TEST_EXPECT_MSG_EQ((event->GetPacket() == nullptr),
+                          true,
+                          "Event kept a reference to its packet");
+    event->SetPacket(packet);
+    NS_TEST_EXPECT_MSG_EQ(event->GetPacket(), packet, "Event did not store its packet");
+    interferenceHelper.ClearAllEvents();
+
+    // Slots of destroyed events are recycled by the pool
+    Ptr<LoraInterferenceHelper::EventPool> pool = Create<LoraInterferenceHelper::EventPool>();
+    event = pool->Allocate(Seconds(2), 14, 7, frequency);
+    LoraInterferenceHelper::Event* slot = PeekPointer(event);
+    NS_TEST_EXPECT_MSG_EQ(pool->GetSize(), 1, "Unexpected number of events in the pool");
+    event = nullptr;
+    NS_TEST_EXPECT_MSG_EQ(pool->GetSize(), 0, "Event was not returned to the pool");
+    event = pool->Allocate(Seconds(1), 14, 8, frequency);
+    NS_TEST_EXPECT_MSG_EQ(PeekPointer(event), slot, "Slot was not recycled");
+    NS_TEST_EXPECT_MSG_EQ(event->GetDuration(), Seconds(1), "Recycled event was not initialized");
+
+    // Events remain valid after the pool is no longer referenced by its owner
+    pool = nullptr;
+    NS_TEST_EXPECT_MSG_EQ(unsigned(event->GetSpreadingFactor()),
+                          8,
+                          "Event was destroyed together with its pool");
+    event = nullptr;
+
+    // Under the ALOHA policy any overlap with the same SF destroys the packet,
+    // regardless of the power of the interferer
+    event = interferenceHelper.Add(Seconds(2), 14, 7, nullptr, frequency);
+    interferenceHelper.Add(Seconds(2), -100, 7, nullptr, frequency);
+    NS_TEST_EXPECT_MSG_EQ(
+        interferenceHelper.IsDestroyedByInterference<GoursaudInterferencePolicy>(event),
+        0,
+        "Packet was destroyed by a weak interferer");
+    NS_TEST_EXPECT_MSG_EQ(
+        interferenceHelper.IsDestroyedByInterference<AlohaInterferencePolicy>(event),
+        7,
+        "Packet survived an overlapping interferer under the ALOHA policy");
+    interferenceHelper.ClearAllEvents();
+
+    event = interferenceHelper.Add(Seconds(2), 14, 7, nullptr, frequency);
+    interferenceHelper.Add(Seconds(2), 14 + 30, 8, nullptr, frequency);
+    interferenceHelper.Add(Seconds(2), 14 + 30, 7, nullptr, differentFrequency);
+    NS_TEST_EXPECT_MSG_EQ(
+        interferenceHelper.IsDestroyedByInterference<AlohaInterferencePolicy>(event),
+        0,
+        "Packet was destroyed by an interferer with a different SF or frequency");
+    interferenceHelper.ClearAllEvents();
+
+    // The collision matrix selects the policy used by IsDestroyedByInterference
+    LoraInterferenceHelper::collisionMatrix = LoraInterferenceHelper::ALOHA;
+    LoraInterferenceHelper alohaHelper;
+    LoraInterferenceHelper::collisionMatrix = LoraInterferenceHelper::GOURSAUD;
+    event = alohaHelper.Add(Seconds(2), 14, 7, nullptr, frequency);
+    alohaHelper.Add(Seconds(2), -100, 7, nullptr, frequency);
+    NS_TEST_EXPECT_MSG_EQ(alohaHelper.IsDestroyedByInterference(event),
+                          7,
+                          "ALOHA collision matrix was not used");
+
+    // Evaluating several events at once gives the same outcomes as evaluating
+    // them one by one
+    std::vector<Ptr<LoraInterferenceHelper::Event>> events;
+    events.push_back(interferenceHelper.Add(Seconds(2), 14, 7, nullptr, frequency));
+    events.push_back(interferenceHelper.Add(Seconds(1), 14 - 6, 7, nullptr, frequency));
+    events.push_back(interferenceHelper.Add(Seconds(2), 14 + 17, 8, nullptr, frequency));
+    events.push_back(interferenceHelper.Add(Seconds(1), 14, 9, nullptr, differentFrequency));
+    events.push_back(interferenceHelper.Add(Seconds(3), 14 + 16, 8, nullptr, frequency));
+    std::vector<uint8_t> outcomes;
+    for (const auto& e : events)
+    {
+        outcomes.push_back(interferenceHelper.IsDestroyedByInterference(e));
+    }
+    NS_TEST_EXPECT_MSG_EQ((interferenceHelper.IsDestroyedByInterference(events) == outcomes),
+                          true,
+                          "Batch evaluation gave different outcomes");
+    interferenceHelper.ClearAllEvents();
+}
+
+/*******************************
+ * IncrementalInterferenceTest *
+ *******************************/
+
+class IncrementalInterferenceTest : public TestCase
+{
+  public:
+    IncrementalInterferenceTest();
+    ~IncrementalInterferenceTest() override;
+
+  private:
+    void DoRun() override;
+    uint8_t RunScenario(bool incremental, double interfererPowerDbm);
+};
+
+// Add some help text to this case to describe what it is intended to test
+IncrementalInterferenceTest::IncrementalInterferenceTest()
+    : TestCase("Verify that incremental interference accumulation matches the batch computation")
+{
+}
+
+// Reminder that the test case should clean up after itself
+IncrementalInterferenceTest::~IncrementalInterferenceTest()
+{
+}
+
+uint8_t
+IncrementalInterferenceTest::RunScenario(bool incremental, double interfererPowerDbm)
+{
+    LoraInterferenceHelper interferenceHelper;
+    interferenceHelper.SetAttribute("IncrementalInterference", BooleanValue(incremental));
+
+    double frequency = 868.1;
+    double differentFrequency = 868.3;
+
+    Ptr<LoraInterferenceHelper::Event> event;
+    uint8_t destroyedBy = 0;
+
+    // An interferer that is already on air when the reception starts
+    Simulator::Schedule(Seconds(0), [&, interfererPowerDbm]() {
+        interferenceHelper.Add(Seconds(2), interfererPowerDbm, 7, nullptr, frequency);
+    });
+    // The event we lock on
+    Simulator::Schedule(Seconds(1), [&]() {
+        event = interferenceHelper.Add(Seconds(2), 14, 7, nullptr, frequency);
+        interferenceHelper.TrackEvent(event);
+    });
+    // Interferers that arrive during the reception
+    Simulator::Schedule(Seconds(1.5), [&, interfererPowerDbm]() {
+        interferenceHelper.Add(Seconds(1), interfererPowerDbm + 20, 8, nullptr, frequency);
+    });
+    Simulator::Schedule(Seconds(2), [&, interfererPowerDbm]() {
+        interferenceHelper.Add(Seconds(2), interfererPowerDbm + 20, 7, nullptr, differentFrequency);
+    });
+    Simulator::Schedule(Seconds(2.5), [&, interfererPowerDbm]() {
+        interferenceHelper.Add(Seconds(1), interfererPowerDbm, 7, nullptr, frequency);
+    });
+    // End of the reception
+    Simulator::Schedule(Seconds(3), [&]() {
+        destroyedBy = interferenceHelper.IsDestroyedByInterference(event);
+    });
+
+    Simulator::Run();
+    Simulator::Destroy();
+
+    return destroyedBy;
+}
+
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+IncrementalInterferenceTest::DoRun()
+{
+    NS_LOG_DEBUG("IncrementalInterferenceTest");
+
+    // Sweep the interferer power across the survival threshold
+    for (double interfererPowerDbm = 0; interfererPowerDbm <= 12; interfererPowerDbm += 1)
+    {
+        NS_TEST_EXPECT_MSG_EQ(unsigned(RunScenario(true, interfererPowerDbm)),
+                              unsigned(RunScenario(false, interfererPowerDbm)),
+                              "Incremental and batch computations gave different outcomes");
+    }
+
+    NS_TEST_EXPECT_MSG_EQ(unsigned(RunScenario(true, 4)),
+                          0,
+                          "Packet did not survive interference as expected");
+    NS_TEST_EXPECT_MSG_EQ(unsigned(RunScenario(true, 12)),
+                          7,
+                          "Packet was not destroyed by interference as expected");
 }
 
 /***************
@@ -409,6 +636,44 @@ HeaderTest::DoRun()
     NS_TEST_EXPECT_MSG_EQ(linkCheckAns->GetGwCnt(),
                           1,
                           "Removed header's MAC command contents don't match");
+
+    /////////////////////////////////////////////////
+    // Test the LoraRemoteTransmissionHeader class //
+    /////////////////////////////////////////////////
+    LoraRemoteTransmissionHeader remoteHdr;
+    remoteHdr.SetSender(1234);
+    remoteHdr.SetPosition(Vector(-1500.25, 2e5, 15));
+    remoteHdr.SetTxPower(14.5);
+    remoteHdr.SetSpreadingFactor(11);
+    remoteHdr.SetFrequency(868.1);
+    remoteHdr.SetDuration(MicroSeconds(1318912));
+    remoteHdr.SetPacketUid(0x123456789a);
+
+    Ptr<Packet> remotePkt = Create<Packet>(10);
+    remotePkt->AddHeader(remoteHdr);
+
+    NS_TEST_EXPECT_MSG_EQ(remotePkt->GetSize(),
+                          10 + remoteHdr.GetSerializedSize(),
+                          "Wrong size of packet + remote transmission header");
+
+    LoraRemoteTransmissionHeader remoteHdr1;
+    remotePkt->RemoveHeader(remoteHdr1);
+
+    NS_TEST_EXPECT_MSG_EQ(remoteHdr1.GetSender(), 1234, "Removed header contents don't match");
+    NS_TEST_EXPECT_MSG_EQ((remoteHdr1.GetPosition() == Vector(-1500.25, 2e5, 15)),
+                          true,
+                          "Removed header contents don't match");
+    NS_TEST_EXPECT_MSG_EQ(remoteHdr1.GetTxPower(), 14.5, "Removed header contents don't match");
+    NS_TEST_EXPECT_MSG_EQ(unsigned(remoteHdr1.GetSpreadingFactor()),
+                          11,
+                          "Removed header contents don't match");
+    NS_TEST_EXPECT_MSG_EQ(remoteHdr1.GetFrequency(), 868.1, "Removed header contents don't match");
+    NS_TEST_EXPECT_MSG_EQ(remoteHdr1.GetDuration(),
+                          MicroSeconds(1318912),
+                          "Removed header contents don't match");
+    NS_TEST_EXPECT_MSG_EQ(remoteHdr1.GetPacketUid(),
+                          0x123456789a,
+                          "Removed header contents don't match");
 }
 
 /*******************
@@ -814,305 +1079,412 @@ ReceivePathTest::DoRun()
     // NS_TEST_EXPECT_MSG_EQ (m_maxOccupiedReceptionPaths, 1, "Unexpected value");
 }
 
-/**************************
- * LogicalLoraChannelTest *
- **************************/
+/*******************************
+ * ReceptionPathAllocationTest *
+ *******************************/
 
-class LogicalLoraChannelTest : public TestCase
+class ReceptionPathAllocationTest : public TestCase
 {
   public:
-    LogicalLoraChannelTest();
-    ~LogicalLoraChannelTest() override;
+    ReceptionPathAllocationTest();
+    ~ReceptionPathAllocationTest() override;
 
   private:
     void DoRun() override;
+    void OccupiedReceptionPaths(int oldValue, int newValue);
+    void NoMoreDemodulators(Ptr<const Packet> packet, uint32_t node);
+    void Transmitting(Ptr<const Packet> packet, uint32_t node);
+    void ReceivedPacket(Ptr<const Packet> packet, uint32_t node);
+    void StartReceive(Ptr<SimpleGatewayLoraPhy> gatewayPhy, uint8_t sf, Time duration);
+
+    int m_occupiedReceptionPaths = 0;
+    int m_maxOccupiedReceptionPaths = 0;
+    int m_noMoreDemodulatorsCalls = 0;
+    int m_transmittingCalls = 0;
+    int m_receivedPacketCalls = 0;
 };
 
 // Add some help text to this case to describe what it is intended to test
-LogicalLoraChannelTest::LogicalLoraChannelTest()
-    : TestCase("Verify that LogicalLoraChannel and LogicalLoraChannelHelper work as expected")
+ReceptionPathAllocationTest::ReceptionPathAllocationTest()
+    : TestCase("Verify that gateway reception paths are correctly allocated and released")
 {
 }
 
 // Reminder that the test case should clean up after itself
-LogicalLoraChannelTest::~LogicalLoraChannelTest()
+ReceptionPathAllocationTest::~ReceptionPathAllocationTest()
 {
 }
 
-// This method is the pure virtual method from class TestCase that every
-// TestCase must implement
 void
-LogicalLoraChannelTest::DoRun()
+ReceptionPathAllocationTest::OccupiedReceptionPaths(int oldValue, int newValue)
 {
-    NS_LOG_DEBUG("LogicalLoraChannelTest");
+    NS_LOG_FUNCTION(oldValue << newValue);
 
-    /////////////////////////////
-    // Test LogicalLoraChannel //
-    /////////////////////////////
+    m_occupiedReceptionPaths = newValue;
+    m_maxOccupiedReceptionPaths = std::max(m_maxOccupiedReceptionPaths, newValue);
+}
 
-    // Setup
-    Ptr<LogicalLoraChannel> channel1 = CreateObject<LogicalLoraChannel>(868);
-    Ptr<LogicalLoraChannel> channel2 = CreateObject<LogicalLoraChannel>(868);
-    Ptr<LogicalLoraChannel> channel3 = CreateObject<LogicalLoraChannel>(868.1);
-    Ptr<LogicalLoraChannel> channel4 = CreateObject<LogicalLoraChannel>(868.001);
+void
+ReceptionPathAllocationTest::NoMoreDemodulators(Ptr<const Packet> packet, uint32_t node)
+{
+    NS_LOG_FUNCTION(packet << node);
 
-    // Equality between channels
-    // Test the == and != operators
-    NS_TEST_EXPECT_MSG_EQ(channel1, channel2, "== operator doesn't work as expected");
-    NS_TEST_EXPECT_MSG_NE(channel1, channel3, "!= operator doesn't work as expected");
-    NS_TEST_EXPECT_MSG_NE(channel1, channel4, "!= operator doesn't work as expected");
+    m_noMoreDemodulatorsCalls++;
+}
 
-    //////////////////
-    // Test SubBand //
-    //////////////////
+void
+ReceptionPathAllocationTest::Transmitting(Ptr<const Packet> packet, uint32_t node)
+{
+    NS_LOG_FUNCTION(packet << node);
 
-    // Setup
-    SubBand subBand(868, 868.7, 0.01, 14);
-    Ptr<LogicalLoraChannel> channel5 = CreateObject<LogicalLoraChannel>(870);
+    m_transmittingCalls++;
+}
 
-    // Test BelongsToSubBand
-    NS_TEST_EXPECT_MSG_EQ(subBand.BelongsToSubBand(channel3),
-                          true,
-                          "BelongsToSubBand does not behave as expected");
-    NS_TEST_EXPECT_MSG_EQ(subBand.BelongsToSubBand(channel3->GetFrequency()),
-                          true,
-                          "BelongsToSubBand does not behave as expected");
-    NS_TEST_EXPECT_MSG_EQ(subBand.BelongsToSubBand(channel5),
-                          false,
-                          "BelongsToSubBand does not behave as expected");
+void
+ReceptionPathAllocationTest::ReceivedPacket(Ptr<const Packet> packet, uint32_t node)
+{
+    NS_LOG_FUNCTION(packet << node);
 
-    ///////////////////////////////////
-    // Test LogicalLoraChannelHelper //
-    ///////////////////////////////////
+    m_receivedPacketCalls++;
+}
 
-    // Setup
-    Ptr<LogicalLoraChannelHelper> channelHelper = CreateObject<LogicalLoraChannelHelper>();
-    SubBand subBand1(869, 869.4, 0.1, 27);
-    channel1 = CreateObject<LogicalLoraChannel>(868.1);
-    channel2 = CreateObject<LogicalLoraChannel>(868.3);
-    channel3 = CreateObject<LogicalLoraChannel>(868.5);
-    channel4 = CreateObject<LogicalLoraChannel>(869.1);
-    channel5 = CreateObject<LogicalLoraChannel>(869.3);
+void
+ReceptionPathAllocationTest::StartReceive(Ptr<SimpleGatewayLoraPhy> gatewayPhy,
+                                          uint8_t sf,
+                                          Time duration)
+{
+    gatewayPhy->StartReceive(Create<Packet>(10), -100, sf, duration, 868.1);
+}
 
-    // Channel diagram
-    //
-    // Channels      1      2      3                     4       5
-    // SubBands  868 ----- 0.1% ----- 868.7       869 ----- 1% ----- 869.4
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+ReceptionPathAllocationTest::DoRun()
+{
+    NS_LOG_DEBUG("ReceptionPathAllocationTest");
 
-    // Add SubBands and LogicalLoraChannels to the helper
-    channelHelper->AddSubBand(&subBand);
-    channelHelper->AddSubBand(&subBand1);
-    channelHelper->AddChannel(channel1);
-    channelHelper->AddChannel(channel2);
-    channelHelper->AddChannel(channel3);
-    channelHelper->AddChannel(channel4);
-    channelHelper->AddChannel(channel5);
+    Ptr<LoraChannel> channel =
+        CreateObject<LoraChannel>(CreateObject<LogDistancePropagationLossModel>(),
+                                  CreateObject<ConstantSpeedPropagationDelayModel>());
 
-    // Duty Cycle tests
-    // (high level duty cycle behavior)
-    ///////////////////////////////////
+    Ptr<SimpleGatewayLoraPhy> gatewayPhy = CreateObject<SimpleGatewayLoraPhy>();
+    Ptr<ConstantPositionMobilityModel> mobility = CreateObject<ConstantPositionMobilityModel>();
+    gatewayPhy->SetMobility(mobility);
+    gatewayPhy->AddFrequency(868.1);
+    for (int path = 0; path < 3; path++)
+    {
+        gatewayPhy->AddReceptionPath();
+    }
+    NS_TEST_EXPECT_MSG_EQ(gatewayPhy->GetNReceptionPaths(), 3, "Wrong number of paths");
+    channel->Add(gatewayPhy);
+    gatewayPhy->SetChannel(channel);
+
+    gatewayPhy->TraceConnectWithoutContext(
+        "OccupiedReceptionPaths",
+        MakeCallback(&ReceptionPathAllocationTest::OccupiedReceptionPaths, this));
+    gatewayPhy->TraceConnectWithoutContext(
+        "LostPacketBecauseNoMoreReceivers",
+        MakeCallback(&ReceptionPathAllocationTest::NoMoreDemodulators, this));
+    gatewayPhy->TraceConnectWithoutContext(
+        "NoReceptionBecauseTransmitting",
+        MakeCallback(&ReceptionPathAllocationTest::Transmitting, this));
+    gatewayPhy->TraceConnectWithoutContext(
+        "ReceivedPacket",
+        MakeCallback(&ReceptionPathAllocationTest::ReceivedPacket, this));
+
+    // Four overlapping receptions on three paths: the last one is dropped
+    for (uint8_t sf = 7; sf <= 10; sf++)
+    {
+        Simulator::Schedule(Seconds(1),
+                            &ReceptionPathAllocationTest::StartReceive,
+                            this,
+                            gatewayPhy,
+                            sf,
+                            Seconds(0.1));
+    }
 
-    channelHelper->AddEvent(Seconds(2), channel1);
-    Time expectedTimeOff = Seconds(2 / 0.01 - 2);
+    // Two receptions interrupted by a transmission of the gateway
+    for (uint8_t sf = 7; sf <= 8; sf++)
+    {
+        Simulator::Schedule(Seconds(3),
+                            &ReceptionPathAllocationTest::StartReceive,
+                            this,
+                            gatewayPhy,
+                            sf,
+                            Seconds(1));
+    }
+    LoraTxParameters txParams;
+    txParams.sf = 7;
+    Simulator::Schedule(Seconds(3.5),
+                        &SimpleGatewayLoraPhy::Send,
+                        gatewayPhy,
+                        Create<Packet>(10),
+                        txParams,
+                        868.1,
+                        14);
 
-    // Waiting time is computed correctly
-    NS_TEST_EXPECT_MSG_EQ(channelHelper->GetWaitingTime(channel1),
-                          expectedTimeOff,
-                          "Waiting time doesn't behave as expected");
+    // The interrupted paths can be used again
+    for (uint8_t sf = 7; sf <= 9; sf++)
+    {
+        Simulator::Schedule(Seconds(10),
+                            &ReceptionPathAllocationTest::StartReceive,
+                            this,
+                            gatewayPhy,
+                            sf,
+                            Seconds(0.1));
+    }
 
-    // Duty Cycle involves the whole SubBand, not just a channel
-    NS_TEST_EXPECT_MSG_EQ(channelHelper->GetWaitingTime(channel2),
-                          expectedTimeOff,
-                          "Waiting time doesn't behave as expected");
-    NS_TEST_EXPECT_MSG_EQ(channelHelper->GetWaitingTime(channel3),
-                          expectedTimeOff,
-                          "Waiting time doesn't behave as expected");
+    Simulator::Stop(Seconds(20));
+    Simulator::Run();
+    Simulator::Destroy();
 
-    // Other bands are not affected by this transmission
-    NS_TEST_EXPECT_MSG_EQ(channelHelper->GetWaitingTime(channel4),
-                          Time(0),
-                          "Waiting time affects other subbands");
-    NS_TEST_EXPECT_MSG_EQ(channelHelper->GetWaitingTime(channel5),
-                          Time(0),
-                          "Waiting time affects other subbands");
+    NS_TEST_EXPECT_MSG_EQ(m_maxOccupiedReceptionPaths, 3, "Wrong maximum number of paths");
+    NS_TEST_EXPECT_MSG_EQ(m_occupiedReceptionPaths, 0, "Reception paths were not released");
+    NS_TEST_EXPECT_MSG_EQ(m_noMoreDemodulatorsCalls, 1, "Wrong number of dropped receptions");
+    NS_TEST_EXPECT_MSG_EQ(m_transmittingCalls, 2, "Wrong number of interrupted receptions");
+    NS_TEST_EXPECT_MSG_EQ(m_receivedPacketCalls, 6, "Wrong number of received packets");
 }
 
-/*****************
- * TimeOnAirTest *
- *****************/
+/***************************
+ * InterferencePruningTest *
+ ***************************/
 
-class TimeOnAirTest : public TestCase
+class InterferencePruningTest : public TestCase
 {
   public:
-    TimeOnAirTest();
-    ~TimeOnAirTest() override;
+    InterferencePruningTest();
+    ~InterferencePruningTest() override;
 
   private:
     void DoRun() override;
+    void UnderSensitivity(Ptr<const Packet> packet, uint32_t node);
+    void ReceivedPacket(Ptr<const Packet> packet, uint32_t node);
+    void Outcome(std::string context, Ptr<const Packet> packet, uint32_t node);
+
+    int m_underSensitivityCalls = 0;
+    int m_receivedPacketCalls = 0;
+    std::map<std::string, int> m_outcomes;
 };
 
 // Add some help text to this case to describe what it is intended to test
-TimeOnAirTest::TimeOnAirTest()
-    : TestCase(
-          "Verify that LoraPhy's function to compute the time on air of a packet works as expected")
+InterferencePruningTest::InterferencePruningTest()
+    : TestCase("Verify that weak signals are pruned from gateway interference tracking")
 {
 }
 
 // Reminder that the test case should clean up after itself
-TimeOnAirTest::~TimeOnAirTest()
+InterferencePruningTest::~InterferencePruningTest()
+{
+}
+
+void
+InterferencePruningTest::UnderSensitivity(Ptr<const Packet> packet, uint32_t node)
+{
+    NS_LOG_FUNCTION(packet << node);
+
+    m_underSensitivityCalls++;
+}
+
+void
+InterferencePruningTest::ReceivedPacket(Ptr<const Packet> packet, uint32_t node)
+{
+    NS_LOG_FUNCTION(packet << node);
+
+    m_receivedPacketCalls++;
+}
+
+void
+InterferencePruningTest::Outcome(std::string context, Ptr<const Packet> packet, uint32_t node)
 {
+    NS_LOG_FUNCTION(context << packet << node);
+
+    m_outcomes[context]++;
 }
 
 // This method is the pure virtual method from class TestCase that every
 // TestCase must implement
 void
-TimeOnAirTest::DoRun()
+InterferencePruningTest::DoRun()
 {
-    NS_LOG_DEBUG("TimeOnAirTest");
+    NS_LOG_DEBUG("InterferencePruningTest");
+
+    Ptr<SimpleGatewayLoraPhy> gatewayPhy = CreateObject<SimpleGatewayLoraPhy>();
+    gatewayPhy->AddFrequency(868.1);
+    gatewayPhy->AddReceptionPath();
+    gatewayPhy->SetAttribute("InterferencePruningThreshold", DoubleValue(-150));
+    gatewayPhy->TraceConnectWithoutContext(
+        "LostPacketBecauseUnderSensitivity",
+        MakeCallback(&InterferencePruningTest::UnderSensitivity, this));
+    gatewayPhy->TraceConnectWithoutContext(
+        "ReceivedPacket",
+        MakeCallback(&InterferencePruningTest::ReceivedPacket, this));
+
+    // A pruned signal, a tracked signal below the sensitivity, and a signal
+    // that is received
+    Simulator::Schedule(Seconds(1),
+                        &SimpleGatewayLoraPhy::StartReceive,
+                        gatewayPhy,
+                        Create<Packet>(10),
+                        -160,
+                        7,
+                        Seconds(2),
+                        868.1);
+    Simulator::Schedule(Seconds(1),
+                        &SimpleGatewayLoraPhy::StartReceive,
+                        gatewayPhy,
+                        Create<Packet>(10),
+                        -145,
+                        7,
+                        Seconds(1),
+                        868.1);
+    Simulator::Schedule(Seconds(1),
+                        &SimpleGatewayLoraPhy::StartReceive,
+                        gatewayPhy,
+                        Create<Packet>(10),
+                        -100,
+                        7,
+                        Seconds(1),
+                        868.1);
 
-    Ptr<Packet> packet;
-    Time duration;
+    Simulator::Run();
+    Simulator::Destroy();
 
-    // Available parameters:
-    // PayloadSize, SF, HeaderDisabled, CodingRate, Bandwidth, nPreambleSyms, crcEnabled,
-    // lowDROptimization
-
-    // Starting parameters
-    packet = Create<Packet>(10);
-    LoraTxParameters txParams;
-    txParams.sf = 7;
-    txParams.headerDisabled = false;
-    txParams.codingRate = 1;
-    txParams.bandwidthHz = 125000;
-    txParams.nPreamble = 8;
-    txParams.crcEnabled = true;
-    txParams.lowDataRateOptimizationEnabled = false;
-
-    duration = LoraPhy::GetOnAirTime(packet, txParams);
-    NS_TEST_EXPECT_MSG_EQ_TOL(duration.GetSeconds(), 0.041216, 0.0001, "Unexpected duration");
-
-    txParams.sf = 8;
-    duration = LoraPhy::GetOnAirTime(packet, txParams);
-    NS_TEST_EXPECT_MSG_EQ_TOL(duration.GetSeconds(), 0.072192, 0.0001, "Unexpected duration");
-
-    txParams.headerDisabled = true;
-    duration = LoraPhy::GetOnAirTime(packet, txParams);
-    NS_TEST_EXPECT_MSG_EQ_TOL(duration.GetSeconds(), 0.072192, 0.0001, "Unexpected duration");
-
-    txParams.codingRate = 2;
-    duration = LoraPhy::GetOnAirTime(packet, txParams);
-    NS_TEST_EXPECT_MSG_EQ_TOL(duration.GetSeconds(), 0.078336, 0.0001, "Unexpected duration");
-
-    txParams.nPreamble = 10;
-    duration = LoraPhy::GetOnAirTime(packet, txParams);
-    NS_TEST_EXPECT_MSG_EQ_TOL(duration.GetSeconds(), 0.082432, 0.0001, "Unexpected duration");
-
-    txParams.lowDataRateOptimizationEnabled = true;
-    duration = LoraPhy::GetOnAirTime(packet, txParams);
-    NS_TEST_EXPECT_MSG_EQ_TOL(duration.GetSeconds(), 0.082432, 0.0001, "Unexpected duration");
-
-    txParams.sf = 10;
-    duration = LoraPhy::GetOnAirTime(packet, txParams);
-    NS_TEST_EXPECT_MSG_EQ_TOL(duration.GetSeconds(), 0.280576, 0.0001, "Unexpected duration");
-
-    txParams.bandwidthHz = 250000;
-    duration = LoraPhy::GetOnAirTime(packet, txParams);
-    NS_TEST_EXPECT_MSG_EQ_TOL(duration.GetSeconds(), 0.14028, 0.0001, "Unexpected duration");
-
-    txParams.bandwidthHz = 500000;
-    duration = LoraPhy::GetOnAirTime(packet, txParams);
-    NS_TEST_EXPECT_MSG_EQ_TOL(duration.GetSeconds(), 0.070144, 0.0001, "Unexpected duration");
-
-    txParams.headerDisabled = false;
-    duration = LoraPhy::GetOnAirTime(packet, txParams);
-    NS_TEST_EXPECT_MSG_EQ_TOL(duration.GetSeconds(), 0.082432, 0.0001, "Unexpected duration");
-
-    txParams.nPreamble = 8;
-    duration = LoraPhy::GetOnAirTime(packet, txParams);
-    NS_TEST_EXPECT_MSG_EQ_TOL(duration.GetSeconds(), 0.078336, 0.0001, "Unexpected duration");
+    NS_TEST_EXPECT_MSG_EQ(m_underSensitivityCalls, 2, "Pruned signals must be reported");
+    NS_TEST_EXPECT_MSG_EQ(m_receivedPacketCalls, 1, "The strong signal was not received");
+    NS_TEST_EXPECT_MSG_EQ(gatewayPhy->GetPrunedInterferers(), 1, "Wrong number of pruned signals");
+    // -160 dBm for 2 seconds
+    NS_TEST_EXPECT_MSG_EQ_TOL(gatewayPhy->GetPrunedInterferenceEnergy(),
+                              2e-19,
+                              1e-25,
+                              "Wrong pruned energy");
+
+    // With the highest threshold, a gateway gets the same outcomes as one
+    // tracking all signals, even for an SF12 signal close to the sensitivity
+    Ptr<SimpleGatewayLoraPhy> pruning = CreateObject<SimpleGatewayLoraPhy>();
+    Ptr<SimpleGatewayLoraPhy> tracking = CreateObject<SimpleGatewayLoraPhy>();
+    double threshold = pruning->GetMaxInterferencePruningThreshold();
+    NS_TEST_EXPECT_MSG_EQ_TOL(threshold, -148.5, 1e-9, "Wrong highest pruning threshold");
+    pruning->SetAttribute("InterferencePruningThreshold", DoubleValue(threshold));
+    for (const auto& [name, phy] : {std::make_pair("pruning", pruning),
+                                    std::make_pair("tracking", tracking)})
+    {
+        phy->AddFrequency(868.1);
+        phy->AddReceptionPath();
+        phy->TraceConnect("ReceivedPacket",
+                          std::string(name) + " received",
+                          MakeCallback(&InterferencePruningTest::Outcome, this));
+        phy->TraceConnect("LostPacketBecauseInterference",
+                          std::string(name) + " interfered",
+                          MakeCallback(&InterferencePruningTest::Outcome, this));
+    }
 
-    txParams.sf = 12;
-    duration = LoraPhy::GetOnAirTime(packet, txParams);
-    NS_TEST_EXPECT_MSG_EQ_TOL(duration.GetSeconds(), 0.264192, 0.0001, "Unexpected duration");
+    // An interferer just below the threshold, which the signal survives, and
+    // one just above it, which destroys the signal
+    int k = 0;
+    for (double interfererDbm : {threshold - 0.1, threshold + 0.2})
+    {
+        for (const auto& phy : {pruning, tracking})
+        {
+            Simulator::Schedule(Seconds(1 + 10 * k),
+                                &SimpleGatewayLoraPhy::StartReceive,
+                                phy,
+                                Create<Packet>(10),
+                                -142.4,
+                                12,
+                                Seconds(1),
+                                868.1);
+            Simulator::Schedule(Seconds(1 + 10 * k),
+                                &SimpleGatewayLoraPhy::StartReceive,
+                                phy,
+                                Create<Packet>(10),
+                                interfererDbm,
+                                12,
+                                Seconds(1),
+                                868.1);
+        }
+        k++;
+    }
 
-    packet = Create<Packet>(50);
-    duration = LoraPhy::GetOnAirTime(packet, txParams);
-    NS_TEST_EXPECT_MSG_EQ_TOL(duration.GetSeconds(), 0.657408, 0.0001, "Unexpected duration");
+    Simulator::Run();
+    Simulator::Destroy();
 
-    txParams.bandwidthHz = 125000;
-    duration = LoraPhy::GetOnAirTime(packet, txParams);
-    NS_TEST_EXPECT_MSG_EQ_TOL(duration.GetSeconds(), 2.629632, 0.0001, "Unexpected duration");
+    NS_TEST_EXPECT_MSG_EQ(pruning->GetPrunedInterferers(), 1, "Wrong number of pruned signals");
+    for (const std::string outcome : {" received", " interfered"})
+    {
+        NS_TEST_EXPECT_MSG_EQ(m_outcomes["pruning" + outcome],
+                              1,
+                              "Wrong number of" << outcome << " packets with pruning");
+        NS_TEST_EXPECT_MSG_EQ(m_outcomes["tracking" + outcome],
+                              1,
+                              "Wrong number of" << outcome << " packets without pruning");
+    }
 
-    txParams.codingRate = 1;
-    duration = LoraPhy::GetOnAirTime(packet, txParams);
-    NS_TEST_EXPECT_MSG_EQ_TOL(duration.GetSeconds(), 2.301952, 0.0001, "Unexpected duration");
+    // Under the ALOHA matrix, any overlap matters, so nothing can be pruned
+    LoraInterferenceHelper::collisionMatrix = LoraInterferenceHelper::ALOHA;
+    Ptr<SimpleGatewayLoraPhy> aloha = CreateObject<SimpleGatewayLoraPhy>();
+    LoraInterferenceHelper::collisionMatrix = LoraInterferenceHelper::GOURSAUD;
+    NS_TEST_EXPECT_MSG_EQ(aloha->GetMaxInterferencePruningThreshold(),
+                          -std::numeric_limits<double>::infinity(),
+                          "Signals can be pruned under the ALOHA matrix");
 }
 
-/**************************
- * PhyConnectivityTest *
- **************************/
+/*********************
+ * Sx1302GatewayTest *
+ *********************/
 
-class PhyConnectivityTest : public TestCase
+class Sx1302GatewayTest : public TestCase
 {
   public:
-    PhyConnectivityTest();
-    ~PhyConnectivityTest() override;
-    void Reset();
-    void ReceivedPacket(Ptr<const Packet> packet, uint32_t node);
-    void UnderSensitivity(Ptr<const Packet> packet, uint32_t node);
-    void Interference(Ptr<const Packet> packet, uint32_t node);
-    void NoMoreDemodulators(Ptr<const Packet> packet, uint32_t node);
-    void WrongFrequency(Ptr<const Packet> packet, uint32_t node);
-    void WrongSf(Ptr<const Packet> packet, uint32_t node);
-    bool HaveSamePacketContents(Ptr<Packet> packet1, Ptr<Packet> packet2);
+    Sx1302GatewayTest();
+    ~Sx1302GatewayTest() override;
 
   private:
     void DoRun() override;
-    Ptr<LoraChannel> channel;
-    Ptr<SimpleEndDeviceLoraPhy> edPhy1;
-    Ptr<SimpleEndDeviceLoraPhy> edPhy2;
-    Ptr<SimpleEndDeviceLoraPhy> edPhy3;
+    void NoMoreDemodulators(Ptr<const Packet> packet, uint32_t node);
+    void WrongFrequency(Ptr<const Packet> packet, uint32_t node);
+    void Interference(Ptr<const Packet> packet, uint32_t node);
+    void ReceivedPacket(Ptr<const Packet> packet, uint32_t node);
+    void FineTimestamp(Ptr<const Packet> packet, Time arrivalTime);
+    void StartReceive(double rxPowerDbm, uint8_t sf, double frequencyMHz);
+    void CheckOccupied(double frequencyMHz, uint32_t expected);
 
-    Ptr<Packet> m_latestReceivedPacket;
-    int m_receivedPacketCalls = 0;
-    int m_underSensitivityCalls = 0;
-    int m_interferenceCalls = 0;
+    Ptr<Sx1302GatewayLoraPhy> m_gatewayPhy;
     int m_noMoreDemodulatorsCalls = 0;
-    int m_wrongSfCalls = 0;
     int m_wrongFrequencyCalls = 0;
+    int m_interferenceCalls = 0;
+    int m_receivedPacketCalls = 0;
+    std::vector<Time> m_timestamps;
 };
 
 // Add some help text to this case to describe what it is intended to test
-PhyConnectivityTest::PhyConnectivityTest()
-    : TestCase("Verify that PhyConnectivity works as expected")
+Sx1302GatewayTest::Sx1302GatewayTest()
+    : TestCase("Verify the demodulator budgets of SX1302 gateways")
 {
 }
 
 // Reminder that the test case should clean up after itself
-PhyConnectivityTest::~PhyConnectivityTest()
+Sx1302GatewayTest::~Sx1302GatewayTest()
 {
 }
 
 void
-PhyConnectivityTest::ReceivedPacket(Ptr<const Packet> packet, uint32_t node)
+Sx1302GatewayTest::NoMoreDemodulators(Ptr<const Packet> packet, uint32_t node)
 {
     NS_LOG_FUNCTION(packet << node);
 
-    m_receivedPacketCalls++;
-
-    m_latestReceivedPacket = packet->Copy();
+    m_noMoreDemodulatorsCalls++;
 }
 
 void
-PhyConnectivityTest::UnderSensitivity(Ptr<const Packet> packet, uint32_t node)
+Sx1302GatewayTest::WrongFrequency(Ptr<const Packet> packet, uint32_t node)
 {
     NS_LOG_FUNCTION(packet << node);
 
-    m_underSensitivityCalls++;
+    m_wrongFrequencyCalls++;
 }
 
 void
-PhyConnectivityTest::Interference(Ptr<const Packet> packet, uint32_t node)
+Sx1302GatewayTest::Interference(Ptr<const Packet> packet, uint32_t node)
 {
     NS_LOG_FUNCTION(packet << node);
 
@@ -1120,393 +1492,2301 @@ PhyConnectivityTest::Interference(Ptr<const Packet> packet, uint32_t node)
 }
 
 void
-PhyConnectivityTest::NoMoreDemodulators(Ptr<const Packet> packet, uint32_t node)
+Sx1302GatewayTest::ReceivedPacket(Ptr<const Packet> packet, uint32_t node)
 {
     NS_LOG_FUNCTION(packet << node);
 
-    m_noMoreDemodulatorsCalls++;
+    m_receivedPacketCalls++;
 }
 
 void
-PhyConnectivityTest::WrongSf(Ptr<const Packet> packet, uint32_t node)
+Sx1302GatewayTest::FineTimestamp(Ptr<const Packet> packet, Time arrivalTime)
 {
-    NS_LOG_FUNCTION(packet << node);
+    NS_LOG_FUNCTION(packet << arrivalTime);
 
-    m_wrongSfCalls++;
+    m_timestamps.push_back(arrivalTime);
 }
 
 void
-PhyConnectivityTest::WrongFrequency(Ptr<const Packet> packet, uint32_t node)
+Sx1302GatewayTest::StartReceive(double rxPowerDbm, uint8_t sf, double frequencyMHz)
 {
-    NS_LOG_FUNCTION(packet << node);
+    m_gatewayPhy->StartReceive(Create<Packet>(10), rxPowerDbm, sf, Seconds(1), frequencyMHz);
+}
 
-    m_wrongFrequencyCalls++;
+void
+Sx1302GatewayTest::CheckOccupied(double frequencyMHz, uint32_t expected)
+{
+    NS_TEST_EXPECT_MSG_EQ(m_gatewayPhy->GetOccupiedDemodulators(frequencyMHz),
+                          expected,
+                          "Wrong number of occupied demodulators on " << frequencyMHz << " MHz");
 }
 
-bool
-PhyConnectivityTest::HaveSamePacketContents(Ptr<Packet> packet1, Ptr<Packet> packet2)
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+Sx1302GatewayTest::DoRun()
 {
-    uint32_t size1 = packet1->GetSerializedSize();
-    uint8_t buffer1[size1];
-    packet1->Serialize(buffer1, size1);
+    NS_LOG_DEBUG("Sx1302GatewayTest");
 
-    uint32_t size2 = packet2->GetSerializedSize();
-    uint8_t buffer2[size2];
-    packet2->Serialize(buffer2, size2);
+    m_gatewayPhy = CreateObject<Sx1302GatewayLoraPhy>();
+    m_gatewayPhy->SetAttribute("Demodulators", UintegerValue(4));
+    m_gatewayPhy->SetAttribute("SfDemodulators", UintegerValue(2));
+    m_gatewayPhy->SetAttribute("FineTimestamp", BooleanValue(true));
+    m_gatewayPhy->AddIfChain(868.1, 3);
+    m_gatewayPhy->AddFrequency(868.3);
+    m_gatewayPhy->AddFrequency(868.3);
 
-    NS_ASSERT(size1 == size2);
+    m_gatewayPhy->TraceConnectWithoutContext(
+        "LostPacketBecauseNoMoreReceivers",
+        MakeCallback(&Sx1302GatewayTest::NoMoreDemodulators, this));
+    m_gatewayPhy->TraceConnectWithoutContext(
+        "LostPacketBecauseWrongFrequency",
+        MakeCallback(&Sx1302GatewayTest::WrongFrequency, this));
+    m_gatewayPhy->TraceConnectWithoutContext(
+        "LostPacketBecauseInterference",
+        MakeCallback(&Sx1302GatewayTest::Interference, this));
+    m_gatewayPhy->TraceConnectWithoutContext(
+        "ReceivedPacket",
+        MakeCallback(&Sx1302GatewayTest::ReceivedPacket, this));
+    m_gatewayPhy->TraceConnectWithoutContext(
+        "FineTimestamp",
+        MakeCallback(&Sx1302GatewayTest::FineTimestamp, this));
+
+    // On 868.1 MHz, the third SF7 packet exceeds the SF budget and the SF9
+    // one the IF chain budget. The weaker SF7 packet is destroyed by the
+    // stronger one.
+    Time start = Seconds(1);
+    Simulator::Schedule(start, &Sx1302GatewayTest::StartReceive, this, -100, 7, 868.1);
+    Simulator::Schedule(start, &Sx1302GatewayTest::StartReceive, this, -125, 7, 868.1);
+    Simulator::Schedule(start, &Sx1302GatewayTest::StartReceive, this, -125, 7, 868.1);
+    Simulator::Schedule(start, &Sx1302GatewayTest::StartReceive, this, -100, 8, 868.1);
+    Simulator::Schedule(start, &Sx1302GatewayTest::StartReceive, this, -100, 9, 868.1);
+
+    // On 868.3 MHz, the second packet exceeds the shared pool
+    Simulator::Schedule(start, &Sx1302GatewayTest::StartReceive, this, -100, 7, 868.3);
+    Simulator::Schedule(start, &Sx1302GatewayTest::StartReceive, this, -100, 8, 868.3);
+
+    // No IF chain listens on 868.5 MHz
+    Simulator::Schedule(start, &Sx1302GatewayTest::StartReceive, this, -100, 7, 868.5);
+
+    Simulator::Schedule(Seconds(1.5), &Sx1302GatewayTest::CheckOccupied, this, 868.1, 3);
+    Simulator::Schedule(Seconds(1.5), &Sx1302GatewayTest::CheckOccupied, this, 868.3, 1);
+    Simulator::Schedule(Seconds(3), &Sx1302GatewayTest::CheckOccupied, this, 868.1, 0);
+    Simulator::Schedule(Seconds(3), &Sx1302GatewayTest::CheckOccupied, this, 868.3, 0);
 
-    bool foundADifference = false;
-    for (uint32_t i = 0; i < size1; i++)
+    Simulator::Run();
+    Simulator::Destroy();
+
+    NS_TEST_EXPECT_MSG_EQ(m_noMoreDemodulatorsCalls, 3, "Wrong number of rejected packets");
+    NS_TEST_EXPECT_MSG_EQ(m_wrongFrequencyCalls, 1, "Wrong number of off-channel packets");
+    NS_TEST_EXPECT_MSG_EQ(m_interferenceCalls, 1, "Wrong number of interfered packets");
+    NS_TEST_EXPECT_MSG_EQ(m_receivedPacketCalls, 3, "Wrong number of received packets");
+    NS_TEST_EXPECT_MSG_EQ(m_timestamps.size(), 3, "Wrong number of fine timestamps");
+    for (const auto& timestamp : m_timestamps)
     {
-        NS_LOG_DEBUG(unsigned(buffer1[i]) << " " << unsigned(buffer2[i]));
-        if (buffer1[i] != buffer2[i])
-        {
-            foundADifference = true;
-            break;
-        }
+        NS_TEST_EXPECT_MSG_EQ(timestamp, start, "Wrong fine timestamp");
     }
 
-    return !foundADifference;
+    m_gatewayPhy = nullptr;
 }
 
-void
-PhyConnectivityTest::Reset()
+/**************************
+ * LogicalLoraChannelTest *
+ **************************/
+
+class LogicalLoraChannelTest : public TestCase
 {
-    m_receivedPacketCalls = 0;
-    m_underSensitivityCalls = 0;
-    m_interferenceCalls = 0;
-    m_wrongSfCalls = 0;
-    m_wrongFrequencyCalls = 0;
+  public:
+    LogicalLoraChannelTest();
+    ~LogicalLoraChannelTest() override;
 
-    Ptr<LogDistancePropagationLossModel> loss = CreateObject<LogDistancePropagationLossModel>();
-    loss->SetPathLossExponent(3.76);
-    loss->SetReference(1, 7.7);
+  private:
+    void DoRun() override;
+};
 
-    Ptr<PropagationDelayModel> delay = CreateObject<ConstantSpeedPropagationDelayModel>();
+// Add some help text to this case to describe what it is intended to test
+LogicalLoraChannelTest::LogicalLoraChannelTest()
+    : TestCase("Verify that LogicalLoraChannel and LogicalLoraChannelHelper work as expected")
+{
+}
 
-    // Create the channel
-    channel = CreateObject<LoraChannel>(loss, delay);
+// Reminder that the test case should clean up after itself
+LogicalLoraChannelTest::~LogicalLoraChannelTest()
+{
+}
 
-    // Connect PHYs
-    edPhy1 = CreateObject<SimpleEndDeviceLoraPhy>();
-    edPhy2 = CreateObject<SimpleEndDeviceLoraPhy>();
-    edPhy3 = CreateObject<SimpleEndDeviceLoraPhy>();
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+LogicalLoraChannelTest::DoRun()
+{
+    NS_LOG_DEBUG("LogicalLoraChannelTest");
 
-    edPhy1->SetFrequency(868.1);
-    edPhy2->SetFrequency(868.1);
-    edPhy3->SetFrequency(868.1);
+    /////////////////////////////
+    // Test LogicalLoraChannel //
+    /////////////////////////////
 
-    Ptr<ConstantPositionMobilityModel> mob1 = CreateObject<ConstantPositionMobilityModel>();
-    Ptr<ConstantPositionMobilityModel> mob2 = CreateObject<ConstantPositionMobilityModel>();
-    Ptr<ConstantPositionMobilityModel> mob3 = CreateObject<ConstantPositionMobilityModel>();
+    // Setup
+    Ptr<LogicalLoraChannel> channel1 = CreateObject<LogicalLoraChannel>(868);
+    Ptr<LogicalLoraChannel> channel2 = CreateObject<LogicalLoraChannel>(868);
+    Ptr<LogicalLoraChannel> channel3 = CreateObject<LogicalLoraChannel>(868.1);
+    Ptr<LogicalLoraChannel> channel4 = CreateObject<LogicalLoraChannel>(868.001);
 
-    mob1->SetPosition(Vector(0.0, 0.0, 0.0));
-    mob2->SetPosition(Vector(10.0, 0.0, 0.0));
-    mob3->SetPosition(Vector(20.0, 0.0, 0.0));
+    // Equality between channels
+    // Test the == and != operators
+    NS_TEST_EXPECT_MSG_EQ(channel1, channel2, "== operator doesn't work as expected");
+    NS_TEST_EXPECT_MSG_NE(channel1, channel3, "!= operator doesn't work as expected");
+    NS_TEST_EXPECT_MSG_NE(channel1, channel4, "!= operator doesn't work as expected");
 
-    edPhy1->SetMobility(mob1);
-    edPhy2->SetMobility(mob2);
-    edPhy3->SetMobility(mob3);
+    //////////////////
+    // Test SubBand //
+    //////////////////
 
-    edPhy1->SwitchToStandby();
-    edPhy2->SwitchToStandby();
-    edPhy3->SwitchToStandby();
+    // Setup
+    SubBand subBand(868, 868.7, 0.01, 14);
+    Ptr<LogicalLoraChannel> channel5 = CreateObject<LogicalLoraChannel>(870);
 
-    channel->Add(edPhy1);
-    channel->Add(edPhy2);
-    channel->Add(edPhy3);
+    // Test BelongsToSubBand
+    NS_TEST_EXPECT_MSG_EQ(subBand.BelongsToSubBand(channel3),
+                          true,
+                          "BelongsToSubBand does not behave as expected");
+    NS_TEST_EXPECT_MSG_EQ(subBand.BelongsToSubBand(channel3->GetFrequency()),
+                          true,
+                          "BelongsToSubBand does not behave as expected");
+    NS_TEST_EXPECT_MSG_EQ(subBand.BelongsToSubBand(channel5),
+                          false,
+                          "BelongsToSubBand does not behave as expected");
 
-    edPhy1->SetChannel(channel);
-    edPhy2->SetChannel(channel);
-    edPhy3->SetChannel(channel);
+    ///////////////////////////////////
+    // Test LogicalLoraChannelHelper //
+    ///////////////////////////////////
 
-    // Listen for a specific SpreadingFactor
-    edPhy1->SetSpreadingFactor(12);
-    edPhy2->SetSpreadingFactor(12);
-    edPhy3->SetSpreadingFactor(12);
+    // Setup
+    Ptr<LogicalLoraChannelHelper> channelHelper = CreateObject<LogicalLoraChannelHelper>();
+    SubBand subBand1(869, 869.4, 0.1, 27);
+    channel1 = CreateObject<LogicalLoraChannel>(868.1);
+    channel2 = CreateObject<LogicalLoraChannel>(868.3);
+    channel3 = CreateObject<LogicalLoraChannel>(868.5);
+    channel4 = CreateObject<LogicalLoraChannel>(869.1);
+    channel5 = CreateObject<LogicalLoraChannel>(869.3);
+
+    // Channel diagram
+    //
+    // Channels      1      2      3                     4       5
+    // SubBands  868 ----- 0.1% ----- 868.7       869 ----- 1% ----- 869.4
+
+    // Add SubBands and LogicalLoraChannels to the helper
+    channelHelper->AddSubBand(&subBand);
+    channelHelper->AddSubBand(&subBand1);
+    channelHelper->AddChannel(channel1);
+    channelHelper->AddChannel(channel2);
+    channelHelper->AddChannel(channel3);
+    channelHelper->AddChannel(channel4);
+    channelHelper->AddChannel(channel5);
+
+    // Duty Cycle tests
+    // (high level duty cycle behavior)
+    ///////////////////////////////////
+
+    channelHelper->AddEvent(Seconds(2), channel1);
+    Time expectedTimeOff = Seconds(2 / 0.01 - 2);
+
+    // Waiting time is computed correctly
+    NS_TEST_EXPECT_MSG_EQ(channelHelper->GetWaitingTime(channel1),
+                          expectedTimeOff,
+                          "Waiting time doesn't behave as expected");
+
+    // Duty Cycle involves the whole SubBand, not just a channel
+    NS_TEST_EXPECT_MSG_EQ(channelHelper->GetWaitingTime(channel2),
+                          expectedTimeOff,
+                          "Waiting time doesn't behave as expected");
+    NS_TEST_EXPECT_MSG_EQ(channelHelper->GetWaitingTime(channel3),
+                          expectedTimeOff,
+                          "Waiting time doesn't behave as expected");
+
+    // Other bands are not affected by this transmission
+    NS_TEST_EXPECT_MSG_EQ(channelHelper->GetWaitingTime(channel4),
+                          Time(0),
+                          "Waiting time affects other subbands");
+    NS_TEST_EXPECT_MSG_EQ(channelHelper->GetWaitingTime(channel5),
+                          Time(0),
+                          "Waiting time affects other subbands");
+
+    // Channel selection tests
+    // (channel mask and duty cycle)
+    ////////////////////////////////
+
+    NS_TEST_EXPECT_MSG_EQ(channelHelper->GetEnabledChannelMask(),
+                          0x1F,
+                          "All channels should be enabled");
+    NS_TEST_EXPECT_MSG_EQ(channelHelper->GetMinWaitingTime(),
+                          Time(0),
+                          "Channels of the other SubBand are available");
+
+    // Only the channels of the SubBand that is not blocked can be picked
+    Ptr<UniformRandomVariable> rv = CreateObject<UniformRandomVariable>();
+    bool picked4 = false;
+    bool picked5 = false;
+    for (int i = 0; i < 50; i++)
+    {
+        Ptr<LogicalLoraChannel> picked = channelHelper->GetRandomAvailableChannel(rv);
+        NS_TEST_ASSERT_MSG_EQ((picked == channel4 || picked == channel5),
+                              true,
+                              "Picked a channel that is blocked by the duty cycle");
+        picked4 |= picked == channel4;
+        picked5 |= picked == channel5;
+    }
+    NS_TEST_EXPECT_MSG_EQ((picked4 && picked5), true, "Not all available channels were picked");
+
+    // Disabled channels are not picked
+    channelHelper->DisableChannel(3);
+    NS_TEST_EXPECT_MSG_EQ(channelHelper->GetEnabledChannelMask(),
+                          0x17,
+                          "Channel mask doesn't behave as expected");
+    NS_TEST_EXPECT_MSG_EQ(channelHelper->GetEnabledChannelList().size(),
+                          4,
+                          "Enabled channel list doesn't follow the channel mask");
+    NS_TEST_EXPECT_MSG_EQ(channelHelper->GetRandomAvailableChannel(rv),
+                          channel5,
+                          "Picked a disabled channel");
+
+    // No channel is available if all the enabled ones are blocked
+    channelHelper->DisableChannel(4);
+    NS_TEST_EXPECT_MSG_EQ(bool(channelHelper->GetRandomAvailableChannel(rv)),
+                          false,
+                          "Picked a channel that is blocked by the duty cycle");
+    NS_TEST_EXPECT_MSG_EQ(channelHelper->GetMinWaitingTime(),
+                          expectedTimeOff,
+                          "Minimum waiting time doesn't behave as expected");
+
+    // The mask follows the channels when one is removed
+    channelHelper->EnableChannel(3);
+    channelHelper->RemoveChannel(channel2);
+    NS_TEST_EXPECT_MSG_EQ(channelHelper->GetEnabledChannelMask(),
+                          0x7,
+                          "Channel mask doesn't follow the removed channel");
+    NS_TEST_EXPECT_MSG_EQ(channelHelper->GetRandomAvailableChannel(rv),
+                          channel4,
+                          "Channel SubBands don't follow the removed channel");
+}
+
+/*****************
+ * TimeOnAirTest *
+ *****************/
+
+class TimeOnAirTest : public TestCase
+{
+  public:
+    TimeOnAirTest();
+    ~TimeOnAirTest() override;
+
+  private:
+    void DoRun() override;
+};
+
+// Add some help text to this case to describe what it is intended to test
+TimeOnAirTest::TimeOnAirTest()
+    : TestCase(
+          "Verify that LoraPhy's function to compute the time on air of a packet works as expected")
+{
+}
+
+// Reminder that the test case should clean up after itself
+TimeOnAirTest::~TimeOnAirTest()
+{
+}
+
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+TimeOnAirTest::DoRun()
+{
+    NS_LOG_DEBUG("TimeOnAirTest");
+
+    Ptr<Packet> packet;
+    Time duration;
+
+    // Available parameters:
+    // PayloadSize, SF, HeaderDisabled, CodingRate, Bandwidth, nPreambleSyms, crcEnabled,
+    // lowDROptimization
+
+    // Starting parameters
+    packet = Create<Packet>(10);
+    LoraTxParameters txParams;
+    txParams.sf = 7;
+    txParams.headerDisabled = false;
+    txParams.codingRate = 1;
+    txParams.bandwidthHz = 125000;
+    txParams.nPreamble = 8;
+    txParams.crcEnabled = true;
+    txParams.lowDataRateOptimizationEnabled = false;
+
+    duration = LoraPhy::GetOnAirTime(packet, txParams);
+    NS_TEST_EXPECT_MSG_EQ_TOL(duration.GetSeconds(), 0.041216, 0.0001, "Unexpected duration");
+
+    txParams.sf = 8;
+    duration = LoraPhy::GetOnAirTime(packet, txParams);
+    NS_TEST_EXPECT_MSG_EQ_TOL(duration.GetSeconds(), 0.072192, 0.0001, "Unexpected duration");
+
+    txParams.headerDisabled = true;
+    duration = LoraPhy::GetOnAirTime(packet, txParams);
+    NS_TEST_EXPECT_MSG_EQ_TOL(duration.GetSeconds(), 0.072192, 0.0001, "Unexpected duration");
+
+    txParams.codingRate = 2;
+    duration = LoraPhy::GetOnAirTime(packet, txParams);
+    NS_TEST_EXPECT_MSG_EQ_TOL(duration.GetSeconds(), 0.078336, 0.0001, "Unexpected duration");
+
+    txParams.nPreamble = 10;
+    duration = LoraPhy::GetOnAirTime(packet, txParams);
+    NS_TEST_EXPECT_MSG_EQ_TOL(duration.GetSeconds(), 0.082432, 0.0001, "Unexpected duration");
+
+    txParams.lowDataRateOptimizationEnabled = true;
+    duration = LoraPhy::GetOnAirTime(packet, txParams);
+    NS_TEST_EXPECT_MSG_EQ_TOL(duration.GetSeconds(), 0.082432, 0.0001, "Unexpected duration");
+
+    txParams.sf = 10;
+    duration = LoraPhy::GetOnAirTime(packet, txParams);
+    NS_TEST_EXPECT_MSG_EQ_TOL(duration.GetSeconds(), 0.280576, 0.0001, "Unexpected duration");
+
+    txParams.bandwidthHz = 250000;
+    duration = LoraPhy::GetOnAirTime(packet, txParams);
+    NS_TEST_EXPECT_MSG_EQ_TOL(duration.GetSeconds(), 0.14028, 0.0001, "Unexpected duration");
+
+    txParams.bandwidthHz = 500000;
+    duration = LoraPhy::GetOnAirTime(packet, txParams);
+    NS_TEST_EXPECT_MSG_EQ_TOL(duration.GetSeconds(), 0.070144, 0.0001, "Unexpected duration");
+
+    txParams.headerDisabled = false;
+    duration = LoraPhy::GetOnAirTime(packet, txParams);
+    NS_TEST_EXPECT_MSG_EQ_TOL(duration.GetSeconds(), 0.082432, 0.0001, "Unexpected duration");
+
+    txParams.nPreamble = 8;
+    duration = LoraPhy::GetOnAirTime(packet, txParams);
+    NS_TEST_EXPECT_MSG_EQ_TOL(duration.GetSeconds(), 0.078336, 0.0001, "Unexpected duration");
+
+    txParams.sf = 12;
+    duration = LoraPhy::GetOnAirTime(packet, txParams);
+    NS_TEST_EXPECT_MSG_EQ_TOL(duration.GetSeconds(), 0.264192, 0.0001, "Unexpected duration");
+
+    packet = Create<Packet>(50);
+    duration = LoraPhy::GetOnAirTime(packet, txParams);
+    NS_TEST_EXPECT_MSG_EQ_TOL(duration.GetSeconds(), 0.657408, 0.0001, "Unexpected duration");
+
+    txParams.bandwidthHz = 125000;
+    duration = LoraPhy::GetOnAirTime(packet, txParams);
+    NS_TEST_EXPECT_MSG_EQ_TOL(duration.GetSeconds(), 2.629632, 0.0001, "Unexpected duration");
+
+    txParams.codingRate = 1;
+    duration = LoraPhy::GetOnAirTime(packet, txParams);
+    NS_TEST_EXPECT_MSG_EQ_TOL(duration.GetSeconds(), 2.301952, 0.0001, "Unexpected duration");
+}
+
+/**************************
+ * PhyConnectivityTest *
+ **************************/
+
+class PhyConnectivityTest : public TestCase
+{
+  public:
+    PhyConnectivityTest();
+    ~PhyConnectivityTest() override;
+    void Reset();
+    void ReceivedPacket(Ptr<const Packet> packet, uint32_t node);
+    void UnderSensitivity(Ptr<const Packet> packet, uint32_t node);
+    void Interference(Ptr<const Packet> packet, uint32_t node);
+    void NoMoreDemodulators(Ptr<const Packet> packet, uint32_t node);
+    void WrongFrequency(Ptr<const Packet> packet, uint32_t node);
+    void WrongSf(Ptr<const Packet> packet, uint32_t node);
+    void PacketSent(Ptr<const Packet> packet);
+    bool HaveSamePacketContents(Ptr<Packet> packet1, Ptr<Packet> packet2);
+
+  private:
+    void DoRun() override;
+    Ptr<LoraChannel> channel;
+    Ptr<SimpleEndDeviceLoraPhy> edPhy1;
+    Ptr<SimpleEndDeviceLoraPhy> edPhy2;
+    Ptr<SimpleEndDeviceLoraPhy> edPhy3;
+
+    Ptr<Packet> m_latestReceivedPacket;
+    int m_receivedPacketCalls = 0;
+    int m_underSensitivityCalls = 0;
+    int m_interferenceCalls = 0;
+    int m_noMoreDemodulatorsCalls = 0;
+    int m_wrongSfCalls = 0;
+    int m_wrongFrequencyCalls = 0;
+    int m_packetSentCalls = 0;
+};
+
+// Add some help text to this case to describe what it is intended to test
+PhyConnectivityTest::PhyConnectivityTest()
+    : TestCase("Verify that PhyConnectivity works as expected")
+{
+}
+
+// Reminder that the test case should clean up after itself
+PhyConnectivityTest::~PhyConnectivityTest()
+{
+}
+
+void
+PhyConnectivityTest::ReceivedPacket(Ptr<const Packet> packet, uint32_t node)
+{
+    NS_LOG_FUNCTION(packet << node);
+
+    m_receivedPacketCalls++;
+
+    m_latestReceivedPacket = packet->Copy();
+}
+
+void
+PhyConnectivityTest::UnderSensitivity(Ptr<const Packet> packet, uint32_t node)
+{
+    NS_LOG_FUNCTION(packet << node);
+
+    m_underSensitivityCalls++;
+}
+
+void
+PhyConnectivityTest::Interference(Ptr<const Packet> packet, uint32_t node)
+{
+    NS_LOG_FUNCTION(packet << node);
+
+    m_interferenceCalls++;
+}
+
+void
+PhyConnectivityTest::NoMoreDemodulators(Ptr<const Packet> packet, uint32_t node)
+{
+    NS_LOG_FUNCTION(packet << node);
+
+    m_noMoreDemodulatorsCalls++;
+}
+
+void
+PhyConnectivityTest::WrongSf(Ptr<const Packet> packet, uint32_t node)
+{
+    NS_LOG_FUNCTION(packet << node);
+
+    m_wrongSfCalls++;
+}
+
+void
+PhyConnectivityTest::WrongFrequency(Ptr<const Packet> packet, uint32_t node)
+{
+    NS_LOG_FUNCTION(packet << node);
+
+    m_wrongFrequencyCalls++;
+}
+
+void
+PhyConnectivityTest::PacketSent(Ptr<const Packet> packet)
+{
+    NS_LOG_FUNCTION(packet);
+
+    m_packetSentCalls++;
+}
+
+bool
+PhyConnectivityTest::HaveSamePacketContents(Ptr<Packet> packet1, Ptr<Packet> packet2)
+{
+    uint32_t size1 = packet1->GetSerializedSize();
+    uint8_t buffer1[size1];
+    packet1->Serialize(buffer1, size1);
+
+    uint32_t size2 = packet2->GetSerializedSize();
+    uint8_t buffer2[size2];
+    packet2->Serialize(buffer2, size2);
+
+    NS_ASSERT(size1 == size2);
+
+    bool foundADifference = false;
+    for (uint32_t i = 0; i < size1; i++)
+    {
+        NS_LOG_DEBUG(unsigned(buffer1[i]) << " " << unsigned(buffer2[i]));
+        if (buffer1[i] != buffer2[i])
+        {
+            foundADifference = true;
+            break;
+        }
+    }
+
+    return !foundADifference;
+}
+
+void
+PhyConnectivityTest::Reset()
+{
+    m_receivedPacketCalls = 0;
+    m_underSensitivityCalls = 0;
+    m_interferenceCalls = 0;
+    m_wrongSfCalls = 0;
+    m_wrongFrequencyCalls = 0;
+    m_packetSentCalls = 0;
+
+    Ptr<LogDistancePropagationLossModel> loss = CreateObject<LogDistancePropagationLossModel>();
+    loss->SetPathLossExponent(3.76);
+    loss->SetReference(1, 7.7);
+
+    Ptr<PropagationDelayModel> delay = CreateObject<ConstantSpeedPropagationDelayModel>();
+
+    // Create the channel
+    channel = CreateObject<LoraChannel>(loss, delay);
+    channel->TraceConnectWithoutContext("PacketSent",
+                                        MakeCallback(&PhyConnectivityTest::PacketSent, this));
+
+    // Connect PHYs
+    edPhy1 = CreateObject<SimpleEndDeviceLoraPhy>();
+    edPhy2 = CreateObject<SimpleEndDeviceLoraPhy>();
+    edPhy3 = CreateObject<SimpleEndDeviceLoraPhy>();
+
+    edPhy1->SetFrequency(868.1);
+    edPhy2->SetFrequency(868.1);
+    edPhy3->SetFrequency(868.1);
+
+    Ptr<ConstantPositionMobilityModel> mob1 = CreateObject<ConstantPositionMobilityModel>();
+    Ptr<ConstantPositionMobilityModel> mob2 = CreateObject<ConstantPositionMobilityModel>();
+    Ptr<ConstantPositionMobilityModel> mob3 = CreateObject<ConstantPositionMobilityModel>();
+
+    mob1->SetPosition(Vector(0.0, 0.0, 0.0));
+    mob2->SetPosition(Vector(10.0, 0.0, 0.0));
+    mob3->SetPosition(Vector(20.0, 0.0, 0.0));
+
+    edPhy1->SetMobility(mob1);
+    edPhy2->SetMobility(mob2);
+    edPhy3->SetMobility(mob3);
+
+    edPhy1->SwitchToStandby();
+    edPhy2->SwitchToStandby();
+    edPhy3->SwitchToStandby();
+
+    channel->Add(edPhy1);
+    channel->Add(edPhy2);
+    channel->Add(edPhy3);
+
+    edPhy1->SetChannel(channel);
+    edPhy2->SetChannel(channel);
+    edPhy3->SetChannel(channel);
+
+    // Listen for a specific SpreadingFactor
+    edPhy1->SetSpreadingFactor(12);
+    edPhy2->SetSpreadingFactor(12);
+    edPhy3->SetSpreadingFactor(12);
+
+    // Listen on a specific frequency
+    edPhy1->SetFrequency(868.1);
+    edPhy2->SetFrequency(868.1);
+    edPhy3->SetFrequency(868.1);
+
+    edPhy1->TraceConnectWithoutContext("ReceivedPacket",
+                                       MakeCallback(&PhyConnectivityTest::ReceivedPacket, this));
+    edPhy2->TraceConnectWithoutContext("ReceivedPacket",
+                                       MakeCallback(&PhyConnectivityTest::ReceivedPacket, this));
+    edPhy3->TraceConnectWithoutContext("ReceivedPacket",
+                                       MakeCallback(&PhyConnectivityTest::ReceivedPacket, this));
+
+    edPhy1->TraceConnectWithoutContext("LostPacketBecauseUnderSensitivity",
+                                       MakeCallback(&PhyConnectivityTest::UnderSensitivity, this));
+    edPhy2->TraceConnectWithoutContext("LostPacketBecauseUnderSensitivity",
+                                       MakeCallback(&PhyConnectivityTest::UnderSensitivity, this));
+    edPhy3->TraceConnectWithoutContext("LostPacketBecauseUnderSensitivity",
+                                       MakeCallback(&PhyConnectivityTest::UnderSensitivity, this));
+
+    edPhy1->TraceConnectWithoutContext("LostPacketBecauseInterference",
+                                       MakeCallback(&PhyConnectivityTest::Interference, this));
+    edPhy2->TraceConnectWithoutContext("LostPacketBecauseInterference",
+                                       MakeCallback(&PhyConnectivityTest::Interference, this));
+    edPhy3->TraceConnectWithoutContext("LostPacketBecauseInterference",
+                                       MakeCallback(&PhyConnectivityTest::Interference, this));
+
+    edPhy1->TraceConnectWithoutContext(
+        "LostPacketBecauseNoMoreReceivers",
+        MakeCallback(&PhyConnectivityTest::NoMoreDemodulators, this));
+    edPhy2->TraceConnectWithoutContext(
+        "LostPacketBecauseNoMoreReceivers",
+        MakeCallback(&PhyConnectivityTest::NoMoreDemodulators, this));
+    edPhy3->TraceConnectWithoutContext(
+        "LostPacketBecauseNoMoreReceivers",
+        MakeCallback(&PhyConnectivityTest::NoMoreDemodulators, this));
+
+    edPhy1->TraceConnectWithoutContext("LostPacketBecauseWrongFrequency",
+                                       MakeCallback(&PhyConnectivityTest::WrongFrequency, this));
+    edPhy2->TraceConnectWithoutContext("LostPacketBecauseWrongFrequency",
+                                       MakeCallback(&PhyConnectivityTest::WrongFrequency, this));
+    edPhy3->TraceConnectWithoutContext("LostPacketBecauseWrongFrequency",
+                                       MakeCallback(&PhyConnectivityTest::WrongFrequency, this));
+
+    edPhy1->TraceConnectWithoutContext("LostPacketBecauseWrongSpreadingFactor",
+                                       MakeCallback(&PhyConnectivityTest::WrongSf, this));
+    edPhy2->TraceConnectWithoutContext("LostPacketBecauseWrongSpreadingFactor",
+                                       MakeCallback(&PhyConnectivityTest::WrongSf, this));
+    edPhy3->TraceConnectWithoutContext("LostPacketBecauseWrongSpreadingFactor",
+                                       MakeCallback(&PhyConnectivityTest::WrongSf, this));
+}
+
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+PhyConnectivityTest::DoRun()
+{
+    NS_LOG_DEBUG("PhyConnectivityTest");
+
+    // Setup
+    ////////
+
+    Reset();
+
+    LoraTxParameters txParams;
+    txParams.sf = 12;
+
+    uint8_t buffer[10] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+    Ptr<Packet> packet = Create<Packet>(buffer, 10);
+
+    // Testing
+    //////////
+
+    // Basic packet delivery test
+    /////////////////////////////
+
+    Simulator::Schedule(Seconds(2),
+                        &SimpleEndDeviceLoraPhy::Send,
+                        edPhy1,
+                        packet,
+                        txParams,
+                        868.1,
+                        14);
+
+    Simulator::Stop(Hours(2));
+    Simulator::Run();
+    Simulator::Destroy();
+
+    NS_TEST_EXPECT_MSG_EQ(
+        m_receivedPacketCalls,
+        2,
+        "Channel skipped some PHYs when delivering a packet"); // All PHYs except the sender
+
+    Reset();
+
+    // Sleeping PHYs do not receive the packet
+
+    edPhy2->SwitchToSleep();
+
+    Simulator::Schedule(Seconds(2),
+                        &SimpleEndDeviceLoraPhy::Send,
+                        edPhy1,
+                        packet,
+                        txParams,
+                        868.1,
+                        14);
+
+    Simulator::Stop(Hours(2));
+    Simulator::Run();
+    Simulator::Destroy();
+
+    NS_TEST_EXPECT_MSG_EQ(
+        m_receivedPacketCalls,
+        1,
+        "Packet was received by a PHY in SLEEP mode"); // All PHYs in Standby except the sender
+
+    Reset();
+
+    // Packet that arrives under sensitivity is received correctly if SF increases
+
+    txParams.sf = 7;
+    edPhy2->SetSpreadingFactor(7);
+    edPhy2->GetMobility()->GetObject<ConstantPositionMobilityModel>()->SetPosition(
+        Vector(2990, 0, 0));
+
+    Simulator::Schedule(Seconds(2),
+                        &SimpleEndDeviceLoraPhy::Send,
+                        edPhy1,
+                        packet,
+                        txParams,
+                        868.1,
+                        14);
+
+    Simulator::Stop(Hours(2));
+    Simulator::Run();
+    Simulator::Destroy();
+
+    NS_TEST_EXPECT_MSG_EQ(
+        m_underSensitivityCalls,
+        1,
+        "Packet that should have been lost because of low receive power was received");
+
+    Reset();
+
+    // Try again using a packet with higher SF
+    txParams.sf = 8;
+    edPhy2->SetSpreadingFactor(8);
+    edPhy2->GetMobility()->GetObject<ConstantPositionMobilityModel>()->SetPosition(
+        Vector(2990, 0, 0));
+
+    Simulator::Schedule(Seconds(2),
+                        &SimpleEndDeviceLoraPhy::Send,
+                        edPhy1,
+                        packet,
+                        txParams,
+                        868.1,
+                        14);
+
+    Simulator::Stop(Hours(2));
+    Simulator::Run();
+    Simulator::Destroy();
+
+    NS_TEST_EXPECT_MSG_EQ(m_underSensitivityCalls,
+                          0,
+                          "Packets that should have arrived above sensitivity were under it");
+
+    Reset();
+
+    // Packets can be destroyed by interference
+
+    txParams.sf = 12;
+    Simulator::Schedule(Seconds(2),
+                        &SimpleEndDeviceLoraPhy::Send,
+                        edPhy1,
+                        packet,
+                        txParams,
+                        868.1,
+                        14);
+    Simulator::Schedule(Seconds(2),
+                        &SimpleEndDeviceLoraPhy::Send,
+                        edPhy3,
+                        packet,
+                        txParams,
+                        868.1,
+                        14);
+
+    Simulator::Stop(Hours(2));
+    Simulator::Run();
+    Simulator::Destroy();
+
+    NS_TEST_EXPECT_MSG_EQ(m_interferenceCalls,
+                          1,
+                          "Packets that should be destroyed by interference weren't");
+
+    Reset();
+
+    // Packets can be lost because the PHY is not listening on the right frequency
+
+    Simulator::Schedule(Seconds(2),
+                        &SimpleEndDeviceLoraPhy::Send,
+                        edPhy1,
+                        packet,
+                        txParams,
+                        868.3,
+                        14);
+
+    Simulator::Stop(Hours(2));
+    Simulator::Run();
+    Simulator::Destroy();
+
+    NS_TEST_EXPECT_MSG_EQ(m_wrongFrequencyCalls,
+                          2,
+                          "Packets were received even though PHY was on a different frequency");
+
+    Reset();
+
+    // Packets can be lost because the PHY is not listening for the right SF
+
+    txParams.sf = 8; // Send with 8, listening for 12
+    Simulator::Schedule(Seconds(2),
+                        &SimpleEndDeviceLoraPhy::Send,
+                        edPhy1,
+                        packet,
+                        txParams,
+                        868.1,
+                        14);
+
+    Simulator::Stop(Hours(2));
+    Simulator::Run();
+    Simulator::Destroy();
+
+    NS_TEST_EXPECT_MSG_EQ(m_wrongSfCalls,
+                          2,
+                          "Packets were received even though PHY was listening for a different SF");
+
+    Reset();
+
+    // Sending of packets
+    /////////////////////
+
+    // The very same packet arrives at the other PHY
+    Simulator::Schedule(Seconds(2),
+                        &SimpleEndDeviceLoraPhy::Send,
+                        edPhy1,
+                        packet,
+                        txParams,
+                        868.1,
+                        14);
+
+    Simulator::Stop(Hours(2));
+    Simulator::Run();
+    Simulator::Destroy();
+
+    NS_TEST_EXPECT_MSG_EQ(HaveSamePacketContents(packet, m_latestReceivedPacket),
+                          true,
+                          "Packet changed contents when going through the channel");
+
+    Reset();
+
+    // Correct state transitions
+    ////////////////////////////
+
+    // PHY switches to STANDBY after TX and RX
+
+    Simulator::Schedule(Seconds(2),
+                        &SimpleEndDeviceLoraPhy::Send,
+                        edPhy1,
+                        packet,
+                        txParams,
+                        868.1,
+                        14);
+
+    Simulator::Stop(Hours(2));
+    Simulator::Run();
+    Simulator::Destroy();
+
+    NS_TEST_EXPECT_MSG_EQ(edPhy1->GetState(),
+                          SimpleEndDeviceLoraPhy::STANDBY,
+                          "State didn't switch to STANDBY as expected");
+    NS_TEST_EXPECT_MSG_EQ(edPhy2->GetState(),
+                          SimpleEndDeviceLoraPhy::STANDBY,
+                          "State didn't switch to STANDBY as expected");
+
+    Reset();
+
+    // PHYs beyond the maximum range of the channel are not notified
+
+    channel->SetMaxRange(15);
+
+    Simulator::Schedule(Seconds(2),
+                        &SimpleEndDeviceLoraPhy::Send,
+                        edPhy1,
+                        packet,
+                        txParams,
+                        868.1,
+                        14);
+
+    Simulator::Stop(Hours(2));
+    Simulator::Run();
+    Simulator::Destroy();
+
+    NS_TEST_EXPECT_MSG_EQ(m_receivedPacketCalls,
+                          1,
+                          "Channel delivered a packet to a PHY beyond its maximum range");
+    NS_TEST_EXPECT_MSG_EQ(m_underSensitivityCalls,
+                          0,
+                          "Out of range PHY was notified of the transmission");
+
+    // The computed range is the distance at which the received power falls
+    // below the sensitivity
+    Ptr<LogDistancePropagationLossModel> loss = CreateObject<LogDistancePropagationLossModel>();
+    loss->SetPathLossExponent(3.76);
+    loss->SetReference(1, 7.7);
+
+    double range = LoraChannel::ComputeMaxRange(loss, 14, -130);
+    double expectedRange = std::pow(10, (14 + 130 - 7.7) / (10 * 3.76));
+
+    NS_TEST_EXPECT_MSG_EQ_TOL(range,
+                              expectedRange,
+                              1,
+                              "Computed maximum range differs from the analytical one");
+
+    // Antenna gains extend the range
+    double gainRange = LoraChannel::ComputeMaxRange(loss, 14, -130, 1e6, 6);
+    double expectedGainRange = std::pow(10, (14 + 6 + 130 - 7.7) / (10 * 3.76));
+
+    NS_TEST_EXPECT_MSG_EQ_TOL(gainRange,
+                              expectedGainRange,
+                              1,
+                              "Computed maximum range does not include the antenna gain");
+
+    Reset();
+
+    // Cached link budgets are refreshed when a PHY changes position
+
+    channel->SetAttribute("LinkBudgetCache", BooleanValue(true));
+
+    Simulator::Schedule(Seconds(2),
+                        &SimpleEndDeviceLoraPhy::Send,
+                        edPhy1,
+                        packet,
+                        txParams,
+                        868.1,
+                        14);
+
+    Simulator::Schedule(Seconds(10),
+                        &MobilityModel::SetPosition,
+                        edPhy3->GetMobility(),
+                        Vector(100000.0, 0.0, 0.0));
+
+    Simulator::Schedule(Seconds(20),
+                        &SimpleEndDeviceLoraPhy::Send,
+                        edPhy1,
+                        packet,
+                        txParams,
+                        868.1,
+                        14);
+
+    Simulator::Stop(Hours(2));
+    Simulator::Run();
+    Simulator::Destroy();
+
+    NS_TEST_EXPECT_MSG_EQ(m_receivedPacketCalls,
+                          3,
+                          "Channel used a stale link budget after a position change");
+    NS_TEST_EXPECT_MSG_EQ(m_underSensitivityCalls,
+                          1,
+                          "Channel used a stale link budget after a position change");
+
+    Reset();
+
+    // End devices only reach gateways, unless end device interference is
+    // explicitly requested
+
+    channel->SetAttribute("DeliveryPolicy", EnumValue(LoraChannel::GATEWAYS_ONLY));
+
+    Simulator::Schedule(Seconds(2),
+                        &SimpleEndDeviceLoraPhy::Send,
+                        edPhy1,
+                        packet,
+                        txParams,
+                        868.1,
+                        14);
+
+    Simulator::Stop(Hours(2));
+    Simulator::Run();
+    Simulator::Destroy();
+
+    NS_TEST_EXPECT_MSG_EQ(m_receivedPacketCalls,
+                          0,
+                          "Channel delivered an end device transmission to end devices");
+
+    Reset();
+
+    channel->SetAttribute("DeliveryPolicy", EnumValue(LoraChannel::GATEWAYS_ONLY));
+    channel->SetAttribute("EndDeviceInterference", BooleanValue(true));
+
+    Simulator::Schedule(Seconds(2),
+                        &SimpleEndDeviceLoraPhy::Send,
+                        edPhy1,
+                        packet,
+                        txParams,
+                        868.1,
+                        14);
+
+    Simulator::Stop(Hours(2));
+    Simulator::Run();
+    Simulator::Destroy();
+
+    NS_TEST_EXPECT_MSG_EQ(m_receivedPacketCalls,
+                          2,
+                          "Channel skipped end devices despite EndDeviceInterference");
+
+    Reset();
+
+    // Subscribed end devices are only notified of transmissions on their
+    // frequency while they are listening
+
+    channel->SetAttribute("EndDeviceSubscription", BooleanValue(true));
+
+    edPhy2->SwitchToSleep();
+    edPhy3->SetFrequency(868.3);
+
+    Simulator::Schedule(Seconds(2),
+                        &SimpleEndDeviceLoraPhy::Send,
+                        edPhy1,
+                        packet,
+                        txParams,
+                        868.1,
+                        14);
+
+    Simulator::Schedule(Seconds(10), &SimpleEndDeviceLoraPhy::SwitchToStandby, edPhy2);
+
+    Simulator::Schedule(Seconds(20),
+                        &SimpleEndDeviceLoraPhy::Send,
+                        edPhy1,
+                        packet,
+                        txParams,
+                        868.1,
+                        14);
+
+    Simulator::Stop(Hours(2));
+    Simulator::Run();
+    Simulator::Destroy();
+
+    NS_TEST_EXPECT_MSG_EQ(m_receivedPacketCalls,
+                          1,
+                          "Channel did not follow the subscriptions of end devices");
+    NS_TEST_EXPECT_MSG_EQ(m_wrongFrequencyCalls,
+                          0,
+                          "Channel notified an end device subscribed to another frequency");
+
+    Reset();
+
+    // In fan-out mode, all receivers are notified and PacketSent fires once
+    // per transmission
+
+    channel->SetAttribute("FanOut", BooleanValue(true));
+
+    Simulator::Schedule(Seconds(2),
+                        &SimpleEndDeviceLoraPhy::Send,
+                        edPhy1,
+                        packet,
+                        txParams,
+                        868.1,
+                        14);
+
+    Simulator::Stop(Hours(2));
+    Simulator::Run();
+    Simulator::Destroy();
+
+    NS_TEST_EXPECT_MSG_EQ(m_receivedPacketCalls,
+                          2,
+                          "Channel skipped some PHYs when delivering a packet in fan-out mode");
+    NS_TEST_EXPECT_MSG_EQ(m_packetSentCalls,
+                          1,
+                          "PacketSent was not fired once per transmission in fan-out mode");
+
+    Reset();
+
+    // The batch computation of received powers matches the scalar one, both
+    // with the log distance fast path and with the generic chain
+
+    Ptr<ConstantPositionMobilityModel> closeMobility =
+        CreateObject<ConstantPositionMobilityModel>();
+    closeMobility->SetPosition(Vector(0.5, 0.0, 0.0));
+    std::vector<Ptr<MobilityModel>> receivers = {edPhy2->GetMobility(),
+                                                 edPhy3->GetMobility(),
+                                                 closeMobility};
+
+    Ptr<LogDistancePropagationLossModel> chained = CreateObject<LogDistancePropagationLossModel>();
+    chained->SetPathLossExponent(3.76);
+    chained->SetReference(1, 7.7);
+    chained->SetNext(CreateObject<LogDistancePropagationLossModel>());
+
+    std::vector<Ptr<PropagationLossModel>> losses = {
+        CreateObject<LogDistancePropagationLossModel>(),
+        chained,
+        CreateObject<FriisPropagationLossModel>()};
+
+    for (const auto& loss : losses)
+    {
+        channel->SetAttribute("PropagationLossModel", PointerValue(loss));
+
+        std::vector<double> rxPowers;
+        channel->GetRxPower(14, edPhy1->GetMobility(), receivers, rxPowers);
+
+        NS_TEST_ASSERT_MSG_EQ(rxPowers.size(), receivers.size(), "Wrong number of powers");
+        for (std::size_t k = 0; k < receivers.size(); k++)
+        {
+            NS_TEST_EXPECT_MSG_EQ(rxPowers[k],
+                                  channel->GetRxPower(14, edPhy1->GetMobility(), receivers[k]),
+                                  "Batch received power differs from the scalar one");
+        }
+    }
+
+    // The shadowing and building penetration models of the complete network
+    // example are applied to all receivers at once, with the same random
+    // draws as the scalar chain
+
+    Ptr<Building> building = CreateObject<Building>();
+    building->SetBoundaries(Box(0, 20, 0, 20, 0, 10));
+    NodeContainer nodes;
+    nodes.Create(4);
+    MobilityHelper mobility;
+    Ptr<ListPositionAllocator> allocator = CreateObject<ListPositionAllocator>();
+    allocator->Add(Vector(300, 200, 1));
+    allocator->Add(Vector(5, 5, 1));
+    allocator->Add(Vector(15, 15, 1));
+    allocator->Add(Vector(1000, 0, 1));
+    mobility.SetPositionAllocator(allocator);
+    mobility.SetMobilityModel("ns3::ConstantPositionMobilityModel");
+    mobility.Install(nodes);
+    BuildingsHelper::Install(nodes);
+
+    Ptr<MobilityModel> chainSender = nodes.Get(0)->GetObject<MobilityModel>();
+    std::vector<Ptr<MobilityModel>> chainReceivers;
+    for (uint32_t k = 1; k < nodes.GetN(); k++)
+    {
+        chainReceivers.push_back(nodes.Get(k)->GetObject<MobilityModel>());
+    }
+
+    std::vector<double> batchPowers;
+    std::vector<double> scalarPowers;
+    for (bool batch : {true, false})
+    {
+        // Identical chains with the same streams, so that both see the same
+        // random values if they are drawn in the same order
+        Ptr<LogDistancePropagationLossModel> logDistance =
+            CreateObject<LogDistancePropagationLossModel>();
+        Ptr<CorrelatedShadowingPropagationLossModel> shadowing =
+            CreateObject<CorrelatedShadowingPropagationLossModel>();
+        shadowing->SetAttribute("CounterBased", BooleanValue(true));
+        logDistance->SetNext(shadowing);
+        shadowing->SetNext(CreateObject<BuildingPenetrationLoss>());
+        logDistance->AssignStreams(10);
+        channel->SetAttribute("PropagationLossModel", PointerValue(logDistance));
+
+        // Evaluate every link twice, so that the random parts are drawn again
+        for (int repetition = 0; repetition < 2; repetition++)
+        {
+            if (batch)
+            {
+                std::vector<double> rxPowers;
+                channel->GetRxPower(14, chainSender, chainReceivers, rxPowers);
+                batchPowers.insert(batchPowers.end(), rxPowers.begin(), rxPowers.end());
+            }
+            else
+            {
+                for (const auto& receiver : chainReceivers)
+                {
+                    scalarPowers.push_back(channel->GetRxPower(14, chainSender, receiver));
+                }
+            }
+        }
+    }
+
+    NS_TEST_ASSERT_MSG_EQ(batchPowers.size(), scalarPowers.size(), "Wrong number of powers");
+    for (std::size_t k = 0; k < batchPowers.size(); k++)
+    {
+        NS_TEST_EXPECT_MSG_EQ(batchPowers[k],
+                              scalarPowers[k],
+                              "Batch received power differs from the scalar chain");
+    }
+
+    Simulator::Destroy();
+}
+
+/**************************
+ * ParallelLinkBudgetTest *
+ **************************/
+
+class ParallelLinkBudgetTest : public TestCase
+{
+  public:
+    ParallelLinkBudgetTest();
+    ~ParallelLinkBudgetTest() override;
+
+  private:
+    void DoRun() override;
+    std::vector<std::string> RunScenario(uint32_t nThreads, bool linkBudgetCache);
+    void ReceivedPacket(std::string context, Ptr<const Packet> packet, uint32_t node);
+    void UnderSensitivity(std::string context, Ptr<const Packet> packet, uint32_t node);
+    void ReceiveOk(Ptr<const Packet> packet);
+
+    std::vector<std::string> m_trace;
+};
+
+// Add some help text to this case to describe what it is intended to test
+ParallelLinkBudgetTest::ParallelLinkBudgetTest()
+    : TestCase("Verify that computing link budgets in parallel does not change the results")
+{
+}
 
-    // Listen on a specific frequency
-    edPhy1->SetFrequency(868.1);
-    edPhy2->SetFrequency(868.1);
-    edPhy3->SetFrequency(868.1);
+// Reminder that the test case should clean up after itself
+ParallelLinkBudgetTest::~ParallelLinkBudgetTest()
+{
+}
 
-    edPhy1->TraceConnectWithoutContext("ReceivedPacket",
-                                       MakeCallback(&PhyConnectivityTest::ReceivedPacket, this));
-    edPhy2->TraceConnectWithoutContext("ReceivedPacket",
-                                       MakeCallback(&PhyConnectivityTest::ReceivedPacket, this));
-    edPhy3->TraceConnectWithoutContext("ReceivedPacket",
-                                       MakeCallback(&PhyConnectivityTest::ReceivedPacket, this));
+void
+ParallelLinkBudgetTest::ReceivedPacket(std::string context, Ptr<const Packet> packet, uint32_t node)
+{
+    std::ostringstream entry;
+    entry << Simulator::Now().GetTimeStep() << " " << context << " received";
+    m_trace.push_back(entry.str());
+}
 
-    edPhy1->TraceConnectWithoutContext("LostPacketBecauseUnderSensitivity",
-                                       MakeCallback(&PhyConnectivityTest::UnderSensitivity, this));
-    edPhy2->TraceConnectWithoutContext("LostPacketBecauseUnderSensitivity",
-                                       MakeCallback(&PhyConnectivityTest::UnderSensitivity, this));
-    edPhy3->TraceConnectWithoutContext("LostPacketBecauseUnderSensitivity",
-                                       MakeCallback(&PhyConnectivityTest::UnderSensitivity, this));
+void
+ParallelLinkBudgetTest::UnderSensitivity(std::string context,
+                                         Ptr<const Packet> packet,
+                                         uint32_t node)
+{
+    std::ostringstream entry;
+    entry << Simulator::Now().GetTimeStep() << " " << context << " under sensitivity";
+    m_trace.push_back(entry.str());
+}
 
-    edPhy1->TraceConnectWithoutContext("LostPacketBecauseInterference",
-                                       MakeCallback(&PhyConnectivityTest::Interference, this));
-    edPhy2->TraceConnectWithoutContext("LostPacketBecauseInterference",
-                                       MakeCallback(&PhyConnectivityTest::Interference, this));
-    edPhy3->TraceConnectWithoutContext("LostPacketBecauseInterference",
-                                       MakeCallback(&PhyConnectivityTest::Interference, this));
+void
+ParallelLinkBudgetTest::ReceiveOk(Ptr<const Packet> packet)
+{
+    LoraTag tag;
+    packet->PeekPacketTag(tag);
 
-    edPhy1->TraceConnectWithoutContext(
-        "LostPacketBecauseNoMoreReceivers",
-        MakeCallback(&PhyConnectivityTest::NoMoreDemodulators, this));
-    edPhy2->TraceConnectWithoutContext(
-        "LostPacketBecauseNoMoreReceivers",
-        MakeCallback(&PhyConnectivityTest::NoMoreDemodulators, this));
-    edPhy3->TraceConnectWithoutContext(
-        "LostPacketBecauseNoMoreReceivers",
-        MakeCallback(&PhyConnectivityTest::NoMoreDemodulators, this));
+    std::ostringstream entry;
+    entry << Simulator::Now().GetTimeStep() << " " << std::setprecision(17)
+          << tag.GetReceivePower();
+    m_trace.push_back(entry.str());
+}
 
-    edPhy1->TraceConnectWithoutContext("LostPacketBecauseWrongFrequency",
-                                       MakeCallback(&PhyConnectivityTest::WrongFrequency, this));
-    edPhy2->TraceConnectWithoutContext("LostPacketBecauseWrongFrequency",
-                                       MakeCallback(&PhyConnectivityTest::WrongFrequency, this));
-    edPhy3->TraceConnectWithoutContext("LostPacketBecauseWrongFrequency",
-                                       MakeCallback(&PhyConnectivityTest::WrongFrequency, this));
+std::vector<std::string>
+ParallelLinkBudgetTest::RunScenario(uint32_t nThreads, bool linkBudgetCache)
+{
+    m_trace.clear();
 
-    edPhy1->TraceConnectWithoutContext("LostPacketBecauseWrongSpreadingFactor",
-                                       MakeCallback(&PhyConnectivityTest::WrongSf, this));
-    edPhy2->TraceConnectWithoutContext("LostPacketBecauseWrongSpreadingFactor",
-                                       MakeCallback(&PhyConnectivityTest::WrongSf, this));
-    edPhy3->TraceConnectWithoutContext("LostPacketBecauseWrongSpreadingFactor",
-                                       MakeCallback(&PhyConnectivityTest::WrongSf, this));
+    // A log distance loss followed by a random one, so that both the
+    // parallel and the serial parts of the computation are used
+    Ptr<LogDistancePropagationLossModel> loss = CreateObject<LogDistancePropagationLossModel>();
+    loss->SetPathLossExponent(3.76);
+    loss->SetReference(1, 7.7);
+    Ptr<RandomPropagationLossModel> randomLoss = CreateObject<RandomPropagationLossModel>();
+    randomLoss->SetAttribute("Variable", StringValue("ns3::UniformRandomVariable[Max=10]"));
+    randomLoss->AssignStreams(0);
+    loss->SetNext(randomLoss);
+
+    Ptr<PropagationDelayModel> delay = CreateObject<ConstantSpeedPropagationDelayModel>();
+
+    Ptr<LoraChannel> channel = CreateObject<LoraChannel>(loss, delay);
+    channel->SetAttribute("LinkBudgetThreads", UintegerValue(nThreads));
+    channel->SetAttribute("LinkBudgetCache", BooleanValue(linkBudgetCache));
+
+    Ptr<SimpleEndDeviceLoraPhy> edPhy = CreateObject<SimpleEndDeviceLoraPhy>();
+    Ptr<ConstantPositionMobilityModel> edMobility = CreateObject<ConstantPositionMobilityModel>();
+    edMobility->SetPosition(Vector(0.0, 0.0, 0.0));
+    edPhy->SetMobility(edMobility);
+    edPhy->SwitchToStandby();
+    channel->Add(edPhy);
+    edPhy->SetChannel(channel);
+
+    // Gateways on a spiral around the device, some of which are out of range
+    std::vector<Ptr<SimpleGatewayLoraPhy>> gatewayPhys;
+    for (int k = 0; k < 300; k++)
+    {
+        Ptr<SimpleGatewayLoraPhy> gatewayPhy = CreateObject<SimpleGatewayLoraPhy>();
+        Ptr<ConstantPositionMobilityModel> mobility =
+            CreateObject<ConstantPositionMobilityModel>();
+        double distance = 100 + 20 * k;
+        mobility->SetPosition(
+            Vector(distance * std::cos(2.4 * k), distance * std::sin(2.4 * k), 15.0));
+        gatewayPhy->SetMobility(mobility);
+        gatewayPhy->AddFrequency(868.1);
+        for (int path = 0; path < 8; path++)
+        {
+            gatewayPhy->AddReceptionPath();
+        }
+        gatewayPhy->TraceConnect("ReceivedPacket",
+                                 std::to_string(k),
+                                 MakeCallback(&ParallelLinkBudgetTest::ReceivedPacket, this));
+        gatewayPhy->TraceConnect("LostPacketBecauseUnderSensitivity",
+                                 std::to_string(k),
+                                 MakeCallback(&ParallelLinkBudgetTest::UnderSensitivity, this));
+        gatewayPhy->SetReceiveOkCallback(MakeCallback(&ParallelLinkBudgetTest::ReceiveOk, this));
+        channel->Add(gatewayPhy);
+        gatewayPhy->SetChannel(channel);
+        gatewayPhys.push_back(gatewayPhy);
+    }
+
+    LoraTxParameters txParams;
+    txParams.sf = 7;
+
+    for (double time : {1.0, 10.0, 20.0})
+    {
+        uint8_t buffer[10] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+        Simulator::Schedule(Seconds(time),
+                            &SimpleEndDeviceLoraPhy::Send,
+                            edPhy,
+                            Create<Packet>(buffer, 10),
+                            txParams,
+                            868.1,
+                            14);
+    }
+
+    Simulator::Stop(Hours(1));
+    Simulator::Run();
+    Simulator::Destroy();
+
+    return m_trace;
+}
+
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+ParallelLinkBudgetTest::DoRun()
+{
+    NS_LOG_DEBUG("ParallelLinkBudgetTest");
+
+    for (bool linkBudgetCache : {false, true})
+    {
+        std::vector<std::string> serialTrace = RunScenario(1, linkBudgetCache);
+        std::vector<std::string> parallelTrace = RunScenario(4, linkBudgetCache);
+
+        NS_TEST_ASSERT_MSG_EQ(serialTrace.empty(), false, "No reception was traced");
+        NS_TEST_ASSERT_MSG_EQ(parallelTrace.size(),
+                              serialTrace.size(),
+                              "Different number of trace entries with multiple threads");
+        for (std::size_t k = 0; k < serialTrace.size(); k++)
+        {
+            NS_TEST_EXPECT_MSG_EQ(parallelTrace[k],
+                                  serialTrace[k],
+                                  "Different trace entries with multiple threads");
+        }
+    }
+}
+
+/***************************
+ * CorrelatedShadowingTest *
+ ***************************/
+
+class CorrelatedShadowingTest : public TestCase
+{
+  public:
+    CorrelatedShadowingTest();
+    ~CorrelatedShadowingTest() override;
+
+  private:
+    void DoRun() override;
+    double GetShadowing(Ptr<CorrelatedShadowingPropagationLossModel> shadowing,
+                        Vector sender,
+                        Vector receiver);
+};
+
+// Add some help text to this case to describe what it is intended to test
+CorrelatedShadowingTest::CorrelatedShadowingTest()
+    : TestCase("Verify that counter-based correlated shadowing is reproducible")
+{
+}
+
+// Reminder that the test case should clean up after itself
+CorrelatedShadowingTest::~CorrelatedShadowingTest()
+{
+}
+
+double
+CorrelatedShadowingTest::GetShadowing(Ptr<CorrelatedShadowingPropagationLossModel> shadowing,
+                                      Vector sender,
+                                      Vector receiver)
+{
+    Ptr<ConstantPositionMobilityModel> a = CreateObject<ConstantPositionMobilityModel>();
+    a->SetPosition(sender);
+    Ptr<ConstantPositionMobilityModel> b = CreateObject<ConstantPositionMobilityModel>();
+    b->SetPosition(receiver);
+    return -shadowing->CalcRxPower(0, a, b);
+}
+
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+CorrelatedShadowingTest::DoRun()
+{
+    NS_LOG_DEBUG("CorrelatedShadowingTest");
+
+    Ptr<CorrelatedShadowingPropagationLossModel> first =
+        CreateObject<CorrelatedShadowingPropagationLossModel>();
+    first->SetAttribute("CounterBased", BooleanValue(true));
+    NS_TEST_EXPECT_MSG_EQ(first->AssignStreams(5), 1, "Wrong number of streams");
+
+    Ptr<CorrelatedShadowingPropagationLossModel> second =
+        CreateObject<CorrelatedShadowingPropagationLossModel>();
+    second->SetAttribute("CounterBased", BooleanValue(true));
+    second->AssignStreams(5);
+
+    Ptr<CorrelatedShadowingPropagationLossModel> other =
+        CreateObject<CorrelatedShadowingPropagationLossModel>();
+    other->SetAttribute("CounterBased", BooleanValue(true));
+    other->AssignStreams(6);
+
+    // Query the same positions in opposite orders
+    Vector sender(10, -20, 0);
+    std::vector<Vector> receivers;
+    for (int k = 0; k < 50; k++)
+    {
+        receivers.emplace_back(37.5 * k - 900, 1000 - 41.25 * k, 0);
+    }
+    std::vector<double> values;
+    for (const auto& receiver : receivers)
+    {
+        values.push_back(GetShadowing(first, sender, receiver));
+    }
+    bool differs = false;
+    for (int k = receivers.size() - 1; k >= 0; k--)
+    {
+        NS_TEST_EXPECT_MSG_EQ(GetShadowing(second, sender, receivers[k]),
+                              values[k],
+                              "Shadowing depends on the order of the queries");
+        NS_TEST_EXPECT_MSG_EQ(GetShadowing(first, sender, receivers[k]),
+                              values[k],
+                              "Shadowing changes when queried again");
+        differs |= GetShadowing(other, sender, receivers[k]) != values[k];
+    }
+    NS_TEST_EXPECT_MSG_EQ(differs, true, "Shadowing does not depend on the stream");
+
+    // An automatic stream and an assigned stream with the same index differ
+    Ptr<CorrelatedShadowingPropagationLossModel> automatic =
+        CreateObject<CorrelatedShadowingPropagationLossModel>();
+    automatic->SetAttribute("CounterBased", BooleanValue(true));
+    uint64_t index = RngSeedManager::GetNextStreamIndex() + 1;
+    double automaticValue = GetShadowing(automatic, sender, receivers[0]);
+    Ptr<CorrelatedShadowingPropagationLossModel> assigned =
+        CreateObject<CorrelatedShadowingPropagationLossModel>();
+    assigned->SetAttribute("CounterBased", BooleanValue(true));
+    assigned->AssignStreams(index);
+    NS_TEST_EXPECT_MSG_NE(GetShadowing(assigned, sender, receivers[0]),
+                          automaticValue,
+                          "Automatic and assigned streams share their values");
+
+    // Neighbouring squares share the vertex at (55, 55)
+    NS_TEST_EXPECT_MSG_EQ_TOL(GetShadowing(first, sender, Vector(54.999, 55, 0)),
+                              GetShadowing(first, sender, Vector(55, 55, 0)),
+                              0.01,
+                              "Neighbouring squares do not share their vertices");
+
+    // Values at the vertices follow the distribution of the shadowing
+    double sum = 0;
+    double squares = 0;
+    int n = 0;
+    for (int i = -30; i < 30; i++)
+    {
+        for (int j = -30; j < 30; j++)
+        {
+            double value = GetShadowing(first, sender, Vector(110 * i + 55, 110 * j + 55, 0));
+            sum += value;
+            squares += value * value;
+            n++;
+        }
+    }
+    double mean = sum / n;
+    double deviation = std::sqrt(squares / n - mean * mean);
+    NS_TEST_EXPECT_MSG_EQ_TOL(mean, 0, 0.5, "Wrong mean of the shadowing");
+    NS_TEST_EXPECT_MSG_EQ_TOL(deviation, 4, 0.4, "Wrong standard deviation of the shadowing");
+
+    // Stored shadowing values also share the vertices of neighbouring squares
+    Ptr<CorrelatedShadowingPropagationLossModel> stored =
+        CreateObject<CorrelatedShadowingPropagationLossModel>();
+    NS_TEST_EXPECT_MSG_EQ(stored->AssignStreams(7), 0, "Stored shadowing maps use no stream");
+    double left = GetShadowing(stored, sender, Vector(54.9, 55, 0));
+    double right = GetShadowing(stored, sender, Vector(55.1, 55, 0));
+    NS_TEST_EXPECT_MSG_EQ_TOL(left,
+                              right,
+                              0.1,
+                              "Neighbouring squares do not share their vertices");
+    NS_TEST_EXPECT_MSG_EQ(GetShadowing(stored, sender, Vector(54.92, 55.01, 0)),
+                          left,
+                          "Close positions do not share their shadowing value");
+}
+
+/**************
+ * RasterTest *
+ **************/
+
+class RasterTest : public TestCase
+{
+  public:
+    RasterTest();
+    ~RasterTest() override;
+
+  private:
+    void DoRun() override;
+};
+
+// Add some help text to this case to describe what it is intended to test
+RasterTest::RasterTest()
+    : TestCase("Verify that losses are correctly read from raster files")
+{
+}
+
+// Reminder that the test case should clean up after itself
+RasterTest::~RasterTest()
+{
+}
+
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+RasterTest::DoRun()
+{
+    NS_LOG_DEBUG("RasterTest");
+
+    // A linear loss is interpolated exactly. The raster does not fill its
+    // last row and column of tiles.
+    auto linearLoss = [](double x, double y) { return 80 + 0.5 * x - 0.25 * y; };
+
+    RasterPropagationLossModel::RasterInfo info;
+    info.originX = -100;
+    info.originY = 50;
+    info.resolution = 10;
+    info.width = 11;
+    info.height = 7;
+    info.tileSize = 4;
+    std::string fieldFilename = CreateTempDirFilename("field.raster");
+    RasterPropagationLossModel::WriteRaster(fieldFilename, info, linearLoss);
+
+    // The loss of the links with a gateway grows with the distance from it
+    info.hasAnchor = true;
+    info.anchor = Vector(-40, 80, 15);
+    std::string anchoredFilename = CreateTempDirFilename("anchored.raster");
+    RasterPropagationLossModel::WriteRaster(anchoredFilename, info, [&info](double x, double y) {
+        return 100 + std::abs(x - info.anchor.x) + std::abs(y - info.anchor.y);
+    });
+
+    Ptr<RasterPropagationLossModel> raster = CreateObject<RasterPropagationLossModel>();
+    raster->SetAttribute("Filename", StringValue(fieldFilename));
+    raster->AddRaster(anchoredFilename);
+
+    Ptr<ConstantPositionMobilityModel> a = CreateObject<ConstantPositionMobilityModel>();
+    Ptr<ConstantPositionMobilityModel> b = CreateObject<ConstantPositionMobilityModel>();
+    a->SetPosition(Vector(1000, 1000, 0));
+
+    for (const auto& position : {Vector(-100, 50, 0), Vector(-33.3, 77.7, 0), Vector(0, 110, 0)})
+    {
+        b->SetPosition(position);
+        NS_TEST_EXPECT_MSG_EQ_TOL(raster->CalcRxPower(14, a, b),
+                                  14 - linearLoss(position.x, position.y),
+                                  1e-3,
+                                  "Wrong interpolated loss");
+    }
+
+    // Positions outside of the raster take the value of the closest edge
+    b->SetPosition(Vector(-500, 60, 0));
+    NS_TEST_EXPECT_MSG_EQ_TOL(raster->CalcRxPower(14, a, b),
+                              14 - linearLoss(-100, 60),
+                              1e-3,
+                              "Wrong loss outside of the raster");
+
+    // Links with the anchor use the anchored raster in both directions
+    a->SetPosition(Vector(-40.2, 80.3, 15));
+    b->SetPosition(Vector(-5, 62.5, 0));
+    NS_TEST_EXPECT_MSG_EQ_TOL(raster->CalcRxPower(14, a, b),
+                              14 - 100 - 35 - 17.5,
+                              1e-3,
+                              "Wrong loss to the anchor");
+    NS_TEST_EXPECT_MSG_EQ_TOL(raster->CalcRxPower(14, b, a),
+                              14 - 100 - 35 - 17.5,
+                              1e-3,
+                              "Wrong loss from the anchor");
+
+    // Anchors apply up to 1 m away in any direction, regardless of how the
+    // coordinates round
+    info.anchor = Vector(10.5, 80, 15);
+    std::string otherFilename = CreateTempDirFilename("other-anchored.raster");
+    RasterPropagationLossModel::WriteRaster(otherFilename, info, [](double x, double y) {
+        return 120.0;
+    });
+    raster->AddRaster(otherFilename);
+    for (const auto& position :
+         {Vector(10.4, 80, 15), Vector(9.9, 80, 15), Vector(10.5, 79.2, 15.5)})
+    {
+        a->SetPosition(position);
+        NS_TEST_EXPECT_MSG_EQ_TOL(raster->CalcRxPower(14, a, b),
+                                  14 - 120,
+                                  1e-3,
+                                  "Anchored raster not used within 1 m of the anchor");
+    }
+    a->SetPosition(Vector(10.5, 80, 16.5));
+    NS_TEST_EXPECT_MSG_EQ_TOL(raster->CalcRxPower(14, a, b),
+                              14 - linearLoss(b->GetPosition().x, b->GetPosition().y),
+                              1e-3,
+                              "Anchored raster used farther than 1 m from the anchor");
+}
+
+/*******************************
+ * BuildingPenetrationLossTest *
+ *******************************/
+
+class BuildingPenetrationLossTest : public TestCase
+{
+  public:
+    BuildingPenetrationLossTest();
+    ~BuildingPenetrationLossTest() override;
+
+  private:
+    void DoRun() override;
+};
+
+// Add some help text to this case to describe what it is intended to test
+BuildingPenetrationLossTest::BuildingPenetrationLossTest()
+    : TestCase("Verify that the per-node building information is correctly cached")
+{
+}
+
+// Reminder that the test case should clean up after itself
+BuildingPenetrationLossTest::~BuildingPenetrationLossTest()
+{
+}
+
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+BuildingPenetrationLossTest::DoRun()
+{
+    NS_LOG_DEBUG("BuildingPenetrationLossTest");
+
+    Ptr<Building> building = CreateObject<Building>();
+    building->SetBoundaries(Box(0, 20, 0, 20, 0, 10));
+
+    // Two nodes in the building, and two outdoor nodes
+    NodeContainer nodes;
+    nodes.Create(4);
+    MobilityHelper mobility;
+    Ptr<ListPositionAllocator> allocator = CreateObject<ListPositionAllocator>();
+    allocator->Add(Vector(5, 5, 1));
+    allocator->Add(Vector(15, 15, 1));
+    allocator->Add(Vector(100, 100, 1));
+    allocator->Add(Vector(200, 100, 1));
+    mobility.SetPositionAllocator(allocator);
+    mobility.SetMobilityModel("ns3::ConstantPositionMobilityModel");
+    mobility.Install(nodes);
+    BuildingsHelper::Install(nodes);
+
+    Ptr<MobilityModel> indoor = nodes.Get(0)->GetObject<MobilityModel>();
+    Ptr<MobilityModel> otherIndoor = nodes.Get(1)->GetObject<MobilityModel>();
+    Ptr<MobilityModel> outdoor = nodes.Get(2)->GetObject<MobilityModel>();
+    Ptr<MobilityModel> otherOutdoor = nodes.Get(3)->GetObject<MobilityModel>();
+
+    Ptr<BuildingPenetrationLoss> loss = CreateObject<BuildingPenetrationLoss>();
+    loss->AssignStreams(1);
+
+    NS_TEST_EXPECT_MSG_EQ_TOL(loss->CalcRxPower(0, outdoor, otherOutdoor),
+                              0,
+                              1e-9,
+                              "Outdoor nodes should see no penetration loss");
+    NS_TEST_EXPECT_MSG_LT(loss->CalcRxPower(0, outdoor, indoor),
+                          -4,
+                          "Indoor nodes should see at least the external wall loss");
+
+    // Moving a node outdoors must update its cached indoor flag
+    indoor->SetPosition(Vector(50, 50, 1));
+    NS_TEST_EXPECT_MSG_EQ_TOL(loss->CalcRxPower(0, outdoor, indoor),
+                              0,
+                              1e-9,
+                              "The indoor flag of a moving node was not updated");
+    indoor->SetPosition(Vector(5, 5, 1));
+
+    // Frozen losses are drawn once, and shared by both directions
+    loss->SetAttribute("FreezeLinkLoss", BooleanValue(true));
+    double frozen = loss->CalcRxPower(0, outdoor, indoor);
+    NS_TEST_EXPECT_MSG_EQ(loss->CalcRxPower(0, outdoor, indoor),
+                          frozen,
+                          "The loss of a frozen link changed");
+    NS_TEST_EXPECT_MSG_EQ(loss->CalcRxPower(0, indoor, outdoor),
+                          frozen,
+                          "The loss of a frozen link is not reciprocal");
+    double sameBuilding = loss->CalcRxPower(0, indoor, otherIndoor);
+    NS_TEST_EXPECT_MSG_LT_OR_EQ(sameBuilding, 0, "The loss should not be negative");
+    NS_TEST_EXPECT_MSG_EQ(loss->CalcRxPower(0, otherIndoor, indoor),
+                          sameBuilding,
+                          "The loss of a frozen link is not reciprocal");
+
+    Simulator::Destroy();
+}
+
+/*********************
+ * GatewaySectorTest *
+ *********************/
+
+class GatewaySectorTest : public TestCase
+{
+  public:
+    GatewaySectorTest();
+    ~GatewaySectorTest() override;
+
+  private:
+    void DoRun() override;
+    bool DeviceReceive(Ptr<NetDevice> device,
+                       Ptr<const Packet> packet,
+                       uint16_t protocol,
+                       const Address& sender);
+    void DroppedDuplicate(Ptr<const Packet> packet);
+
+    std::vector<double> m_forwardedRxPowers;
+    int m_droppedDuplicates = 0;
+};
+
+// Add some help text to this case to describe what it is intended to test
+GatewaySectorTest::GatewaySectorTest()
+    : TestCase("Verify that the sectors of a gateway apply their antenna gain and that their "
+               "duplicates are forwarded once")
+{
+}
+
+// Reminder that the test case should clean up after itself
+GatewaySectorTest::~GatewaySectorTest()
+{
+}
+
+bool
+GatewaySectorTest::DeviceReceive(Ptr<NetDevice> device,
+                                 Ptr<const Packet> packet,
+                                 uint16_t protocol,
+                                 const Address& sender)
+{
+    LoraTag tag;
+    packet->PeekPacketTag(tag);
+    m_forwardedRxPowers.push_back(tag.GetReceivePower());
+    return true;
+}
+
+void
+GatewaySectorTest::DroppedDuplicate(Ptr<const Packet> packet)
+{
+    m_droppedDuplicates++;
+}
+
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+GatewaySectorTest::DoRun()
+{
+    NS_LOG_DEBUG("GatewaySectorTest");
+
+    Ptr<LogDistancePropagationLossModel> loss = CreateObject<LogDistancePropagationLossModel>();
+    loss->SetPathLossExponent(3.76);
+    loss->SetReference(1, 7.7);
+    Ptr<PropagationDelayModel> delay = CreateObject<ConstantSpeedPropagationDelayModel>();
+    Ptr<LoraChannel> channel = CreateObject<LoraChannel>(loss, delay);
+    channel->SetAttribute("LinkBudgetCache", BooleanValue(true));
+
+    Ptr<SimpleEndDeviceLoraPhy> edPhy = CreateObject<SimpleEndDeviceLoraPhy>();
+    Ptr<ConstantPositionMobilityModel> edMobility = CreateObject<ConstantPositionMobilityModel>();
+    edMobility->SetPosition(Vector(0.0, 0.0, 0.0));
+    edPhy->SetMobility(edMobility);
+    edPhy->SwitchToStandby();
+    channel->Add(edPhy);
+    edPhy->SetChannel(channel);
+
+    // A gateway with two sectors sharing the mobility model of the node, only
+    // the first of which has an antenna gain
+    Ptr<Node> gateway = CreateObject<Node>();
+    Ptr<ConstantPositionMobilityModel> gwMobility = CreateObject<ConstantPositionMobilityModel>();
+    gwMobility->SetPosition(Vector(1000.0, 0.0, 15.0));
+    gateway->AggregateObject(gwMobility);
+
+    Ptr<LoraNetDevice> device = CreateObject<LoraNetDevice>();
+    std::vector<Ptr<SimpleGatewayLoraPhy>> sectorPhys;
+    for (int k = 0; k < 2; k++)
+    {
+        Ptr<SimpleGatewayLoraPhy> sectorPhy = CreateObject<SimpleGatewayLoraPhy>();
+        sectorPhy->AddFrequency(868.1);
+        for (int path = 0; path < 8; path++)
+        {
+            sectorPhy->AddReceptionPath();
+        }
+        sectorPhy->SetDevice(device);
+        channel->Add(sectorPhy);
+        sectorPhy->SetChannel(channel);
+        sectorPhys.push_back(sectorPhy);
+    }
+    Ptr<IsotropicAntennaModel> antenna = CreateObject<IsotropicAntennaModel>();
+    antenna->SetAttribute("Gain", DoubleValue(6));
+    sectorPhys[0]->SetAntenna(antenna);
+    device->SetPhy(sectorPhys[0]);
+    device->AddPhy(sectorPhys[1]);
+
+    Ptr<GatewayLorawanMac> mac = CreateObject<GatewayLorawanMac>();
+    mac->SetDevice(device);
+    mac->TraceConnectWithoutContext("DroppedDuplicate",
+                                    MakeCallback(&GatewaySectorTest::DroppedDuplicate, this));
+    device->SetMac(mac);
+    device->SetReceiveCallback(MakeCallback(&GatewaySectorTest::DeviceReceive, this));
+    gateway->AddDevice(device);
+
+    NS_TEST_ASSERT_MSG_EQ(device->GetNPhys(), 2, "The gateway should have two PHYs");
+
+    // Send twice, so that the second packet uses the cached link budget
+    LoraTxParameters txParams;
+    txParams.sf = 7;
+    for (double time : {1.0, 10.0})
+    {
+        Ptr<Packet> packet = Create<Packet>(10);
+        LorawanMacHeader macHdr;
+        macHdr.SetMType(LorawanMacHeader::UNCONFIRMED_DATA_UP);
+        packet->AddHeader(macHdr);
+        Simulator::Schedule(Seconds(time),
+                            &SimpleEndDeviceLoraPhy::Send,
+                            edPhy,
+                            packet,
+                            txParams,
+                            868.1,
+                            14);
+    }
+
+    Simulator::Stop(Hours(1));
+    Simulator::Run();
+
+    double expected = loss->CalcRxPower(14, edMobility, gwMobility) + 6;
+    NS_TEST_ASSERT_MSG_EQ(m_forwardedRxPowers.size(), 2, "Each packet should be forwarded once");
+    NS_TEST_EXPECT_MSG_EQ(m_droppedDuplicates, 2, "The copy of each packet should be dropped");
+    for (double rxPowerDbm : m_forwardedRxPowers)
+    {
+        NS_TEST_EXPECT_MSG_EQ_TOL(rxPowerDbm,
+                                  expected,
+                                  1e-9,
+                                  "The copy with the antenna gain should be forwarded");
+    }
+
+    Simulator::Destroy();
+}
+
+/*****************************
+ * GatewaySectorDownlinkTest *
+ *****************************/
+
+class GatewaySectorDownlinkTest : public TestCase
+{
+  public:
+    GatewaySectorDownlinkTest();
+    ~GatewaySectorDownlinkTest() override;
+
+  private:
+    void DoRun() override;
+    void CheckTransmitting(bool expected);
+    void SectorRxBegin(Ptr<const Packet> packet);
+    void SectorReceived(Ptr<const Packet> packet, uint32_t node);
+    void SectorInterrupted(Ptr<const Packet> packet, uint32_t node);
+    void EndDeviceReceived(Ptr<const Packet> packet, uint32_t node);
+
+    std::vector<Ptr<SimpleGatewayLoraPhy>> m_sectorPhys;
+    int m_sectorRxBegins = 0;
+    int m_sectorReceptions = 0;
+    int m_sectorInterruptions = 0;
+    int m_endDeviceReceptions = 0;
+};
+
+// Add some help text to this case to describe what it is intended to test
+GatewaySectorDownlinkTest::GatewaySectorDownlinkTest()
+    : TestCase("Verify that a downlink from a sector of a gateway puts all its sectors in TX mode "
+               "and is not delivered to them")
+{
+}
+
+// Reminder that the test case should clean up after itself
+GatewaySectorDownlinkTest::~GatewaySectorDownlinkTest()
+{
+}
+
+void
+GatewaySectorDownlinkTest::CheckTransmitting(bool expected)
+{
+    for (const auto& phy : m_sectorPhys)
+    {
+        NS_TEST_EXPECT_MSG_EQ(phy->IsTransmitting(), expected, "Wrong TX state of a sector");
+    }
+}
+
+void
+GatewaySectorDownlinkTest::SectorRxBegin(Ptr<const Packet> packet)
+{
+    m_sectorRxBegins++;
+}
+
+void
+GatewaySectorDownlinkTest::SectorReceived(Ptr<const Packet> packet, uint32_t node)
+{
+    m_sectorReceptions++;
+}
+
+void
+GatewaySectorDownlinkTest::SectorInterrupted(Ptr<const Packet> packet, uint32_t node)
+{
+    m_sectorInterruptions++;
+}
+
+void
+GatewaySectorDownlinkTest::EndDeviceReceived(Ptr<const Packet> packet, uint32_t node)
+{
+    m_endDeviceReceptions++;
 }
 
 // This method is the pure virtual method from class TestCase that every
 // TestCase must implement
 void
-PhyConnectivityTest::DoRun()
+GatewaySectorDownlinkTest::DoRun()
 {
-    NS_LOG_DEBUG("PhyConnectivityTest");
-
-    // Setup
-    ////////
-
-    Reset();
-
-    LoraTxParameters txParams;
-    txParams.sf = 12;
-
-    uint8_t buffer[10] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
-    Ptr<Packet> packet = Create<Packet>(buffer, 10);
+    NS_LOG_DEBUG("GatewaySectorDownlinkTest");
 
-    // Testing
-    //////////
+    Ptr<LogDistancePropagationLossModel> loss = CreateObject<LogDistancePropagationLossModel>();
+    loss->SetPathLossExponent(3.76);
+    loss->SetReference(1, 7.7);
+    Ptr<PropagationDelayModel> delay = CreateObject<ConstantSpeedPropagationDelayModel>();
+    Ptr<LoraChannel> channel = CreateObject<LoraChannel>(loss, delay);
 
-    // Basic packet delivery test
-    /////////////////////////////
+    // A gateway with three sectors, each with a directional antenna
+    Ptr<Node> gateway = CreateObject<Node>();
+    Ptr<ConstantPositionMobilityModel> gwMobility = CreateObject<ConstantPositionMobilityModel>();
+    gwMobility->SetPosition(Vector(0.0, 0.0, 15.0));
+    gateway->AggregateObject(gwMobility);
 
-    Simulator::Schedule(Seconds(2),
-                        &SimpleEndDeviceLoraPhy::Send,
-                        edPhy1,
-                        packet,
-                        txParams,
+    Ptr<LoraNetDevice> device = CreateObject<LoraNetDevice>();
+    for (double orientation : {0.0, 120.0, -120.0})
+    {
+        Ptr<SimpleGatewayLoraPhy> sectorPhy = CreateObject<SimpleGatewayLoraPhy>();
+        sectorPhy->AddFrequency(868.1);
+        for (int path = 0; path < 8; path++)
+        {
+            sectorPhy->AddReceptionPath();
+        }
+        Ptr<ParabolicAntennaModel> antenna = CreateObject<ParabolicAntennaModel>();
+        antenna->SetAttribute("Orientation", DoubleValue(orientation));
+        antenna->SetAttribute("Beamwidth", DoubleValue(120));
+        sectorPhy->SetAntenna(antenna);
+        sectorPhy->SetDevice(device);
+        channel->Add(sectorPhy);
+        sectorPhy->SetChannel(channel);
+        sectorPhy->TraceConnectWithoutContext(
+            "PhyRxBegin",
+            MakeCallback(&GatewaySectorDownlinkTest::SectorRxBegin, this));
+        sectorPhy->TraceConnectWithoutContext(
+            "ReceivedPacket",
+            MakeCallback(&GatewaySectorDownlinkTest::SectorReceived, this));
+        sectorPhy->TraceConnectWithoutContext(
+            "NoReceptionBecauseTransmitting",
+            MakeCallback(&GatewaySectorDownlinkTest::SectorInterrupted, this));
+        m_sectorPhys.push_back(sectorPhy);
+    }
+    device->SetPhy(m_sectorPhys[0]);
+    device->AddPhy(m_sectorPhys[1]);
+    device->AddPhy(m_sectorPhys[2]);
+    gateway->AddDevice(device);
+
+    // An end device in front of the first sector listens for the downlink,
+    // while another one, in front of the second sector, sends uplinks with a
+    // different spreading factor
+    Ptr<SimpleEndDeviceLoraPhy> listenerPhy = CreateObject<SimpleEndDeviceLoraPhy>();
+    Ptr<ConstantPositionMobilityModel> listenerMobility =
+        CreateObject<ConstantPositionMobilityModel>();
+    listenerMobility->SetPosition(Vector(1000.0, 0.0, 0.0));
+    listenerPhy->SetMobility(listenerMobility);
+    listenerPhy->SetFrequency(868.1);
+    listenerPhy->SetSpreadingFactor(12);
+    listenerPhy->SwitchToStandby();
+    listenerPhy->TraceConnectWithoutContext(
+        "ReceivedPacket",
+        MakeCallback(&GatewaySectorDownlinkTest::EndDeviceReceived, this));
+    channel->Add(listenerPhy);
+    listenerPhy->SetChannel(channel);
+
+    Ptr<SimpleEndDeviceLoraPhy> senderPhy = CreateObject<SimpleEndDeviceLoraPhy>();
+    Ptr<ConstantPositionMobilityModel> senderMobility =
+        CreateObject<ConstantPositionMobilityModel>();
+    senderMobility->SetPosition(Vector(-500.0, 866.0, 0.0));
+    senderPhy->SetMobility(senderMobility);
+    senderPhy->SwitchToStandby();
+    channel->Add(senderPhy);
+    senderPhy->SetChannel(channel);
+
+    // The downlink starts while the first uplink is being received by all
+    // sectors, and ends before the second uplink
+    LoraTxParameters uplinkParams;
+    uplinkParams.sf = 7;
+    for (double time : {1.0, 5.0})
+    {
+        Simulator::Schedule(Seconds(time),
+                            &SimpleEndDeviceLoraPhy::Send,
+                            senderPhy,
+                            Create<Packet>(10),
+                            uplinkParams,
+                            868.1,
+                            14);
+    }
+    LoraTxParameters downlinkParams;
+    downlinkParams.sf = 12;
+    Simulator::Schedule(Seconds(1.01),
+                        &SimpleGatewayLoraPhy::Send,
+                        m_sectorPhys[0],
+                        Create<Packet>(10),
+                        downlinkParams,
                         868.1,
                         14);
+    Simulator::Schedule(Seconds(1.02), &GatewaySectorDownlinkTest::CheckTransmitting, this, true);
+    Simulator::Schedule(Seconds(4), &GatewaySectorDownlinkTest::CheckTransmitting, this, false);
 
-    Simulator::Stop(Hours(2));
+    Simulator::Stop(Hours(1));
     Simulator::Run();
-    Simulator::Destroy();
-
-    NS_TEST_EXPECT_MSG_EQ(
-        m_receivedPacketCalls,
-        2,
-        "Channel skipped some PHYs when delivering a packet"); // All PHYs except the sender
-
-    Reset();
 
-    // Sleeping PHYs do not receive the packet
-
-    edPhy2->SwitchToSleep();
-
-    Simulator::Schedule(Seconds(2),
-                        &SimpleEndDeviceLoraPhy::Send,
-                        edPhy1,
-                        packet,
-                        txParams,
-                        868.1,
-                        14);
+    NS_TEST_EXPECT_MSG_EQ(m_sectorRxBegins, 6, "The downlink should not reach the sectors");
+    NS_TEST_EXPECT_MSG_EQ(m_sectorInterruptions,
+                          3,
+                          "The first uplink should be interrupted on all sectors");
+    NS_TEST_EXPECT_MSG_EQ(m_sectorReceptions,
+                          3,
+                          "Only the second uplink should be received, by all sectors");
+    NS_TEST_EXPECT_MSG_EQ(m_endDeviceReceptions, 1, "The downlink should be received");
 
-    Simulator::Stop(Hours(2));
-    Simulator::Run();
     Simulator::Destroy();
+}
 
-    NS_TEST_EXPECT_MSG_EQ(
-        m_receivedPacketCalls,
-        1,
-        "Packet was received by a PHY in SLEEP mode"); // All PHYs in Standby except the sender
+/*******************************
+ * InterferenceBookkeepingTest *
+ *******************************/
 
-    Reset();
+class InterferenceBookkeepingTest : public TestCase
+{
+  public:
+    InterferenceBookkeepingTest();
+    ~InterferenceBookkeepingTest() override;
 
-    // Packet that arrives under sensitivity is received correctly if SF increases
+  private:
+    void DoRun() override;
+    void RunScenario(EndDeviceLoraPhy::InterferenceBookkeeping bookkeeping, bool subscription);
+    void CountInterferers(Ptr<SimpleEndDeviceLoraPhy> phy);
+    void ReceivedPacket(Ptr<const Packet> packet);
+    void FailedReception(Ptr<const Packet> packet);
+
+    std::size_t m_interferers = 0;
+    int m_receivedPackets = 0;
+    int m_failedReceptions = 0;
+};
 
-    txParams.sf = 7;
-    edPhy2->SetSpreadingFactor(7);
-    edPhy2->GetMobility()->GetObject<ConstantPositionMobilityModel>()->SetPosition(
-        Vector(2990, 0, 0));
+// Add some help text to this case to describe what it is intended to test
+InterferenceBookkeepingTest::InterferenceBookkeepingTest()
+    : TestCase("Verify that end devices only record the interferers that may overlap a "
+               "receive window, without changing the outcome of receptions, and "
+               "that subscribed end devices are notified of them")
+{
+}
 
-    Simulator::Schedule(Seconds(2),
-                        &SimpleEndDeviceLoraPhy::Send,
-                        edPhy1,
-                        packet,
-                        txParams,
-                        868.1,
-                        14);
+// Reminder that the test case should clean up after itself
+InterferenceBookkeepingTest::~InterferenceBookkeepingTest()
+{
+}
 
-    Simulator::Stop(Hours(2));
-    Simulator::Run();
-    Simulator::Destroy();
+void
+InterferenceBookkeepingTest::CountInterferers(Ptr<SimpleEndDeviceLoraPhy> phy)
+{
+    m_interferers = phy->GetInterferenceHelper().GetInterferers().size();
+}
 
-    NS_TEST_EXPECT_MSG_EQ(
-        m_underSensitivityCalls,
-        1,
-        "Packet that should have been lost because of low receive power was received");
+void
+InterferenceBookkeepingTest::ReceivedPacket(Ptr<const Packet> packet)
+{
+    m_receivedPackets++;
+}
 
-    Reset();
+void
+InterferenceBookkeepingTest::FailedReception(Ptr<const Packet> packet)
+{
+    m_failedReceptions++;
+}
 
-    // Try again using a packet with higher SF
-    txParams.sf = 8;
-    edPhy2->SetSpreadingFactor(8);
-    edPhy2->GetMobility()->GetObject<ConstantPositionMobilityModel>()->SetPosition(
-        Vector(2990, 0, 0));
+void
+InterferenceBookkeepingTest::RunScenario(EndDeviceLoraPhy::InterferenceBookkeeping bookkeeping,
+                                         bool subscription)
+{
+    m_interferers = 0;
+    m_receivedPackets = 0;
+    m_failedReceptions = 0;
 
-    Simulator::Schedule(Seconds(2),
+    Ptr<LogDistancePropagationLossModel> loss = CreateObject<LogDistancePropagationLossModel>();
+    loss->SetPathLossExponent(3.76);
+    loss->SetReference(1, 7.7);
+    Ptr<PropagationDelayModel> delay = CreateObject<ConstantSpeedPropagationDelayModel>();
+    Ptr<LoraChannel> channel = CreateObject<LoraChannel>(loss, delay);
+    channel->SetAttribute("EndDeviceSubscription", BooleanValue(subscription));
+
+    // The receiver starts asleep, as after a transmission
+    Ptr<SimpleEndDeviceLoraPhy> rxPhy = CreateObject<SimpleEndDeviceLoraPhy>();
+    rxPhy->SetAttribute("InterferenceBookkeeping", EnumValue(bookkeeping));
+    Ptr<ConstantPositionMobilityModel> rxMobility = CreateObject<ConstantPositionMobilityModel>();
+    rxMobility->SetPosition(Vector(0.0, 0.0, 0.0));
+    rxPhy->SetMobility(rxMobility);
+    rxPhy->SetFrequency(868.1);
+    rxPhy->SetSpreadingFactor(12);
+    rxPhy->SetReceiveOkCallback(MakeCallback(&InterferenceBookkeepingTest::ReceivedPacket, this));
+    rxPhy->SetReceiveFailedCallback(
+        MakeCallback(&InterferenceBookkeepingTest::FailedReception, this));
+    channel->Add(rxPhy);
+    rxPhy->SetChannel(channel);
+
+    // A short and a long interferer close to the receiver, and a farther
+    // sender for the packet the receiver will lock on
+    std::vector<Ptr<SimpleEndDeviceLoraPhy>> txPhys;
+    for (double distance : {10.0, 10.0, 100.0})
+    {
+        Ptr<SimpleEndDeviceLoraPhy> txPhy = CreateObject<SimpleEndDeviceLoraPhy>();
+        Ptr<ConstantPositionMobilityModel> mobility =
+            CreateObject<ConstantPositionMobilityModel>();
+        mobility->SetPosition(Vector(distance, 0.0, 0.0));
+        txPhy->SetMobility(mobility);
+        channel->Add(txPhy);
+        txPhy->SetChannel(channel);
+        txPhys.push_back(txPhy);
+    }
+
+    LoraTxParameters shortParams;
+    shortParams.sf = 7;
+    LoraTxParameters longParams;
+    longParams.sf = 12;
+
+    // The receive window opens at 2 s: the short interferer ends before that,
+    // while the long one is still in the air. Both start while the receiver
+    // sleeps, before it subscribes to the frequency of the window
+    Simulator::Schedule(Seconds(0.5),
+                        &EndDeviceLoraPhy::ArmReceiveWindow,
+                        rxPhy,
+                        Seconds(2));
+    Simulator::Schedule(Seconds(1),
                         &SimpleEndDeviceLoraPhy::Send,
-                        edPhy1,
-                        packet,
-                        txParams,
+                        txPhys[0],
+                        Create<Packet>(10),
+                        shortParams,
                         868.1,
                         14);
-
-    Simulator::Stop(Hours(2));
-    Simulator::Run();
-    Simulator::Destroy();
-
-    NS_TEST_EXPECT_MSG_EQ(m_underSensitivityCalls,
-                          0,
-                          "Packets that should have arrived above sensitivity were under it");
-
-    Reset();
-
-    // Packets can be destroyed by interference
-
-    txParams.sf = 12;
-    Simulator::Schedule(Seconds(2),
+    Simulator::Schedule(Seconds(1.1),
                         &SimpleEndDeviceLoraPhy::Send,
-                        edPhy1,
-                        packet,
-                        txParams,
+                        txPhys[1],
+                        Create<Packet>(10),
+                        longParams,
                         868.1,
                         14);
-    Simulator::Schedule(Seconds(2),
+    Simulator::Schedule(Seconds(1.5),
+                        &InterferenceBookkeepingTest::CountInterferers,
+                        this,
+                        rxPhy);
+    Simulator::Schedule(Seconds(2), &EndDeviceLoraPhy::SwitchToStandby, rxPhy);
+    Simulator::Schedule(Seconds(2.001),
                         &SimpleEndDeviceLoraPhy::Send,
-                        edPhy3,
-                        packet,
-                        txParams,
+                        txPhys[2],
+                        Create<Packet>(10),
+                        longParams,
                         868.1,
                         14);
 
-    Simulator::Stop(Hours(2));
+    Simulator::Stop(Seconds(10));
     Simulator::Run();
     Simulator::Destroy();
+}
 
-    NS_TEST_EXPECT_MSG_EQ(m_interferenceCalls,
-                          1,
-                          "Packets that should be destroyed by interference weren't");
-
-    Reset();
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+InterferenceBookkeepingTest::DoRun()
+{
+    NS_LOG_DEBUG("InterferenceBookkeepingTest");
 
-    // Packets can be lost because the PHY is not listening on the right frequency
+    for (bool subscription : {false, true})
+    {
+        RunScenario(EndDeviceLoraPhy::ALL_SIGNALS, subscription);
+        NS_TEST_EXPECT_MSG_EQ(m_interferers, 2, "Both interferers should be recorded");
+        NS_TEST_EXPECT_MSG_EQ(m_receivedPackets, 0, "The packet should not be received");
+        NS_TEST_EXPECT_MSG_EQ(m_failedReceptions, 1, "The packet should be interfered");
+
+        RunScenario(EndDeviceLoraPhy::RECEIVE_WINDOWS, subscription);
+        NS_TEST_EXPECT_MSG_EQ(m_interferers,
+                              1,
+                              "Only the interferer overlapping the window should be recorded");
+        NS_TEST_EXPECT_MSG_EQ(m_receivedPackets, 0, "The packet should not be received");
+        NS_TEST_EXPECT_MSG_EQ(m_failedReceptions, 1, "The packet should be interfered");
+    }
+}
 
-    Simulator::Schedule(Seconds(2),
-                        &SimpleEndDeviceLoraPhy::Send,
-                        edPhy1,
-                        packet,
-                        txParams,
-                        868.3,
-                        14);
+/****************************
+ * SimultaneousArrivalsTest *
+ ****************************/
 
-    Simulator::Stop(Hours(2));
-    Simulator::Run();
-    Simulator::Destroy();
+class SimultaneousArrivalsTest : public TestCase
+{
+  public:
+    SimultaneousArrivalsTest();
+    ~SimultaneousArrivalsTest() override;
 
-    NS_TEST_EXPECT_MSG_EQ(m_wrongFrequencyCalls,
-                          2,
-                          "Packets were received even though PHY was on a different frequency");
+  private:
+    void DoRun() override;
+    void RunScenario(bool sortArrivals);
+    void RxBegin(Ptr<const Packet> packet);
 
-    Reset();
+    Ptr<const Packet> m_firstPacket;
+};
 
-    // Packets can be lost because the PHY is not listening for the right SF
+// Add some help text to this case to describe what it is intended to test
+SimultaneousArrivalsTest::SimultaneousArrivalsTest()
+    : TestCase("Verify that signals reaching a PHY at the same time can be delivered in an "
+               "order that doesn't depend on the order they were sent in")
+{
+}
 
-    txParams.sf = 8; // Send with 8, listening for 12
-    Simulator::Schedule(Seconds(2),
-                        &SimpleEndDeviceLoraPhy::Send,
-                        edPhy1,
-                        packet,
-                        txParams,
-                        868.1,
-                        14);
+// Reminder that the test case should clean up after itself
+SimultaneousArrivalsTest::~SimultaneousArrivalsTest()
+{
+}
 
-    Simulator::Stop(Hours(2));
-    Simulator::Run();
-    Simulator::Destroy();
+void
+SimultaneousArrivalsTest::RxBegin(Ptr<const Packet> packet)
+{
+    if (!m_firstPacket)
+    {
+        m_firstPacket = packet;
+    }
+}
 
-    NS_TEST_EXPECT_MSG_EQ(m_wrongSfCalls,
-                          2,
-                          "Packets were received even though PHY was listening for a different SF");
+void
+SimultaneousArrivalsTest::RunScenario(bool sortArrivals)
+{
+    m_firstPacket = nullptr;
 
-    Reset();
+    Ptr<LogDistancePropagationLossModel> loss = CreateObject<LogDistancePropagationLossModel>();
+    Ptr<PropagationDelayModel> delay = CreateObject<ConstantSpeedPropagationDelayModel>();
+    Ptr<LoraChannel> channel = CreateObject<LoraChannel>(loss, delay);
+    channel->SetAttribute("SortSimultaneousArrivals", BooleanValue(sortArrivals));
+
+    // The receiver locks on the first signal that reaches it
+    Ptr<SimpleEndDeviceLoraPhy> rxPhy = CreateObject<SimpleEndDeviceLoraPhy>();
+    Ptr<ConstantPositionMobilityModel> rxMobility = CreateObject<ConstantPositionMobilityModel>();
+    rxMobility->SetPosition(Vector(0.0, 0.0, 0.0));
+    rxPhy->SetMobility(rxMobility);
+    rxPhy->SetFrequency(868.1);
+    rxPhy->SetSpreadingFactor(7);
+    rxPhy->TraceConnectWithoutContext("PhyRxBegin",
+                                      MakeCallback(&SimultaneousArrivalsTest::RxBegin, this));
+    channel->Add(rxPhy);
+    rxPhy->SetChannel(channel);
+    rxPhy->SwitchToStandby();
+
+    // Two senders at the same distance from the receiver
+    std::vector<Ptr<SimpleEndDeviceLoraPhy>> txPhys;
+    for (double x : {-100.0, 100.0})
+    {
+        Ptr<SimpleEndDeviceLoraPhy> txPhy = CreateObject<SimpleEndDeviceLoraPhy>();
+        Ptr<ConstantPositionMobilityModel> mobility =
+            CreateObject<ConstantPositionMobilityModel>();
+        mobility->SetPosition(Vector(x, 0.0, 0.0));
+        txPhy->SetMobility(mobility);
+        channel->Add(txPhy);
+        txPhy->SetChannel(channel);
+        txPhys.push_back(txPhy);
+    }
 
-    // Sending of packets
-    /////////////////////
+    LoraTxParameters txParams;
+    txParams.sf = 7;
 
-    // The very same packet arrives at the other PHY
-    Simulator::Schedule(Seconds(2),
+    // The sender that was connected last transmits first
+    Simulator::Schedule(Seconds(1),
                         &SimpleEndDeviceLoraPhy::Send,
-                        edPhy1,
-                        packet,
+                        txPhys[1],
+                        Create<Packet>(20),
                         txParams,
                         868.1,
                         14);
-
-    Simulator::Stop(Hours(2));
-    Simulator::Run();
-    Simulator::Destroy();
-
-    NS_TEST_EXPECT_MSG_EQ(HaveSamePacketContents(packet, m_latestReceivedPacket),
-                          true,
-                          "Packet changed contents when going through the channel");
-
-    Reset();
-
-    // Correct state transitions
-    ////////////////////////////
-
-    // PHY switches to STANDBY after TX and RX
-
-    Simulator::Schedule(Seconds(2),
+    Simulator::Schedule(Seconds(1),
                         &SimpleEndDeviceLoraPhy::Send,
-                        edPhy1,
-                        packet,
+                        txPhys[0],
+                        Create<Packet>(10),
                         txParams,
                         868.1,
                         14);
 
-    Simulator::Stop(Hours(2));
+    Simulator::Stop(Seconds(10));
     Simulator::Run();
     Simulator::Destroy();
+}
 
-    NS_TEST_EXPECT_MSG_EQ(edPhy1->GetState(),
-                          SimpleEndDeviceLoraPhy::STANDBY,
-                          "State didn't switch to STANDBY as expected");
-    NS_TEST_EXPECT_MSG_EQ(edPhy2->GetState(),
-                          SimpleEndDeviceLoraPhy::STANDBY,
-                          "State didn't switch to STANDBY as expected");
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+SimultaneousArrivalsTest::DoRun()
+{
+    NS_LOG_DEBUG("SimultaneousArrivalsTest");
+
+    RunScenario(false);
+    NS_TEST_ASSERT_MSG_EQ(bool(m_firstPacket), true, "The receiver should lock on a packet");
+    NS_TEST_EXPECT_MSG_EQ(m_firstPacket->GetSize(),
+                          20,
+                          "Signals should arrive in the order they were sent in");
+
+    RunScenario(true);
+    NS_TEST_ASSERT_MSG_EQ(bool(m_firstPacket), true, "The receiver should lock on a packet");
+    NS_TEST_EXPECT_MSG_EQ(m_firstPacket->GetSize(),
+                          10,
+                          "Signals should arrive in the order of their senders");
 }
 
 /*****************
@@ -1562,12 +3842,24 @@ LorawanTestSuite::LorawanTestSuite()
     LogComponentEnable("LorawanTestSuite", LOG_LEVEL_DEBUG);
     // TestDuration for TestCase can be QUICK, EXTENSIVE or TAKES_FOREVER
     AddTestCase(new InterferenceTest, TestCase::QUICK);
+    AddTestCase(new IncrementalInterferenceTest, TestCase::QUICK);
     AddTestCase(new AddressTest, TestCase::QUICK);
     AddTestCase(new HeaderTest, TestCase::QUICK);
     AddTestCase(new ReceivePathTest, TestCase::QUICK);
+    AddTestCase(new ReceptionPathAllocationTest, TestCase::QUICK);
+    AddTestCase(new InterferencePruningTest, TestCase::QUICK);
+    AddTestCase(new Sx1302GatewayTest, TestCase::QUICK);
     AddTestCase(new LogicalLoraChannelTest, TestCase::QUICK);
     AddTestCase(new TimeOnAirTest, TestCase::QUICK);
     AddTestCase(new PhyConnectivityTest, TestCase::QUICK);
+    AddTestCase(new ParallelLinkBudgetTest, TestCase::QUICK);
+    AddTestCase(new CorrelatedShadowingTest, TestCase::QUICK);
+    AddTestCase(new RasterTest, TestCase::QUICK);
+    AddTestCase(new BuildingPenetrationLossTest, TestCase::QUICK);
+    AddTestCase(new GatewaySectorTest, TestCase::QUICK);
+    AddTestCase(new GatewaySectorDownlinkTest, TestCase::QUICK);
+    AddTestCase(new InterferenceBookkeepingTest, TestCase::QUICK);
+    AddTestCase(new SimultaneousArrivalsTest, TestCase::QUICK);
 }
 
 // Do not forget to allocate an instance of this TestSuite